@@ -9,6 +9,8 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <thread>
+#include <exception>
 
 namespace Integration {
 
@@ -49,7 +51,7 @@ bool LexerPreprocessorBridge::initialize() {
         // std::cout << "[DEBUG] Interface do pré-processador inicializada com sucesso" << std::endl;
         
         // Inicializar error handler
-        errorHandler = std::make_unique<Lexer::ErrorHandler>();
+        errorHandler = std::make_unique<Lexer::ErrorHandler>(config.maxLexerErrors);
         
         // Configurar integração de erros se habilitada
         if (config.enableErrorIntegration) {
@@ -79,44 +81,18 @@ bool LexerPreprocessorBridge::processFile(const std::string& filename) {
     }
     
     try {
+        if (config.enablePipelining) {
+            return processFilePipelined(filename);
+        }
+        
         // Processar arquivo através do preprocessor
         // std::cout << "[DEBUG] Chamando preprocessorInterface->processFile..." << std::endl;
-        lastProcessingResult = preprocessorInterface->processFile(filename);
+        lastProcessingResult = preprocessorInterface->processFileAndRelease(filename);
          // std::cout << "[DEBUG] Resultado do processamento: hasErrors=" << lastProcessingResult.hasErrors << std::endl;
         
         if (lastProcessingResult.hasErrors) {
              std::cout << "[DEBUG] Processamento falhou com erros - implementando fallback para código original" << std::endl;
-            
-            // FALLBACK: Ler e processar código original sem pré-processamento
-            std::ifstream file(filename);
-            if (!file.is_open()) {
-                 std::cout << "[DEBUG] Erro: não foi possível abrir arquivo para fallback" << std::endl;
-                return false;
-            }
-            
-            std::string originalCode((std::istreambuf_iterator<char>(file)),
-                                   std::istreambuf_iterator<char>());
-            file.close();
-            
-             std::cout << "[DEBUG] FALLBACK: Processando código original sem pré-processamento" << std::endl;
-             std::cout << "[DEBUG] Código original tem " << originalCode.length() << " caracteres" << std::endl;
-            
-            // Limpar resultado anterior e configurar para código original
-            lastProcessingResult.processedCode = originalCode;
-            lastProcessingResult.hasErrors = true; // Manter flag de erro para indicar que houve problemas no pré-processamento
-            
-            // Inicializar lexer com código original
-            codeStream = std::make_unique<std::istringstream>(originalCode);
-            lexer = std::make_unique<Lexer::LexerMain>(*codeStream, errorHandler.get(), filename);
-            
-            // Construir tokens integrados (sem mapeamentos do pré-processador)
-            buildIntegratedTokens();
-            
-            hasProcessedInput = true;
-            currentTokenIndex = 0;
-            
-             std::cout << "[DEBUG] FALLBACK: Processamento do código original concluído" << std::endl;
-            return true; // Retorna true para permitir análise léxica do código original
+            return processFileFallback(filename);
         }
         
          // std::cout << "[DEBUG] Processamento bem-sucedido, código processado tem " << lastProcessingResult.processedCode.length() << " caracteres" << std::endl;
@@ -128,8 +104,7 @@ bool LexerPreprocessorBridge::processFile(const std::string& filename) {
         std::cout << "========================================" << std::endl;
         
         // Inicializar lexer com código processado
-        codeStream = std::make_unique<std::istringstream>(lastProcessingResult.processedCode);
-        lexer = std::make_unique<Lexer::LexerMain>(*codeStream, errorHandler.get(), filename);
+        attachLexer(lastProcessingResult.processedCode, filename);
         
         // Construir tokens integrados
         buildIntegratedTokens();
@@ -157,6 +132,132 @@ bool LexerPreprocessorBridge::processFile(const std::string& filename) {
     }
 }
 
+bool LexerPreprocessorBridge::processFileFallback(const std::string& filename) {
+    // FALLBACK: Processar código original sem pré-processamento, a partir da
+    // visão já mapeada pelo pré-processador (o arquivo não é relido)
+    Preprocessor::FileView source = preprocessorInterface
+        ? preprocessorInterface->openSourceView(filename)
+        : Preprocessor::FileView::open(filename);
+    if (!source.valid()) {
+         std::cout << "[DEBUG] Erro: não foi possível abrir arquivo para fallback" << std::endl;
+        return false;
+    }
+    
+     std::cout << "[DEBUG] FALLBACK: Processando código original sem pré-processamento" << std::endl;
+     std::cout << "[DEBUG] Código original tem " << source.size() << " caracteres" << std::endl;
+    
+    // Limpar resultado anterior e configurar para código original
+    lastProcessingResult.processedCode.assign(source.data(), source.size());
+    lastProcessingResult.hasErrors = true; // Manter flag de erro para indicar que houve problemas no pré-processamento
+    
+    // Inicializar lexer com código original
+    attachLexer(lastProcessingResult.processedCode, filename);
+    
+    // Construir tokens integrados (sem mapeamentos do pré-processador)
+    buildIntegratedTokens();
+    
+    hasProcessedInput = true;
+    currentTokenIndex = 0;
+    
+     std::cout << "[DEBUG] FALLBACK: Processamento do código original concluído" << std::endl;
+    return true; // Retorna true para permitir análise léxica do código original
+}
+
+bool LexerPreprocessorBridge::processFilePipelined(const std::string& filename) {
+    // Produtor (preprocessor) e consumidor (lexer) trocam blocos por uma fila limitada;
+    // o lexer tokeniza o início da saída enquanto o restante ainda está sendo expandido
+    ChunkQueue queue(config.pipelineQueueDepth);
+    ChunkQueueStreamBuf queueBuffer(queue);
+    std::istream queueStream(&queueBuffer);
+    
+    lastProcessingResult = Preprocessor::ProcessingResult();
+    std::string retainedCode;
+    std::exception_ptr producerError;
+    
+    std::thread producer([&]() {
+        std::string pending;
+        pending.reserve(config.pipelineChunkSize);
+        try {
+            lastProcessingResult = preprocessorInterface->processFileStreaming(filename,
+                [&](std::string_view chunk) {
+                    retainedCode.append(chunk.data(), chunk.size());
+                    pending.append(chunk.data(), chunk.size());
+                    if (pending.size() >= config.pipelineChunkSize) {
+                        queue.push(std::move(pending));
+                        pending.clear();
+                        pending.reserve(config.pipelineChunkSize);
+                    }
+                });
+        } catch (...) {
+            producerError = std::current_exception();
+        }
+        if (!pending.empty()) {
+            queue.push(std::move(pending));
+        }
+        queue.close();
+    });
+    
+    std::vector<Lexer::Token> tokens;
+    try {
+        lexer.reset();
+        codeStream.reset();
+        codeBuffer.reset();
+        Lexer::LexerMain streamLexer(queueStream, errorHandler.get(), filename);
+        tokens = streamLexer.tokenizeAll();
+    } catch (...) {
+        // Drena a fila para que o produtor não fique bloqueado antes do join
+        queue.close();
+        producer.join();
+        throw;
+    }
+    // O lexer pode parar antes do fim do fluxo (limite de erros); fechar a fila
+    // libera o produtor, que continua retendo a saída completa
+    queue.close();
+    producer.join();
+    
+    if (producerError) {
+        std::rethrow_exception(producerError);
+    }
+    
+    lastProcessingResult.processedCode = std::move(retainedCode);
+    
+    if (lastProcessingResult.hasErrors) {
+        return processFileFallback(filename);
+    }
+    
+    // Mapeamentos só ficam completos ao fim do pré-processamento, então são
+    // associados aos tokens depois do join
+    tokenCache.clear();
+    tokenCache.reserve(tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        tokenCache.push_back(createIntegratedToken(tokens[i], i));
+    }
+    
+    // Lexer persistente sobre o código retido, para reset() e consultas posteriores
+    attachLexer(lastProcessingResult.processedCode, filename);
+    
+    if (config.enablePositionMapping) {
+        validatePositionMappings();
+    }
+    
+    hasProcessedInput = true;
+    currentTokenIndex = 0;
+    
+    if (onFileIncluded) {
+        onFileIncluded(filename);
+    }
+    
+    return true;
+}
+
+void LexerPreprocessorBridge::attachLexer(const std::string& code, const std::string& filename) {
+    // O lexer lê direto da string do resultado, sem cópia para istringstream
+    lexer.reset();
+    codeBuffer = std::make_unique<StringViewStreamBuf>(code.data(), code.size());
+    codeStream = std::make_unique<std::istream>(codeBuffer.get());
+    lexer = std::make_unique<Lexer::LexerMain>(*codeStream, errorHandler.get(), filename);
+}
+
 bool LexerPreprocessorBridge::processString(const std::string& code, const std::string& filename) {
     if (!isInitialized) {
         if (!initialize()) {
@@ -173,8 +274,7 @@ bool LexerPreprocessorBridge::processString(const std::string& code, const std::
         }
         
         // Inicializar lexer com código processado
-        codeStream = std::make_unique<std::istringstream>(lastProcessingResult.processedCode);
-        lexer = std::make_unique<Lexer::LexerMain>(*codeStream, errorHandler.get(), filename);
+        attachLexer(lastProcessingResult.processedCode, filename);
         
         // Construir tokens integrados
         buildIntegratedTokens();
@@ -252,11 +352,16 @@ void LexerPreprocessorBridge::reset() {
     tokenCache.clear();
     currentTokenIndex = 0;
     hasProcessedInput = false;
-    lastProcessingResult = Preprocessor::ProcessingResult();
     
     if (lexer) {
         lexer->reset();
     }
+    
+    // O stream lê diretamente do resultado: descartá-lo antes de liberar o código
+    lexer.reset();
+    codeStream.reset();
+    codeBuffer.reset();
+    lastProcessingResult = Preprocessor::ProcessingResult();
 }
 
 bool LexerPreprocessorBridge::mapToOriginalPosition(size_t processedLine, size_t processedColumn,
@@ -267,15 +372,15 @@ bool LexerPreprocessorBridge::mapToOriginalPosition(size_t processedLine, size_t
     }
     
     const auto& mapper = preprocessorInterface->getPositionMapper();
-    const auto* mapping = mapper.findMapping(processedLine, processedColumn);
+    Preprocessor::SourceMapping mapping;
     
-    if (!mapping || mapping->originalLine == 0) {
+    if (!mapper.resolve(processedLine, processedColumn, mapping) || mapping.originalLine == 0) {
         return false; // Mapeamento não encontrado
     }
     
-    originalLine = mapping->originalLine;
-    originalColumn = mapping->originalColumn;
-    originalFile = mapping->originalFile;
+    originalLine = mapping.originalLine;
+    originalColumn = mapping.originalColumn;
+    originalFile = mapping.originalFile;
     
     return true;
 }
@@ -285,9 +390,8 @@ bool LexerPreprocessorBridge::validatePositionMappings() const {
         return false;
     }
     
-    // Implementar validação básica
-    const auto& result = preprocessorInterface->getLastResult();
-    return !result.processedCode.empty() && !result.positionMappings.empty();
+    // Implementar validação básica (o código processado pertence à ponte)
+    return !lastProcessingResult.processedCode.empty() && !lastProcessingResult.positionMappings.empty();
 }
 
 bool LexerPreprocessorBridge::runIntegrationTests() {
@@ -424,14 +528,9 @@ Preprocessor::SourceMapping LexerPreprocessorBridge::findMappingForPosition(size
         return Preprocessor::SourceMapping();
     }
     
-    const auto& mapper = preprocessorInterface->getPositionMapper();
-    const auto* mapping = mapper.findMapping(line, column);
-    
-    if (mapping) {
-        return *mapping;
-    }
-    
-    return Preprocessor::SourceMapping();
+    Preprocessor::SourceMapping mapping;
+    preprocessorInterface->getPositionMapper().resolve(line, column, mapping);
+    return mapping;
 }
 
 void LexerPreprocessorBridge::validatePositionMappings() {
@@ -18,6 +18,10 @@
 #include <functional>
 #include <unordered_map>
 #include <sstream>
+#include <streambuf>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
 
 namespace Integration {
 
@@ -32,13 +36,130 @@ struct IntegrationConfig {
     bool enableDebugMode;           ///< Habilita modo de debug
     std::string cStandard;          ///< Padrão C a ser usado ("c99", "c11", etc.)
     std::vector<std::string> includePaths; ///< Caminhos de busca para includes
+    bool enablePipelining;          ///< Preprocessor e lexer em threads concorrentes
+    size_t pipelineChunkSize;       ///< Bytes acumulados antes de publicar um bloco
+    size_t pipelineQueueDepth;      ///< Blocos em trânsito antes de bloquear o produtor
+    int maxLexerErrors;             ///< Erros léxicos antes de o lexer interromper a tokenização
     
     IntegrationConfig() 
         : enablePositionMapping(true)
         , enableMacroTracking(true)
         , enableErrorIntegration(true)
         , enableDebugMode(false)
-        , cStandard("c99") {}
+        , cStandard("c99")
+        , enablePipelining(false)
+        , pipelineChunkSize(64 * 1024)
+        , pipelineQueueDepth(8)
+        , maxLexerErrors(100) {}
+};
+
+/**
+ * @class StringViewStreamBuf
+ * @brief streambuf somente leitura sobre memória já existente
+ * 
+ * Permite entregar o código processado ao lexer sem copiá-lo para um
+ * istringstream. A memória deve sobreviver ao stream.
+ */
+class StringViewStreamBuf : public std::streambuf {
+public:
+    StringViewStreamBuf(const char* data, size_t size) {
+        char* begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+    
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which = std::ios_base::in) override {
+        if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+        char* target = dir == std::ios_base::beg ? eback() + off
+                     : dir == std::ios_base::cur ? gptr() + off
+                     : egptr() + off;
+        if (target < eback() || target > egptr()) return pos_type(off_type(-1));
+        setg(eback(), target, egptr());
+        return pos_type(target - eback());
+    }
+    
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+/**
+ * @class ChunkQueue
+ * @brief Fila limitada de blocos de texto com um produtor e um consumidor
+ * 
+ * O produtor bloqueia quando a fila está cheia e o consumidor quando está
+ * vazia; close() sinaliza fim de dados e libera ambos os lados.
+ */
+class ChunkQueue {
+public:
+    explicit ChunkQueue(size_t capacity) : capacity_(capacity ? capacity : 1), closed_(false) {}
+    
+    /**
+     * @brief Publica um bloco (bloqueia enquanto a fila está cheia)
+     * @return false se a fila já foi fechada
+     */
+    bool push(std::string chunk) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this] { return chunks_.size() < capacity_ || closed_; });
+        if (closed_) return false;
+        chunks_.push_back(std::move(chunk));
+        notEmpty_.notify_one();
+        return true;
+    }
+    
+    /**
+     * @brief Retira o próximo bloco (bloqueia enquanto a fila está vazia)
+     * @return false quando a fila foi fechada e não há mais blocos
+     */
+    bool pop(std::string& chunk) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this] { return !chunks_.empty() || closed_; });
+        if (chunks_.empty()) return false;
+        chunk = std::move(chunks_.front());
+        chunks_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+    
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+    
+private:
+    std::deque<std::string> chunks_;
+    size_t capacity_;
+    bool closed_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
+
+/**
+ * @class ChunkQueueStreamBuf
+ * @brief streambuf que lê blocos de uma ChunkQueue à medida que chegam
+ */
+class ChunkQueueStreamBuf : public std::streambuf {
+public:
+    explicit ChunkQueueStreamBuf(ChunkQueue& queue) : queue_(queue) {}
+    
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+        do {
+            if (!queue_.pop(current_)) return traits_type::eof();
+        } while (current_.empty());
+        char* begin = &current_[0];
+        setg(begin, begin, begin + current_.size());
+        return traits_type::to_int_type(*gptr());
+    }
+    
+private:
+    ChunkQueue& queue_;
+    std::string current_;
 };
 
 /**
@@ -76,8 +197,9 @@ private:
     bool isInitialized;
     bool hasProcessedInput;
     
-    // Stream para armazenar código processado
-    std::unique_ptr<std::istringstream> codeStream;
+    // Stream de leitura sobre o código processado (sem cópia)
+    std::unique_ptr<StringViewStreamBuf> codeBuffer;
+    std::unique_ptr<std::istream> codeStream;
     
     // Callbacks para eventos de integração
     std::function<void(const std::string&, const Preprocessor::SourceMapping&)> onMacroExpanded;
@@ -87,6 +209,9 @@ private:
     // Métodos auxiliares privados
     bool initializeComponents();
     void setupErrorIntegration();
+    void attachLexer(const std::string& code, const std::string& filename);
+    bool processFilePipelined(const std::string& filename);
+    bool processFileFallback(const std::string& filename);
     void buildIntegratedTokens();
     IntegratedToken createIntegratedToken(const Lexer::Token& token, size_t position);
     Preprocessor::SourceMapping findMappingForPosition(size_t line, size_t column) const;
@@ -1,10 +1,14 @@
 #include "preprocessor/include/preprocessor.hpp"
 #include "preprocessor/include/preprocessor_lexer_interface.hpp"
+#include "preprocessor/include/preprocessor_server.hpp"
+#include "preprocessor/include/batch_preprocessor.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <iomanip>
 #include <cstdlib>
+#include <filesystem>
+#include <algorithm>
 #include <sys/stat.h>
 
 #ifdef _WIN32
@@ -65,9 +69,160 @@ std::vector<std::string> getSystemIncludePaths() {
     return paths;
 }
 
+// Modo servidor: mantém os caches aquecidos entre invocações
+int runServer(const std::string& socket_path) {
+    Preprocessor::ServerOptions options;
+    options.socket_path = socket_path;
+    for (const auto& path : getSystemIncludePaths()) {
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+            options.include_paths.push_back(path);
+        }
+    }
+    options.include_paths.push_back(".");
+    
+    Preprocessor::PreprocessorServer server(options);
+    if (!server.start()) {
+        std::cerr << "[ERRO] Não foi possível escutar em " << socket_path << std::endl;
+        return 1;
+    }
+    std::cerr << "[INFO] Servidor escutando em " << socket_path << std::endl;
+    server.serve();
+    std::cerr << "[INFO] Servidor encerrado após " << server.getRequestCount() << " requisições" << std::endl;
+    return 0;
+}
+
+// Modo cliente: envia uma requisição a um servidor em execução
+int runClient(const std::string& socket_path, Preprocessor::ServerRequest request) {
+    if (!request.filename.empty()) {
+        request.filename = std::filesystem::absolute(request.filename).string();
+    }
+    
+    Preprocessor::ServerResponse response;
+    if (!Preprocessor::sendServerRequest(socket_path, request, response)) {
+        std::cerr << "[ERRO] Servidor indisponível em " << socket_path << std::endl;
+        return 1;
+    }
+    if (!response.success) {
+        std::cerr << "[ERRO] " << response.message << std::endl;
+        return 1;
+    }
+    
+    std::cout << response.expanded_code;
+    if (!response.message.empty()) {
+        std::cout << response.message << std::endl;
+    }
+    return 0;
+}
+
+// Lê um argumento -DNOME[=valor]
+bool parseDefine(const std::string& define, std::pair<std::string, std::string>& macro) {
+    if (define.rfind("-D", 0) != 0 || define.size() < 3) {
+        std::cerr << "[ERRO] Argumento inválido: " << define << std::endl;
+        return false;
+    }
+    size_t equals = define.find('=');
+    if (equals == std::string::npos) {
+        macro = {define.substr(2), "1"};
+    } else {
+        macro = {define.substr(2, equals - 2), define.substr(equals + 1)};
+    }
+    return true;
+}
+
+// Modo incremental: reprocessa apenas as unidades cujas entradas mudaram
+int runIncremental(const std::string& directory, const std::string& output_directory,
+                   const std::vector<std::pair<std::string, std::string>>& macros) {
+    std::vector<std::string> files;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, error);
+         !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (it->is_regular_file() && it->path().extension() == ".c") {
+            files.push_back(it->path().string());
+        }
+    }
+    if (error) {
+        std::cerr << "[ERRO] Não foi possível listar " << directory << ": " << error.message() << std::endl;
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+    
+    Preprocessor::BatchOptions options;
+    options.output_directory = output_directory;
+    options.source_root = directory;
+    options.dependency_graph_file = (std::filesystem::path(output_directory) / ".ppdeps").string();
+    for (const auto& path : getSystemIncludePaths()) {
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+            options.include_paths.push_back(path);
+        }
+    }
+    options.include_paths.push_back(".");
+    for (const auto& macro : macros) {
+        options.macros[macro.first] = macro.second;
+    }
+    
+    std::filesystem::create_directories(output_directory, error);
+    Preprocessor::BatchPreprocessor batch(options);
+    size_t reprocessed = 0, up_to_date = 0, failed = 0;
+    for (const auto& result : batch.process(files)) {
+        if (!result.success) {
+            failed++;
+            std::cerr << "[ERRO] Falha ao pré-processar " << result.filename
+                      << (result.error.empty() ? "" : ": " + result.error) << std::endl;
+        } else if (result.up_to_date) {
+            up_to_date++;
+        } else {
+            reprocessed++;
+        }
+    }
+    
+    std::cout << files.size() << " unidades: " << reprocessed << " reprocessadas, "
+              << up_to_date << " atualizadas, " << failed << " com falha" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
+    const std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--incremental" && argc >= 4) {
+        std::vector<std::pair<std::string, std::string>> macros;
+        for (int i = 4; i < argc; ++i) {
+            std::pair<std::string, std::string> macro;
+            if (!parseDefine(argv[i], macro)) {
+                return 1;
+            }
+            macros.push_back(macro);
+        }
+        return runIncremental(argv[2], argv[3], macros);
+    }
+    if (mode == "--server" && argc == 3) {
+        return runServer(argv[2]);
+    }
+    if ((mode == "--client" && argc >= 4) || ((mode == "--stats" || mode == "--stop") && argc == 3)) {
+        Preprocessor::ServerRequest request;
+        if (mode == "--stats") {
+            request.type = Preprocessor::ServerRequestType::STATISTICS;
+        } else if (mode == "--stop") {
+            request.type = Preprocessor::ServerRequestType::SHUTDOWN;
+        } else {
+            request.filename = argv[3];
+            for (int i = 4; i < argc; ++i) {
+                std::pair<std::string, std::string> macro;
+                if (!parseDefine(argv[i], macro)) {
+                    return 1;
+                }
+                request.macros.push_back(macro);
+            }
+        }
+        return runClient(argv[2], request);
+    }
+    
     if (argc != 2) {
         std::cerr << "Uso: " << argv[0] << " <arquivo.c>" << std::endl;
+        std::cerr << "     " << argv[0] << " --server <socket>" << std::endl;
+        std::cerr << "     " << argv[0] << " --client <socket> <arquivo.c> [-DNOME[=valor]]..." << std::endl;
+        std::cerr << "     " << argv[0] << " --stats <socket> | --stop <socket>" << std::endl;
+        std::cerr << "     " << argv[0] << " --incremental <diretório> <saída> [-DNOME[=valor]]..." << std::endl;
         return 1;
     }
 
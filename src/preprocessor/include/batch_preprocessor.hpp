@@ -0,0 +1,120 @@
+#ifndef BATCH_PREPROCESSOR_HPP
+#define BATCH_PREPROCESSOR_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "preprocessor.hpp"
+#include "dependency_graph.hpp"
+
+namespace Preprocessor {
+
+/**
+ * @brief Opções de um lote de unidades de tradução
+ */
+struct BatchOptions {
+    size_t worker_count = 0;                                  ///< Threads de trabalho (0 = núcleos disponíveis)
+    std::string config_file;                                  ///< Arquivo de configuração de cada instância
+    std::vector<std::string> include_paths;                   ///< Caminhos de busca (vazio = padrão do PreprocessorMain)
+    std::unordered_map<std::string, std::string> macros;      ///< Macros definidas em todas as unidades
+    ProcessingProfile profile = ProcessingProfile::CHECKED;   ///< Perfil de desempenho
+    std::string output_directory;                             ///< Grava <unidade>.i e <unidade>.d (vazio = só em memória)
+    std::string source_root;                                  ///< Saídas espelham o caminho relativo a esta raiz (vazio = diretório atual)
+    std::string dependency_graph_file;                        ///< Grafo persistido; exige output_directory
+    bool follow_system_includes = false;                      ///< Inclui cabeçalhos <> no grafo e nos .d
+};
+
+/**
+ * @brief Resultado do pré-processamento de uma unidade de tradução
+ */
+struct BatchUnitResult {
+    std::string filename;                    ///< Arquivo de entrada
+    bool success = false;                    ///< process() concluiu sem erros
+    std::string expanded_code;               ///< Código expandido
+    std::vector<std::string> dependencies;   ///< Arquivos lidos pela unidade
+    bool up_to_date = false;                 ///< Saída anterior reaproveitada (expanded_code fica vazio)
+    std::string output_file;                 ///< Saída gravada (.i), com output_directory
+    std::string depfile;                     ///< Regra de Make gravada (.d), com output_directory
+    std::string error;                       ///< Motivo da falha, quando não vem do logger da instância
+};
+
+/**
+ * @brief Pré-processa várias unidades de tradução em paralelo
+ * 
+ * Cada unidade tem seu próprio PreprocessorMain (macros e estado condicional
+ * são por unidade), mas todas compartilham um único FileManager: arquivos,
+ * hashes e resoluções de inclusão lidos por uma thread servem às demais e
+ * permanecem em cache entre chamadas de process().
+ * 
+ * Com output_directory, cada unidade grava sua saída e um arquivo .d com o
+ * arquivo principal e os cabeçalhos incluídos. Com dependency_graph_file, o
+ * grafo de dependências da execução anterior é consultado e apenas as
+ * unidades cujas entradas (transitivas), macros consumidas ou configuração
+ * mudaram são reprocessadas. Se duas unidades forem mapeadas para a mesma
+ * saída, o lote inteiro falha sem processar nenhuma delas.
+ */
+class BatchPreprocessor {
+public:
+    /**
+     * @brief Cria o lote e o FileManager compartilhado
+     * @param options Opções aplicadas a todas as unidades
+     */
+    explicit BatchPreprocessor(BatchOptions options = BatchOptions());
+    
+    /**
+     * @brief Pré-processa os arquivos
+     * @param files Unidades de tradução
+     * @return Um resultado por arquivo, na ordem de entrada
+     */
+    std::vector<BatchUnitResult> process(const std::vector<std::string>& files);
+    
+    /**
+     * @brief FileManager compartilhado pelas unidades
+     */
+    const std::shared_ptr<FileManager>& getFileManager() const { return file_manager_; }
+    
+    /**
+     * @brief Número de threads usadas por process()
+     */
+    size_t getWorkerCount() const { return worker_count_; }
+
+private:
+    /**
+     * @brief Pré-processa uma unidade com uma instância própria de PreprocessorMain
+     * @param filename Arquivo de entrada
+     * @param graph Grafo da execução anterior (nullptr = processar sempre)
+     * @param configuration Impressão da configuração do lote
+     * @param result Recebe o resultado
+     * @param record Recebe o registro de dependências, se a unidade foi processada
+     */
+    void processUnit(const std::string& filename, const DependencyGraph* graph, uint64_t configuration,
+                     BatchUnitResult& result, DependencyRecord& record) const;
+    
+    /**
+     * @brief Impressão da configuração que afeta todas as unidades
+     * 
+     * Cobre caminhos de busca, perfil, versão do formato e o conteúdo do
+     * arquivo de configuração.
+     */
+    uint64_t configurationFingerprint() const;
+    
+    /**
+     * @brief Caminho de saída de uma unidade dentro de output_directory
+     * 
+     * Unidades dentro de source_root espelham o caminho relativo a ela; as
+     * demais usam o caminho absoluto normalizado (sem a barra inicial), de
+     * modo que arquivos homônimos em diretórios diferentes nunca colidem.
+     * @param filename Arquivo de entrada
+     * @param extension Extensão da saída (".i" ou ".d")
+     */
+    std::string outputPath(const std::string& filename, const char* extension) const;
+    
+    BatchOptions options_;
+    std::shared_ptr<FileManager> file_manager_;
+    size_t worker_count_;
+};
+
+} // namespace Preprocessor
+
+#endif // BATCH_PREPROCESSOR_HPP
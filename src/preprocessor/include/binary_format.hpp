@@ -0,0 +1,258 @@
+#ifndef BINARY_FORMAT_HPP
+#define BINARY_FORMAT_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include "macro_processor.hpp"
+#include "content_hash.hpp"
+
+namespace Preprocessor {
+
+/**
+ * @brief Codificação binária compacta usada pelos arquivos persistidos do pré-processador
+ *
+ * Inteiros little-endian de tamanho fixo e strings prefixadas pelo tamanho.
+ * Compartilhada por snapshots de macros e pelo cache de saída.
+ */
+namespace BinaryFormat {
+
+inline void putU8(std::string& out, uint8_t value) {
+    out.push_back(static_cast<char>(value));
+}
+
+inline void putU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+inline void putU64(std::string& out, uint64_t value) {
+    putU32(out, static_cast<uint32_t>(value));
+    putU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+inline void putString(std::string& out, const std::string& value) {
+    putU32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+/**
+ * @brief Checksum do conteúdo (XXH64), também usado como chave de conteúdo
+ * @param seed Permite derivar hashes independentes do mesmo conteúdo
+ */
+inline uint64_t checksum(const char* data, size_t size, uint64_t seed = 0) {
+    return ContentHash::compute(data, size, seed);
+}
+
+/**
+ * @brief Leitor com verificação de limites; após o primeiro erro todas as leituras falham
+ */
+class Reader {
+public:
+    Reader(const char* data, size_t size) : cursor_(data), end_(data + size), ok_(true) {}
+
+    uint8_t u8() {
+        if (!require(1)) return 0;
+        return static_cast<uint8_t>(*cursor_++);
+    }
+
+    uint32_t u32() {
+        if (!require(4)) return 0;
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(static_cast<unsigned char>(cursor_[i])) << (8 * i);
+        }
+        cursor_ += 4;
+        return value;
+    }
+
+    uint64_t u64() {
+        uint64_t low = u32();
+        uint64_t high = u32();
+        return low | (high << 32);
+    }
+
+    std::string str() {
+        uint32_t size = u32();
+        if (!require(size)) return std::string();
+        std::string value(cursor_, size);
+        cursor_ += size;
+        return value;
+    }
+
+    size_t remaining() const { return static_cast<size_t>(end_ - cursor_); }
+    bool good() const { return ok_; }
+    bool atEnd() const { return cursor_ == end_; }
+
+private:
+    bool require(size_t bytes) {
+        if (!ok_ || static_cast<size_t>(end_ - cursor_) < bytes) {
+            ok_ = false;
+        }
+        return ok_;
+    }
+
+    const char* cursor_;
+    const char* end_;
+    bool ok_;
+};
+
+inline void putMacro(std::string& out, const MacroInfo& info) {
+    putString(out, info.name);
+    putString(out, info.value);
+    putU8(out, static_cast<uint8_t>(info.type));
+    putU8(out, info.isVariadic ? 1 : 0);
+    putU32(out, static_cast<uint32_t>(info.parameters.size()));
+    for (const auto& parameter : info.parameters) {
+        putString(out, parameter);
+    }
+    putString(out, info.definedAt.filename);
+    putU32(out, static_cast<uint32_t>(info.definedAt.line));
+    putU32(out, static_cast<uint32_t>(info.definedAt.column));
+}
+
+/**
+ * @brief Lê uma macro gravada por putMacro()
+ * @return false se os dados estão truncados ou o tipo é inválido
+ */
+inline bool readMacro(Reader& reader, MacroInfo& info) {
+    info.name = reader.str();
+    info.value = reader.str();
+    uint8_t type = reader.u8();
+    if (type > static_cast<uint8_t>(MacroType::VARIADIC)) {
+        return false;
+    }
+    info.type = static_cast<MacroType>(type);
+    info.isVariadic = reader.u8() != 0;
+    uint32_t parameter_count = reader.u32();
+    if (parameter_count > reader.remaining()) {
+        return false;
+    }
+    info.parameters.clear();
+    for (uint32_t i = 0; i < parameter_count && reader.good(); ++i) {
+        info.parameters.push_back(reader.str());
+    }
+    std::string filename = reader.str();
+    int line = static_cast<int>(reader.u32());
+    int column = static_cast<int>(reader.u32());
+    info.definedAt = PreprocessorPosition(filename, line, column);
+    info.isPredefined = false;
+    return reader.good();
+}
+
+/**
+ * @brief Resultado da abertura de um arquivo com cabeçalho e checksum
+ */
+enum class EnvelopeStatus {
+    OK,
+    BAD_MAGIC,      ///< Não é um arquivo deste tipo (ou está truncado)
+    BAD_VERSION,    ///< Versão de formato incompatível
+    BAD_CHECKSUM    ///< Conteúdo corrompido
+};
+
+/**
+ * @brief Monta o arquivo: magic (4 bytes), versão do formato, payload e checksum
+ */
+inline std::string seal(const char (&magic)[4], uint32_t version, const std::string& payload) {
+    std::string data(magic, sizeof(magic));
+    data.reserve(sizeof(magic) + 4 + payload.size() + 8);
+    putU32(data, version);
+    data += payload;
+    putU64(data, checksum(payload.data(), payload.size()));
+    return data;
+}
+
+/**
+ * @brief Valida o cabeçalho e o checksum de um arquivo montado por seal()
+ * @param payload Recebe o início do payload (aponta para dentro de data)
+ * @param payload_size Recebe o tamanho do payload
+ */
+inline EnvelopeStatus unseal(const char* data, size_t size, const char (&magic)[4], uint32_t version,
+                             const char*& payload, size_t& payload_size) {
+    const size_t header_size = sizeof(magic) + 4;
+    if (size < header_size + 8 || std::memcmp(data, magic, sizeof(magic)) != 0) {
+        return EnvelopeStatus::BAD_MAGIC;
+    }
+    Reader header(data + sizeof(magic), 4);
+    if (header.u32() != version) {
+        return EnvelopeStatus::BAD_VERSION;
+    }
+    payload = data + header_size;
+    payload_size = size - header_size - 8;
+    Reader trailer(payload + payload_size, 8);
+    if (trailer.u64() != checksum(payload, payload_size)) {
+        return EnvelopeStatus::BAD_CHECKSUM;
+    }
+    return EnvelopeStatus::OK;
+}
+
+/**
+ * @brief Cria um arquivo temporário exclusivo no diretório de destino
+ *
+ * O nome combina pid e um contador do processo, e o arquivo é criado com
+ * O_EXCL: escritores concorrentes do mesmo destino nunca compartilham o
+ * temporário, e um arquivo existente do usuário nunca é truncado.
+ * @return Caminho do arquivo criado (vazio em caso de falha)
+ */
+inline std::string createTempFile(const std::string& path) {
+    static std::atomic<uint64_t> counter{0};
+    const size_t slash = path.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    const std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        std::string temp_path = dir + "." + name + "." + std::to_string(getpid()) + "-" +
+                                std::to_string(counter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+        int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fd >= 0) {
+            ::close(fd);
+            return temp_path;
+        }
+        if (errno != EEXIST) {
+            break;
+        }
+    }
+    return std::string();
+}
+
+/**
+ * @brief Grava em arquivo temporário e renomeia, para nunca deixar um arquivo parcial
+ * @return false se a gravação ou a renomeação falhar
+ */
+inline bool writeFileAtomically(const std::string& path, const std::string& data) {
+    const std::string temp_path = createTempFile(path);
+    if (temp_path.empty()) {
+        return false;
+    }
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out.good()) {
+            out.close();
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace BinaryFormat
+
+} // namespace Preprocessor
+
+#endif // BINARY_FORMAT_HPP
@@ -0,0 +1,128 @@
+#ifndef BLOCK_CODEC_HPP
+#define BLOCK_CODEC_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include "content_hash.hpp"
+
+namespace Preprocessor {
+
+/**
+ * @brief Compressor de blocos da família LZ4, sem dependências externas
+ *
+ * Cada bloco (até BLOCK_SIZE bytes) é codificado como sequências de literais
+ * e referências (deslocamento de 16 bits, comprimento mínimo 4) no formato de
+ * bloco do LZ4. Os blocos formam um quadro: magic, tamanho de bloco, blocos
+ * prefixados pelo tamanho (blocos que não encolhem são gravados sem
+ * compressão) e um marcador final com o XXH64 do conteúdo. Um quadro pode ser
+ * produzido e consumido em partes com Encoder e Decoder, sem manter o
+ * conteúdo inteiro em memória.
+ */
+class BlockCodec {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    /**
+     * @brief Maior tamanho possível de um bloco comprimido
+     */
+    static size_t compressBound(size_t size) { return size + size / 255 + 16; }
+
+    /**
+     * @brief Comprime um bloco
+     * @param source Dados de entrada (no máximo BLOCK_SIZE bytes)
+     * @param size Quantidade de bytes
+     * @param destination Saída com pelo menos compressBound(size) bytes
+     * @return Tamanho comprimido
+     */
+    static size_t compressBlock(const char* source, size_t size, char* destination);
+
+    /**
+     * @brief Descomprime um bloco, verificando todos os limites
+     * @param source Bloco comprimido
+     * @param size Tamanho do bloco comprimido
+     * @param destination Saída
+     * @param capacity Capacidade da saída
+     * @param written Recebe a quantidade de bytes produzida
+     * @return false se o bloco é inválido ou não cabe na saída
+     */
+    static bool decompressBlock(const char* source, size_t size, char* destination,
+                                size_t capacity, size_t& written);
+
+    /**
+     * @brief Comprime um conteúdo inteiro em um quadro
+     */
+    static std::string compress(const char* data, size_t size);
+    static std::string compress(const std::string& data) { return compress(data.data(), data.size()); }
+
+    /**
+     * @brief Descomprime um quadro produzido por compress() ou Encoder
+     * @param output Recebe o conteúdo original
+     * @return false se o quadro está truncado, corrompido ou falha no checksum
+     */
+    static bool decompress(const char* data, size_t size, std::string& output);
+
+    /**
+     * @brief Indica se os dados começam com o cabeçalho de um quadro
+     */
+    static bool isFrame(const char* data, size_t size);
+
+    /**
+     * @brief Produz um quadro em partes sobre um fluxo de saída
+     *
+     * Os dados são acumulados até completar um bloco; finish() grava o bloco
+     * pendente e o marcador final.
+     */
+    class Encoder {
+    public:
+        explicit Encoder(std::ostream& output);
+
+        void write(const char* data, size_t size);
+        bool finish();
+
+    private:
+        void flushBlock();
+
+        std::ostream& output_;
+        std::string pending_;
+        std::string compressed_;
+        ContentHash hash_;
+        bool finished_;
+    };
+
+    /**
+     * @brief Consome um quadro em partes a partir de um fluxo de entrada
+     */
+    class Decoder {
+    public:
+        explicit Decoder(std::istream& input);
+
+        /**
+         * @brief Lê o próximo bloco
+         * @param block Recebe o conteúdo do bloco
+         * @return false ao fim do quadro ou em erro (ver failed())
+         */
+        bool next(std::string& block);
+
+        /**
+         * @brief Indica se o quadro era inválido ou estava corrompido
+         */
+        bool failed() const { return failed_; }
+
+    private:
+        bool fail();
+
+        std::istream& input_;
+        std::string compressed_;
+        ContentHash hash_;
+        bool started_;
+        bool done_;
+        bool failed_;
+    };
+};
+
+} // namespace Preprocessor
+
+#endif // BLOCK_CODEC_HPP
@@ -0,0 +1,66 @@
+#ifndef CONTENT_HASH_HPP
+#define CONTENT_HASH_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace Preprocessor {
+
+/**
+ * @brief Hash de conteúdo de 64 bits, rápido e não criptográfico (algoritmo XXH64)
+ *
+ * Pode ser alimentado em partes com update(); o resultado é idêntico ao de
+ * compute() sobre o conteúdo concatenado. Usado como chave dos caches e na
+ * verificação de integridade de arquivos, nunca para fins de segurança.
+ */
+class ContentHash {
+public:
+    explicit ContentHash(uint64_t seed = 0);
+
+    /**
+     * @brief Acrescenta dados ao hash
+     * @param data Início dos dados
+     * @param size Quantidade de bytes
+     */
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief Hash dos dados acumulados até aqui (não altera o estado)
+     */
+    uint64_t digest() const;
+
+    /**
+     * @brief Calcula o hash de um bloco de memória em uma única chamada
+     */
+    static uint64_t compute(const void* data, size_t size, uint64_t seed = 0);
+
+    /**
+     * @brief Calcula o hash do conteúdo de um arquivo
+     *
+     * O arquivo é mapeado em memória e percorrido sequencialmente; se o
+     * mapeamento não for possível é lido em blocos.
+     * @param path Caminho do arquivo
+     * @param hash Recebe o hash
+     * @return false se o arquivo não pode ser lido
+     */
+    static bool computeFile(const std::string& path, uint64_t& hash);
+
+    /**
+     * @brief Representação hexadecimal com 16 dígitos
+     */
+    static std::string toHex(uint64_t hash);
+
+private:
+    void consumeStripe(const unsigned char* stripe);
+
+    uint64_t seed_;
+    uint64_t accumulators_[4];
+    unsigned char buffer_[32];
+    size_t buffered_;
+    uint64_t total_length_;
+};
+
+} // namespace Preprocessor
+
+#endif // CONTENT_HASH_HPP
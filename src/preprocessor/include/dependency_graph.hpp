@@ -0,0 +1,145 @@
+#ifndef DEPENDENCY_GRAPH_HPP
+#define DEPENDENCY_GRAPH_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Preprocessor {
+
+class FileManager;
+
+/**
+ * @brief Arquivo lido por uma unidade, com identidade e hash do conteúdo
+ *
+ * Tamanho e data de modificação evitam recalcular o hash de arquivos não
+ * tocados; o hash decide quando eles mudam. modified_ns negativo indica que o
+ * arquivo mudou durante a leitura e o hash é sempre recalculado.
+ */
+struct DependencyInput {
+    std::string path;
+    uint64_t content_hash = 0;
+    uint64_t size = 0;
+    int64_t modified_ns = 0;
+};
+
+/**
+ * @brief Entradas de uma unidade de tradução registradas no grafo
+ */
+struct DependencyRecord {
+    std::string translation_unit;                               ///< Arquivo principal
+    uint64_t configuration = 0;                                 ///< Impressão da configuração (caminhos, perfil, versão)
+    std::string output_file;                                    ///< Saída gerada (.i)
+    std::vector<DependencyInput> inputs;                        ///< Arquivo principal e inclusões transitivas
+    std::vector<std::string> known_macros;                      ///< Macros de linha de comando existentes na execução
+    std::vector<std::pair<std::string, std::string>> consumed_macros; ///< Macros de linha de comando citadas pelas entradas
+    std::vector<std::string> absent_paths;                      ///< Candidatos de inclusão inexistentes (dependências negativas)
+};
+
+/**
+ * @brief Grafo de dependências persistido entre execuções
+ *
+ * Para cada unidade de tradução guarda o hash de cada arquivo lido
+ * (transitivamente, pelas diretivas #include), as macros de linha de comando
+ * que as entradas citam, a configuração usada e os candidatos de inclusão
+ * que não existiam (um cabeçalho criado depois pode ser encontrado ou passar
+ * a ter precedência). Uma unidade está atualizada se nada disso mudou e sua
+ * saída ainda existe; nesse caso não precisa ser reprocessada. Gravado com
+ * BinaryFormat (magic, versão e checksum).
+ */
+class DependencyGraph {
+public:
+    /**
+     * @brief Carrega um grafo gravado por save()
+     * @param path Arquivo do grafo
+     * @return false se o arquivo não existe ou é inválido (o grafo fica vazio)
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Grava o grafo (gravação atômica)
+     * @param path Arquivo do grafo
+     * @return false se a gravação falhar
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Registro de uma unidade
+     * @return nullptr se a unidade não está no grafo
+     */
+    const DependencyRecord* find(const std::string& translation_unit) const;
+
+    /**
+     * @brief Insere ou substitui o registro de uma unidade
+     */
+    void update(DependencyRecord record);
+
+    /**
+     * @brief Remove o registro de uma unidade (ex.: após falha no processamento)
+     */
+    void remove(const std::string& translation_unit);
+
+    /**
+     * @brief Número de unidades registradas
+     */
+    size_t size() const { return records_.size(); }
+
+    /**
+     * @brief Verifica se uma unidade pode reaproveitar a saída anterior
+     *
+     * Compara a configuração, cada entrada (tamanho e data; o hash só quando
+     * o arquivo foi tocado), os valores das macros consumidas, a presença de
+     * macros novas que as entradas possam citar e a ausência dos candidatos
+     * de inclusão registrados.
+     * Seguro para chamadas concorrentes (somente leitura).
+     * @param record Registro da execução anterior
+     * @param configuration Impressão da configuração atual
+     * @param macros Macros de linha de comando atuais
+     * @param files FileManager usado para os hashes das entradas tocadas
+     */
+    static bool isUpToDate(const DependencyRecord& record, uint64_t configuration,
+                           const std::unordered_map<std::string, std::string>& macros,
+                           const FileManager& files);
+
+    /**
+     * @brief Monta o registro de uma unidade, antes de processá-la
+     *
+     * Segue as diretivas #include do arquivo principal e dos cabeçalhos
+     * encontrados (inclusive em blocos condicionais, de forma conservadora);
+     * inclusões de sistema só são seguidas com follow_system. Cada entrada é
+     * identificada (stat) antes de ser lida e o hash é o dos bytes lidos pelo
+     * FileManager, os mesmos que o processamento recebe do cache; se o arquivo
+     * mudar depois, o registro fica com a versão anterior e a próxima execução
+     * reprocessa. Os candidatos sondados antes do destino de cada inclusão (ou
+     * todos, se ela não foi resolvida) viram dependências negativas.
+     * @param translation_unit Arquivo principal
+     * @param configuration Impressão da configuração atual
+     * @param macros Macros de linha de comando atuais
+     * @param files FileManager para leitura, resolução e hashes
+     * @param follow_system Seguir inclusões com <>
+     * @param record Recebe o registro
+     * @return false se o arquivo principal não pôde ser lido
+     */
+    static bool buildRecord(const std::string& translation_unit, uint64_t configuration,
+                            const std::unordered_map<std::string, std::string>& macros,
+                            FileManager& files, bool follow_system, DependencyRecord& record);
+
+    /**
+     * @brief Regra no formato de Make para as entradas de um registro
+     *
+     * Inclui um alvo vazio para cada cabeçalho, para que a remoção de um
+     * cabeçalho não quebre o make (como -MP).
+     * @param target Alvo da regra
+     * @param record Registro da unidade
+     */
+    static std::string makeDepfile(const std::string& target, const DependencyRecord& record);
+
+private:
+    std::unordered_map<std::string, DependencyRecord> records_;
+};
+
+} // namespace Preprocessor
+
+#endif // DEPENDENCY_GRAPH_HPP
@@ -89,7 +89,7 @@ public:
      * @brief Retorna os argumentos da diretiva
      * @return Vetor com argumentos da diretiva
      */
-    std::vector<std::string> getArguments() const { return arguments_; }
+    const std::vector<std::string>& getArguments() const { return arguments_; }
     
     /**
      * @brief Verifica se a diretiva é válida
@@ -123,6 +123,12 @@ public:
      */
     void setArguments(const std::vector<std::string>& args);
     
+    /**
+     * @brief Define os argumentos da diretiva, assumindo o vetor
+     * @param args Vetor com argumentos (movido)
+     */
+    void setArguments(std::vector<std::string>&& args);
+    
     /**
      * @brief Marca a diretiva como válida ou inválida
      * @param valid Flag de validade
@@ -401,6 +407,28 @@ public:
      */
     std::string normalizeDirectiveLine(const std::string& line);
     
+    /**
+     * @brief Versão sem cópia de extractDirectiveName()
+     * @param line Linha contendo a diretiva
+     * @return Visão do nome sobre a linha (vazia se não houver)
+     */
+    std::string_view scanDirectiveName(std::string_view line) const;
+    
+    /**
+     * @brief Versão sem cópia de extractDirectiveArguments()
+     * @param line Linha contendo a diretiva
+     * @param directive_name Nome devolvido por scanDirectiveName()
+     * @return Visão dos argumentos sobre a linha, sem comentários e espaços finais
+     */
+    std::string_view scanDirectiveArguments(std::string_view line, std::string_view directive_name) const;
+    
+    /**
+     * @brief Verifica se normalizeDirectiveLine() devolveria a própria linha
+     * @param line Linha a verificar
+     * @return true se a linha não tem comentário de linha, tabulações nem espaços repetidos ou finais
+     */
+    static bool isNormalizedDirectiveLine(std::string_view line);
+    
     /**
      * @brief Atualiza estatísticas de diretiva
      * @param type Tipo da diretiva
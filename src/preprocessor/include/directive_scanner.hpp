@@ -0,0 +1,78 @@
+#ifndef DIRECTIVE_SCANNER_HPP
+#define DIRECTIVE_SCANNER_HPP
+
+#include <string_view>
+#include <cctype>
+#include "directive.hpp"
+
+namespace Preprocessor {
+
+/**
+ * @brief Resultado da leitura de uma linha de diretiva
+ *
+ * Todas as partes são visões sobre a linha original; nada é copiado.
+ */
+struct DirectiveScan {
+    DirectiveType type = DirectiveType::UNKNOWN;
+    std::string_view name;       ///< Nome da diretiva como escrito (sequência de [A-Za-z0-9_])
+    std::string_view arguments;  ///< Restante da linha após o nome, sem espaços iniciais
+    bool is_directive = false;   ///< A linha começa (após espaços) com '#'
+};
+
+/**
+ * @brief Identifica o nome de uma diretiva
+ *
+ * Usa uma tabela de hash perfeito sobre (tamanho, primeiro e último caractere)
+ * seguida de uma única comparação; não diferencia maiúsculas de minúsculas.
+ *
+ * @param name Nome sem o '#'
+ * @return Tipo da diretiva ou UNKNOWN
+ */
+DirectiveType lookupDirectiveType(std::string_view name);
+
+/**
+ * @brief Lê o '#', o nome e o início dos argumentos de uma linha
+ * @param line Linha completa
+ * @param scan Recebe as visões; scan.type é UNKNOWN se não houver nome reconhecido
+ * @return true se a linha é uma diretiva com nome não vazio
+ */
+bool scanDirective(std::string_view line, DirectiveScan& scan);
+
+/**
+ * @brief Corta os argumentos no primeiro comentário e remove espaços finais
+ * @param arguments Argumentos da diretiva
+ * @return Visão sem comentário de linha ou de bloco
+ */
+std::string_view stripDirectiveComment(std::string_view arguments);
+
+/**
+ * @brief Remove espaços (e quebras de linha) no final de uma visão
+ */
+std::string_view trimTrailingSpace(std::string_view text);
+
+/**
+ * @brief Percorre as palavras separadas por espaços em branco dos argumentos
+ * @param arguments Argumentos da diretiva
+ * @param fn Chamada com cada palavra (std::string_view)
+ */
+template<typename Fn>
+void forEachDirectiveWord(std::string_view arguments, Fn&& fn) {
+    size_t pos = 0;
+    const size_t size = arguments.size();
+    while (pos < size) {
+        while (pos < size && std::isspace(static_cast<unsigned char>(arguments[pos]))) {
+            pos++;
+        }
+        size_t start = pos;
+        while (pos < size && !std::isspace(static_cast<unsigned char>(arguments[pos]))) {
+            pos++;
+        }
+        if (pos > start) {
+            fn(arguments.substr(start, pos - start));
+        }
+    }
+}
+
+} // namespace Preprocessor
+
+#endif // DIRECTIVE_SCANNER_HPP
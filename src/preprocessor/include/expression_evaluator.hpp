@@ -9,6 +9,7 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <cstdint>
 #include "preprocessor_types.hpp"
 #include "preprocessor_logger.hpp"
 
@@ -89,6 +90,51 @@ enum class OperatorType {
     DEFINED_OP       // defined()
 };
 
+/**
+ * @brief Códigos de operação do programa compilado de uma expressão
+ */
+enum class ExpressionOpCode : uint8_t {
+    PUSH_CONSTANT,   // Empilha literal numérico
+    PUSH_IDENTIFIER, // Empilha valor atual do identificador (0 se indefinido)
+    PUSH_DEFINED,    // Empilha defined(nome)
+    UNARY,           // Aplica operador unário ao topo
+    BINARY,          // Aplica operador binário aos dois valores do topo
+    BINARY_UNKNOWN   // Operador binário sem semântica definida (resultado 0)
+};
+
+/**
+ * @brief Instrução do programa compilado (notação pós-fixa)
+ */
+struct ExpressionInstruction {
+    ExpressionOpCode opcode;
+    OperatorType op;         // Para UNARY/BINARY
+    uint32_t nameIndex;      // Para PUSH_IDENTIFIER/PUSH_DEFINED
+    long long value;         // Para PUSH_CONSTANT
+};
+
+/**
+ * @brief Expressão compilada, reavaliável contra os valores atuais das macros
+ */
+struct CompiledExpression {
+    std::vector<ExpressionInstruction> code;
+    std::vector<std::string> names;      // Identificadores referenciados
+    bool interpreted;                    // Forma não suportada: usa o avaliador de tokens
+    std::vector<ExpressionToken> tokens; // Tokens originais (somente se interpreted)
+    
+    CompiledExpression() : interpreted(false) {}
+};
+
+/**
+ * @brief Estatísticas dos caches de expressões
+ */
+struct ExpressionCacheStats {
+    size_t compilations;     // Expressões compiladas
+    size_t compiledHits;     // Programas compilados reutilizados
+    size_t memoHits;         // Resultados reutilizados na mesma geração de macros
+    
+    ExpressionCacheStats() : compilations(0), compiledHits(0), memoHits(0) {}
+};
+
 /**
  * @brief Classe principal do avaliador de expressões
  */
@@ -155,6 +201,19 @@ public:
      */
     std::vector<ExpressionToken> parseTokens(const std::vector<ExpressionToken>& tokens);
     
+    // Cache de expressões compiladas
+    
+    /**
+     * @brief Obtém estatísticas dos caches de expressões
+     * @return Contadores de compilação e reuso
+     */
+    ExpressionCacheStats getCacheStatistics() const;
+    
+    /**
+     * @brief Descarta programas compilados e resultados memorizados
+     */
+    void clearExpressionCache();
+    
 private:
     // Membros privados
     MacroProcessor* macroProcessor;
@@ -166,6 +225,33 @@ private:
     // Mapa de operadores para tipos
     std::unordered_map<std::string, OperatorType> operatorMap;
     
+    // Programas compilados por texto expandido e resultados por texto original
+    struct MemoizedResult {
+        uint64_t generation;
+        long long value;
+    };
+    static constexpr size_t MAX_CACHED_EXPRESSIONS = 4096;
+    std::unordered_map<std::string, CompiledExpression> compiledExpressions;
+    std::unordered_map<std::string, MemoizedResult> memoizedResults;
+    std::vector<long long> evaluationStack;
+    ExpressionCacheStats cacheStats;
+    
+    /**
+     * @brief Compila (ou obtém do cache) o programa de uma expressão expandida
+     * @param expandedExpression Expressão após expansão de macros
+     * @param pos Posição no código fonte
+     * @return Programa compilado
+     */
+    const CompiledExpression& compileExpression(const std::string& expandedExpression,
+                                                const PreprocessorPosition& pos);
+    
+    /**
+     * @brief Executa um programa compilado
+     * @param program Programa a executar
+     * @return Resultado da avaliação
+     */
+    long long runCompiledExpression(const CompiledExpression& program);
+    
     // Métodos privados de avaliação
     
     /**
@@ -7,11 +7,18 @@
 #include <unordered_set>
 #include <memory>
 #include <chrono>
+#include <cstdint>
 #include <fstream>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include "preprocessor_logger.hpp"
+#include "file_view.hpp"
 
 namespace Preprocessor {
 
+class FileWatcher;
+
 // ============================================================================
 // ESTRUTURAS DE DADOS
 // ============================================================================
@@ -28,6 +35,12 @@ struct FileStats {
     size_t circular_inclusions = 0;     // Inclusões circulares detectadas
     size_t path_resolutions = 0;        // Resoluções de caminho
     size_t dependency_updates = 0;      // Atualizações de dependência
+    size_t hashes_computed = 0;         // Hashes de conteúdo calculados
+    size_t hash_memo_hits = 0;          // Hashes reaproveitados (arquivo inalterado)
+    size_t stat_cache_hits = 0;         // Consultas de existência respondidas pelo cache
+    size_t resolution_cache_hits = 0;   // Inclusões resolvidas pelo memo
+    size_t directories_listed = 0;      // Diretórios de busca listados (modo de listagem)
+    size_t change_events = 0;           // Eventos de mudança aplicados aos caches
     
     // Métodos utilitários
     double getCacheHitRatio() const {
@@ -38,30 +51,89 @@ struct FileStats {
     void reset() {
         files_read = files_cached = cache_hits = cache_misses = 0;
         total_bytes_read = circular_inclusions = path_resolutions = dependency_updates = 0;
+        hashes_computed = hash_memo_hits = 0;
+        stat_cache_hits = resolution_cache_hits = directories_listed = 0;
+        change_events = 0;
     }
 };
 
+/**
+ * @brief Contadores de FileStats atualizados por várias threads
+ */
+struct ConcurrentFileStats {
+    std::atomic<size_t> files_read{0};
+    std::atomic<size_t> files_cached{0};
+    std::atomic<size_t> cache_hits{0};
+    std::atomic<size_t> cache_misses{0};
+    std::atomic<size_t> total_bytes_read{0};
+    std::atomic<size_t> circular_inclusions{0};
+    std::atomic<size_t> path_resolutions{0};
+    std::atomic<size_t> dependency_updates{0};
+    std::atomic<size_t> hashes_computed{0};
+    std::atomic<size_t> hash_memo_hits{0};
+    std::atomic<size_t> stat_cache_hits{0};
+    std::atomic<size_t> resolution_cache_hits{0};
+    std::atomic<size_t> directories_listed{0};
+    std::atomic<size_t> change_events{0};
+    
+    // Cópia dos valores atuais (cada contador é lido isoladamente)
+    FileStats snapshot() const;
+    
+    // Substitui todos os contadores
+    void assign(const FileStats& stats);
+    
+    void reset() { assign(FileStats()); }
+};
+
 /**
  * @brief Informações de um arquivo em cache
  */
 struct CachedFile {
-    std::string content;                           // Conteúdo do arquivo
+    FileView content;                              // Conteúdo do arquivo (mapeado ou no heap)
+    bool compressed;                               // content guarda um quadro do BlockCodec
     std::chrono::system_clock::time_point timestamp; // Timestamp de cache
     std::chrono::system_clock::time_point last_modified; // Última modificação do arquivo
     size_t file_size;                             // Tamanho do arquivo
     std::string normalized_path;                  // Caminho normalizado
     std::string file_hash;                        // Hash do conteúdo para validação
+    int64_t mapped_modified_ns;                   // mtime (ns) do arquivo mapeado; -1 se não mapeado ou incerto
     bool is_system_file;                         // Se é arquivo de sistema
-    size_t access_count;                         // Contador de acessos
-    std::chrono::system_clock::time_point last_access; // Último acesso
-    
-    CachedFile() : file_size(0), is_system_file(false), access_count(0) {}
-    
-    CachedFile(const std::string& content, size_t size, bool system_file = false)
-        : content(content), timestamp(std::chrono::system_clock::now()),
-          file_size(size), is_system_file(system_file),
-          last_access(std::chrono::system_clock::now()),
-          access_count(1) {}
+    // Atualizados por leitores concorrentes (sob trava compartilhada)
+    mutable std::atomic<size_t> access_count;    // Contador de acessos
+    mutable std::atomic<std::chrono::system_clock::rep> last_access; // Último acesso (ticks do system_clock)
+    
+    CachedFile() : compressed(false), file_size(0), mapped_modified_ns(-1), is_system_file(false),
+                   access_count(0), last_access(0) {}
+    
+    CachedFile(FileView content, bool system_file = false)
+        : content(std::move(content)), compressed(false), timestamp(std::chrono::system_clock::now()),
+          file_size(this->content.size()), mapped_modified_ns(-1), is_system_file(system_file),
+          access_count(1),
+          last_access(std::chrono::system_clock::now().time_since_epoch().count()) {}
+    
+    CachedFile(const CachedFile& other)
+        : content(other.content), compressed(other.compressed), timestamp(other.timestamp),
+          last_modified(other.last_modified),
+          file_size(other.file_size), normalized_path(other.normalized_path),
+          file_hash(other.file_hash), mapped_modified_ns(other.mapped_modified_ns),
+          is_system_file(other.is_system_file),
+          access_count(other.access_count.load(std::memory_order_relaxed)),
+          last_access(other.last_access.load(std::memory_order_relaxed)) {}
+    
+    CachedFile& operator=(const CachedFile& other) {
+        content = other.content;
+        compressed = other.compressed;
+        timestamp = other.timestamp;
+        last_modified = other.last_modified;
+        file_size = other.file_size;
+        normalized_path = other.normalized_path;
+        file_hash = other.file_hash;
+        mapped_modified_ns = other.mapped_modified_ns;
+        is_system_file = other.is_system_file;
+        access_count.store(other.access_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        last_access.store(other.last_access.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
     
     // Verifica se o cache expirou (TTL)
     bool isExpired(std::chrono::seconds ttl = std::chrono::seconds(300)) const {
@@ -70,12 +142,28 @@ struct CachedFile {
     }
     
     // Atualiza estatísticas de acesso
-    void updateAccess() {
-        last_access = std::chrono::system_clock::now();
-        access_count++;
+    void updateAccess() const {
+        last_access.store(std::chrono::system_clock::now().time_since_epoch().count(),
+                          std::memory_order_relaxed);
+        access_count.fetch_add(1, std::memory_order_relaxed);
     }
 };
 
+/**
+ * @brief Hash de conteúdo memorizado pela identidade do arquivo
+ * 
+ * O hash é reaproveitado enquanto dispositivo, inode, tamanho e data de
+ * modificação não mudarem.
+ */
+struct FileHashEntry {
+    uint64_t device = 0;                    // Dispositivo (st_dev)
+    uint64_t inode = 0;                     // Inode (st_ino)
+    uint64_t size = 0;                      // Tamanho em bytes
+    int64_t mtime_ns = 0;                   // Última modificação em nanossegundos
+    uint64_t hash = 0;                      // Hash do conteúdo (XXH64)
+    bool racy = false;                      // Modificado no mesmo instante do cálculo
+};
+
 /**
  * @brief Informações de dependência de arquivo
  */
@@ -105,6 +193,12 @@ struct FileDependency {
  * - Cache de arquivos
  * - Detecção de inclusões circulares
  * - Gerenciamento de dependências
+ * 
+ * Leitura, resolução de inclusões e hashes podem ser chamados por várias
+ * threads ao mesmo tempo: os caches de conteúdo e de busca têm travas de
+ * leitura/escrita próprias e acertos usam apenas a trava compartilhada. A
+ * configuração (caminhos de busca, limites do cache, modo de listagem e
+ * observação de mudanças) deve ser feita antes de compartilhar a instância.
  */
 class FileManager {
 public:
@@ -145,6 +239,17 @@ public:
      */
     std::string readFile(const std::string& filepath);
     
+    /**
+     * @brief Obtém uma visão somente leitura do conteúdo de um arquivo
+     * 
+     * O conteúdo é mapeado em memória (ou lido para o heap, em arquivos
+     * pequenos) uma única vez e compartilhado pelo cache: chamadas seguintes
+     * para o arquivo inalterado devolvem a mesma visão, sem cópia.
+     * @param filepath Caminho do arquivo
+     * @return Visão do conteúdo; inválida se o arquivo não pode ser lido
+     */
+    FileView openFileView(const std::string& filepath);
+    
     /**
      * @brief Escreve conteúdo em um arquivo
      * @param filepath Caminho do arquivo
@@ -185,6 +290,20 @@ public:
                               bool is_system, 
                               const std::string& current_file = "");
     
+    /**
+     * @brief Caminhos que resolveInclude() sondaria, na ordem de busca
+     * 
+     * Não consulta o sistema de arquivos. Usado para registrar os candidatos
+     * anteriores ao arquivo encontrado (ou todos, se nenhum foi encontrado):
+     * se um deles passar a existir, a inclusão muda de destino.
+     * @param filename Nome do arquivo a incluir
+     * @param is_system Se é inclusão de sistema (<>) ou local ("")
+     * @param current_file Arquivo atual (para inclusões relativas)
+     */
+    std::vector<std::string> includeCandidates(const std::string& filename,
+                                               bool is_system,
+                                               const std::string& current_file = "") const;
+    
     // ========================================================================
     // GERENCIAMENTO DE CAMINHOS DE BUSCA
     // ========================================================================
@@ -229,12 +348,39 @@ public:
      */
     void clearCache();
     
+    /**
+     * @brief Limpa os caches de resolução de inclusões
+     * 
+     * Descarta os resultados de stat (inclusive os negativos) e o memo de
+     * resolveInclude. Deve ser chamado entre execuções quando arquivos de
+     * inclusão podem ter sido criados ou removidos.
+     */
+    void clearLookupCaches();
+    
+    /**
+     * @brief Ativa a resolução de inclusões por listagem de diretórios
+     * 
+     * Neste modo cada diretório de busca é listado uma única vez (na primeira
+     * consulta) e os nomes são procurados em memória; só os candidatos presentes
+     * na listagem são verificados com stat. Útil com muitos caminhos de busca,
+     * onde a maioria das sondagens falharia.
+     * 
+     * @param enabled true para listar diretórios, false para sondar com stat
+     */
+    void setDirectoryListingMode(bool enabled);
+    
+    /**
+     * @brief Verifica se o modo de listagem de diretórios está ativo
+     */
+    bool isDirectoryListingMode() const { return directory_listing_mode_; }
+    
     /**
      * @brief Configura parâmetros de cache otimizado
      * @param max_size Tamanho máximo do cache em bytes
      * @param max_entries Número máximo de entradas
      * @param ttl TTL do cache em segundos
-     * @param enable_compression Habilitar compressão
+     * @param enable_compression Guardar comprimido (BlockCodec) o conteúdo em heap
+     *        que encolhe; arquivos mapeados não ocupam heap e ficam como estão
      */
     void configureCacheOptimization(size_t max_size = 50 * 1024 * 1024, // 50MB
                                    size_t max_entries = 1000,
@@ -338,18 +484,19 @@ public:
     // ========================================================================
     
     /**
-     * @brief Comprime um arquivo
+     * @brief Comprime um arquivo em um quadro do BlockCodec, lido e gravado em blocos
      * @param filepath Caminho do arquivo original
-     * @param compressed_path Caminho do arquivo comprimido (opcional)
+     * @param compressed_path Caminho do arquivo comprimido (padrão: filepath + ".ppz")
      * @return true se a compressão foi bem-sucedida
      */
     bool compressFile(const std::string& filepath, const std::string& compressed_path = "");
     
     /**
-     * @brief Descomprime um arquivo
+     * @brief Descomprime um arquivo gravado por compressFile()
      * @param compressed_path Caminho do arquivo comprimido
-     * @param output_path Caminho do arquivo descomprimido (opcional)
-     * @return true se a descompressão foi bem-sucedida
+     * @param output_path Caminho do arquivo descomprimido (padrão: sem a extensão ".ppz";
+     *        obrigatório para outras extensões)
+     * @return true se a descompressão foi bem-sucedida (inclusive o checksum)
      */
     bool decompressFile(const std::string& compressed_path, const std::string& output_path = "");
     
@@ -360,10 +507,22 @@ public:
     /**
      * @brief Calcula hash de um arquivo
      * @param filepath Caminho do arquivo
-     * @return Hash do arquivo (SHA-256)
+     * @return Hash do arquivo (XXH64, 16 dígitos hexadecimais); vazio em caso de erro
      */
     std::string calculateFileHash(const std::string& filepath) const;
     
+    /**
+     * @brief Obtém o hash de conteúdo de 64 bits de um arquivo
+     * 
+     * Calculado sobre o arquivo mapeado em memória e memorizado por
+     * (inode, tamanho, data de modificação): enquanto o arquivo não muda, a
+     * consulta custa apenas um stat().
+     * @param filepath Caminho do arquivo
+     * @param hash Recebe o hash
+     * @return false se o arquivo não pode ser lido
+     */
+    bool getContentHash(const std::string& filepath, uint64_t& hash) const;
+    
     /**
      * @brief Verifica integridade de um arquivo
      * @param filepath Caminho do arquivo
@@ -378,11 +537,43 @@ public:
     
     /**
      * @brief Monitora mudanças em arquivos
+     * 
+     * Ativa a observação de mudanças (se ainda inativa) e observa o diretório
+     * do arquivo.
+     * 
      * @param filepath Caminho do arquivo a monitorar
      * @return true se o monitoramento foi iniciado com sucesso
      */
     bool monitorFileChanges(const std::string& filepath);
     
+    /**
+     * @brief Ativa ou desativa a invalidação de caches por notificações do sistema
+     * 
+     * Com a observação ativa (inotify), os diretórios dos arquivos em cache, os
+     * caminhos de busca e os diretórios sondados na resolução de inclusões são
+     * observados; os caches de arquivos, hashes e resoluções são invalidados
+     * pelos eventos, e os acertos de cache deixam de consultar a data de
+     * modificação do arquivo.
+     * 
+     * @param enabled true para ativar
+     * @return false se as notificações não estão disponíveis neste sistema
+     */
+    bool enableChangeWatching(bool enabled = true);
+    
+    /**
+     * @brief Verifica se a observação de mudanças está ativa
+     */
+    bool isChangeWatchingActive() const;
+    
+    /**
+     * @brief Aplica aos caches os eventos pendentes do sistema de arquivos
+     * 
+     * Chamado automaticamente por openFileView() e resolveInclude().
+     * 
+     * @return Número de eventos aplicados
+     */
+    size_t processFileSystemEvents();
+    
     /**
      * @brief Manipula eventos do sistema de arquivos
      * @param event_type Tipo do evento
@@ -406,7 +597,14 @@ private:
     std::unordered_map<std::string, FileDependency> dependencies_; // Dependências
     std::unordered_set<std::string> circular_detection_set_; // Detecção circular
     PreprocessorLogger* logger_;                         // Logger
-    mutable FileStats stats_;                           // Estatísticas
+    mutable ConcurrentFileStats stats_;                 // Estatísticas
+    
+    // Travas: cache_mutex_ protege file_cache_, file_hashes_, dependencies_,
+    // locked_files_ e monitored_files_; lookup_mutex_ protege search_paths_ e os
+    // caches de resolução. Nenhuma é mantida durante chamadas a outros métodos.
+    mutable std::shared_mutex cache_mutex_;
+    mutable std::shared_mutex lookup_mutex_;
+    mutable std::mutex watcher_mutex_;                  // Serializa o uso de watcher_
     
     // Configurações de cache otimizado
     size_t max_cache_size_;                             // Tamanho máximo do cache (bytes)
@@ -416,9 +614,18 @@ private:
     
     // Arquivos e monitoramento
     std::unordered_set<std::string> locked_files_;           // Arquivos bloqueados
-    std::unordered_map<std::string, std::string> file_hashes_; // Cache de hashes
+    mutable std::unordered_map<std::string, FileHashEntry> file_hashes_; // Cache de hashes
     std::unordered_set<std::string> monitored_files_;        // Arquivos monitorados
     
+    // Caches de resolução de inclusões (válidos durante uma execução)
+    mutable std::unordered_map<std::string, bool> stat_cache_;        // Caminho -> existe como arquivo regular
+    std::unordered_map<std::string, std::string> resolution_cache_;   // (tipo, diretório, nome) -> caminho resolvido
+    bool directory_listing_mode_;                                     // Resolve por listagem de diretórios
+    mutable std::unordered_map<std::string, std::unordered_set<std::string>> directory_listings_; // Diretório -> entradas
+    
+    // Observação de mudanças (nullptr quando inativa)
+    std::unique_ptr<FileWatcher> watcher_;
+    
     // Tratamento de erros externo
     void* external_error_handler_;                           // Manipulador de erros externo
     
@@ -435,6 +642,27 @@ private:
     std::string searchInPaths(const std::string& filename, 
                              const std::vector<std::string>& paths) const;
     
+    /**
+     * @brief Verifica a existência de um candidato de inclusão usando o cache de stat
+     * @param path Caminho candidato (diretório de busca + nome)
+     * @return true se o caminho é um arquivo regular
+     */
+    bool probeIncludeCandidate(const std::string& path) const;
+    
+    /**
+     * @brief Verifica se um diretório contém uma entrada, listando-o na primeira consulta
+     * @param directory Diretório
+     * @param name Nome da entrada (sem barras)
+     * @return true se a entrada aparece na listagem
+     */
+    bool directoryContains(const std::string& directory, const std::string& name) const;
+    
+    /**
+     * @brief Observa o diretório de um caminho (ou o ancestral existente mais próximo)
+     * @param path Arquivo ou diretório de interesse
+     */
+    void watchContainingDirectory(const std::string& path) const;
+    
     /**
      * @brief Resolve caminho relativo
      * @param filename Nome do arquivo
@@ -450,34 +678,50 @@ private:
      * @param content Conteúdo do arquivo
      * @param file_modified Timestamp de modificação do arquivo
      */
-    void cacheFile(const std::string& filepath, const std::string& content,
+    void cacheFile(const std::string& filepath, FileView content,
                    std::chrono::system_clock::time_point file_modified = std::chrono::system_clock::now());
     
     /**
      * @brief Verifica se o cache precisa ser invalidado
      * @param filepath Caminho do arquivo
+     * @param cached Entrada do cache para o arquivo
      * @return true se precisa invalidar
      */
-    bool shouldInvalidateCache(const std::string& filepath) const;
+    bool shouldInvalidateCache(const std::string& filepath, const CachedFile& cached) const;
+    
+    /**
+     * @brief Verifica se o arquivo de uma entrada mapeada mantém tamanho e mtime
+     *
+     * O mapeamento reflete o arquivo no disco: um truncamento causaria SIGBUS
+     * na leitura e uma edição no lugar mudaria o conteúdo em cache.
+     * @return true se a entrada não é mapeada ou o arquivo não mudou
+     */
+    bool mappedEntryValid(const std::string& filepath, const CachedFile& cached) const;
     
     /**
-     * @brief Remove entradas menos usadas do cache (LRU)
+     * @brief Remove entradas expiradas e, se preciso, as menos usadas (requer cache_mutex_ exclusiva)
+     */
+    void optimizeCacheLocked();
+    
+    /**
+     * @brief Remove entradas menos usadas do cache (LRU; requer cache_mutex_ exclusiva)
      * @param target_size Tamanho alvo após limpeza
      */
     void evictLeastRecentlyUsed(size_t target_size);
     
     /**
-     * @brief Calcula tamanho atual do cache em bytes
+     * @brief Calcula tamanho atual do cache em bytes (requer cache_mutex_)
      * @return Tamanho do cache
      */
     size_t getCurrentCacheSize() const;
     
     /**
      * @brief Recupera arquivo do cache
-     * @param filepath Caminho do arquivo
-     * @return Ponteiro para arquivo em cache ou nullptr
+     * @param filepath Caminho normalizado do arquivo
+     * @param view Recebe a visão compartilhada com o cache
+     * @return true se havia entrada válida
      */
-    const CachedFile* getCachedFile(const std::string& filepath) const;
+    bool getCachedFile(const std::string& filepath, FileView& view) const;
     
     /**
      * @brief Valida caminho de arquivo
@@ -0,0 +1,65 @@
+#ifndef FILE_VIEW_HPP
+#define FILE_VIEW_HPP
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstddef>
+
+namespace Preprocessor {
+
+/**
+ * @brief Visão somente leitura, com contagem de referências, do conteúdo de um arquivo
+ *
+ * Arquivos maiores que uma página são mapeados em memória; os menores (ou
+ * quando o mapeamento falha) são lidos para um buffer no heap. Cópias da visão
+ * compartilham o mesmo conteúdo, que é liberado quando a última cópia é
+ * destruída. O conteúdo não deve ser truncado enquanto houver visões mapeadas.
+ */
+class FileView {
+public:
+    FileView() = default;
+
+    /**
+     * @brief Abre um arquivo
+     * @param path Caminho do arquivo
+     * @return Visão do conteúdo; inválida (valid() == false) se o arquivo não pode ser lido
+     */
+    static FileView open(const std::string& path);
+
+    /**
+     * @brief Cria uma visão sobre conteúdo já em memória
+     * @param content Conteúdo (movido para a visão)
+     */
+    static FileView fromString(std::string content);
+
+    const char* data() const { return data_.data(); }
+    size_t size() const { return data_.size(); }
+    bool empty() const { return data_.empty(); }
+    std::string_view view() const { return data_; }
+
+    /**
+     * @brief Cópia do conteúdo, para APIs que exigem std::string
+     */
+    std::string str() const { return std::string(data_); }
+
+    /**
+     * @brief Indica se a visão se refere a um conteúdo (mesmo vazio)
+     */
+    bool valid() const { return storage_ != nullptr; }
+
+    /**
+     * @brief Indica se o conteúdo está mapeado em memória (e não no heap)
+     */
+    bool isMapped() const;
+
+private:
+    struct Storage;
+
+    std::shared_ptr<const Storage> storage_;
+    std::string_view data_;
+};
+
+} // namespace Preprocessor
+
+#endif // FILE_VIEW_HPP
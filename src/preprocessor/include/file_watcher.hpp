@@ -0,0 +1,81 @@
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace Preprocessor {
+
+/**
+ * @brief Tipo de mudança observada pelo FileWatcher
+ */
+enum class FileWatchEventType {
+    MODIFIED,   ///< Conteúdo ou atributos de um arquivo mudaram
+    CREATED,    ///< Entrada criada (ou movida para dentro) em um diretório observado
+    DELETED,    ///< Entrada removida (ou movida para fora), inclusive o próprio diretório
+    OVERFLOW    ///< Fila do kernel transbordou: eventos foram perdidos
+};
+
+/**
+ * @brief Evento entregue por FileWatcher::poll()
+ */
+struct FileWatchEvent {
+    FileWatchEventType type;
+    std::string path;           ///< Caminho afetado (vazio em OVERFLOW)
+};
+
+/**
+ * @brief Observa diretórios com inotify (Linux)
+ *
+ * Observar o diretório (e não cada arquivo) cobre modificações, criações,
+ * remoções e substituições por rename de todos os arquivos nele. O descritor é
+ * não bloqueante: poll() só consome o que já está na fila. Em sistemas sem
+ * inotify o observador fica inativo (isActive() == false).
+ */
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /**
+     * @brief Indica se o descritor inotify foi criado
+     */
+    bool isActive() const { return fd_ >= 0; }
+
+    /**
+     * @brief Passa a observar um diretório (chamadas repetidas são ignoradas)
+     * @param directory Caminho do diretório
+     * @return true se o diretório está sendo observado
+     */
+    bool watchDirectory(const std::string& directory);
+
+    /**
+     * @brief Verifica se um diretório já está sendo observado
+     */
+    bool isWatching(const std::string& directory) const;
+
+    /**
+     * @brief Número de diretórios observados
+     */
+    size_t watchCount() const { return directories_.size(); }
+
+    /**
+     * @brief Lê os eventos pendentes sem bloquear
+     * @param events Recebe os eventos (acrescentados ao final)
+     * @return Número de eventos acrescentados
+     */
+    size_t poll(std::vector<FileWatchEvent>& events);
+
+private:
+    int fd_;
+    std::unordered_map<int, std::string> paths_;        // Descritor de observação -> diretório
+    std::unordered_map<std::string, int> directories_;  // Diretório -> descritor de observação
+};
+
+} // namespace Preprocessor
+
+#endif // FILE_WATCHER_HPP
@@ -0,0 +1,78 @@
+#ifndef LINE_READER_HPP
+#define LINE_READER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+namespace Preprocessor {
+
+/**
+ * @brief Leitor de linhas lógicas sobre um buffer completo
+ *
+ * Separa as linhas físicas com memchr e junta, numa única passagem, as linhas
+ * terminadas por barra invertida (fase 2 da tradução). Linhas sem continuação
+ * são devolvidas como visões sobre o buffer original; somente as linhas
+ * emendadas são copiadas para um buffer interno reaproveitado.
+ */
+class LineReader {
+public:
+    /**
+     * @brief Cria o leitor
+     * @param content Buffer completo (deve sobreviver ao leitor)
+     * @param offset Posição inicial de leitura
+     */
+    explicit LineReader(std::string_view content, size_t offset = 0);
+
+    /**
+     * @brief Lê a próxima linha lógica
+     * @param line Recebe a linha, sem o '\n' final; válida até a próxima chamada
+     * @return false no fim do buffer
+     */
+    bool next(std::string_view& line);
+
+    /**
+     * @brief Posição do primeiro byte ainda não lido
+     */
+    size_t offset() const { return offset_; }
+
+    /**
+     * @brief Reposiciona a leitura (ex.: após saltar um bloco inativo)
+     * @param offset Nova posição, sempre no início de uma linha física
+     */
+    void seek(size_t offset) { offset_ = offset; }
+
+    /**
+     * @brief Número de linhas físicas que formaram a última linha lógica
+     */
+    int physicalLineCount() const { return static_cast<int>(splice_columns_.size()) + 1; }
+
+    /**
+     * @brief Indica se a última linha lógica foi emendada
+     */
+    bool wasSpliced() const { return !splice_columns_.empty(); }
+
+    /**
+     * @brief Deslocamentos, na última linha lógica, do início de cada linha física após a primeira
+     */
+    const std::vector<size_t>& spliceColumns() const { return splice_columns_; }
+
+    /**
+     * @brief Converte uma coluna da última linha lógica em posição física
+     * @param column Coluna na linha lógica (base 1)
+     * @param line_offset Recebe quantas linhas físicas após a primeira contêm a coluna
+     * @param physical_column Recebe a coluna correspondente na linha física (base 1)
+     */
+    void physicalPosition(size_t column, int& line_offset, size_t& physical_column) const;
+
+private:
+    std::string_view content_;
+    size_t offset_;
+    std::string spliced_;                 ///< Buffer das linhas emendadas
+    std::vector<size_t> splice_columns_;  ///< Deslocamento, na linha lógica, do início de cada linha física emendada
+};
+
+} // namespace Preprocessor
+
+#endif // LINE_READER_HPP
@@ -2,10 +2,13 @@
 #define MACRO_PROCESSOR_HPP
 
 #include <string>
+#include <string_view>
+#include <cstdint>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
+#include <ctime>
 #include "preprocessor_logger.hpp"
 #include "preprocessor_state.hpp"
 
@@ -24,6 +27,42 @@ enum class MacroType {
     VARIADIC        // #define NAME(params, ...) body
 };
 
+/**
+ * @brief Tipos de trecho de um corpo de macro pré-compilado
+ */
+enum class MacroTemplateSlot {
+    LITERAL,     // Texto copiado sem alterações
+    PARAMETER,   // Argumento inserido como está
+    STRINGIFY,   // #param - argumento convertido em string literal
+    PASTE        // Operando de ## - argumento sem espaços nas bordas
+};
+
+/**
+ * @brief Trecho de um corpo de macro pré-compilado
+ */
+struct MacroTemplatePart {
+    MacroTemplateSlot kind;
+    std::string text;        // Texto literal (apenas LITERAL)
+    size_t paramIndex;       // Índice do parâmetro; parameters.size() = __VA_ARGS__
+    
+    MacroTemplatePart(MacroTemplateSlot k, const std::string& t, size_t index = 0)
+        : kind(k), text(t), paramIndex(index) {}
+};
+
+/**
+ * @brief Corpo de macro funcional compilado em trechos literais e slots
+ * 
+ * Gerado uma única vez na definição; a expansão apenas concatena os trechos
+ * literais com os textos dos argumentos, sem nova análise do corpo.
+ */
+struct MacroReplacementTemplate {
+    std::vector<MacroTemplatePart> parts;
+    size_t literalBytes;     // Soma dos trechos literais (para reserva)
+    bool compiled;
+    
+    MacroReplacementTemplate() : literalBytes(0), compiled(false) {}
+};
+
 /**
  * @brief Informações sobre uma macro definida
  */
@@ -36,6 +75,7 @@ struct MacroInfo {
     Preprocessor::PreprocessorPosition definedAt;      // Onde foi definida
     bool isPredefined;                   // Se é uma macro predefinida
     int expansionCount;                  // Contador de expansões
+    MacroReplacementTemplate replacement; // Corpo pré-compilado (macros funcionais)
     
     // Construtores
     MacroInfo();
@@ -69,6 +109,234 @@ struct MacroExpansionContext {
     void reset();
 };
 
+/**
+ * @brief Tabela de macros com endereçamento aberto sobre definições em blocos
+ * 
+ * A tabela (sondagem linear, capacidade potência de 2) guarda apenas hash,
+ * visão do nome e índice da definição; a visão aponta para o próprio
+ * MacroInfo::name, então cada nome é armazenado uma única vez e some com a
+ * definição. As definições vivem em blocos contíguos de tamanho fixo, de modo
+ * que ponteiros para MacroInfo permanecem válidos até a remoção da macro.
+ * reset() descarta tudo de uma vez mantendo a memória reservada para a
+ * próxima unidade de tradução.
+ */
+class MacroTable {
+public:
+    MacroTable();
+    
+    MacroInfo* find(std::string_view name);
+    const MacroInfo* find(std::string_view name) const;
+    
+    /**
+     * @brief Insere ou substitui a definição de uma macro
+     * @param name Nome da macro
+     * @param info Definição (o campo name é ajustado para o nome informado)
+     * @return Referência para a definição armazenada
+     */
+    MacroInfo& assign(std::string_view name, MacroInfo info);
+    
+    /**
+     * @brief Remove uma macro
+     * @return true se a macro existia
+     */
+    bool erase(std::string_view name);
+    
+    /**
+     * @brief Descarta todas as macros preservando a capacidade alocada
+     */
+    void reset();
+    
+    size_t size() const { return count_; }
+    size_t capacity() const { return slots_.size(); }
+    size_t arenaBytes() const;
+    
+    /**
+     * @brief Contador incrementado a cada definição, remoção ou reset
+     * 
+     * Permite que consumidores invalidem resultados derivados das macros
+     * sem comparar as definições.
+     */
+    uint64_t generation() const { return generation_; }
+    
+    /**
+     * @brief Visita todas as definições vivas (ordem de inserção não garantida)
+     */
+    template<typename Func>
+    void forEach(Func&& func) const {
+        for (size_t i = 0; i < definitionCount_; ++i) {
+            if (definitionLive_[i]) func(definitionAt(i));
+        }
+    }
+    
+    template<typename Func>
+    void forEach(Func&& func) {
+        for (size_t i = 0; i < definitionCount_; ++i) {
+            if (definitionLive_[i]) func(definitionAt(i));
+        }
+    }
+    
+    /**
+     * @brief Remove todas as definições que satisfazem o predicado
+     * @return Número de macros removidas
+     */
+    template<typename Pred>
+    size_t eraseIf(Pred&& pred) {
+        std::vector<std::string> doomed;
+        forEach([&](const MacroInfo& info) {
+            if (pred(info)) doomed.push_back(info.name);
+        });
+        for (const auto& name : doomed) erase(name);
+        return doomed.size();
+    }
+    
+private:
+    static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFFu;
+    static constexpr uint32_t TOMBSTONE = 0xFFFFFFFEu;
+    static constexpr size_t DEFINITION_CHUNK = 256;
+    
+    struct Slot {
+        uint64_t hash;
+        const char* name;        // Dados de MacroInfo::name da definição
+        uint32_t nameLength;
+        uint32_t definition;     // Índice da definição, EMPTY_SLOT ou TOMBSTONE
+    };
+    
+    std::vector<Slot> slots_;
+    size_t count_;
+    size_t tombstones_;
+    
+    // Definições em blocos contíguos
+    std::vector<std::unique_ptr<MacroInfo[]>> definitionChunks_;
+    std::vector<uint8_t> definitionLive_;
+    std::vector<uint32_t> freeDefinitions_;
+    size_t definitionCount_;
+    
+    uint64_t generation_;
+    
+    static uint64_t hashName(std::string_view name);
+    size_t findSlot(std::string_view name, uint64_t hash) const;
+    uint32_t allocateDefinition();
+    void rehash(size_t newCapacity);
+    
+    MacroInfo& definitionAt(size_t index) {
+        return definitionChunks_[index / DEFINITION_CHUNK][index % DEFINITION_CHUNK];
+    }
+    const MacroInfo& definitionAt(size_t index) const {
+        return definitionChunks_[index / DEFINITION_CHUNK][index % DEFINITION_CHUNK];
+    }
+};
+
+/**
+ * @brief Contadores de uso do cache de expansões
+ */
+struct MacroCacheStats {
+    size_t hits;         // Consultas atendidas pelo cache
+    size_t misses;       // Consultas sem entrada no cache
+    size_t evictions;    // Entradas removidas por limite de entradas/bytes
+    size_t bytesSaved;   // Bytes de expansão reaproveitados em hits
+    
+    MacroCacheStats() : hits(0), misses(0), evictions(0), bytesSaved(0) {}
+};
+
+/**
+ * @brief Medições de uma macro coletadas pelo modo de instrumentação
+ * 
+ * Tempos são de relógio monotônico; o tempo total inclui as expansões
+ * aninhadas e o tempo próprio as exclui.
+ */
+struct MacroProfile {
+    std::string name;                    // Nome da macro
+    size_t expansions;                   // Expansões (incluindo acertos de cache)
+    size_t cacheHits;                    // Expansões atendidas pelo cache
+    uint64_t totalNanoseconds;           // Tempo acumulado, com expansões aninhadas
+    uint64_t selfNanoseconds;            // Tempo acumulado, sem expansões aninhadas
+    size_t bytesProduced;                // Bytes de texto gerados
+    int maxDepth;                        // Maior profundidade de aninhamento observada
+    std::vector<Preprocessor::PreprocessorPosition> callSites; // Linhas distintas que a expandiram
+    bool callSitesTruncated;             // Mais locais do que o limite armazenado
+    
+    MacroProfile() : expansions(0), cacheHits(0), totalNanoseconds(0), selfNanoseconds(0),
+                     bytesProduced(0), maxDepth(0), callSitesTruncated(false) {}
+};
+
+/**
+ * @brief Cache LRU limitado de expansões de macros
+ * 
+ * Cada entrada é um nó de uma lista duplamente encadeada intrusiva armazenado
+ * diretamente na tabela hash; a cabeça é a entrada usada mais recentemente e a
+ * cauda é a primeira candidata à remoção. O cache respeita simultaneamente um
+ * limite de entradas e um orçamento de bytes (chave + expansão).
+ */
+class MacroExpansionCache {
+public:
+    MacroExpansionCache(size_t maxEntries = 1000, size_t maxBytes = 4 * 1024 * 1024);
+    
+    // Os nós referenciam uns aos outros por ponteiro: cópia proibida
+    MacroExpansionCache(const MacroExpansionCache&) = delete;
+    MacroExpansionCache& operator=(const MacroExpansionCache&) = delete;
+    MacroExpansionCache(MacroExpansionCache&& other) noexcept;
+    MacroExpansionCache& operator=(MacroExpansionCache&& other) noexcept;
+    
+    /**
+     * @brief Procura uma expansão e a promove para a cabeça da lista
+     * @param key Chave da expansão
+     * @return Ponteiro para a expansão ou nullptr em caso de miss
+     */
+    const std::string* lookup(const std::string& key);
+    
+    /**
+     * @brief Verifica presença sem alterar ordem nem contadores
+     */
+    bool contains(const std::string& key) const;
+    
+    /**
+     * @brief Insere ou atualiza uma expansão, removendo entradas LRU se necessário
+     * @param key Chave da expansão
+     * @param value Texto expandido
+     */
+    void insert(const std::string& key, const std::string& value);
+    
+    /**
+     * @brief Remove entradas não acessadas há mais de maxAge segundos
+     * @param maxAge Idade máxima em segundos
+     * @return Número de entradas removidas
+     */
+    size_t removeOlderThan(int maxAge);
+    
+    void clear();
+    void setLimits(size_t maxEntries, size_t maxBytes);
+    void resetStatistics();
+    
+    size_t size() const { return entries_.size(); }
+    size_t bytes() const { return currentBytes_; }
+    size_t maxEntries() const { return maxEntries_; }
+    size_t maxBytes() const { return maxBytes_; }
+    const MacroCacheStats& statistics() const { return stats_; }
+    
+private:
+    struct Node {
+        const std::string* key;   // Aponta para a chave armazenada na tabela
+        std::string value;
+        time_t lastAccess;
+        Node* prev;
+        Node* next;
+    };
+    
+    std::unordered_map<std::string, Node> entries_;
+    Node* head_;                 // Mais recentemente usado
+    Node* tail_;                 // Menos recentemente usado
+    size_t currentBytes_;
+    size_t maxEntries_;
+    size_t maxBytes_;
+    MacroCacheStats stats_;
+    
+    void unlink(Node* node);
+    void pushFront(Node* node);
+    void erase(Node* node);
+    void enforceLimits();
+    static size_t entryBytes(const std::string& key, const std::string& value);
+};
+
 // ============================================================================
 // CLASSE PRINCIPAL
 // ============================================================================
@@ -79,7 +347,7 @@ struct MacroExpansionContext {
 class MacroProcessor {
 private:
     // Armazenamento de macros
-    std::unordered_map<std::string, MacroInfo> macros_;
+    MacroTable macros_;
     
     // Componentes auxiliares
     std::shared_ptr<Preprocessor::PreprocessorLogger> logger_;
@@ -88,19 +356,22 @@ private:
     // Controle de expansão
     MacroExpansionContext expansionContext_;
     
-    // Cache de expansões
-    std::unordered_map<std::string, std::string> expansionCache_;
+    // Cache de expansões (LRU limitado por entradas e bytes)
+    MacroExpansionCache expansionCache_;
     bool cacheEnabled_;
     
     // Configurações de otimização
-    size_t maxCacheSize_;
     bool enablePrecompilation_;
-    std::unordered_map<std::string, time_t> cacheTimestamps_;
     
     // Estatísticas
     size_t totalExpansions_;
-    size_t cacheHits_;
-    size_t cacheMisses_;
+    
+    // Instrumentação por macro (desativada por padrão)
+    bool profilingEnabled_;
+    std::unordered_map<std::string, MacroProfile> profiles_;
+    std::vector<uint64_t> profileChildNanos_;            // Tempo das expansões aninhadas, por nível
+    Preprocessor::PreprocessorPosition profileSite_;     // Linha em processamento
+    static constexpr size_t MAX_PROFILE_CALL_SITES = 8;
     
     // Tratamento de erros
     void* external_error_handler_;
@@ -168,6 +439,12 @@ public:
      */
     bool isDefined(const std::string& name) const;
     
+    /**
+     * @brief Obtém a geração atual da tabela de macros
+     * @return Valor que muda sempre que alguma macro é definida ou removida
+     */
+    uint64_t getMacroGeneration() const { return macros_.generation(); }
+    
     /**
      * @brief Obtém o valor de uma macro
      * @param name Nome da macro
@@ -222,6 +499,14 @@ public:
      */
     std::string processLine(const std::string& line);
     
+    /**
+     * @brief Processa uma linha registrando sua posição como local de chamada
+     * @param line Linha a processar
+     * @param position Posição da linha no arquivo de origem
+     * @return Linha processada
+     */
+    std::string processLine(const std::string& line, const Preprocessor::PreprocessorPosition& position);
+    
     // ========================================================================
     // VALIDAÇÃO
     // ========================================================================
@@ -373,6 +658,24 @@ public:
      */
     size_t getCurrentCacheSize() const;
     
+    /**
+     * @brief Define o orçamento de memória do cache de expansões
+     * @param maxBytes Total máximo de bytes (chaves + expansões)
+     */
+    void setCacheMemoryBudget(size_t maxBytes);
+    
+    /**
+     * @brief Obtém bytes atualmente ocupados pelo cache
+     * @return Bytes de chaves e expansões armazenadas
+     */
+    size_t getCurrentCacheBytes() const;
+    
+    /**
+     * @brief Obtém contadores do cache (hits, misses, remoções, bytes poupados)
+     * @return Estrutura com os contadores
+     */
+    const MacroCacheStats& getCacheStatistics() const;
+    
     /**
      * @brief Armazena resultado no cache
      * @param key Chave do cache
@@ -401,6 +704,33 @@ public:
      */
     void resetStatistics();
     
+    /**
+     * @brief Ativa ou desativa a instrumentação por macro
+     * 
+     * Com a instrumentação ativa, cada expansão registra tempo, bytes gerados,
+     * profundidade e local de chamada; generateMacroReport() passa a incluir
+     * as macros ordenadas por custo.
+     * @param enabled true para ativar
+     */
+    void setProfilingEnabled(bool enabled);
+    
+    /**
+     * @brief Verifica se a instrumentação por macro está ativa
+     */
+    bool isProfilingEnabled() const { return profilingEnabled_; }
+    
+    /**
+     * @brief Obtém as medições por macro
+     * @return Perfis ordenados por tempo total decrescente
+     */
+    std::vector<MacroProfile> getMacroProfiles() const;
+    
+    /**
+     * @brief Exporta as medições por macro em JSON
+     * @return Objeto com o total de expansões e a lista ordenada de macros
+     */
+    std::string exportProfileJson() const;
+    
     // ========================================================================
     // CONFIGURAÇÃO E CONTROLE
     // ========================================================================
@@ -426,6 +756,22 @@ public:
      */
     void clearAllMacros();
     
+    /**
+     * @brief Exporta as definições das macros de usuário (não predefinidas)
+     * @return Cópia das definições, usada para snapshots do estado de macros
+     */
+    std::vector<MacroInfo> exportUserMacros() const;
+    
+    /**
+     * @brief Substitui as macros de usuário por um conjunto exportado
+     * 
+     * Não revalida nem registra cada definição: destina-se a restaurar um
+     * estado previamente produzido por exportUserMacros().
+     * @param macros Definições a restaurar
+     * @return Número de macros restauradas
+     */
+    size_t importMacros(std::vector<MacroInfo> macros);
+    
     /**
      * @brief Define o manipulador de erros externo
      * @param errorHandler Ponteiro para o manipulador de erros
@@ -449,6 +795,53 @@ private:
      */
     bool isReservedName(const std::string& name) const;
     
+    /**
+     * @brief Inicia a medição de uma expansão
+     * @return Instante inicial em nanossegundos (0 com a instrumentação desativada)
+     */
+    uint64_t beginMacroProfile();
+    
+    /**
+     * @brief Conclui a medição iniciada por beginMacroProfile()
+     * @param name Macro expandida
+     * @param start Valor retornado por beginMacroProfile()
+     * @param bytes Tamanho do texto gerado
+     * @param cacheHit Se a expansão veio do cache
+     */
+    void endMacroProfile(const std::string& name, uint64_t start, size_t bytes, bool cacheHit);
+    
+    /**
+     * @brief Medição de uma expansão com término garantido
+     *
+     * Se a expansão lançar exceção antes de finish(), o destrutor conclui a
+     * medição sem bytes produzidos, mantendo a pilha de tempos equilibrada.
+     */
+    class MacroProfileScope {
+    public:
+        MacroProfileScope(MacroProcessor& processor, const std::string& name)
+            : processor_(processor), name_(name), start_(processor.beginMacroProfile()), finished_(false) {}
+        
+        ~MacroProfileScope() {
+            if (!finished_) {
+                processor_.endMacroProfile(name_, start_, 0, false);
+            }
+        }
+        
+        void finish(size_t bytes, bool cacheHit) {
+            finished_ = true;
+            processor_.endMacroProfile(name_, start_, bytes, cacheHit);
+        }
+        
+        MacroProfileScope(const MacroProfileScope&) = delete;
+        MacroProfileScope& operator=(const MacroProfileScope&) = delete;
+        
+    private:
+        MacroProcessor& processor_;
+        const std::string& name_;
+        uint64_t start_;
+        bool finished_;
+    };
+    
     /**
      * @brief Substitui parâmetros por argumentos no corpo da macro
      * @param body Corpo da macro
@@ -461,15 +854,26 @@ private:
                                    const std::vector<std::string>& arguments);
     
     /**
-     * @brief Processa operadores # (stringificação) e ## (concatenação)
+     * @brief Compila o corpo de uma macro funcional em trechos e slots
      * @param body Corpo da macro
      * @param parameters Lista de parâmetros
+     * @param isVariadic Se __VA_ARGS__ deve virar slot
+     * @return Template com operadores # e ## já resolvidos
+     */
+    MacroReplacementTemplate compileReplacementTemplate(const std::string& body,
+                                                        const std::vector<std::string>& parameters,
+                                                        bool isVariadic) const;
+    
+    /**
+     * @brief Instancia um template pré-compilado com os argumentos da chamada
+     * @param tmpl Template compilado
+     * @param parameterCount Número de parâmetros nomeados
      * @param arguments Lista de argumentos
-     * @return String com operadores processados
+     * @return Corpo com argumentos inseridos
      */
-    std::string processStringificationAndConcatenation(const std::string& body,
-                                                      const std::vector<std::string>& parameters,
-                                                      const std::vector<std::string>& arguments);
+    std::string instantiateTemplate(const MacroReplacementTemplate& tmpl,
+                                    size_t parameterCount,
+                                    const std::vector<std::string>& arguments);
     
     /**
      * @brief Encontra próxima ocorrência de macro no texto
@@ -0,0 +1,103 @@
+#ifndef OUTPUT_CACHE_HPP
+#define OUTPUT_CACHE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "preprocessor_types.hpp"
+#include "preprocessor_logger.hpp"
+#include "macro_processor.hpp"
+#include "file_manager.hpp"
+
+namespace Preprocessor {
+
+/**
+ * @brief Estatísticas do cache de saída
+ */
+struct OutputCacheStats {
+    size_t hits = 0;          ///< Resultados reaproveitados do disco
+    size_t misses = 0;        ///< Entradas ausentes ou rejeitadas
+    size_t stores = 0;        ///< Entradas gravadas
+    size_t invalidated = 0;   ///< Entradas descartadas porque uma dependência mudou
+};
+
+/**
+ * @brief Arquivo lido durante o processamento e o hash do seu conteúdo
+ */
+struct CachedDependency {
+    std::string path;
+    uint64_t contentHash;
+};
+
+/**
+ * @brief Resultado completo de PreprocessorMain::process() guardado no cache
+ */
+struct CachedOutput {
+    std::vector<CachedDependency> dependencies;  ///< Arquivos lidos (verificados em cada acerto)
+    std::vector<MacroInfo> macros;               ///< Macros de usuário ao final do processamento
+    std::string expandedCode;
+    size_t outputLines = 0;
+    LineMap lineMap;
+};
+
+/**
+ * @brief Cache em disco endereçado por conteúdo para a saída do pré-processador
+ *
+ * Cada entrada é um arquivo <chave>.ppo no diretório do cache. A chave cobre o
+ * arquivo principal e toda a configuração que influencia a expansão; os demais
+ * arquivos lidos são verificados pelo hash do conteúdo no momento da consulta.
+ * O código expandido é gravado comprimido (BlockCodec) quando encolhe.
+ */
+class OutputCache {
+public:
+    /**
+     * @brief Construtor; cria o diretório se necessário
+     * @param directory Diretório onde as entradas são gravadas
+     * @param logger Logger para diagnósticos (pode ser nullptr)
+     * @param file_manager Fonte dos hashes de conteúdo memorizados (pode ser nullptr)
+     */
+    OutputCache(const std::string& directory, PreprocessorLogger* logger,
+                const FileManager* file_manager = nullptr);
+
+    /**
+     * @brief Verifica se o diretório do cache está disponível
+     */
+    bool isUsable() const { return usable_; }
+
+    const std::string& getDirectory() const { return directory_; }
+
+    /**
+     * @brief Procura uma entrada válida para a chave
+     * @param key Chave calculada pelo pré-processador
+     * @param output Recebe o resultado guardado
+     * @return true se a entrada existe, está íntegra e nenhuma dependência mudou
+     */
+    bool lookup(uint64_t key, CachedOutput& output);
+
+    /**
+     * @brief Grava (ou substitui) a entrada da chave
+     * @return true se a entrada foi gravada
+     */
+    bool store(uint64_t key, const CachedOutput& output);
+
+    /**
+     * @brief Calcula o hash do conteúdo de um arquivo
+     * @return false se o arquivo não pode ser lido
+     */
+    bool hashFileContent(const std::string& path, uint64_t& hash) const;
+
+    const OutputCacheStats& getStatistics() const { return stats_; }
+
+private:
+    std::string entryPath(uint64_t key) const;
+
+    std::string directory_;
+    PreprocessorLogger* logger_;
+    const FileManager* file_manager_;
+    bool usable_;
+    OutputCacheStats stats_;
+};
+
+} // namespace Preprocessor
+
+#endif // OUTPUT_CACHE_HPP
@@ -5,6 +5,9 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <functional>
+#include <string_view>
+#include <cstdint>
 #include "preprocessor_types.hpp"
 #include "preprocessor_config.hpp"
 #include "preprocessor_state.hpp"
@@ -14,9 +17,45 @@
 #include "file_manager.hpp"
 #include "conditional_processor.hpp"
 #include "expression_evaluator.hpp"
+#include "output_cache.hpp"
 
 namespace Preprocessor {
 
+/**
+ * @brief Consumidor de saída do pré-processador
+ * 
+ * Recebe cada linha completa (incluindo o '\n') assim que é produzida. A visão
+ * só é válida durante a chamada.
+ */
+using OutputSink = std::function<void(std::string_view)>;
+
+/**
+ * @brief Custo acumulado de uma verificação de consistência
+ */
+struct ConsistencyCheckCost {
+    size_t runs = 0;              ///< Número de execuções
+    uint64_t nanoseconds = 0;     ///< Tempo total gasto
+};
+
+/**
+ * @brief Custos das verificações de consistência do processamento
+ * 
+ * Acumulados desde a construção ou o último reset(). No perfil FAST apenas a
+ * verificação de integridade é executada, pois ela decide o resultado de process().
+ */
+struct ConsistencyCheckStats {
+    ConsistencyCheckCost input_validation;    ///< validateInput
+    ConsistencyCheckCost synchronization;     ///< synchronizeProcessors
+    ConsistencyCheckCost output_validation;   ///< validateOutput (por linha e final)
+    ConsistencyCheckCost integrity_check;     ///< performIntegrityCheck
+    ConsistencyCheckCost report;              ///< generateProcessingReport
+    
+    uint64_t totalNanoseconds() const {
+        return input_validation.nanoseconds + synchronization.nanoseconds +
+               output_validation.nanoseconds + integrity_check.nanoseconds + report.nanoseconds;
+    }
+};
+
 /**
  * @brief Classe principal do pré-processador C
  * 
@@ -28,8 +67,11 @@ public:
     /**
      * @brief Construtor com arquivo de configuração
      * @param config_file Caminho para arquivo de configuração
+     * @param shared_files FileManager compartilhado com outras instâncias (opcional).
+     *        Quando fornecido, seus caminhos de busca e caches são usados como estão.
      */
-    explicit PreprocessorMain(const std::string& config_file = "");
+    explicit PreprocessorMain(const std::string& config_file = "",
+                              std::shared_ptr<FileManager> shared_files = nullptr);
     
     /**
      * @brief Destrutor que libera recursos
@@ -58,6 +100,43 @@ public:
      */
     std::string getExpandedCode() const;
     
+    /**
+     * @brief Transfere o buffer de saída sem cópia
+     * @return Código expandido; o buffer interno fica vazio
+     */
+    std::string takeExpandedCode();
+    
+    /**
+     * @brief Define consumidor de saída em streaming
+     * 
+     * Com um sink ativo as linhas são entregues diretamente ao consumidor e não
+     * são acumuladas no buffer interno. Passe nullptr para voltar ao modo buffer.
+     * @param sink Função que recebe cada linha produzida
+     */
+    void setOutputSink(OutputSink sink);
+    
+    /**
+     * @brief Total de bytes produzidos no último processamento
+     * @return Bytes escritos (buffer ou sink)
+     */
+    size_t getOutputSize() const;
+    
+    /**
+     * @brief Obtém a tabela de linhas (linha expandida -> arquivo/linha original)
+     * @return Sequências de linhas registradas no último processamento
+     */
+    const LineMap& getLineMap() const;
+    
+    /**
+     * @brief Visão somente leitura de um arquivo, compartilhada com o cache do FileManager
+     * 
+     * Permite que outros estágios (ex.: o lexer no modo de fallback) reutilizem
+     * o conteúdo já mapeado pelo pré-processador em vez de reler o arquivo.
+     * @param filename Caminho do arquivo
+     * @return Visão do conteúdo; inválida se o arquivo não pode ser lido
+     */
+    FileView openFileView(const std::string& filename);
+    
     /**
      * @brief Lista de arquivos incluídos
      * @return Vetor com caminhos dos arquivos incluídos
@@ -115,6 +194,82 @@ public:
      */
     void setVersion(CVersion version);
     
+    /**
+     * @brief Define o perfil de desempenho
+     * 
+     * FAST omite validação de entrada e saída, sincronização de processadores
+     * e relatório final; CHECKED (padrão) executa todas as verificações.
+     * @param profile Novo perfil
+     */
+    void setProcessingProfile(ProcessingProfile profile);
+    
+    /**
+     * @brief Define o nível mínimo das mensagens do logger da instância
+     * @param level Nível mínimo (INFO por padrão)
+     */
+    void setLogLevel(LogLevel level);
+    
+    /**
+     * @brief Ativa a instrumentação por macro (tempo, bytes, profundidade e locais)
+     * @param enabled true para ativar; desativada por padrão
+     */
+    void setMacroProfilingEnabled(bool enabled);
+    
+    /**
+     * @brief Relatório de macros, com as mais custosas primeiro quando instrumentado
+     */
+    std::string getMacroReport() const;
+    
+    /**
+     * @brief Grava as medições por macro em JSON
+     * @param path Arquivo de saída
+     * @return false se a instrumentação está desativada ou a gravação falhou
+     */
+    bool exportMacroProfile(const std::string& path) const;
+    
+    /**
+     * @brief Salva o estado de macros em um snapshot binário
+     * 
+     * Destinado a ser chamado após processar o prelúdio de configuração:
+     * grava as macros de usuário, os arquivos já processados e a versão do C.
+     * Falha se houver diretivas condicionais abertas.
+     * @param path Caminho do arquivo de snapshot
+     * @return true se o snapshot foi gravado
+     */
+    bool saveSnapshot(const std::string& path) const;
+    
+    /**
+     * @brief Restaura um snapshot gravado por saveSnapshot()
+     * 
+     * Substitui as macros de usuário e marca os arquivos do prelúdio como
+     * processados. Em caso de falha o estado atual não é alterado.
+     * @param path Caminho do arquivo de snapshot
+     * @return true se o snapshot foi carregado
+     */
+    bool loadSnapshot(const std::string& path);
+    
+    /**
+     * @brief Habilita o cache em disco dos resultados de process()
+     * 
+     * A chave cobre o conteúdo do arquivo, macros de usuário e predefinidas,
+     * caminhos de busca e versão do C; os arquivos lidos são verificados pelo
+     * conteúdo a cada acerto. String vazia desabilita o cache.
+     * @param directory Diretório das entradas do cache
+     */
+    void setOutputCacheDirectory(const std::string& directory);
+    
+    /**
+     * @brief Estatísticas do cache de saída
+     * @return Acertos, falhas e gravações desde que o cache foi habilitado
+     */
+    OutputCacheStats getOutputCacheStatistics() const;
+    
+    /**
+     * @brief Custos das verificações de consistência
+     * @return Execuções e tempo gasto em cada verificação
+     */
+    const ConsistencyCheckStats& getConsistencyCheckStatistics() const { return consistency_stats_; }
+    
     /**
      * @brief Retorna estatísticas de processamento
      * @return Estrutura com estatísticas
@@ -151,6 +306,29 @@ private:
      */
     bool processLine(const std::string& line, int line_number);
     
+    /**
+     * @brief Processa um buffer completo linha a linha
+     * 
+     * Blocos condicionais inativos são saltados por skipInactiveBlock.
+     * @param content Conteúdo a processar
+     * @param line_number Número da linha corrente (atualizado; em caso de falha,
+     *                    aponta para a linha que falhou)
+     * @return true se processamento foi bem-sucedido
+     */
+    bool processBuffer(std::string_view content, int& line_number);
+    
+    /**
+     * @brief Avança sobre as linhas de um bloco condicional inativo
+     * 
+     * Procura apenas por '#' no início de linha e para na próxima diretiva
+     * condicional; as demais linhas viram quebras de linha na saída.
+     * @param content Buffer em processamento
+     * @param offset Início da primeira linha do bloco
+     * @param line_number Número da linha corrente (atualizado)
+     * @return Offset da próxima diretiva condicional ou fim do buffer
+     */
+    size_t skipInactiveBlock(std::string_view content, size_t offset, int& line_number);
+    
     /**
      * @brief Manipula diretiva específica
      * @param directive Diretiva a ser processada
@@ -222,6 +400,20 @@ private:
     void enableOptimizations();
 
 private:
+    /**
+     * @brief Calcula a chave do cache de saída para o arquivo principal
+     * @param filename Arquivo principal
+     * @param key Recebe a chave
+     * @return false se o resultado não pode ser reaproveitado (ex.: usa __TIME__)
+     */
+    bool computeOutputCacheKey(const std::string& filename, uint64_t& key) const;
+    
+    /**
+     * @brief Aplica um resultado do cache como se o arquivo tivesse sido processado
+     * @param cached Entrada carregada (consumida)
+     */
+    void restoreCachedOutput(CachedOutput& cached);
+    
     // Método auxiliar para parsear diretivas
     Directive parseDirective(const std::string& line, const PreprocessorPosition& pos);
     
@@ -281,14 +473,21 @@ private:
     std::unique_ptr<PreprocessorState> state_;
     std::unique_ptr<PreprocessorLogger> logger_;
     std::unique_ptr<MacroProcessor> macro_processor_;
-    std::unique_ptr<FileManager> file_manager_;
+    std::shared_ptr<FileManager> file_manager_;
+    bool shared_file_manager_;
     std::unique_ptr<ConditionalProcessor> conditional_processor_;
     std::unique_ptr<ExpressionEvaluator> expression_evaluator_;
     
     // Buffers e estado interno
     std::string expanded_code_;
+    OutputSink output_sink_;
+    size_t output_bytes_;
     std::vector<std::string> dependencies_;
-    std::vector<std::pair<PreprocessorPosition, PreprocessorPosition>> position_mappings_;
+    size_t output_lines_;
+    LineMap line_map_;
+    std::vector<std::string> snapshot_files_;
+    std::unique_ptr<OutputCache> output_cache_;
+    ConsistencyCheckStats consistency_stats_;
     
     // Estado de processamento
     bool initialized_;
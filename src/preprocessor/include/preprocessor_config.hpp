@@ -38,6 +38,17 @@ struct VersionFeatures {
     bool supports_decimal_floats = false;       ///< Suporte a floats decimais (C23)
 };
 
+/**
+ * @brief Perfil de desempenho do processamento
+ * 
+ * Controla as verificações de consistência que não alteram a saída
+ * (validação de entrada e saída, sincronização de processadores e relatório).
+ */
+enum class ProcessingProfile {
+    CHECKED,    ///< Executa todas as verificações (padrão, recomendado para depuração)
+    FAST        ///< Confia no pipeline e omite as verificações de diagnóstico
+};
+
 /**
  * @brief Classe principal de configuração do pré-processador
  * 
@@ -301,6 +312,24 @@ public:
      * @param depth Nova profundidade máxima
      */
     void setMaxIncludeDepth(int depth) { max_include_depth_ = depth; }
+    
+    /**
+     * @brief Obtém o perfil de desempenho
+     * @return Perfil configurado
+     */
+    ProcessingProfile getProcessingProfile() const { return processing_profile_; }
+    
+    /**
+     * @brief Define o perfil de desempenho
+     * @param profile Novo perfil
+     */
+    void setProcessingProfile(ProcessingProfile profile) { processing_profile_ = profile; }
+    
+    /**
+     * @brief Verifica se as verificações de consistência devem ser executadas
+     * @return true no perfil CHECKED
+     */
+    bool areConsistencyChecksEnabled() const { return processing_profile_ == ProcessingProfile::CHECKED; }
 
 private:
     // ========================================================================
@@ -318,6 +347,7 @@ private:
     bool enable_warnings_ = true;                          ///< Warnings habilitados
     bool strict_mode_ = false;                             ///< Modo estrito
     bool preserve_comments_ = false;                       ///< Preservar comentários
+    ProcessingProfile processing_profile_ = ProcessingProfile::CHECKED;  ///< Perfil de desempenho
     
     // Limites de processamento
     size_t max_macro_expansion_size_ = 1024 * 1024;       ///< Tamanho máximo de expansão (1MB)
@@ -367,6 +397,21 @@ std::string cVersionToString(CVersion version);
  */
 CVersion stringToCVersion(const std::string& version_str);
 
+/**
+ * @brief Converte perfil de desempenho para string
+ * @param profile Perfil de desempenho
+ * @return "checked" ou "fast"
+ */
+std::string processingProfileToString(ProcessingProfile profile);
+
+/**
+ * @brief Converte string para perfil de desempenho
+ * @param profile_str String com o perfil ("checked" ou "fast")
+ * @return Perfil correspondente
+ * @throws std::invalid_argument se o perfil não for reconhecido
+ */
+ProcessingProfile stringToProcessingProfile(const std::string& profile_str);
+
 /**
  * @brief Verifica se uma versão suporta uma feature específica
  * @param version Versão do C
@@ -74,7 +74,7 @@ struct ProcessedToken {
  */
 struct ProcessingResult {
     std::string processedCode;                    ///< Código completamente processado
-    std::vector<SourceMapping> positionMappings; ///< Mapeamentos de posição
+    std::vector<SourceMapping> positionMappings; ///< Mapeamentos de posição (um por sequência de linhas)
     std::vector<std::string> includedFiles;      ///< Arquivos incluídos
     std::vector<std::string> definedMacros;      ///< Macros definidas
     std::unordered_map<std::string, std::string> macroDefinitions; ///< Definições de macros
@@ -108,27 +108,54 @@ struct ProcessingResult {
 /**
  * @class PositionMapper
  * @brief Classe para mapear posições entre código processado e original
+ * 
+ * Cada mapeamento armazenado inicia uma sequência de linhas contíguas do
+ * mesmo arquivo/macro; a sequência vale até o início da próxima. A busca é
+ * binária sobre as sequências, ordenadas por linha processada.
  */
 class PositionMapper {
 private:
     std::vector<SourceMapping> mappings;
-    std::unordered_map<size_t, size_t> lineToMappingIndex;
+    std::vector<std::pair<size_t, std::vector<size_t>>> splices;  ///< Emendas por linha processada, em ordem
+    
+    static bool continuesRun(const SourceMapping& run, const SourceMapping& mapping);
     
 public:
     /**
      * @brief Adiciona um mapeamento de posição
+     * 
+     * Mapeamentos que continuam a sequência anterior não geram entrada nova.
      * @param mapping Mapeamento a ser adicionado
      */
     void addMapping(const SourceMapping& mapping);
     
     /**
-     * @brief Encontra o mapeamento para uma posição processada
+     * @brief Registra as emendas (barra invertida + quebra de linha) de uma linha processada
+     * 
+     * Colunas após uma emenda são resolvidas para a linha física seguinte,
+     * com a coluna relativa ao início dela.
+     * @param processedLine Linha no código processado
+     * @param columns Deslocamento, na linha lógica, do início de cada linha física seguinte
+     */
+    void addSplices(size_t processedLine, std::vector<size_t> columns);
+    
+    /**
+     * @brief Encontra a sequência que contém uma posição processada
      * @param processedLine Linha no código processado
      * @param processedColumn Coluna no código processado
-     * @return Mapeamento correspondente ou nullptr se não encontrado
+     * @return Início da sequência correspondente ou nullptr se não encontrado
      */
     const SourceMapping* findMapping(size_t processedLine, size_t processedColumn) const;
     
+    /**
+     * @brief Resolve uma posição processada para o mapeamento exato
+     * @param processedLine Linha no código processado
+     * @param processedColumn Coluna no código processado
+     * @param mapping Mapeamento resolvido para a linha/coluna (saída)
+     * @return true se mapeamento encontrado, false caso contrário
+     */
+    bool resolve(size_t processedLine, size_t processedColumn, SourceMapping& mapping) const;
+    
     /**
      * @brief Converte posição processada para posição original
      * @param processedLine Linha no código processado
@@ -170,7 +197,7 @@ public:
     
     /**
      * @brief Obtém todos os mapeamentos
-     * @return Vetor com todos os mapeamentos
+     * @return Vetor com o início de cada sequência
      */
     const std::vector<SourceMapping>& getAllMappings() const { return mappings; }
 };
@@ -293,8 +320,12 @@ private:
     std::function<void(const IntegratedErrorHandler::IntegratedError&)> onError;
     
     // Métodos privados auxiliares
-    void buildPositionMappings(const std::string& filename, const std::string& processedCode);
+    void buildPositionMappings(const std::string& filename, const std::string& processedCode,
+                               const LineMap* lineMap = nullptr);
+    void buildLineMappings(const std::string& filename, size_t lineCount, bool hasContent,
+                           const LineMap* lineMap = nullptr);
     void collectMacroInformation();
+    void runFileProcessing(const std::string& filename);
     
 public:
     /**
@@ -321,6 +352,38 @@ public:
      */
     ProcessingResult processFile(const std::string& filename);
     
+    /**
+     * @brief Processa um arquivo transferindo o resultado sem cópia
+     * 
+     * Equivalente a processFile(), mas o código processado é movido para o
+     * chamador; getProcessedCode() fica vazio após a chamada.
+     * @param filename Nome do arquivo a ser processado
+     * @return Resultado do processamento
+     */
+    ProcessingResult processFileAndRelease(const std::string& filename);
+    
+    /**
+     * @brief Processa um arquivo entregando a saída em streaming
+     * 
+     * As linhas são passadas ao sink à medida que são produzidas; o resultado
+     * não contém processedCode, apenas mapeamentos, dependências e mensagens.
+     * Em caso de falha do pré-processador nenhum fallback é aplicado.
+     * @param filename Nome do arquivo a ser processado
+     * @param sink Consumidor das linhas produzidas
+     * @return Resultado do processamento (sem o código)
+     */
+    ProcessingResult processFileStreaming(const std::string& filename, OutputSink sink);
+    
+    /**
+     * @brief Visão somente leitura do arquivo fonte original
+     * 
+     * Compartilha o conteúdo já mapeado durante o pré-processamento, de modo
+     * que o fallback do lexer não relê o arquivo.
+     * @param filename Nome do arquivo
+     * @return Visão do conteúdo; inválida se o arquivo não pode ser lido
+     */
+    FileView openSourceView(const std::string& filename);
+    
     /**
      * @brief Processa uma string e prepara para análise léxica
      * @param code Código a ser processado
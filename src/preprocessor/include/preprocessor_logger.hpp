@@ -11,6 +11,10 @@
 #include <vector>
 #include <queue>
 #include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
 #include "preprocessor_config.hpp"
 #include "preprocessor_types.hpp"
 
@@ -29,6 +33,28 @@ enum class LogLevel {
     ERROR = 3     ///< Erros
 };
 
+/**
+ * @brief Nível mínimo de log compilado nas macros PP_LOG_*
+ * 
+ * Chamadas abaixo deste nível são eliminadas em tempo de compilação (a
+ * mensagem nem é montada). Em builds Release (NDEBUG) o padrão é WARNING;
+ * pode ser sobrescrito com -DPREPROCESSOR_MIN_LOG_LEVEL=<0..3>.
+ */
+#ifndef PREPROCESSOR_MIN_LOG_LEVEL
+#ifdef NDEBUG
+#define PREPROCESSOR_MIN_LOG_LEVEL 2
+#else
+#define PREPROCESSOR_MIN_LOG_LEVEL 0
+#endif
+#endif
+
+/**
+ * @brief Verifica se um nível foi compilado nas macros de log
+ */
+constexpr bool isLogLevelCompiled(LogLevel level) {
+    return static_cast<int>(level) >= PREPROCESSOR_MIN_LOG_LEVEL;
+}
+
 /**
  * @brief Estrutura para estatísticas de logging
  * 
@@ -42,10 +68,12 @@ struct LogStatistics {
     size_t totalMessages = 0;   ///< Total de mensagens processadas
     size_t bufferedMessages = 0; ///< Mensagens em buffer
     size_t fileRotations = 0;   ///< Número de rotações de arquivo
+    size_t asyncWrites = 0;     ///< Mensagens gravadas pela thread de escrita
     
     void reset() {
         debugCount = infoCount = warningCount = errorCount = 0;
         totalMessages = bufferedMessages = fileRotations = 0;
+        asyncWrites = 0;
     }
 };
 
@@ -75,11 +103,28 @@ private:
     // Estatísticas
     LogStatistics statistics;                           ///< Estatísticas de logging
     
+    // Arquivo de log: tamanho acompanhado em memória (evita stat por mensagem)
+    size_t currentFileSize;                             ///< Bytes no arquivo de log atual
+    std::mutex fileMutex;                               ///< Protege outputFile e currentFileSize
+    
+    // Escrita assíncrona do arquivo
+    std::thread asyncWriter;                            ///< Thread de escrita (se ativa)
+    std::mutex asyncMutex;                              ///< Protege a fila assíncrona
+    std::condition_variable asyncCondition;             ///< Sinaliza mensagens pendentes
+    std::vector<std::string> asyncQueue;                ///< Mensagens aguardando gravação
+    bool asyncStopping;                                 ///< Pedido de encerramento da thread
+    
+    // Cache do timestamp: só é reformatado quando o segundo muda
+    mutable std::time_t cachedTimestampSecond;          ///< Segundo do prefixo em cache
+    mutable char cachedTimestampPrefix[32];             ///< "AAAA-MM-DD HH:MM:SS"
+    
     // Métodos privados auxiliares
     std::string formatLogMessage(LogLevel level, const std::string& message, 
                                 const PreprocessorPosition& pos = PreprocessorPosition()) const;
     std::string getCurrentTimestamp() const;
     void writeToFile(const std::string& message);
+    void writeLinesToFile(const std::vector<std::string>& messages);
+    void runAsyncWriter();
     void writeToConsole(const std::string& message);
     std::string logLevelToString(LogLevel level) const;
     bool shouldLog(LogLevel level) const;
@@ -100,6 +145,22 @@ public:
     void enableConsoleOutput(bool enable = true);
     void enableFileOutput(bool enable = true);
     
+    /**
+     * @brief Verifica se mensagens do nível seriam registradas
+     * 
+     * Usado pelas macros PP_LOG_* para não montar mensagens descartadas.
+     */
+    bool isEnabled(LogLevel level) const { return level >= currentLogLevel; }
+    
+    /**
+     * @brief Grava o arquivo de log em uma thread separada
+     * 
+     * As mensagens formatadas são enfileiradas e gravadas em lotes, com um
+     * flush por lote. Desativar (ou destruir o logger) grava o que está pendente.
+     */
+    void enableAsyncFileWriter(bool enable = true);
+    bool isAsyncFileWriterEnabled() const { return asyncWriter.joinable(); }
+    
     // Inicialização e configuração avançada
     void initializeLogger();
     void setLogDirectory(const std::string& directory);
@@ -161,6 +222,32 @@ public:
     std::string getLogDirectory() const { return logDirectory; }
 };
 
+// ============================================================================
+// MACROS DE LOG PREGUIÇOSAS
+// ============================================================================
+
+/**
+ * Avaliam a mensagem (e os demais argumentos) apenas se o nível estiver
+ * habilitado no logger e compilado (PREPROCESSOR_MIN_LOG_LEVEL). Aceitam
+ * ponteiros simples ou inteligentes, inclusive nulos:
+ * 
+ *     PP_LOG_INFO(logger_, "Processando #define: " + directive.getContent());
+ */
+#define PP_LOG_ENABLED(logger, level) \
+    (::Preprocessor::isLogLevelCompiled(level) && (logger) && (logger)->isEnabled(level))
+
+#define PP_LOG_AT(logger, level, method, ...) \
+    do { \
+        if (PP_LOG_ENABLED(logger, level)) { \
+            (logger)->method(__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define PP_LOG_DEBUG(logger, ...)   PP_LOG_AT(logger, ::Preprocessor::LogLevel::DEBUG, debug, __VA_ARGS__)
+#define PP_LOG_INFO(logger, ...)    PP_LOG_AT(logger, ::Preprocessor::LogLevel::INFO, info, __VA_ARGS__)
+#define PP_LOG_WARNING(logger, ...) PP_LOG_AT(logger, ::Preprocessor::LogLevel::WARNING, warning, __VA_ARGS__)
+#define PP_LOG_ERROR(logger, ...)   PP_LOG_AT(logger, ::Preprocessor::LogLevel::ERROR, error, __VA_ARGS__)
+
 // Funções utilitárias globais
 std::string logLevelToString(LogLevel level);
 LogLevel stringToLogLevel(const std::string& levelStr);
@@ -0,0 +1,192 @@
+#ifndef PREPROCESSOR_SERVER_HPP
+#define PREPROCESSOR_SERVER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "preprocessor.hpp"
+
+namespace Preprocessor {
+
+/**
+ * @brief Opções do servidor de pré-processamento
+ */
+struct ServerOptions {
+    std::string socket_path;                                  ///< Caminho do socket Unix
+    size_t worker_count = 0;                                  ///< Conexões atendidas em paralelo (0 = núcleos disponíveis)
+    std::string config_file;                                  ///< Arquivo de configuração das instâncias
+    std::vector<std::string> include_paths;                   ///< Caminhos de busca (vazio = padrão do PreprocessorMain)
+    std::string snapshot_file;                                ///< Snapshot de macros restaurado antes de cada requisição
+    ProcessingProfile profile = ProcessingProfile::CHECKED;   ///< Perfil de desempenho
+    int idle_timeout_ms = 30000;                              ///< Conexão sem requisições por mais tempo é fechada (0 = sem limite)
+};
+
+/**
+ * @brief Operações aceitas pelo servidor
+ */
+enum class ServerRequestType : uint8_t {
+    PREPROCESS = 1,   ///< Pré-processa um arquivo
+    STATISTICS = 2,   ///< Retorna as estatísticas do servidor em JSON
+    SHUTDOWN = 3      ///< Encerra o servidor após a resposta
+};
+
+/**
+ * @brief Requisição de um cliente
+ */
+struct ServerRequest {
+    ServerRequestType type = ServerRequestType::PREPROCESS;
+    std::string filename;                                       ///< Arquivo de entrada (caminho absoluto)
+    std::vector<std::pair<std::string, std::string>> macros;    ///< Macros definidas só nesta requisição
+};
+
+/**
+ * @brief Resposta do servidor
+ */
+struct ServerResponse {
+    bool success = false;
+    std::string expanded_code;               ///< Código expandido (PREPROCESS)
+    std::vector<std::string> dependencies;   ///< Arquivos lidos pela unidade (PREPROCESS)
+    std::string message;                     ///< Mensagem de erro ou estatísticas em JSON
+};
+
+/**
+ * @brief Protocolo binário entre cliente e servidor
+ *
+ * Cada mensagem é um quadro: tamanho (u32 little-endian) seguido de um
+ * payload selado com BinaryFormat::seal() (magic, versão e checksum).
+ */
+namespace ServerProtocol {
+
+std::string encodeRequest(const ServerRequest& request);
+bool decodeRequest(const std::string& frame, ServerRequest& request);
+std::string encodeResponse(const ServerResponse& response);
+bool decodeResponse(const std::string& frame, ServerResponse& response);
+
+/**
+ * @brief Envia um quadro completo
+ * @return false se a conexão foi fechada ou houve erro de escrita
+ */
+bool writeFrame(int fd, const std::string& frame);
+
+/**
+ * @brief Lê um quadro completo
+ * @return false no fim da conexão, erro de leitura ou tamanho acima do limite
+ */
+bool readFrame(int fd, std::string& frame);
+
+} // namespace ServerProtocol
+
+/**
+ * @brief Servidor de longa duração que mantém os caches aquecidos
+ *
+ * Escuta em um socket Unix e atende cada conexão com um PreprocessorMain
+ * reutilizado pela thread de trabalho (reset() entre requisições), de modo
+ * que configuração, macros predefinidas e expressões #if compiladas não
+ * são reconstruídas a cada arquivo. Todas as threads compartilham um único
+ * FileManager, com a observação de mudanças ativa quando disponível.
+ */
+class PreprocessorServer {
+public:
+    /**
+     * @brief Cria o servidor e o FileManager compartilhado
+     * @param options Opções aplicadas a todas as requisições
+     */
+    explicit PreprocessorServer(ServerOptions options);
+
+    /**
+     * @brief Encerra o servidor e remove o socket
+     */
+    ~PreprocessorServer();
+
+    PreprocessorServer(const PreprocessorServer&) = delete;
+    PreprocessorServer& operator=(const PreprocessorServer&) = delete;
+
+    /**
+     * @brief Cria o socket e começa a escutar
+     * @return false se o socket não pôde ser criado (outro servidor ativo, caminho inválido
+     *         ou ocupado por algo que não é um socket)
+     */
+    bool start();
+
+    /**
+     * @brief Atende conexões até uma requisição SHUTDOWN ou uma chamada a stop()
+     */
+    void serve();
+
+    /**
+     * @brief Solicita o encerramento; serve() retorna após concluir as conexões em andamento
+     * 
+     * Conexões abertas deixam de receber requisições (a leitura é encerrada),
+     * mas a resposta em andamento ainda é enviada.
+     */
+    void stop();
+
+    /**
+     * @brief Número de requisições atendidas
+     */
+    size_t getRequestCount() const { return request_count_.load(); }
+
+    /**
+     * @brief FileManager compartilhado pelas requisições
+     */
+    const std::shared_ptr<FileManager>& getFileManager() const { return file_manager_; }
+
+private:
+    /**
+     * @brief Laço de uma thread de trabalho: retira conexões da fila
+     */
+    void workerLoop();
+
+    /**
+     * @brief Atende todas as requisições de uma conexão
+     * @param fd Socket da conexão (fechado ao final)
+     * @param preprocessor Instância da thread
+     */
+    void handleConnection(int fd, PreprocessorMain& preprocessor);
+
+    /**
+     * @brief Executa uma requisição
+     */
+    ServerResponse handleRequest(const ServerRequest& request, PreprocessorMain& preprocessor);
+
+    /**
+     * @brief Estatísticas do servidor e do FileManager em JSON
+     */
+    std::string statisticsJson() const;
+
+    ServerOptions options_;
+    std::shared_ptr<FileManager> file_manager_;
+    size_t worker_count_;
+    int listen_fd_;
+    std::atomic<bool> running_;
+    std::atomic<size_t> request_count_;
+
+    std::mutex queue_mutex_;
+    std::condition_variable queue_ready_;
+    std::queue<int> pending_connections_;
+    std::vector<std::thread> workers_;
+
+    std::mutex connections_mutex_;
+    std::unordered_set<int> active_connections_;   // Conexões em atendimento, encerradas por stop()
+};
+
+/**
+ * @brief Envia uma requisição a um servidor e aguarda a resposta
+ * @param socket_path Socket do servidor
+ * @param request Requisição
+ * @param response Recebe a resposta
+ * @return false se não foi possível conectar ou a resposta é inválida
+ */
+bool sendServerRequest(const std::string& socket_path, const ServerRequest& request, ServerResponse& response);
+
+} // namespace Preprocessor
+
+#endif // PREPROCESSOR_SERVER_HPP
@@ -2,6 +2,10 @@
 #define PREPROCESSOR_TYPES_HPP
 
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
 
 namespace Preprocessor {
 
@@ -57,6 +61,167 @@ struct PreprocessorPosition {
     }
 };
 
+/**
+ * @brief Sequência contígua de linhas expandidas vindas do mesmo arquivo
+ * 
+ * A linha expandida L dentro da sequência corresponde à linha original
+ * originalLine + (L - expandedLine).
+ */
+struct LineRun {
+    uint32_t expandedLine;  ///< Primeira linha expandida da sequência
+    uint32_t originalLine;  ///< Linha original correspondente à primeira
+    uint32_t fileIndex;     ///< Índice na tabela de arquivos do LineMap
+};
+
+/**
+ * @brief Emendas (barra invertida + quebra de linha) da linha lógica que ocupa uma linha expandida
+ * 
+ * Os deslocamentos [begin, begin + count) da tabela do LineMap indicam, na
+ * linha lógica, onde começa cada linha física após a primeira.
+ */
+struct LineSplice {
+    uint32_t expandedLine;  ///< Linha expandida da linha lógica emendada
+    uint32_t begin;         ///< Primeiro deslocamento na tabela de colunas
+    uint32_t count;         ///< Número de emendas (linhas físicas - 1)
+};
+
+/**
+ * @brief Tabela de linhas codificada por sequências (run-length)
+ * 
+ * Somente aceita inserções em ordem crescente de linha expandida; linhas que
+ * continuam a sequência anterior não geram entrada nova. A consulta é uma
+ * busca binária sobre as sequências. Linhas lógicas emendadas guardam também
+ * os deslocamentos das emendas, para que colunas após uma emenda sejam
+ * resolvidas para a linha e coluna físicas.
+ */
+class LineMap {
+public:
+    /**
+     * @brief Registra que a linha expandida veio de (arquivo, linha original)
+     * @return false se a linha não é posterior à última registrada
+     */
+    bool append(uint32_t expandedLine, uint32_t originalLine, const std::string& file) {
+        if (!runs_.empty() && expandedLine <= last_expanded_) {
+            return false;
+        }
+        uint32_t file_index = internFile(file);
+        if (!runs_.empty()) {
+            const LineRun& last = runs_.back();
+            if (last.fileIndex == file_index &&
+                originalLine >= last.originalLine &&
+                expandedLine - last.expandedLine == originalLine - last.originalLine) {
+                last_expanded_ = expandedLine;
+                return true;
+            }
+        }
+        runs_.push_back(LineRun{expandedLine, originalLine, file_index});
+        last_expanded_ = expandedLine;
+        return true;
+    }
+    
+    /**
+     * @brief Resolve uma linha expandida para a posição original
+     * @return false se a linha é anterior à primeira sequência
+     */
+    bool lookup(uint32_t expandedLine, uint32_t& originalLine, const std::string*& file) const {
+        auto it = std::upper_bound(runs_.begin(), runs_.end(), expandedLine,
+            [](uint32_t line, const LineRun& run) { return line < run.expandedLine; });
+        if (it == runs_.begin()) {
+            return false;
+        }
+        --it;
+        originalLine = it->originalLine + (expandedLine - it->expandedLine);
+        file = &files_[it->fileIndex];
+        return true;
+    }
+    
+    /**
+     * @brief Registra as emendas da linha lógica que ocupa a linha expandida
+     * @param columns Deslocamento, na linha lógica, do início de cada linha física seguinte
+     * @return false se não há emendas ou a linha não é posterior à última registrada
+     */
+    bool appendSplices(uint32_t expandedLine, const std::vector<size_t>& columns) {
+        if (columns.empty() || (!splices_.empty() && expandedLine <= splices_.back().expandedLine)) {
+            return false;
+        }
+        splices_.push_back(LineSplice{expandedLine, static_cast<uint32_t>(splice_columns_.size()),
+                                      static_cast<uint32_t>(columns.size())});
+        for (size_t column : columns) {
+            splice_columns_.push_back(static_cast<uint32_t>(column));
+        }
+        return true;
+    }
+    
+    /**
+     * @brief Resolve linha e coluna expandidas para a posição física original
+     * 
+     * A coluna é tomada como coluna da linha lógica; após uma emenda ela cai
+     * nas linhas físicas seguintes.
+     * @return false se a linha é anterior à primeira sequência
+     */
+    bool lookup(uint32_t expandedLine, uint32_t column, uint32_t& originalLine, uint32_t& originalColumn,
+                const std::string*& file) const {
+        if (!lookup(expandedLine, originalLine, file)) {
+            return false;
+        }
+        originalColumn = column;
+        auto it = std::lower_bound(splices_.begin(), splices_.end(), expandedLine,
+            [](const LineSplice& splice, uint32_t line) { return splice.expandedLine < line; });
+        if (it != splices_.end() && it->expandedLine == expandedLine) {
+            for (uint32_t i = 0; i < it->count; ++i) {
+                const uint32_t start = splice_columns_[it->begin + i];
+                if (column <= start) {
+                    break;
+                }
+                originalLine++;
+                originalColumn = column - start;
+            }
+        }
+        return true;
+    }
+    
+    const std::vector<LineRun>& runs() const { return runs_; }
+    const std::vector<LineSplice>& splices() const { return splices_; }
+    const std::vector<uint32_t>& spliceColumns() const { return splice_columns_; }
+    const std::string& fileName(uint32_t index) const { return files_[index]; }
+    size_t runCount() const { return runs_.size(); }
+    size_t fileCount() const { return files_.size(); }
+    bool empty() const { return runs_.empty(); }
+    void reserve(size_t runs) { runs_.reserve(runs); }
+    
+    void clear() {
+        runs_.clear();
+        splices_.clear();
+        splice_columns_.clear();
+        files_.clear();
+        file_indices_.clear();
+        last_expanded_ = 0;
+    }
+    
+private:
+    uint32_t internFile(const std::string& file) {
+        // Linhas consecutivas quase sempre vêm do mesmo arquivo
+        if (!runs_.empty() && files_[runs_.back().fileIndex] == file) {
+            return runs_.back().fileIndex;
+        }
+        auto it = file_indices_.find(file);
+        if (it != file_indices_.end()) {
+            return it->second;
+        }
+        uint32_t index = static_cast<uint32_t>(files_.size());
+        files_.push_back(file);
+        file_indices_.emplace(file, index);
+        return index;
+    }
+    
+    std::vector<LineRun> runs_;
+    std::vector<LineSplice> splices_;
+    std::vector<uint32_t> splice_columns_;
+    std::vector<std::string> files_;
+    std::unordered_map<std::string, uint32_t> file_indices_;
+    uint32_t last_expanded_ = 0;
+};
+
 } // namespace Preprocessor
 
 #endif // PREPROCESSOR_TYPES_HPP
\ No newline at end of file
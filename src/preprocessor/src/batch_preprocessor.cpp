@@ -0,0 +1,201 @@
+#include "../include/batch_preprocessor.hpp"
+#include "../include/binary_format.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+namespace Preprocessor {
+
+BatchPreprocessor::BatchPreprocessor(BatchOptions options)
+    : options_(std::move(options)),
+      file_manager_(std::make_shared<FileManager>()),
+      worker_count_(options_.worker_count) {
+    if (worker_count_ == 0) {
+        worker_count_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+    
+    // Mesmos caminhos que uma instância isolada usaria
+    if (options_.include_paths.empty()) {
+        file_manager_->setSearchPaths({"/usr/include", "/usr/local/include", "."});
+    } else {
+        file_manager_->setSearchPaths(options_.include_paths);
+    }
+}
+
+std::vector<BatchUnitResult> BatchPreprocessor::process(const std::vector<std::string>& files) {
+    std::vector<BatchUnitResult> results(files.size());
+    if (files.empty()) {
+        return results;
+    }
+    
+    // O grafo só é lido pelas threads; as atualizações são aplicadas ao final
+    const bool incremental = !options_.dependency_graph_file.empty() && !options_.output_directory.empty();
+    DependencyGraph graph;
+    if (incremental) {
+        graph.load(options_.dependency_graph_file);
+    }
+    const uint64_t configuration = configurationFingerprint();
+    std::vector<DependencyRecord> records(files.size());
+    
+    // Duas unidades com a mesma saída se sobrescreveriam (e o grafo daria ambas por atualizadas)
+    if (!options_.output_directory.empty()) {
+        std::unordered_map<std::string, size_t> owners;
+        bool conflict = false;
+        for (size_t i = 0; i < files.size(); ++i) {
+            results[i].filename = files[i];
+            auto inserted = owners.emplace(outputPath(files[i], ".i"), i);
+            if (!inserted.second) {
+                const size_t owner = inserted.first->second;
+                results[i].error = "Saída " + inserted.first->first + " também gerada por " + files[owner];
+                if (results[owner].error.empty()) {
+                    results[owner].error = "Saída " + inserted.first->first + " também gerada por " + files[i];
+                }
+                conflict = true;
+            }
+        }
+        if (conflict) {
+            for (auto& result : results) {
+                if (result.error.empty()) {
+                    result.error = "Lote cancelado: unidades com saídas em conflito";
+                }
+            }
+            return results;
+        }
+    }
+    
+    // Cada thread retira o próximo índice livre; arquivos grandes não atrasam os demais
+    std::atomic<size_t> next_index{0};
+    auto worker = [&]() {
+        for (size_t i = next_index.fetch_add(1); i < files.size(); i = next_index.fetch_add(1)) {
+            processUnit(files[i], incremental ? &graph : nullptr, configuration, results[i], records[i]);
+        }
+    };
+    
+    const size_t thread_count = std::min(worker_count_, files.size());
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    if (incremental) {
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (!results[i].success) {
+                graph.remove(files[i]);
+            } else if (!results[i].up_to_date && !records[i].translation_unit.empty()) {
+                graph.update(std::move(records[i]));
+            }
+        }
+        graph.save(options_.dependency_graph_file);
+    }
+    
+    return results;
+}
+
+uint64_t BatchPreprocessor::configurationFingerprint() const {
+    std::string description = "profile=" + processingProfileToString(options_.profile);
+    description += "\nfollow_system=" + std::string(options_.follow_system_includes ? "1" : "0");
+    for (const auto& path : file_manager_->getSearchPaths()) {
+        description += "\npath=" + path;
+    }
+    description += "\nconfig=" + options_.config_file;
+    uint64_t config_hash = 0;
+    if (!options_.config_file.empty() && file_manager_->getContentHash(options_.config_file, config_hash)) {
+        description += "#" + std::to_string(config_hash);
+    }
+    return BinaryFormat::checksum(description.data(), description.size());
+}
+
+std::string BatchPreprocessor::outputPath(const std::string& filename, const char* extension) const {
+    std::error_code error;
+    const std::filesystem::path source = std::filesystem::absolute(filename, error).lexically_normal();
+    std::filesystem::path root = std::filesystem::absolute(
+        options_.source_root.empty() ? std::string(".") : options_.source_root, error).lexically_normal();
+    if (!root.has_filename()) {
+        root = root.parent_path();
+    }
+    
+    // Fora da raiz: o caminho absoluto inteiro mantém homônimos separados
+    std::filesystem::path relative = source.lexically_relative(root);
+    if (relative.empty() || *relative.begin() == "..") {
+        relative = source.relative_path();
+    }
+    relative.replace_extension(extension);
+    return (std::filesystem::path(options_.output_directory) / relative).string();
+}
+
+void BatchPreprocessor::processUnit(const std::string& filename, const DependencyGraph* graph,
+                                    uint64_t configuration, BatchUnitResult& result,
+                                    DependencyRecord& record) const {
+    result.filename = filename;
+    const bool write_outputs = !options_.output_directory.empty();
+    if (write_outputs) {
+        result.output_file = outputPath(filename, ".i");
+        result.depfile = outputPath(filename, ".d");
+    }
+    
+    // Saída anterior ainda válida: nada a reprocessar
+    if (graph) {
+        const DependencyRecord* previous = graph->find(filename);
+        if (previous && previous->output_file == result.output_file &&
+            DependencyGraph::isUpToDate(*previous, configuration, options_.macros, *file_manager_)) {
+            result.success = true;
+            result.up_to_date = true;
+            for (const auto& input : previous->inputs) {
+                result.dependencies.push_back(input.path);
+            }
+            return;
+        }
+    }
+    
+    // Registro antes do processamento: as entradas são identificadas e lidas
+    // (para o cache compartilhado) antes que o processamento as consuma
+    if (write_outputs &&
+        !DependencyGraph::buildRecord(filename, configuration, options_.macros, *file_manager_,
+                                      options_.follow_system_includes, record)) {
+        result.success = false;
+        return;
+    }
+    
+    try {
+        PreprocessorMain preprocessor(options_.config_file, file_manager_);
+        preprocessor.setProcessingProfile(options_.profile);
+        for (const auto& macro : options_.macros) {
+            preprocessor.defineMacro(macro.first, macro.second);
+        }
+        
+        result.success = preprocessor.process(filename);
+        result.expanded_code = preprocessor.takeExpandedCode();
+        result.dependencies = preprocessor.getDependencies();
+    } catch (const std::exception&) {
+        // Erros já foram registrados pelo logger da instância
+        result.success = false;
+    }
+    
+    if (!result.success || !write_outputs) {
+        record = DependencyRecord();
+        return;
+    }
+    
+    // Saída e regra de Make
+    record.output_file = result.output_file;
+    result.dependencies.clear();
+    for (const auto& input : record.inputs) {
+        result.dependencies.push_back(input.path);
+    }
+    
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(result.output_file).parent_path(), error);
+    if (!BinaryFormat::writeFileAtomically(result.output_file, result.expanded_code) ||
+        !BinaryFormat::writeFileAtomically(result.depfile, DependencyGraph::makeDepfile(result.output_file, record))) {
+        result.success = false;
+        record = DependencyRecord();
+    }
+}
+
+} // namespace Preprocessor
@@ -0,0 +1,434 @@
+#include "../include/block_codec.hpp"
+#include <cstring>
+
+namespace Preprocessor {
+
+namespace {
+
+constexpr char FRAME_MAGIC[4] = {'P', 'P', 'L', 'Z'};
+constexpr size_t FRAME_HEADER_SIZE = 8;
+constexpr uint32_t STORED_BLOCK_FLAG = 0x80000000u;
+
+// Limites do formato de bloco: os últimos 5 bytes são sempre literais e
+// nenhuma referência começa nos últimos 12
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t LAST_LITERALS = 5;
+constexpr size_t MATCH_FIND_LIMIT = 12;
+constexpr size_t MAX_OFFSET = 65535;
+
+constexpr int HASH_LOG = 13;
+// Após 2^SKIP_TRIGGER tentativas sem sucesso o passo aumenta (dados incompressíveis)
+constexpr int SKIP_TRIGGER = 6;
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t hashPosition(const unsigned char* p) {
+    return (read32(p) * 2654435761u) >> (32 - HASH_LOG);
+}
+
+inline void putU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+inline void putU64(std::string& out, uint64_t value) {
+    putU32(out, static_cast<uint32_t>(value));
+    putU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+inline uint32_t getU32(const char* p) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    }
+    return value;
+}
+
+inline uint64_t getU64(const char* p) {
+    return static_cast<uint64_t>(getU32(p)) | (static_cast<uint64_t>(getU32(p + 4)) << 32);
+}
+
+// Comprimento acima de 15 continua em bytes de 255 (formato LZ4)
+inline unsigned char* putLength(unsigned char* op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = static_cast<unsigned char>(length);
+    return op;
+}
+
+inline bool readLength(const unsigned char*& ip, const unsigned char* end, size_t& length) {
+    unsigned char byte;
+    do {
+        if (ip >= end) {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+unsigned char* putSequence(unsigned char* op, const unsigned char* literals, size_t literal_length,
+                           size_t offset, size_t match_length) {
+    unsigned char* token = op++;
+    *token = static_cast<unsigned char>((literal_length >= 15 ? 15 : literal_length) << 4);
+    if (literal_length >= 15) {
+        op = putLength(op, literal_length - 15);
+    }
+    std::memcpy(op, literals, literal_length);
+    op += literal_length;
+    if (match_length == 0) {
+        return op;
+    }
+
+    *op++ = static_cast<unsigned char>(offset & 0xFF);
+    *op++ = static_cast<unsigned char>(offset >> 8);
+    const size_t extra = match_length - MIN_MATCH;
+    *token |= static_cast<unsigned char>(extra >= 15 ? 15 : extra);
+    if (extra >= 15) {
+        op = putLength(op, extra - 15);
+    }
+    return op;
+}
+
+// Grava um bloco no quadro: comprimido, ou cru quando não encolhe
+void appendBlock(std::string& frame, const char* data, size_t size, std::string& scratch) {
+    scratch.resize(BlockCodec::compressBound(size));
+    const size_t compressed = BlockCodec::compressBlock(data, size, &scratch[0]);
+    if (compressed < size) {
+        putU32(frame, static_cast<uint32_t>(compressed));
+        frame.append(scratch.data(), compressed);
+    } else {
+        putU32(frame, static_cast<uint32_t>(size) | STORED_BLOCK_FLAG);
+        frame.append(data, size);
+    }
+}
+
+void appendHeader(std::string& frame) {
+    frame.append(FRAME_MAGIC, sizeof(FRAME_MAGIC));
+    putU32(frame, static_cast<uint32_t>(BlockCodec::BLOCK_SIZE));
+}
+
+void appendTrailer(std::string& frame, uint64_t hash) {
+    putU32(frame, 0);
+    putU64(frame, hash);
+}
+
+} // namespace
+
+// ============================================================================
+// Blocos
+// ============================================================================
+
+size_t BlockCodec::compressBlock(const char* source, size_t size, char* destination) {
+    const unsigned char* const base = reinterpret_cast<const unsigned char*>(source);
+    const unsigned char* const end = base + size;
+    unsigned char* op = reinterpret_cast<unsigned char*>(destination);
+    const unsigned char* anchor = base;
+
+    if (size > MATCH_FIND_LIMIT) {
+        // Posições relativas ao início do bloco cabem em 16 bits
+        uint16_t table[1 << HASH_LOG] = {};
+        const unsigned char* const match_limit = end - LAST_LITERALS;
+        const unsigned char* const find_limit = end - MATCH_FIND_LIMIT;
+        const unsigned char* ip = base + 1;
+
+        while (ip < find_limit) {
+            const unsigned char* reference = nullptr;
+            unsigned attempts = 1u << SKIP_TRIGGER;
+            for (;;) {
+                const uint32_t hash = hashPosition(ip);
+                reference = base + table[hash];
+                table[hash] = static_cast<uint16_t>(ip - base);
+                if (reference < ip && static_cast<size_t>(ip - reference) <= MAX_OFFSET &&
+                    read32(reference) == read32(ip)) {
+                    break;
+                }
+                ip += attempts++ >> SKIP_TRIGGER;
+                if (ip >= find_limit) {
+                    reference = nullptr;
+                    break;
+                }
+            }
+            if (!reference) {
+                break;
+            }
+
+            while (ip > anchor && reference > base && ip[-1] == reference[-1]) {
+                --ip;
+                --reference;
+            }
+
+            const unsigned char* match_end = ip + MIN_MATCH;
+            const unsigned char* reference_end = reference + MIN_MATCH;
+            while (match_end < match_limit && *match_end == *reference_end) {
+                ++match_end;
+                ++reference_end;
+            }
+
+            op = putSequence(op, anchor, static_cast<size_t>(ip - anchor),
+                             static_cast<size_t>(ip - reference), static_cast<size_t>(match_end - ip));
+            ip = match_end;
+            anchor = ip;
+
+            if (ip < find_limit) {
+                table[hashPosition(ip - 2)] = static_cast<uint16_t>(ip - 2 - base);
+            }
+        }
+    }
+
+    op = putSequence(op, anchor, static_cast<size_t>(end - anchor), 0, 0);
+    return static_cast<size_t>(op - reinterpret_cast<unsigned char*>(destination));
+}
+
+bool BlockCodec::decompressBlock(const char* source, size_t size, char* destination,
+                                 size_t capacity, size_t& written) {
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(source);
+    const unsigned char* const input_end = ip + size;
+    unsigned char* const output = reinterpret_cast<unsigned char*>(destination);
+    unsigned char* op = output;
+    unsigned char* const output_end = output + capacity;
+
+    while (ip < input_end) {
+        const unsigned char token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !readLength(ip, input_end, literal_length)) {
+            return false;
+        }
+        if (literal_length > static_cast<size_t>(input_end - ip) ||
+            literal_length > static_cast<size_t>(output_end - op)) {
+            return false;
+        }
+        std::memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        // A última sequência só tem literais
+        if (ip == input_end) {
+            break;
+        }
+
+        if (input_end - ip < 2) {
+            return false;
+        }
+        const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - output)) {
+            return false;
+        }
+
+        size_t match_length = token & 0x0F;
+        if (match_length == 15 && !readLength(ip, input_end, match_length)) {
+            return false;
+        }
+        match_length += MIN_MATCH;
+        if (match_length > static_cast<size_t>(output_end - op)) {
+            return false;
+        }
+
+        const unsigned char* match = op - offset;
+        if (offset >= match_length) {
+            std::memcpy(op, match, match_length);
+            op += match_length;
+        } else {
+            // Sobreposição: a referência repete bytes recém-escritos
+            for (size_t i = 0; i < match_length; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    written = static_cast<size_t>(op - output);
+    return true;
+}
+
+// ============================================================================
+// Quadros em memória
+// ============================================================================
+
+bool BlockCodec::isFrame(const char* data, size_t size) {
+    return size >= FRAME_HEADER_SIZE && std::memcmp(data, FRAME_MAGIC, sizeof(FRAME_MAGIC)) == 0;
+}
+
+std::string BlockCodec::compress(const char* data, size_t size) {
+    std::string frame;
+    frame.reserve(FRAME_HEADER_SIZE + size / 2 + 16);
+    appendHeader(frame);
+
+    std::string scratch;
+    for (size_t offset = 0; offset < size; offset += BLOCK_SIZE) {
+        const size_t length = size - offset < BLOCK_SIZE ? size - offset : BLOCK_SIZE;
+        appendBlock(frame, data + offset, length, scratch);
+    }
+
+    appendTrailer(frame, ContentHash::compute(data, size));
+    return frame;
+}
+
+bool BlockCodec::decompress(const char* data, size_t size, std::string& output) {
+    output.clear();
+    if (!isFrame(data, size)) {
+        return false;
+    }
+    const size_t block_size = getU32(data + sizeof(FRAME_MAGIC));
+    if (block_size == 0 || block_size > BLOCK_SIZE) {
+        return false;
+    }
+
+    size_t position = FRAME_HEADER_SIZE;
+    for (;;) {
+        if (size - position < 4) {
+            return false;
+        }
+        const uint32_t header = getU32(data + position);
+        position += 4;
+        if (header == 0) {
+            break;
+        }
+
+        const size_t stored = header & ~STORED_BLOCK_FLAG;
+        if (stored > size - position || stored > compressBound(block_size)) {
+            return false;
+        }
+        if (header & STORED_BLOCK_FLAG) {
+            if (stored > block_size) {
+                return false;
+            }
+            output.append(data + position, stored);
+        } else {
+            const size_t start = output.size();
+            output.resize(start + block_size);
+            size_t written = 0;
+            if (!decompressBlock(data + position, stored, &output[start], block_size, written)) {
+                return false;
+            }
+            output.resize(start + written);
+        }
+        position += stored;
+    }
+
+    if (size - position != 8) {
+        return false;
+    }
+    return getU64(data + position) == ContentHash::compute(output.data(), output.size());
+}
+
+// ============================================================================
+// Quadros em fluxo
+// ============================================================================
+
+BlockCodec::Encoder::Encoder(std::ostream& output)
+    : output_(output), finished_(false) {
+    std::string header;
+    appendHeader(header);
+    output_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    pending_.reserve(BLOCK_SIZE);
+}
+
+void BlockCodec::Encoder::write(const char* data, size_t size) {
+    hash_.update(data, size);
+    while (size > 0) {
+        const size_t room = BLOCK_SIZE - pending_.size();
+        const size_t length = size < room ? size : room;
+        pending_.append(data, length);
+        data += length;
+        size -= length;
+        if (pending_.size() == BLOCK_SIZE) {
+            flushBlock();
+        }
+    }
+}
+
+void BlockCodec::Encoder::flushBlock() {
+    std::string block;
+    appendBlock(block, pending_.data(), pending_.size(), compressed_);
+    output_.write(block.data(), static_cast<std::streamsize>(block.size()));
+    pending_.clear();
+}
+
+bool BlockCodec::Encoder::finish() {
+    if (!finished_) {
+        if (!pending_.empty()) {
+            flushBlock();
+        }
+        std::string trailer;
+        appendTrailer(trailer, hash_.digest());
+        output_.write(trailer.data(), static_cast<std::streamsize>(trailer.size()));
+        output_.flush();
+        finished_ = true;
+    }
+    return output_.good();
+}
+
+BlockCodec::Decoder::Decoder(std::istream& input)
+    : input_(input), started_(false), done_(false), failed_(false) {}
+
+bool BlockCodec::Decoder::fail() {
+    failed_ = true;
+    done_ = true;
+    return false;
+}
+
+bool BlockCodec::Decoder::next(std::string& block) {
+    block.clear();
+    if (done_) {
+        return false;
+    }
+
+    char header[FRAME_HEADER_SIZE];
+    if (!started_) {
+        if (!input_.read(header, FRAME_HEADER_SIZE) || !isFrame(header, FRAME_HEADER_SIZE) ||
+            getU32(header + sizeof(FRAME_MAGIC)) != BLOCK_SIZE) {
+            return fail();
+        }
+        started_ = true;
+    }
+
+    if (!input_.read(header, 4)) {
+        return fail();
+    }
+    const uint32_t block_header = getU32(header);
+
+    // Marcador final: confere o checksum do conteúdo entregue
+    if (block_header == 0) {
+        if (!input_.read(header, 8) || getU64(header) != hash_.digest()) {
+            return fail();
+        }
+        done_ = true;
+        return false;
+    }
+
+    const size_t stored = block_header & ~STORED_BLOCK_FLAG;
+    if (stored > compressBound(BLOCK_SIZE) || ((block_header & STORED_BLOCK_FLAG) && stored > BLOCK_SIZE)) {
+        return fail();
+    }
+    if (block_header & STORED_BLOCK_FLAG) {
+        block.resize(stored);
+        if (!input_.read(&block[0], static_cast<std::streamsize>(stored))) {
+            return fail();
+        }
+    } else {
+        compressed_.resize(stored);
+        if (!input_.read(&compressed_[0], static_cast<std::streamsize>(stored))) {
+            return fail();
+        }
+        block.resize(BLOCK_SIZE);
+        size_t written = 0;
+        if (!decompressBlock(compressed_.data(), stored, &block[0], BLOCK_SIZE, written)) {
+            return fail();
+        }
+        block.resize(written);
+    }
+    hash_.update(block.data(), block.size());
+    return true;
+}
+
+} // namespace Preprocessor
@@ -21,7 +21,7 @@ ConditionalProcessor::ConditionalProcessor(PreprocessorLogger* logger, MacroProc
       external_error_handler_(nullptr) {
     // Inicializar logger
     if (logger_) {
-        logger_->info("ConditionalProcessor initialized");
+        PP_LOG_INFO(logger_, "ConditionalProcessor initialized");
     }
 }
 
@@ -48,7 +48,7 @@ bool ConditionalProcessor::pushConditionalContext(bool condition, ConditionalTyp
         }
         
         if (logger_) {
-            logger_->info("Pushed conditional context: " + conditionalTypeToString(type));
+            PP_LOG_INFO(logger_, "Pushed conditional context: " + conditionalTypeToString(type));
         }
         
         return true;
@@ -75,7 +75,7 @@ bool ConditionalProcessor::popConditionalContext() {
         context_stack_.pop();
         
         if (logger_) {
-            logger_->info("Popped conditional context: " + conditionalTypeToString(context.type));
+            PP_LOG_INFO(logger_, "Popped conditional context: " + conditionalTypeToString(context.type));
         }
         
         return true;
@@ -415,7 +415,7 @@ void ConditionalProcessor::optimizeConditionalEvaluation(bool enable) {
     
     if (logger_) {
         std::string status = enable ? "enabled" : "disabled";
-        logger_->info("Conditional evaluation optimization " + status);
+        PP_LOG_INFO(logger_, "Conditional evaluation optimization " + status);
     }
 }
 
@@ -439,7 +439,7 @@ void ConditionalProcessor::reset() {
     statistics_ = ConditionalStats(); // Reset statistics
     
     if (logger_) {
-        logger_->info("ConditionalProcessor reset completed");
+        PP_LOG_INFO(logger_, "ConditionalProcessor reset completed");
     }
 }
 
@@ -0,0 +1,191 @@
+#include "../include/content_hash.hpp"
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Preprocessor {
+
+namespace {
+
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+inline uint64_t rotl64(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Leituras little-endian; memcpy evita acessos desalinhados
+inline uint64_t read64(const unsigned char* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t round64(uint64_t accumulator, uint64_t input) {
+    accumulator += input * PRIME64_2;
+    accumulator = rotl64(accumulator, 31);
+    return accumulator * PRIME64_1;
+}
+
+inline uint64_t mergeRound(uint64_t hash, uint64_t accumulator) {
+    hash ^= round64(0, accumulator);
+    return hash * PRIME64_1 + PRIME64_4;
+}
+
+} // namespace
+
+ContentHash::ContentHash(uint64_t seed)
+    : seed_(seed), buffered_(0), total_length_(0) {
+    accumulators_[0] = seed + PRIME64_1 + PRIME64_2;
+    accumulators_[1] = seed + PRIME64_2;
+    accumulators_[2] = seed;
+    accumulators_[3] = seed - PRIME64_1;
+}
+
+void ContentHash::consumeStripe(const unsigned char* stripe) {
+    accumulators_[0] = round64(accumulators_[0], read64(stripe));
+    accumulators_[1] = round64(accumulators_[1], read64(stripe + 8));
+    accumulators_[2] = round64(accumulators_[2], read64(stripe + 16));
+    accumulators_[3] = round64(accumulators_[3], read64(stripe + 24));
+}
+
+void ContentHash::update(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    total_length_ += size;
+
+    // Completa o bloco pendente da chamada anterior
+    if (buffered_ > 0) {
+        size_t needed = sizeof(buffer_) - buffered_;
+        if (size < needed) {
+            std::memcpy(buffer_ + buffered_, p, size);
+            buffered_ += size;
+            return;
+        }
+        std::memcpy(buffer_ + buffered_, p, needed);
+        consumeStripe(buffer_);
+        p += needed;
+        buffered_ = 0;
+    }
+
+    while (end - p >= 32) {
+        consumeStripe(p);
+        p += 32;
+    }
+
+    if (p < end) {
+        buffered_ = static_cast<size_t>(end - p);
+        std::memcpy(buffer_, p, buffered_);
+    }
+}
+
+uint64_t ContentHash::digest() const {
+    uint64_t hash;
+    if (total_length_ >= 32) {
+        hash = rotl64(accumulators_[0], 1) + rotl64(accumulators_[1], 7) +
+               rotl64(accumulators_[2], 12) + rotl64(accumulators_[3], 18);
+        for (uint64_t accumulator : accumulators_) {
+            hash = mergeRound(hash, accumulator);
+        }
+    } else {
+        hash = seed_ + PRIME64_5;
+    }
+    hash += total_length_;
+
+    const unsigned char* p = buffer_;
+    const unsigned char* end = buffer_ + buffered_;
+    while (end - p >= 8) {
+        hash ^= round64(0, read64(p));
+        hash = rotl64(hash, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (end - p >= 4) {
+        hash ^= static_cast<uint64_t>(read32(p)) * PRIME64_1;
+        hash = rotl64(hash, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        hash ^= (*p) * PRIME64_5;
+        hash = rotl64(hash, 11) * PRIME64_1;
+        ++p;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t ContentHash::compute(const void* data, size_t size, uint64_t seed) {
+    ContentHash hasher(seed);
+    hasher.update(data, size);
+    return hasher.digest();
+}
+
+bool ContentHash::computeFile(const std::string& path, uint64_t& hash) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    ContentHash hasher;
+    const size_t size = static_cast<size_t>(info.st_size);
+    if (size > 0) {
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            ::madvise(mapped, size, MADV_SEQUENTIAL);
+            hasher.update(mapped, size);
+            ::munmap(mapped, size);
+            ::close(fd);
+            hash = hasher.digest();
+            return true;
+        }
+    }
+
+    // Sem mapeamento (arquivo vazio ou sistema de arquivos sem suporte): leitura em blocos
+    unsigned char chunk[READ_CHUNK_SIZE];
+    for (;;) {
+        ssize_t bytes = ::read(fd, chunk, sizeof(chunk));
+        if (bytes < 0) {
+            ::close(fd);
+            return false;
+        }
+        if (bytes == 0) {
+            break;
+        }
+        hasher.update(chunk, static_cast<size_t>(bytes));
+    }
+    ::close(fd);
+    hash = hasher.digest();
+    return true;
+}
+
+std::string ContentHash::toHex(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return std::string(text, 16);
+}
+
+} // namespace Preprocessor
@@ -0,0 +1,395 @@
+#include "../include/dependency_graph.hpp"
+#include "../include/binary_format.hpp"
+#include "../include/content_hash.hpp"
+#include "../include/directive_scanner.hpp"
+#include "../include/file_manager.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <unordered_set>
+#include <sys/stat.h>
+
+namespace Preprocessor {
+
+namespace {
+
+constexpr char GRAPH_MAGIC[4] = {'P', 'P', 'D', 'G'};
+constexpr uint32_t GRAPH_FORMAT_VERSION = 2;
+
+inline bool isIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_';
+}
+
+// O texto contém o identificador como palavra inteira
+bool citesIdentifier(std::string_view text, const std::string& name) {
+    size_t pos = text.find(name);
+    while (pos != std::string_view::npos) {
+        const size_t end = pos + name.size();
+        const bool starts = pos == 0 || !isIdentifierChar(text[pos - 1]);
+        const bool ends = end >= text.size() || !isIdentifierChar(text[end]);
+        if (starts && ends) {
+            return true;
+        }
+        pos = text.find(name, pos + 1);
+    }
+    return false;
+}
+
+// Nome entre aspas ou <> de um #include; vazio para inclusões por macro
+std::string_view includeTarget(std::string_view arguments, bool& is_system) {
+    arguments = stripDirectiveComment(arguments);
+    if (arguments.size() < 2) {
+        return std::string_view();
+    }
+    const char open = arguments.front();
+    const char close = open == '<' ? '>' : (open == '"' ? '"' : '\0');
+    if (close == '\0') {
+        return std::string_view();
+    }
+    const size_t end = arguments.find(close, 1);
+    if (end == std::string_view::npos) {
+        return std::string_view();
+    }
+    is_system = open == '<';
+    return arguments.substr(1, end - 1);
+}
+
+// Escapa espaços e '$' para Make
+std::string makeEscape(const std::string& path) {
+    std::string escaped;
+    escaped.reserve(path.size());
+    for (char c : path) {
+        if (c == ' ') {
+            escaped += '\\';
+        } else if (c == '$') {
+            escaped += '$';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+// Tamanho e data de modificação (ns) do arquivo
+bool statIdentity(const std::string& path, uint64_t& size, int64_t& modified_ns) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    modified_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// Persistência
+// ============================================================================
+
+bool DependencyGraph::load(const std::string& path) {
+    records_.clear();
+
+    const FileView data = FileView::open(path);
+    if (!data.valid()) {
+        return false;
+    }
+
+    const char* payload = nullptr;
+    size_t payload_size = 0;
+    if (BinaryFormat::unseal(data.data(), data.size(), GRAPH_MAGIC, GRAPH_FORMAT_VERSION,
+                             payload, payload_size) != BinaryFormat::EnvelopeStatus::OK) {
+        return false;
+    }
+
+    BinaryFormat::Reader reader(payload, payload_size);
+    uint32_t record_count = reader.u32();
+    if (record_count > payload_size) {
+        return false;
+    }
+
+    std::unordered_map<std::string, DependencyRecord> records;
+    for (uint32_t i = 0; i < record_count && reader.good(); ++i) {
+        DependencyRecord record;
+        record.translation_unit = reader.str();
+        record.configuration = reader.u64();
+        record.output_file = reader.str();
+
+        uint32_t input_count = reader.u32();
+        if (input_count > reader.remaining()) {
+            return false;
+        }
+        for (uint32_t j = 0; j < input_count && reader.good(); ++j) {
+            DependencyInput input;
+            input.path = reader.str();
+            input.content_hash = reader.u64();
+            input.size = reader.u64();
+            input.modified_ns = static_cast<int64_t>(reader.u64());
+            record.inputs.push_back(std::move(input));
+        }
+
+        uint32_t known_count = reader.u32();
+        if (known_count > reader.remaining()) {
+            return false;
+        }
+        for (uint32_t j = 0; j < known_count && reader.good(); ++j) {
+            record.known_macros.push_back(reader.str());
+        }
+
+        uint32_t consumed_count = reader.u32();
+        if (consumed_count > reader.remaining()) {
+            return false;
+        }
+        for (uint32_t j = 0; j < consumed_count && reader.good(); ++j) {
+            std::string name = reader.str();
+            std::string value = reader.str();
+            record.consumed_macros.emplace_back(std::move(name), std::move(value));
+        }
+
+        uint32_t absent_count = reader.u32();
+        if (absent_count > reader.remaining()) {
+            return false;
+        }
+        for (uint32_t j = 0; j < absent_count && reader.good(); ++j) {
+            record.absent_paths.push_back(reader.str());
+        }
+
+        std::string key = record.translation_unit;
+        records[key] = std::move(record);
+    }
+
+    if (!reader.good() || !reader.atEnd()) {
+        return false;
+    }
+    records_ = std::move(records);
+    return true;
+}
+
+bool DependencyGraph::save(const std::string& path) const {
+    // Ordem estável: o mesmo grafo sempre produz o mesmo arquivo
+    std::vector<const DependencyRecord*> ordered;
+    ordered.reserve(records_.size());
+    for (const auto& entry : records_) {
+        ordered.push_back(&entry.second);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const DependencyRecord* a, const DependencyRecord* b) {
+        return a->translation_unit < b->translation_unit;
+    });
+
+    std::string payload;
+    BinaryFormat::putU32(payload, static_cast<uint32_t>(ordered.size()));
+    for (const DependencyRecord* record : ordered) {
+        BinaryFormat::putString(payload, record->translation_unit);
+        BinaryFormat::putU64(payload, record->configuration);
+        BinaryFormat::putString(payload, record->output_file);
+        BinaryFormat::putU32(payload, static_cast<uint32_t>(record->inputs.size()));
+        for (const auto& input : record->inputs) {
+            BinaryFormat::putString(payload, input.path);
+            BinaryFormat::putU64(payload, input.content_hash);
+            BinaryFormat::putU64(payload, input.size);
+            BinaryFormat::putU64(payload, static_cast<uint64_t>(input.modified_ns));
+        }
+        BinaryFormat::putU32(payload, static_cast<uint32_t>(record->known_macros.size()));
+        for (const auto& name : record->known_macros) {
+            BinaryFormat::putString(payload, name);
+        }
+        BinaryFormat::putU32(payload, static_cast<uint32_t>(record->consumed_macros.size()));
+        for (const auto& macro : record->consumed_macros) {
+            BinaryFormat::putString(payload, macro.first);
+            BinaryFormat::putString(payload, macro.second);
+        }
+        BinaryFormat::putU32(payload, static_cast<uint32_t>(record->absent_paths.size()));
+        for (const auto& path : record->absent_paths) {
+            BinaryFormat::putString(payload, path);
+        }
+    }
+
+    return BinaryFormat::writeFileAtomically(path, BinaryFormat::seal(GRAPH_MAGIC, GRAPH_FORMAT_VERSION, payload));
+}
+
+const DependencyRecord* DependencyGraph::find(const std::string& translation_unit) const {
+    auto it = records_.find(translation_unit);
+    return it != records_.end() ? &it->second : nullptr;
+}
+
+void DependencyGraph::update(DependencyRecord record) {
+    std::string key = record.translation_unit;
+    records_[key] = std::move(record);
+}
+
+void DependencyGraph::remove(const std::string& translation_unit) {
+    records_.erase(translation_unit);
+}
+
+// ============================================================================
+// Verificação e construção de registros
+// ============================================================================
+
+bool DependencyGraph::isUpToDate(const DependencyRecord& record, uint64_t configuration,
+                                 const std::unordered_map<std::string, std::string>& macros,
+                                 const FileManager& files) {
+    if (record.configuration != configuration) {
+        return false;
+    }
+
+    std::error_code error;
+    if (!record.output_file.empty() && !std::filesystem::exists(record.output_file, error)) {
+        return false;
+    }
+
+    // Macro nova pode ser citada pelas entradas: sem o texto, não há como saber
+    for (const auto& macro : macros) {
+        if (std::find(record.known_macros.begin(), record.known_macros.end(), macro.first) ==
+            record.known_macros.end()) {
+            return false;
+        }
+    }
+    for (const auto& consumed : record.consumed_macros) {
+        auto it = macros.find(consumed.first);
+        if (it == macros.end() || it->second != consumed.second) {
+            return false;
+        }
+    }
+
+    // Um candidato que passou a existir muda o destino de uma inclusão
+    for (const auto& path : record.absent_paths) {
+        struct stat info;
+        if (::stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+            return false;
+        }
+    }
+
+    // Arquivos não tocados não são lidos; os tocados são decididos pelo conteúdo
+    for (const auto& input : record.inputs) {
+        uint64_t size = 0;
+        int64_t modified_ns = 0;
+        if (!statIdentity(input.path, size, modified_ns)) {
+            return false;
+        }
+        if (size == input.size && modified_ns == input.modified_ns) {
+            continue;
+        }
+        uint64_t hash = 0;
+        if (size != input.size || !files.getContentHash(input.path, hash) || hash != input.content_hash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DependencyGraph::buildRecord(const std::string& translation_unit, uint64_t configuration,
+                                  const std::unordered_map<std::string, std::string>& macros,
+                                  FileManager& files, bool follow_system, DependencyRecord& record) {
+    record = DependencyRecord();
+    record.translation_unit = translation_unit;
+    record.configuration = configuration;
+    for (const auto& macro : macros) {
+        record.known_macros.push_back(macro.first);
+    }
+    std::sort(record.known_macros.begin(), record.known_macros.end());
+
+    std::unordered_set<std::string> consumed;
+    std::unordered_set<std::string> absent;
+    std::unordered_set<std::string> visited{translation_unit};
+    std::deque<std::string> pending{translation_unit};
+
+    while (!pending.empty()) {
+        const std::string path = std::move(pending.front());
+        pending.pop_front();
+
+        // Identidade antes da leitura: uma alteração posterior aparece na próxima verificação
+        DependencyInput input;
+        input.path = path;
+        const bool identified = statIdentity(path, input.size, input.modified_ns);
+        FileView content = files.openFileView(path);
+        if (!identified || !content.valid()) {
+            if (path == translation_unit) {
+                return false;
+            }
+            continue;
+        }
+        input.content_hash = ContentHash::compute(content.data(), content.size());
+        if (content.size() != input.size) {
+            input.modified_ns = -1;
+        }
+        record.inputs.push_back(std::move(input));
+
+        const std::string_view text = content.view();
+
+        // Colagem de tokens pode formar qualquer nome: todas as macros contam
+        const bool pastes = text.find("##") != std::string_view::npos;
+        for (const auto& macro : macros) {
+            if (consumed.count(macro.first) == 0 && (pastes || citesIdentifier(text, macro.first))) {
+                consumed.insert(macro.first);
+            }
+        }
+
+        // Diretivas #include, linha a linha
+        size_t line_start = 0;
+        while (line_start < text.size()) {
+            const char* newline = static_cast<const char*>(
+                std::memchr(text.data() + line_start, '\n', text.size() - line_start));
+            const size_t line_end = newline ? static_cast<size_t>(newline - text.data()) : text.size();
+            const std::string_view line = text.substr(line_start, line_end - line_start);
+            line_start = line_end + 1;
+
+            DirectiveScan scan;
+            if (line.find('#') == std::string_view::npos || !scanDirective(line, scan) ||
+                scan.type != DirectiveType::INCLUDE) {
+                continue;
+            }
+            bool is_system = false;
+            const std::string_view target = includeTarget(scan.arguments, is_system);
+            if (target.empty() || (is_system && !follow_system)) {
+                continue;
+            }
+
+            std::string resolved;
+            try {
+                resolved = files.resolveInclude(std::string(target), is_system, path);
+                resolved = std::filesystem::path(resolved).lexically_normal().string();
+            } catch (const std::exception&) {
+                resolved.clear();
+            }
+
+            // Candidatos anteriores ao destino (todos, se não resolvida) não podem surgir
+            for (const auto& candidate : files.includeCandidates(std::string(target), is_system, path)) {
+                std::string normalized = std::filesystem::path(candidate).lexically_normal().string();
+                if (normalized == resolved) {
+                    break;
+                }
+                struct stat info;
+                const bool exists = ::stat(normalized.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+                if (!exists && absent.insert(normalized).second) {
+                    record.absent_paths.push_back(std::move(normalized));
+                }
+            }
+
+            if (!resolved.empty() && visited.insert(resolved).second) {
+                pending.push_back(std::move(resolved));
+            }
+        }
+    }
+
+    for (const auto& name : record.known_macros) {
+        if (consumed.count(name) != 0) {
+            record.consumed_macros.emplace_back(name, macros.at(name));
+        }
+    }
+    return true;
+}
+
+std::string DependencyGraph::makeDepfile(const std::string& target, const DependencyRecord& record) {
+    std::string rule = makeEscape(target) + ":";
+    for (const auto& input : record.inputs) {
+        rule += " \\\n  " + makeEscape(input.path);
+    }
+    rule += "\n";
+    for (size_t i = 1; i < record.inputs.size(); ++i) {
+        rule += "\n" + makeEscape(record.inputs[i].path) + ":\n";
+    }
+    return rule;
+}
+
+} // namespace Preprocessor
@@ -1,4 +1,5 @@
 #include "../include/directive.hpp"
+#include "../include/directive_scanner.hpp"
 #include "../include/preprocessor_state.hpp"
 #include "../include/preprocessor_logger.hpp"
 #include "../include/macro_processor.hpp"
@@ -71,10 +72,10 @@ bool Directive::validateSyntax() const {
         return false; // Nome vazio
     }
     
-    std::string directive_name = content_.substr(start, end - start);
+    std::string_view directive_name(content_.data() + start, end - start);
     
     // Verificar se é um tipo conhecido
-    DirectiveType detected_type = stringToDirectiveType(directive_name);
+    DirectiveType detected_type = lookupDirectiveType(directive_name);
     if (detected_type == DirectiveType::UNKNOWN && type_ != DirectiveType::UNKNOWN) {
         return false;
     }
@@ -140,6 +141,11 @@ void Directive::setArguments(const std::vector<std::string>& args) {
     valid_ = validateSyntax() && validateArguments();
 }
 
+void Directive::setArguments(std::vector<std::string>&& args) {
+    arguments_ = std::move(args);
+    valid_ = validateSyntax() && validateArguments();
+}
+
 // ============================================================================
 // Funções utilitárias
 // ============================================================================
@@ -167,28 +173,8 @@ std::string directiveTypeToString(DirectiveType type) {
 }
 
 DirectiveType stringToDirectiveType(const std::string& str) {
-    static const std::unordered_map<std::string, DirectiveType> string_to_type = {
-        {"include", DirectiveType::INCLUDE},
-        {"define", DirectiveType::DEFINE},
-        {"undef", DirectiveType::UNDEF},
-        {"if", DirectiveType::IF},
-        {"ifdef", DirectiveType::IFDEF},
-        {"ifndef", DirectiveType::IFNDEF},
-        {"else", DirectiveType::ELSE},
-        {"elif", DirectiveType::ELIF},
-        {"endif", DirectiveType::ENDIF},
-        {"error", DirectiveType::ERROR},
-        {"warning", DirectiveType::WARNING},
-        {"pragma", DirectiveType::PRAGMA},
-        {"line", DirectiveType::LINE}
-    };
-    
-    // Converter para minúsculas para comparação case-insensitive
-    std::string lower_str = str;
-    std::transform(lower_str.begin(), lower_str.end(), lower_str.begin(), ::tolower);
-    
-    auto it = string_to_type.find(lower_str);
-    return (it != string_to_type.end()) ? it->second : DirectiveType::UNKNOWN;
+    // Comparação case-insensitive via hash perfeito (sem cópia em minúsculas)
+    return lookupDirectiveType(str);
 }
 
 bool isConditionalDirective(DirectiveType type) {
@@ -251,77 +237,60 @@ DirectiveProcessor::DirectiveProcessor(PreprocessorState* state,
 
 Directive DirectiveProcessor::parseDirective(const std::string& line, const PreprocessorPosition& pos) {
     try {
-        // Normalizar a linha
-        std::string normalized_line = normalizeDirectiveLine(line);
-        
-        // Extrair nome da diretiva
-        std::string directive_name = extractDirectiveName(normalized_line);
+        // Normalizar a linha (só copia se houver algo a normalizar)
+        std::string normalized_storage;
+        std::string_view normalized_line = line;
+        if (!isNormalizedDirectiveLine(line)) {
+            normalized_storage = normalizeDirectiveLine(line);
+            normalized_line = normalized_storage;
+        }
         
-        // Converter para tipo
-        DirectiveType type = stringToDirectiveType(directive_name);
+        // Extrair nome da diretiva e converter para tipo
+        std::string_view directive_name = scanDirectiveName(normalized_line);
+        DirectiveType type = lookupDirectiveType(directive_name);
         
         // Criar objeto Directive
-        Directive directive(type, normalized_line, pos);
+        Directive directive(type, std::string(normalized_line), pos);
         
-        // Extrair argumentos
-        std::string args = extractDirectiveArguments(normalized_line, directive_name);
+        // Extrair argumentos (visão sobre a linha normalizada)
+        std::string_view args = scanDirectiveArguments(normalized_line, directive_name);
         
-        // Processar argumentos baseado no tipo
+        // Processar argumentos baseado no tipo; só aqui os argumentos são copiados
         std::vector<std::string> arguments;
         if (!args.empty()) {
-            std::istringstream iss(args);
-            std::string token;
-            
             switch (type) {
-                case DirectiveType::INCLUDE:
-                    // Para #include, manter o argumento como está (pode ter < > ou " ")
-                    arguments.push_back(args);
-                    break;
-                    
-                case DirectiveType::DEFINE:
+                case DirectiveType::DEFINE: {
                     // Para #define, separar nome da macro do valor
-                    if (iss >> token) {
-                        arguments.push_back(token); // Nome da macro
-                        std::string rest;
-                        std::getline(iss, rest);
+                    size_t name_start = 0;
+                    while (name_start < args.size() && std::isspace(static_cast<unsigned char>(args[name_start]))) {
+                        name_start++;
+                    }
+                    if (name_start < args.size()) {
+                        size_t name_end = name_start;
+                        while (name_end < args.size() && !std::isspace(static_cast<unsigned char>(args[name_end]))) {
+                            name_end++;
+                        }
+                        arguments.reserve(2);
+                        arguments.emplace_back(args.substr(name_start, name_end - name_start)); // Nome da macro
+                        std::string_view rest = args.substr(name_end);
+                        rest = rest.substr(0, rest.find('\n'));
                         if (!rest.empty() && rest[0] == ' ') {
-                            rest = rest.substr(1); // Remover espaço inicial
+                            rest.remove_prefix(1); // Remover espaço inicial
                         }
-                        arguments.push_back(rest); // Valor da macro
+                        arguments.emplace_back(rest); // Valor da macro
                     }
                     break;
-                    
-                case DirectiveType::UNDEF:
-                case DirectiveType::IFDEF:
-                case DirectiveType::IFNDEF:
-                    // Para estas diretivas, apenas o nome da macro
-                    arguments.push_back(args);
-                    break;
-                    
-                case DirectiveType::IF:
-                case DirectiveType::ELIF:
-                    // Para condicionais, manter expressão completa
-                    arguments.push_back(args);
-                    break;
-                    
-                case DirectiveType::ERROR:
-                case DirectiveType::WARNING:
-                case DirectiveType::PRAGMA:
-                case DirectiveType::LINE:
-                    // Para estas diretivas, manter argumentos como string única
-                    arguments.push_back(args);
-                    break;
+                }
                     
                 default:
-                    // Para diretivas desconhecidas ou sem argumentos
-                    if (!args.empty()) {
-                        arguments.push_back(args);
-                    }
+                    // #include mantém < > ou " "; condicionais mantêm a expressão completa;
+                    // demais diretivas mantêm os argumentos como string única
+                    arguments.emplace_back(args);
                     break;
             }
         }
         
-        directive.setArguments(arguments);
+        directive.setArguments(std::move(arguments));
         
         // Validar sintaxe
         bool syntax_valid = validateDirectiveSyntax(directive);
@@ -529,13 +498,13 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
             bool is_system = (filename.front() == '<' && filename.back() == '>');
             
             if (logger_) {
-                logger_->info("[DEBUG] processIncludeDirective: filename='" + filename + "', clean_filename='" + clean_filename + "', is_system=" + (is_system ? "true" : "false"));
+                PP_LOG_INFO(logger_, "[DEBUG] processIncludeDirective: filename='" + filename + "', clean_filename='" + clean_filename + "', is_system=" + (is_system ? "true" : "false"));
             }
             
             std::string resolved_path = file_manager_->resolveInclude(clean_filename, is_system, "");
             
             if (logger_) {
-                logger_->info("[DEBUG] resolveInclude retornou: '" + resolved_path + "'");
+                PP_LOG_INFO(logger_, "[DEBUG] resolveInclude retornou: '" + resolved_path + "'");
             }
             
             if (!resolved_path.empty()) {
@@ -560,7 +529,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
              
              // Log de sucesso
              if (logger_) {
-                 logger_->info("Arquivo incluído com sucesso: " + clean_filename);
+                 PP_LOG_INFO(logger_, "Arquivo incluído com sucesso: " + clean_filename);
              }
              
              // Atualizar estatísticas
@@ -619,7 +588,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
              }
              
              // Log de sucesso
-             if (logger_) {
+             if (PP_LOG_ENABLED(logger_, LogLevel::INFO)) {
                  std::string msg = "Macro definida: " + macro_name;
                  if (!macro_value.empty()) {
                      msg += " = " + macro_value;
@@ -668,7 +637,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
              }
              
              // Log de sucesso
-             if (logger_) {
+             if (PP_LOG_ENABLED(logger_, LogLevel::INFO)) {
                  std::string msg = "Bloco #if iniciado: " + condition + " = " + (condition_result ? "true" : "false");
                  logger_->info(msg);
              }
@@ -712,7 +681,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
              }
              
              // Log de sucesso
-             if (logger_) {
+             if (PP_LOG_ENABLED(logger_, LogLevel::INFO)) {
                  std::string msg = "Bloco #ifdef iniciado: " + macro_name + " = " + (is_defined ? "definida" : "não definida");
                  logger_->info(msg);
              }
@@ -756,7 +725,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
              }
              
              // Log de sucesso
-             if (logger_) {
+             if (PP_LOG_ENABLED(logger_, LogLevel::INFO)) {
                  std::string msg = "Bloco #ifndef iniciado: " + macro_name + " = " + (is_not_defined ? "não definida" : "definida");
                  logger_->info(msg);
              }
@@ -788,7 +757,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
          if (success) {
              // Log de sucesso
              if (logger_) {
-                 logger_->info("Bloco #else processado");
+                 PP_LOG_INFO(logger_, "Bloco #else processado");
              }
              
              // Atualizar estatísticas
@@ -823,7 +792,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
          if (success) {
              // Log de sucesso
              if (logger_) {
-                 logger_->info("Bloco #elif processado: " + condition);
+                 PP_LOG_INFO(logger_, "Bloco #elif processado: " + condition);
              }
              
              // Atualizar estatísticas
@@ -858,7 +827,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
              
              // Log de sucesso
              if (logger_) {
-                 logger_->info("Bloco condicional finalizado com #endif");
+                 PP_LOG_INFO(logger_, "Bloco condicional finalizado com #endif");
              }
              
              // Atualizar estatísticas
@@ -900,7 +869,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
          if (success) {
              // Log de sucesso
              if (logger_) {
-                 logger_->info("Macro removida: " + macro_name);
+                 PP_LOG_INFO(logger_, "Macro removida: " + macro_name);
              }
              
              // Atualizar estatísticas
@@ -985,7 +954,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
          
          // Log de processamento
          if (logger_) {
-             logger_->info("Processando #pragma: " + pragma_command);
+             PP_LOG_INFO(logger_, "Processando #pragma: " + pragma_command);
          }
          
          // Processar pragmas conhecidos
@@ -995,18 +964,18 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
                  // Marcar arquivo como "include once"
                  // Implementação específica dependeria do FileManager
                  if (logger_) {
-                     logger_->info("#pragma once aplicado ao arquivo: " + pos.filename);
+                     PP_LOG_INFO(logger_, "#pragma once aplicado ao arquivo: " + pos.filename);
                  }
              }
          } else if (pragma_command == "pack") {
              // #pragma pack - controle de alinhamento de estruturas
              if (logger_) {
-                 logger_->info("#pragma pack processado (implementação específica do compilador)");
+                 PP_LOG_INFO(logger_, "#pragma pack processado (implementação específica do compilador)");
              }
          } else if (pragma_command == "warning") {
              // #pragma warning - controle de warnings
              if (logger_) {
-                 logger_->info("#pragma warning processado");
+                 PP_LOG_INFO(logger_, "#pragma warning processado");
              }
          } else {
              // Pragma desconhecido - apenas log
@@ -1080,7 +1049,7 @@ bool DirectiveProcessor::validateDirectiveSyntax(const Directive& directive) {
          }
          
          // Log de processamento
-         if (logger_) {
+         if (PP_LOG_ENABLED(logger_, LogLevel::INFO)) {
              std::string log_msg = "#line processado: linha " + std::to_string(new_line_number);
              if (!filename.empty()) {
                  log_msg += ", arquivo: " + filename;
@@ -1186,115 +1155,57 @@ void DirectiveProcessor::handleDirectiveErrors(const std::string& error_message,
  // Métodos auxiliares
  
  std::string DirectiveProcessor::extractDirectiveName(const std::string& line) {
-     try {
-         std::string trimmed = line;
-         
-         // Remover espaços no início
-         size_t start = trimmed.find_first_not_of(" \t");
-         if (start != std::string::npos) {
-             trimmed = trimmed.substr(start);
-         }
-         
-         // Deve começar com #
-         if (trimmed.empty() || trimmed[0] != '#') {
-             return "";
-         }
-         
-         // Remover o #
-         trimmed = trimmed.substr(1);
-         
-         // Remover comentários antes de extrair o nome
-         size_t comment_pos = trimmed.find("//");
-         if (comment_pos != std::string::npos) {
-             trimmed = trimmed.substr(0, comment_pos);
-         }
-         
-         // Remover comentários de bloco
-         size_t block_comment_start = trimmed.find("/*");
-         if (block_comment_start != std::string::npos) {
-             trimmed = trimmed.substr(0, block_comment_start);
-         }
-         
-         // Remover espaços no final após remoção de comentários
-         size_t end_trim = trimmed.find_last_not_of(" \t\n\r");
-         if (end_trim != std::string::npos) {
-             trimmed = trimmed.substr(0, end_trim + 1);
-         }
-         
-         // Encontrar o nome da diretiva
-         size_t end = trimmed.find_first_of(" \t\n\r");
-         if (end == std::string::npos) {
-             return trimmed;
-         }
-         
-         return trimmed.substr(0, end);
-         
-     } catch (const std::exception& e) {
-         if (logger_) {
-             logger_->error("Erro ao extrair nome da diretiva: " + std::string(e.what()));
-         }
-         return "";
-     }
+     return std::string(scanDirectiveName(line));
  }
  
  std::string DirectiveProcessor::extractDirectiveArguments(const std::string& line, const std::string& directive_name) {
-     try {
-         // Encontrar posição após o nome da diretiva
-         size_t hash_pos = line.find('#');
-         if (hash_pos == std::string::npos) {
-             return "";
-         }
-         
-         size_t directive_pos = line.find(directive_name, hash_pos);
-         if (directive_pos == std::string::npos) {
-             return "";
-         }
-         
-         size_t args_start = directive_pos + directive_name.length();
-         
-         // Pular espaços
-         while (args_start < line.length() && (line[args_start] == ' ' || line[args_start] == '\t')) {
-             args_start++;
-         }
-         
-         if (args_start >= line.length()) {
-             return "";
-         }
-         
-         // Extrair argumentos até o final da linha
-         std::string args = line.substr(args_start);
-         
-         // Remover comentários C-style (/* ... */) e comentários de linha (//)
-         size_t block_comment_start = args.find("/*");
-         size_t line_comment_start = args.find("//");
-         
-         size_t comment_start = std::string::npos;
-         if (block_comment_start != std::string::npos && line_comment_start != std::string::npos) {
-             comment_start = std::min(block_comment_start, line_comment_start);
-         } else if (block_comment_start != std::string::npos) {
-             comment_start = block_comment_start;
-         } else if (line_comment_start != std::string::npos) {
-             comment_start = line_comment_start;
-         }
-         
-         if (comment_start != std::string::npos) {
-             args = args.substr(0, comment_start);
-         }
-         
-         // Remover espaços no final
-         size_t end = args.find_last_not_of(" \t\n\r");
-         if (end != std::string::npos) {
-             args = args.substr(0, end + 1);
-         }
-         
-         return args;
-         
-     } catch (const std::exception& e) {
-         if (logger_) {
-             logger_->error("Erro ao extrair argumentos da diretiva: " + std::string(e.what()));
-         }
-         return "";
+     return std::string(scanDirectiveArguments(line, directive_name));
+ }
+ 
+ std::string_view DirectiveProcessor::scanDirectiveName(std::string_view line) const {
+     // Remover espaços no início
+     size_t start = line.find_first_not_of(" \t");
+     if (start == std::string_view::npos || line[start] != '#') {
+         return std::string_view();
      }
+     
+     // Remover o # e os comentários antes de extrair o nome
+     std::string_view trimmed = stripDirectiveComment(line.substr(start + 1));
+     
+     // O nome vai até o primeiro espaço
+     size_t end = trimmed.find_first_of(" \t\n\r");
+     return end == std::string_view::npos ? trimmed : trimmed.substr(0, end);
+ }
+ 
+ std::string_view DirectiveProcessor::scanDirectiveArguments(std::string_view line, std::string_view directive_name) const {
+     // Encontrar posição após o nome da diretiva
+     size_t hash_pos = line.find('#');
+     if (hash_pos == std::string_view::npos) {
+         return std::string_view();
+     }
+     
+     size_t directive_pos = line.find(directive_name, hash_pos);
+     if (directive_pos == std::string_view::npos) {
+         return std::string_view();
+     }
+     
+     size_t args_start = directive_pos + directive_name.length();
+     
+     // Pular espaços
+     while (args_start < line.length() && (line[args_start] == ' ' || line[args_start] == '\t')) {
+         args_start++;
+     }
+     
+     // Argumentos até o final da linha, sem comentários C-style (/* ... */) ou de linha (//)
+     return stripDirectiveComment(line.substr(args_start));
+ }
+ 
+ bool DirectiveProcessor::isNormalizedDirectiveLine(std::string_view line) {
+     if (line.find("//") != std::string_view::npos || line.find('\t') != std::string_view::npos ||
+         line.find("  ") != std::string_view::npos) {
+         return false;
+     }
+     return line.empty() || line.back() != ' ';
  }
  
  std::string DirectiveProcessor::normalizeDirectiveLine(const std::string& line) {
@@ -1361,7 +1272,7 @@ void DirectiveProcessor::handleDirectiveErrors(const std::string& error_message,
          }
          
          if (logger_) {
-             logger_->debug("Estatísticas atualizadas para diretiva: " + directiveTypeToString(type));
+             PP_LOG_DEBUG(logger_, "Estatísticas atualizadas para diretiva: " + directiveTypeToString(type));
          }
          
      } catch (const std::exception& e) {
@@ -1373,7 +1284,7 @@ void DirectiveProcessor::handleDirectiveErrors(const std::string& error_message,
  
  void DirectiveProcessor::logDirectiveProcessing(const Directive& directive, const PreprocessorPosition& pos) {
      try {
-         if (logger_) {
+         if (PP_LOG_ENABLED(logger_, LogLevel::DEBUG)) {
              std::string msg = "Processando diretiva " + directiveTypeToString(directive.getType()) +
                               " na linha " + std::to_string(pos.original_line) +
                               " do arquivo " + pos.filename;
@@ -1528,7 +1439,7 @@ void DirectiveProcessor::handleDirectiveErrors(const std::string& error_message,
       
       // 1. Otimização de cache para diretivas frequentes
        if (logger_) {
-           logger_->info("Otimizando processamento de diretivas...");
+           PP_LOG_INFO(logger_, "Otimizando processamento de diretivas...");
        }
        
        // 2. Pré-carregamento de includes comuns
@@ -1545,7 +1456,7 @@ void DirectiveProcessor::handleDirectiveErrors(const std::string& error_message,
        }
        
        if (logger_) {
-           logger_->info("Otimização de diretivas concluída");
+           PP_LOG_INFO(logger_, "Otimização de diretivas concluída");
        }
   }
 
@@ -0,0 +1,146 @@
+#include "../include/directive_scanner.hpp"
+#include <array>
+#include <cctype>
+
+namespace Preprocessor {
+
+namespace {
+
+struct DirectiveName {
+    std::string_view name;
+    DirectiveType type;
+};
+
+constexpr DirectiveName DIRECTIVE_NAMES[] = {
+    {"include", DirectiveType::INCLUDE},
+    {"define", DirectiveType::DEFINE},
+    {"undef", DirectiveType::UNDEF},
+    {"if", DirectiveType::IF},
+    {"ifdef", DirectiveType::IFDEF},
+    {"ifndef", DirectiveType::IFNDEF},
+    {"else", DirectiveType::ELSE},
+    {"elif", DirectiveType::ELIF},
+    {"endif", DirectiveType::ENDIF},
+    {"error", DirectiveType::ERROR},
+    {"warning", DirectiveType::WARNING},
+    {"pragma", DirectiveType::PRAGMA},
+    {"line", DirectiveType::LINE}
+};
+
+constexpr size_t TABLE_SIZE = 32;
+
+constexpr char toLowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Sem colisões para os 13 nomes acima (verificado em tempo de compilação)
+constexpr size_t directiveHash(std::string_view name) {
+    return (name.size() * 5 +
+            static_cast<unsigned char>(toLowerAscii(name.front())) +
+            static_cast<unsigned char>(toLowerAscii(name.back()))) & (TABLE_SIZE - 1);
+}
+
+constexpr std::array<signed char, TABLE_SIZE> buildTable() {
+    std::array<signed char, TABLE_SIZE> table{};
+    for (auto& slot : table) {
+        slot = -1;
+    }
+    for (size_t i = 0; i < sizeof(DIRECTIVE_NAMES) / sizeof(DIRECTIVE_NAMES[0]); ++i) {
+        size_t slot = directiveHash(DIRECTIVE_NAMES[i].name);
+        if (table[slot] != -1) {
+            throw "colisão na tabela de diretivas";
+        }
+        table[slot] = static_cast<signed char>(i);
+    }
+    return table;
+}
+
+constexpr std::array<signed char, TABLE_SIZE> DIRECTIVE_TABLE = buildTable();
+
+inline bool isBlank(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+inline bool isIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_';
+}
+
+} // namespace
+
+DirectiveType lookupDirectiveType(std::string_view name) {
+    if (name.size() < 2 || name.size() > 7) {
+        return DirectiveType::UNKNOWN;
+    }
+
+    signed char index = DIRECTIVE_TABLE[directiveHash(name)];
+    if (index < 0) {
+        return DirectiveType::UNKNOWN;
+    }
+
+    const DirectiveName& candidate = DIRECTIVE_NAMES[index];
+    if (candidate.name.size() != name.size()) {
+        return DirectiveType::UNKNOWN;
+    }
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (toLowerAscii(name[i]) != candidate.name[i]) {
+            return DirectiveType::UNKNOWN;
+        }
+    }
+    return candidate.type;
+}
+
+bool scanDirective(std::string_view line, DirectiveScan& scan) {
+    scan = DirectiveScan();
+
+    size_t pos = 0;
+    while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) {
+        pos++;
+    }
+    if (pos >= line.size() || line[pos] != '#') {
+        return false;
+    }
+    scan.is_directive = true;
+
+    pos++;
+    while (pos < line.size() && isBlank(line[pos])) {
+        pos++;
+    }
+    size_t name_end = pos;
+    while (name_end < line.size() && isIdentifierChar(line[name_end])) {
+        name_end++;
+    }
+    if (name_end == pos) {
+        return false;
+    }
+
+    scan.name = line.substr(pos, name_end - pos);
+    scan.type = lookupDirectiveType(scan.name);
+
+    size_t args_start = name_end;
+    while (args_start < line.size() && isBlank(line[args_start])) {
+        args_start++;
+    }
+    scan.arguments = line.substr(args_start);
+    return true;
+}
+
+std::string_view trimTrailingSpace(std::string_view text) {
+    size_t end = text.size();
+    while (end > 0 && (text[end - 1] == ' ' || text[end - 1] == '\t' ||
+                       text[end - 1] == '\n' || text[end - 1] == '\r')) {
+        end--;
+    }
+    return text.substr(0, end);
+}
+
+std::string_view stripDirectiveComment(std::string_view arguments) {
+    for (size_t i = 0; i + 1 < arguments.size(); ++i) {
+        if (arguments[i] == '/' && (arguments[i + 1] == '/' || arguments[i + 1] == '*')) {
+            arguments = arguments.substr(0, i);
+            break;
+        }
+    }
+    return trimTrailingSpace(arguments);
+}
+
+} // namespace Preprocessor
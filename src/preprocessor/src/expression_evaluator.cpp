@@ -29,35 +29,194 @@ long long ExpressionEvaluator::evaluateExpression(const std::string& expression,
             throw std::invalid_argument("Expression cannot be empty");
         }
         
-        // Expandir macros na expressão antes de tokenizar
+        // Mesma expressão e mesma geração de macros: resultado já conhecido
+        uint64_t generation = macroProcessor ? macroProcessor->getMacroGeneration() : 0;
+        auto memo = memoizedResults.find(expression);
+        if (memo != memoizedResults.end() && memo->second.generation == generation) {
+            cacheStats.memoHits++;
+            return memo->second.value;
+        }
+        
+        // Expandir macros na expressão antes de compilar
         std::string expandedExpression = expandMacrosInExpression(expression, pos);
         
-        // Tokenizar a expressão expandida
-        auto tokens = tokenizeExpression(expandedExpression);
+        // Compilar uma vez por texto expandido e avaliar contra as macros atuais
+        const CompiledExpression& program = compileExpression(expandedExpression, pos);
+        long long value = runCompiledExpression(program);
         
-        if (tokens.empty()) {
-            throw std::invalid_argument("No valid tokens found in expression");
+        // __LINE__/__COUNTER__ mudam sem alterar a tabela de macros
+        if (expression.find("__LINE__") == std::string::npos &&
+            expression.find("__COUNTER__") == std::string::npos) {
+            if (memoizedResults.size() >= MAX_CACHED_EXPRESSIONS) {
+                memoizedResults.clear();
+            }
+            memoizedResults[expression] = MemoizedResult{generation, value};
         }
+        return value;
         
-        // Validar parênteses balanceados
-        if (!validateParentheses(tokens)) {
-            throw std::invalid_argument("Unbalanced parentheses");
+    } catch (const std::exception& e) {
+        handleExpressionErrors(e.what(), pos);
+        throw; // Relança a exceção para que os testes possam capturá-la
+    }
+}
+
+const CompiledExpression& ExpressionEvaluator::compileExpression(const std::string& expandedExpression,
+                                                                 const PreprocessorPosition& pos) {
+    auto cached = compiledExpressions.find(expandedExpression);
+    if (cached != compiledExpressions.end()) {
+        cacheStats.compiledHits++;
+        return cached->second;
+    }
+    
+    // Tokenizar a expressão expandida
+    auto tokens = tokenizeExpression(expandedExpression);
+    
+    if (tokens.empty()) {
+        throw std::invalid_argument("No valid tokens found in expression");
+    }
+    
+    // Validar parênteses balanceados
+    if (!validateParentheses(tokens)) {
+        throw std::invalid_argument("Unbalanced parentheses");
+    }
+    
+    // Validar sintaxe de operadores
+    if (!validateOperatorSyntax(tokens)) {
+        handleExpressionErrors("Invalid operator syntax", pos);
+        throw std::invalid_argument("Invalid operator syntax");
+    }
+    
+    CompiledExpression program;
+    
+    // defined X / defined(X) vira um operando; o prefixo com espaço não colide
+    // com identificadores reais
+    std::vector<ExpressionToken> operands;
+    operands.reserve(tokens.size());
+    for (size_t i = 0; i < tokens.size() && !program.interpreted; ++i) {
+        if (tokens[i].type != ExpressionTokenType::DEFINED) {
+            operands.push_back(tokens[i]);
+            continue;
         }
-        
-        // Validar sintaxe de operadores
-        if (!validateOperatorSyntax(tokens)) {
-            handleExpressionErrors("Invalid operator syntax", pos);
-            throw std::invalid_argument("Invalid operator syntax");
+        size_t next = i + 1;
+        bool hasParens = next < tokens.size() && tokens[next].type == ExpressionTokenType::LEFT_PAREN;
+        if (hasParens) next++;
+        if (next >= tokens.size() || tokens[next].type != ExpressionTokenType::IDENTIFIER) {
+            program.interpreted = true;
+            break;
+        }
+        operands.emplace_back(ExpressionTokenType::IDENTIFIER, "defined " + tokens[next].value, 0);
+        i = next;
+        if (hasParens && i + 1 < tokens.size() && tokens[i + 1].type == ExpressionTokenType::RIGHT_PAREN) {
+            i++;
         }
+    }
+    
+    if (program.interpreted) {
+        program.tokens = std::move(tokens);
+    } else {
+        std::unordered_map<std::string, uint32_t> nameIndices;
+        auto internName = [&](const std::string& name) {
+            auto it = nameIndices.find(name);
+            if (it != nameIndices.end()) return it->second;
+            uint32_t index = static_cast<uint32_t>(program.names.size());
+            program.names.push_back(name);
+            nameIndices.emplace(name, index);
+            return index;
+        };
         
-        // Avaliar os tokens usando parsing
-        auto parsedTokens = parseTokens(tokens);
+        for (const auto& token : handleOperatorPrecedence(operands)) {
+            ExpressionInstruction instruction{ExpressionOpCode::PUSH_CONSTANT, OperatorType::ADD, 0, 0};
+            
+            if (token.type == ExpressionTokenType::NUMBER) {
+                instruction.value = token.numericValue;
+            } else if (token.type == ExpressionTokenType::IDENTIFIER) {
+                if (token.value.compare(0, 8, "defined ") == 0) {
+                    instruction.opcode = ExpressionOpCode::PUSH_DEFINED;
+                    instruction.nameIndex = internName(token.value.substr(8));
+                } else {
+                    instruction.opcode = ExpressionOpCode::PUSH_IDENTIFIER;
+                    instruction.nameIndex = internName(token.value);
+                }
+            } else if (token.type == ExpressionTokenType::OPERATOR) {
+                const std::string& op = token.value;
+                if (op == "u-" || op == "u+" || op == "u!" || op == "!") {
+                    instruction.opcode = ExpressionOpCode::UNARY;
+                    instruction.op = op == "u-" ? OperatorType::UNARY_MINUS :
+                                     op == "u+" ? OperatorType::UNARY_PLUS : OperatorType::LOGICAL_NOT;
+                } else {
+                    auto it = operatorMap.find(op);
+                    if (it == operatorMap.end() || it->second == OperatorType::LOGICAL_NOT ||
+                        it->second == OperatorType::BITWISE_NOT) {
+                        instruction.opcode = ExpressionOpCode::BINARY_UNKNOWN;
+                    } else {
+                        instruction.opcode = ExpressionOpCode::BINARY;
+                        instruction.op = it->second;
+                    }
+                }
+            } else {
+                continue; // Parênteses já resolvidos pela conversão pós-fixa
+            }
+            
+            program.code.push_back(instruction);
+        }
+    }
+    
+    if (compiledExpressions.size() >= MAX_CACHED_EXPRESSIONS) {
+        compiledExpressions.clear();
+    }
+    cacheStats.compilations++;
+    return compiledExpressions.emplace(expandedExpression, std::move(program)).first->second;
+}
+
+long long ExpressionEvaluator::runCompiledExpression(const CompiledExpression& program) {
+    if (program.interpreted) {
+        auto parsedTokens = parseTokens(program.tokens);
         return evaluateSubexpression(parsedTokens, 0, parsedTokens.size());
-        
-    } catch (const std::exception& e) {
-        handleExpressionErrors(e.what(), pos);
-        throw; // Relança a exceção para que os testes possam capturá-la
     }
+    
+    std::vector<long long>& stack = evaluationStack;
+    stack.clear();
+    
+    for (const auto& instruction : program.code) {
+        switch (instruction.opcode) {
+            case ExpressionOpCode::PUSH_CONSTANT:
+                stack.push_back(instruction.value);
+                break;
+            case ExpressionOpCode::PUSH_IDENTIFIER:
+                stack.push_back(resolveIdentifierValue(program.names[instruction.nameIndex], PreprocessorPosition()));
+                break;
+            case ExpressionOpCode::PUSH_DEFINED:
+                stack.push_back(macroProcessor && macroProcessor->isDefined(program.names[instruction.nameIndex]) ? 1 : 0);
+                break;
+            case ExpressionOpCode::UNARY:
+                if (!stack.empty()) {
+                    stack.back() = evaluateUnaryOperator(instruction.op, stack.back());
+                }
+                break;
+            case ExpressionOpCode::BINARY:
+            case ExpressionOpCode::BINARY_UNKNOWN:
+                // Operandos insuficientes: operador ignorado, como no avaliador de tokens
+                if (stack.size() >= 2) {
+                    long long right = stack.back(); stack.pop_back();
+                    long long left = stack.back();
+                    stack.back() = instruction.opcode == ExpressionOpCode::BINARY
+                        ? applyOperator(instruction.op, left, right) : 0;
+                }
+                break;
+        }
+    }
+    
+    return stack.empty() ? 0 : stack.back();
+}
+
+ExpressionCacheStats ExpressionEvaluator::getCacheStatistics() const {
+    return cacheStats;
+}
+
+void ExpressionEvaluator::clearExpressionCache() {
+    compiledExpressions.clear();
+    memoizedResults.clear();
+    cacheStats = ExpressionCacheStats();
 }
 
 // Tokenização da expressão
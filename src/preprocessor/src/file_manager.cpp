@@ -2,8 +2,13 @@
 // Implementação da classe FileManager para gerenciamento de inclusão de arquivos
 
 #include "../include/file_manager.hpp"
+#include "../include/binary_format.hpp"
+#include "../include/block_codec.hpp"
+#include "../include/content_hash.hpp"
+#include "../include/file_watcher.hpp"
 #include <fstream>
 #include <sstream>
+#include <filesystem>
 #include <algorithm>
 #include <sys/stat.h>
 #include <stdexcept>
@@ -11,9 +16,48 @@
 #include <cstring>
 #include <unistd.h>
 #include <dirent.h>
+#include <ctime>
 
 namespace Preprocessor {
 
+// Monta a mensagem só quando INFO está habilitado no logger
+#define FM_LOG_INFO(...) \
+    do { \
+        if (PP_LOG_ENABLED(logger_, LogLevel::INFO)) { \
+            logInfo(__VA_ARGS__); \
+        } \
+    } while (0)
+
+// Abaixo disso o quadro comprimido quase não encolhe e a descompressão a cada acesso não compensa
+constexpr size_t MIN_CACHE_COMPRESSION_SIZE = 1024;
+
+// Arquivos mapeados até este tamanho são copiados para o heap antes de irem ao
+// cache: a cópia é barata e a entrada deixa de depender do arquivo no disco
+constexpr size_t MAX_CACHE_HEAP_COPY_SIZE = 64 * 1024;
+
+namespace {
+
+// Tamanho e mtime (ns) de um arquivo regular
+bool statIdentity(const std::string& path, size_t& size, int64_t& modified_ns) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+    size = static_cast<size_t>(info.st_size);
+    modified_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+// Verdadeiro se os dois caminhos existem e levam ao mesmo arquivo (links inclusive)
+bool sameFile(const std::string& first, const std::string& second) {
+    struct stat a;
+    struct stat b;
+    return stat(first.c_str(), &a) == 0 && stat(second.c_str(), &b) == 0 &&
+           a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+
+} // namespace
+
 // ============================================================================
 // CONSTRUTORES E DESTRUTOR
 // ============================================================================
@@ -24,6 +68,7 @@ FileManager::FileManager(const std::vector<std::string>& search_paths, Preproces
       max_cache_entries_(1000),
       cache_ttl_(std::chrono::seconds(300)), // 5 minutos
       enable_cache_compression_(false),
+      directory_listing_mode_(false),
       external_error_handler_(nullptr) {
     // Normaliza os caminhos de busca
     for (auto& path : search_paths_) {
@@ -31,8 +76,8 @@ FileManager::FileManager(const std::vector<std::string>& search_paths, Preproces
     }
     
     if (logger_) {
-        logInfo("FileManager inicializado com " + std::to_string(search_paths_.size()) + " caminhos de busca");
-        logInfo("Cache configurado: " + std::to_string(max_cache_size_ / (1024*1024)) + "MB, " + 
+        FM_LOG_INFO("FileManager inicializado com " + std::to_string(search_paths_.size()) + " caminhos de busca");
+        FM_LOG_INFO("Cache configurado: " + std::to_string(max_cache_size_ / (1024*1024)) + "MB, " + 
                 std::to_string(max_cache_entries_) + " entradas, TTL: " + 
                 std::to_string(cache_ttl_.count()) + "s");
     }
@@ -40,7 +85,7 @@ FileManager::FileManager(const std::vector<std::string>& search_paths, Preproces
 
 FileManager::~FileManager() {
     if (logger_) {
-        logInfo("FileManager destruído. Estatísticas finais: " + 
+        FM_LOG_INFO("FileManager destruído. Estatísticas finais: " + 
                 std::to_string(stats_.files_read) + " arquivos lidos, " +
                 std::to_string(stats_.cache_hits) + " cache hits");
     }
@@ -52,12 +97,14 @@ FileManager::FileManager(FileManager&& other) noexcept
       dependencies_(std::move(other.dependencies_)),
       circular_detection_set_(std::move(other.circular_detection_set_)),
       logger_(other.logger_),
-      stats_(other.stats_),
       max_cache_size_(other.max_cache_size_),
       max_cache_entries_(other.max_cache_entries_),
       cache_ttl_(other.cache_ttl_),
       enable_cache_compression_(other.enable_cache_compression_),
+      directory_listing_mode_(other.directory_listing_mode_),
+      watcher_(std::move(other.watcher_)),
       external_error_handler_(other.external_error_handler_) {
+    stats_.assign(other.stats_.snapshot());
     other.logger_ = nullptr;
     other.stats_.reset();
 }
@@ -69,7 +116,10 @@ FileManager& FileManager::operator=(FileManager&& other) noexcept {
         dependencies_ = std::move(other.dependencies_);
         circular_detection_set_ = std::move(other.circular_detection_set_);
         logger_ = other.logger_;
-        stats_ = other.stats_;
+        stats_.assign(other.stats_.snapshot());
+        directory_listing_mode_ = other.directory_listing_mode_;
+        watcher_ = std::move(other.watcher_);
+        clearLookupCaches();
         
         other.logger_ = nullptr;
         other.stats_.reset();
@@ -86,55 +136,68 @@ std::string FileManager::readFile(const std::string& filepath) {
         throw std::runtime_error("Caminho de arquivo vazio");
     }
     
+    std::string normalized_path = normalizeFilePath(filepath);
+    FileView view = openFileView(normalized_path);
+    if (!view.valid()) {
+        if (!fileExists(normalized_path)) {
+            throw std::runtime_error("Arquivo não encontrado: " + normalized_path);
+        }
+        throw std::runtime_error("Não foi possível abrir o arquivo: " + normalized_path);
+    }
+    
+    return view.str();
+}
+
+FileView FileManager::openFileView(const std::string& filepath) {
+    if (filepath.empty()) {
+        return FileView();
+    }
+    
     // Normaliza o caminho
     std::string normalized_path = normalizeFilePath(filepath);
     
+    if (watcher_) {
+        processFileSystemEvents();
+    }
+    
     // Verifica cache primeiro
-    const CachedFile* cached = getCachedFile(normalized_path);
-    if (cached) {
+    FileView cached;
+    if (getCachedFile(normalized_path, cached)) {
         stats_.cache_hits++;
         if (logger_) {
-            logInfo("Arquivo lido do cache: " + normalized_path);
+            FM_LOG_INFO("Arquivo lido do cache: " + normalized_path);
         }
-        return cached->content;
+        return cached;
     }
     
     stats_.cache_misses++;
     
-    // Verifica se o arquivo existe
-    if (!fileExists(normalized_path)) {
-        throw std::runtime_error("Arquivo não encontrado: " + normalized_path);
+    // Mapeia (ou lê) o arquivo uma única vez; o cache guarda a mesma visão
+    FileView view = FileView::open(normalized_path);
+    if (!view.valid()) {
+        logError("Não foi possível abrir o arquivo", normalized_path);
+        return view;
     }
-    
-    // Lê o arquivo
-    std::ifstream file(normalized_path, std::ios::binary);
-    if (!file.is_open()) {
-        throw std::runtime_error("Não foi possível abrir o arquivo: " + normalized_path);
+    if (view.isMapped() && view.size() <= MAX_CACHE_HEAP_COPY_SIZE) {
+        view = FileView::fromString(view.str());
     }
     
-    // Lê todo o conteúdo
-    std::ostringstream content_stream;
-    content_stream << file.rdbuf();
-    std::string content = content_stream.str();
-    
-    file.close();
-    
     // Atualiza estatísticas
     stats_.files_read++;
-    stats_.total_bytes_read += content.size();
+    stats_.total_bytes_read += view.size();
     
     // Armazena no cache
-    cacheFile(normalized_path, content);
+    cacheFile(normalized_path, view, getLastModified(normalized_path));
     
     // Atualiza dependências
     updateDependencies(normalized_path);
     
     if (logger_) {
-        logInfo("Arquivo lido do disco: " + normalized_path + " (" + 
-                std::to_string(content.size()) + " bytes)");
+        FM_LOG_INFO("Arquivo lido do disco: " + normalized_path + " (" + 
+                std::to_string(view.size()) + " bytes" + (view.isMapped() ? ", mapeado" : "") + ")");
     }
     
-    return content;
+    return view;
 }
 
 bool FileManager::writeFile(const std::string& filepath, const std::string& content) {
@@ -170,15 +233,26 @@ bool FileManager::writeFile(const std::string& filepath, const std::string& cont
         file.close();
         
         // Atualiza cache se o arquivo já estava em cache
-        if (file_cache_.find(normalized_path) != file_cache_.end()) {
-            cacheFile(normalized_path, content);
+        bool was_cached = false;
+        {
+            std::shared_lock<std::shared_mutex> lock(cache_mutex_);
+            was_cached = file_cache_.find(normalized_path) != file_cache_.end();
+        }
+        if (was_cached) {
+            cacheFile(normalized_path, FileView::fromString(content));
         }
         
         // Remove hash do cache também
-        file_hashes_.erase(normalized_path);
+        {
+            std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+            file_hashes_.erase(normalized_path);
+        }
+        
+        // O arquivo pode ter acabado de ser criado: resultados negativos deixam de valer
+        clearLookupCaches();
         
         if (logger_) {
-            logInfo("Arquivo escrito: " + normalized_path + " (" + 
+            FM_LOG_INFO("Arquivo escrito: " + normalized_path + " (" + 
                     std::to_string(content.size()) + " bytes)");
         }
         
@@ -217,50 +291,90 @@ std::string FileManager::resolveInclude(const std::string& filename,
     }
     
     if (logger_) {
-        logInfo("[DEBUG] resolveInclude chamado para: " + filename + ", is_system: " + (is_system ? "true" : "false"));
-        logInfo("[DEBUG] search_paths_ tem " + std::to_string(search_paths_.size()) + " caminhos");
+        FM_LOG_INFO("[DEBUG] resolveInclude chamado para: " + filename + ", is_system: " + (is_system ? "true" : "false"));
     }
     
     stats_.path_resolutions++;
     
+    if (watcher_) {
+        processFileSystemEvents();
+    }
+    
+    // Diretório do arquivo atual, usado pelas inclusões locais
+    std::string current_dir;
+    if (!is_system && !current_file.empty()) {
+        size_t last_slash = current_file.find_last_of("/\\");
+        if (last_slash != std::string::npos) {
+            current_dir = current_file.substr(0, last_slash);
+        }
+    }
+    
+    // Memo da resolução: o mesmo nome incluído do mesmo diretório resolve igual
+    std::string memo_key;
+    memo_key.reserve(current_dir.size() + filename.size() + 2);
+    memo_key += is_system ? '<' : '"';
+    memo_key += current_dir;
+    memo_key += '\0';
+    memo_key += filename;
+    
+    std::vector<std::string> search_paths;
+    {
+        std::shared_lock<std::shared_mutex> lock(lookup_mutex_);
+        auto memo = resolution_cache_.find(memo_key);
+        if (memo != resolution_cache_.end()) {
+            stats_.resolution_cache_hits++;
+            std::string memoized = memo->second;
+            lock.unlock();
+            if (memoized.empty()) {
+                logError("[resolveInclude] Arquivo de inclusão não encontrado", filename);
+                throw std::runtime_error("Arquivo de inclusão não encontrado: " + filename);
+            }
+            return memoized;
+        }
+        // A busca sonda os caches de stat, que têm a mesma trava
+        search_paths = search_paths_;
+    }
+    
     std::string resolved_path;
     
     if (is_system) {
         // Para inclusões de sistema (<>), busca apenas nos caminhos de sistema
         if (logger_) {
-            logInfo("[DEBUG] Buscando include de sistema nos caminhos configurados");
+            FM_LOG_INFO("[DEBUG] Buscando include de sistema nos caminhos configurados");
         }
-        resolved_path = searchInPaths(filename, search_paths_);
+        resolved_path = searchInPaths(filename, search_paths);
     } else {
         // Para inclusões locais (""), busca primeiro no diretório do arquivo atual
-         if (!current_file.empty()) {
-             size_t last_slash = current_file.find_last_of("/\\");
-             std::string current_dir;
-             if (last_slash != std::string::npos) {
-                 current_dir = current_file.substr(0, last_slash);
-             }
-            
+        if (!current_file.empty()) {
             std::string local_path = resolveRelativePath(filename, current_dir);
-            if (fileExists(local_path)) {
+            if (probeIncludeCandidate(local_path)) {
                 resolved_path = local_path;
             }
         }
         
         // Se não encontrou localmente, busca nos caminhos de busca
         if (resolved_path.empty()) {
-            resolved_path = searchInPaths(filename, search_paths_);
+            resolved_path = searchInPaths(filename, search_paths);
         }
     }
     
     if (resolved_path.empty()) {
+        {
+            std::unique_lock<std::shared_mutex> lock(lookup_mutex_);
+            resolution_cache_.emplace(std::move(memo_key), std::string());
+        }
         logError("[resolveInclude] Arquivo de inclusão não encontrado", filename);
         throw std::runtime_error("Arquivo de inclusão não encontrado: " + filename);
     }
     
     resolved_path = normalizeFilePath(resolved_path);
+    {
+        std::unique_lock<std::shared_mutex> lock(lookup_mutex_);
+        resolution_cache_.emplace(std::move(memo_key), resolved_path);
+    }
     
     if (logger_) {
-        logInfo("Inclusão resolvida: " + filename + " -> " + resolved_path);
+        FM_LOG_INFO("Inclusão resolvida: " + filename + " -> " + resolved_path);
     }
     
     return resolved_path;
@@ -279,31 +393,58 @@ void FileManager::addSearchPath(const std::string& path) {
     std::string normalized_path = normalizeFilePath(path);
     
     // Verifica se o caminho já existe
+    std::unique_lock<std::shared_mutex> lock(lookup_mutex_);
     auto it = std::find(search_paths_.begin(), search_paths_.end(), normalized_path);
     if (it == search_paths_.end()) {
         search_paths_.push_back(normalized_path);
+        resolution_cache_.clear();
+        lock.unlock();
         
         if (logger_) {
-            logInfo("Caminho de busca adicionado: " + normalized_path);
+            FM_LOG_INFO("Caminho de busca adicionado: " + normalized_path);
         }
     }
 }
 
 void FileManager::setSearchPaths(const std::vector<std::string>& paths) {
-    search_paths_.clear();
-    
+    std::vector<std::string> normalized_paths;
     for (const auto& path : paths) {
         if (!path.empty()) {
-            search_paths_.push_back(normalizeFilePath(path));
+            normalized_paths.push_back(normalizeFilePath(path));
         }
     }
+    const size_t path_count = normalized_paths.size();
+    
+    {
+        std::unique_lock<std::shared_mutex> lock(lookup_mutex_);
+        search_paths_ = std::move(normalized_paths);
+        resolution_cache_.clear();
+    }
     
     if (logger_) {
-        logInfo("Caminhos de busca redefinidos: " + std::to_string(search_paths_.size()) + " caminhos");
+        FM_LOG_INFO("Caminhos de busca redefinidos: " + std::to_string(path_count) + " caminhos");
     }
 }
 
+std::vector<std::string> FileManager::includeCandidates(const std::string& filename,
+                                                        bool is_system,
+                                                        const std::string& current_file) const {
+    std::vector<std::string> candidates;
+    
+    // Mesma ordem de resolveInclude: diretório do arquivo atual, depois os caminhos de busca
+    if (!is_system && !current_file.empty()) {
+        size_t last_slash = current_file.find_last_of("/\\");
+        std::string current_dir = last_slash != std::string::npos ? current_file.substr(0, last_slash) : "";
+        candidates.push_back(resolveRelativePath(filename, current_dir));
+    }
+    for (const auto& search_path : getSearchPaths()) {
+        candidates.push_back(resolveRelativePath(filename, search_path));
+    }
+    return candidates;
+}
+
 std::vector<std::string> FileManager::getSearchPaths() const {
+    std::shared_lock<std::shared_mutex> lock(lookup_mutex_);
     return search_paths_;
 }
 
@@ -344,11 +485,35 @@ bool FileManager::checkCircularInclusion(const std::string& filepath,
 // ============================================================================
 
 void FileManager::clearCache() {
-    size_t cached_files = file_cache_.size();
-    file_cache_.clear();
+    size_t cached_files = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+        cached_files = file_cache_.size();
+        file_cache_.clear();
+    }
+    clearLookupCaches();
+    
+    if (logger_) {
+        FM_LOG_INFO("Cache limpo: " + std::to_string(cached_files) + " arquivos removidos");
+    }
+}
+
+void FileManager::clearLookupCaches() {
+    std::unique_lock<std::shared_mutex> lock(lookup_mutex_);
+    stat_cache_.clear();
+    resolution_cache_.clear();
+    directory_listings_.clear();
+}
+
+void FileManager::setDirectoryListingMode(bool enabled) {
+    if (directory_listing_mode_ == enabled) {
+        return;
+    }
+    directory_listing_mode_ = enabled;
+    clearLookupCaches();
     
     if (logger_) {
-        logInfo("Cache limpo: " + std::to_string(cached_files) + " arquivos removidos");
+        FM_LOG_INFO(std::string("Resolução por listagem de diretórios ") + (enabled ? "ativada" : "desativada"));
     }
 }
 
@@ -359,11 +524,14 @@ void FileManager::clearCache() {
 std::vector<std::string> FileManager::getDependencies() const {
     std::vector<std::string> all_dependencies;
     
-    for (const auto& [filepath, dependency] : dependencies_) {
-        all_dependencies.push_back(filepath);
-        
-        for (const auto& dep : dependency.dependencies) {
-            all_dependencies.push_back(dep);
+    {
+        std::shared_lock<std::shared_mutex> lock(cache_mutex_);
+        for (const auto& [filepath, dependency] : dependencies_) {
+            all_dependencies.push_back(filepath);
+            
+            for (const auto& dep : dependency.dependencies) {
+                all_dependencies.push_back(dep);
+            }
         }
     }
     
@@ -409,15 +577,51 @@ std::chrono::system_clock::time_point FileManager::getLastModified(const std::st
 // ESTATÍSTICAS
 // ============================================================================
 
+FileStats ConcurrentFileStats::snapshot() const {
+    FileStats stats;
+    stats.files_read = files_read.load(std::memory_order_relaxed);
+    stats.files_cached = files_cached.load(std::memory_order_relaxed);
+    stats.cache_hits = cache_hits.load(std::memory_order_relaxed);
+    stats.cache_misses = cache_misses.load(std::memory_order_relaxed);
+    stats.total_bytes_read = total_bytes_read.load(std::memory_order_relaxed);
+    stats.circular_inclusions = circular_inclusions.load(std::memory_order_relaxed);
+    stats.path_resolutions = path_resolutions.load(std::memory_order_relaxed);
+    stats.dependency_updates = dependency_updates.load(std::memory_order_relaxed);
+    stats.hashes_computed = hashes_computed.load(std::memory_order_relaxed);
+    stats.hash_memo_hits = hash_memo_hits.load(std::memory_order_relaxed);
+    stats.stat_cache_hits = stat_cache_hits.load(std::memory_order_relaxed);
+    stats.resolution_cache_hits = resolution_cache_hits.load(std::memory_order_relaxed);
+    stats.directories_listed = directories_listed.load(std::memory_order_relaxed);
+    stats.change_events = change_events.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ConcurrentFileStats::assign(const FileStats& stats) {
+    files_read.store(stats.files_read, std::memory_order_relaxed);
+    files_cached.store(stats.files_cached, std::memory_order_relaxed);
+    cache_hits.store(stats.cache_hits, std::memory_order_relaxed);
+    cache_misses.store(stats.cache_misses, std::memory_order_relaxed);
+    total_bytes_read.store(stats.total_bytes_read, std::memory_order_relaxed);
+    circular_inclusions.store(stats.circular_inclusions, std::memory_order_relaxed);
+    path_resolutions.store(stats.path_resolutions, std::memory_order_relaxed);
+    dependency_updates.store(stats.dependency_updates, std::memory_order_relaxed);
+    hashes_computed.store(stats.hashes_computed, std::memory_order_relaxed);
+    hash_memo_hits.store(stats.hash_memo_hits, std::memory_order_relaxed);
+    stat_cache_hits.store(stats.stat_cache_hits, std::memory_order_relaxed);
+    resolution_cache_hits.store(stats.resolution_cache_hits, std::memory_order_relaxed);
+    directories_listed.store(stats.directories_listed, std::memory_order_relaxed);
+    change_events.store(stats.change_events, std::memory_order_relaxed);
+}
+
 FileStats FileManager::getStatistics() const {
-    return stats_;
+    return stats_.snapshot();
 }
 
 void FileManager::resetStatistics() {
     stats_.reset();
     
     if (logger_) {
-        logInfo("Estatísticas do FileManager resetadas");
+        FM_LOG_INFO("Estatísticas do FileManager resetadas");
     }
 }
 
@@ -447,7 +651,7 @@ bool FileManager::createBackup(const std::string& filepath, const std::string& b
             return false;
         }
         
-        logInfo("Backup criado: " + backup_path);
+        FM_LOG_INFO("Backup criado: " + backup_path);
         return true;
         
     } catch (const std::exception& e) {
@@ -479,9 +683,12 @@ bool FileManager::restoreFromBackup(const std::string& filepath, const std::stri
         }
         
         // Remove do cache para forçar releitura
-        file_cache_.erase(normalized_path);
+        {
+            std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+            file_cache_.erase(normalized_path);
+        }
         
-        logInfo("Arquivo restaurado do backup: " + normalized_path);
+        FM_LOG_INFO("Arquivo restaurado do backup: " + normalized_path);
         return true;
         
     } catch (const std::exception& e) {
@@ -503,13 +710,17 @@ bool FileManager::lockFile(const std::string& filepath) {
             return false;
         }
         
-        if (locked_files_.find(normalized_path) != locked_files_.end()) {
+        bool inserted = false;
+        {
+            std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+            inserted = locked_files_.insert(normalized_path).second;
+        }
+        if (!inserted) {
             logWarning("Arquivo já está bloqueado: " + normalized_path);
             return false;
         }
         
-        locked_files_.insert(normalized_path);
-        logInfo("Arquivo bloqueado: " + normalized_path);
+        FM_LOG_INFO("Arquivo bloqueado: " + normalized_path);
         return true;
         
     } catch (const std::exception& e) {
@@ -522,14 +733,17 @@ bool FileManager::unlockFile(const std::string& filepath) {
     try {
         std::string normalized_path = normalizeFilePath(filepath);
         
-        auto it = locked_files_.find(normalized_path);
-        if (it == locked_files_.end()) {
+        size_t erased = 0;
+        {
+            std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+            erased = locked_files_.erase(normalized_path);
+        }
+        if (erased == 0) {
             logWarning("Arquivo não está bloqueado: " + normalized_path);
             return false;
         }
         
-        locked_files_.erase(it);
-        logInfo("Arquivo desbloqueado: " + normalized_path);
+        FM_LOG_INFO("Arquivo desbloqueado: " + normalized_path);
         return true;
         
     } catch (const std::exception& e) {
@@ -552,24 +766,57 @@ bool FileManager::compressFile(const std::string& filepath, const std::string& c
         }
         
         std::string output_path = compressed_path.empty() ? 
-            normalized_path + ".gz" : compressed_path;
+            normalized_path + ".ppz" : compressed_path;
         
-        // Lê o conteúdo do arquivo
-        std::string content = readFile(normalized_path);
-        if (content.empty() && !fileExists(normalized_path)) {
+        if (normalizeFilePath(output_path) == normalized_path || sameFile(normalized_path, output_path)) {
+            logError("Arquivo comprimido não pode substituir o original: " + output_path);
             return false;
         }
         
-        // Simulação de compressão (implementação básica)
-        // Em uma implementação real, usaria zlib ou similar
-        std::string compressed_content = "COMPRESSED:" + content;
+        std::ifstream input(normalized_path, std::ios::binary);
+        if (!input.is_open()) {
+            logError("Falha ao abrir arquivo para compressão: " + normalized_path);
+            return false;
+        }
         
-        if (!writeFile(output_path, compressed_content)) {
+        // Gravado em arquivo temporário: uma falha não destrói um arquivo comprimido anterior
+        const std::string temp_path = BinaryFormat::createTempFile(output_path);
+        if (temp_path.empty()) {
+            logError("Falha ao criar arquivo temporário para: " + output_path);
+            return false;
+        }
+        bool written = false;
+        std::streamoff compressed_size = 0;
+        {
+            std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+            if (output.is_open()) {
+                // Lido e comprimido em blocos: o arquivo nunca está inteiro em memória
+                BlockCodec::Encoder encoder(output);
+                std::string chunk(BlockCodec::BLOCK_SIZE, '\0');
+                while (input.read(&chunk[0], static_cast<std::streamsize>(chunk.size())) || input.gcount() > 0) {
+                    encoder.write(chunk.data(), static_cast<size_t>(input.gcount()));
+                }
+                written = !input.bad() && encoder.finish();
+                compressed_size = output.tellp();
+                output.close();
+                written = written && !output.fail();
+            }
+        }
+        if (!written || std::rename(temp_path.c_str(), output_path.c_str()) != 0) {
+            std::remove(temp_path.c_str());
             logError("Falha ao escrever arquivo comprimido: " + output_path);
             return false;
         }
         
-        logInfo("Arquivo comprimido: " + output_path);
+        // Conteúdo substituído: o cache e o hash antigos não valem mais
+        {
+            const std::string normalized_output = normalizeFilePath(output_path);
+            std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+            file_cache_.erase(normalized_output);
+            file_hashes_.erase(normalized_output);
+        }
+        
+        FM_LOG_INFO("Arquivo comprimido: " + output_path + " (" + std::to_string(compressed_size) + " bytes)");
         return true;
         
     } catch (const std::exception& e) {
@@ -587,29 +834,61 @@ bool FileManager::decompressFile(const std::string& compressed_path, const std::
             return false;
         }
         
-        // Lê o arquivo comprimido
-        std::string compressed_content = readFile(normalized_compressed);
-        if (compressed_content.empty()) {
-            return false;
+        // Sem destino explícito, apenas o sufixo de compressFile() é removido
+        std::string final_output_path = output_path;
+        if (final_output_path.empty()) {
+            std::filesystem::path compressed(normalized_compressed);
+            if (compressed.extension() != ".ppz") {
+                logError("Destino obrigatório para arquivo sem extensão .ppz: " + normalized_compressed);
+                return false;
+            }
+            final_output_path = compressed.replace_extension().string();
         }
         
-        // Simulação de descompressão
-        if (compressed_content.substr(0, 11) != "COMPRESSED:") {
-            logError("Formato de arquivo comprimido inválido");
+        if (normalizeFilePath(final_output_path) == normalized_compressed ||
+            sameFile(normalized_compressed, final_output_path)) {
+            logError("Arquivo descomprimido não pode substituir o comprimido: " + final_output_path);
             return false;
         }
         
-        std::string decompressed_content = compressed_content.substr(11);
-        
-        std::string final_output_path = output_path.empty() ? 
-            normalized_compressed.substr(0, normalized_compressed.find_last_of('.')) : output_path;
+        std::ifstream input(normalized_compressed, std::ios::binary);
+        if (!input.is_open()) {
+            logError("Falha ao abrir arquivo comprimido: " + normalized_compressed);
+            return false;
+        }
         
-        if (!writeFile(final_output_path, decompressed_content)) {
-            logError("Falha ao escrever arquivo descomprimido: " + final_output_path);
+        // Gravado em arquivo temporário: um quadro corrompido não deixa saída parcial
+        const std::string temp_path = BinaryFormat::createTempFile(final_output_path);
+        if (temp_path.empty()) {
+            logError("Falha ao criar arquivo temporário para: " + final_output_path);
+            return false;
+        }
+        bool written = true;
+        BlockCodec::Decoder decoder(input);
+        {
+            std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+            std::string block;
+            while (output.good() && decoder.next(block)) {
+                output.write(block.data(), static_cast<std::streamsize>(block.size()));
+            }
+            written = output.good();
+        }
+        if (decoder.failed() || !written || std::rename(temp_path.c_str(), final_output_path.c_str()) != 0) {
+            std::remove(temp_path.c_str());
+            logError(decoder.failed() ? "Formato de arquivo comprimido inválido: " + normalized_compressed
+                                      : "Falha ao escrever arquivo descomprimido: " + final_output_path);
             return false;
         }
         
-        logInfo("Arquivo descomprimido: " + final_output_path);
+        // Conteúdo substituído: o cache e o hash antigos não valem mais
+        {
+            const std::string normalized_output = normalizeFilePath(final_output_path);
+            std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+            file_cache_.erase(normalized_output);
+            file_hashes_.erase(normalized_output);
+        }
+        
+        FM_LOG_INFO("Arquivo descomprimido: " + final_output_path);
         return true;
         
     } catch (const std::exception& e) {
@@ -626,42 +905,13 @@ std::string FileManager::calculateFileHash(const std::string& filepath) const {
     try {
         std::string normalized_path = normalizeFilePath(filepath);
         
-        if (!fileExists(normalized_path)) {
-            logError("Arquivo não encontrado para cálculo de hash: " + normalized_path);
+        uint64_t hash_value = 0;
+        if (!getContentHash(normalized_path, hash_value)) {
+            logError("Não foi possível calcular hash do arquivo: " + normalized_path);
             return "";
         }
         
-        // Verifica se já temos o hash em cache
-        auto it = file_hashes_.find(normalized_path);
-        if (it != file_hashes_.end()) {
-            return it->second;
-        }
-        
-        // Lê o conteúdo do arquivo usando std::ifstream diretamente
-        std::ifstream file(normalized_path, std::ios::binary);
-        if (!file.is_open()) {
-            logError("Não foi possível abrir arquivo para hash: " + normalized_path);
-            return "";
-        }
-        
-        std::string content((std::istreambuf_iterator<char>(file)),
-                           std::istreambuf_iterator<char>());
-        file.close();
-        
-        // Simulação de hash SHA-256 (implementação básica)
-        // Em uma implementação real, usaria OpenSSL ou similar
-        std::hash<std::string> hasher;
-        size_t hash_value = hasher(content);
-        
-        std::stringstream ss;
-        ss << std::hex << hash_value;
-        std::string hash_result = ss.str();
-        
-        // Armazena no cache (cast para remover const)
-        const_cast<FileManager*>(this)->file_hashes_[normalized_path] = hash_result;
-        
-        logInfo("Hash calculado para " + normalized_path + ": " + hash_result);
-        return hash_result;
+        return ContentHash::toHex(hash_value);
         
     } catch (const std::exception& e) {
         logError("Erro ao calcular hash: " + std::string(e.what()));
@@ -669,6 +919,56 @@ std::string FileManager::calculateFileHash(const std::string& filepath) const {
     }
 }
 
+bool FileManager::getContentHash(const std::string& filepath, uint64_t& hash) const {
+    std::string normalized_path = normalizeFilePath(filepath);
+    
+    struct stat before;
+    if (stat(normalized_path.c_str(), &before) != 0 || !S_ISREG(before.st_mode)) {
+        return false;
+    }
+    
+    FileHashEntry identity;
+    identity.device = static_cast<uint64_t>(before.st_dev);
+    identity.inode = static_cast<uint64_t>(before.st_ino);
+    identity.size = static_cast<uint64_t>(before.st_size);
+    identity.mtime_ns = static_cast<int64_t>(before.st_mtim.tv_sec) * 1000000000LL + before.st_mtim.tv_nsec;
+    
+    // Arquivo inalterado: o hash memorizado vale sem reler o conteúdo
+    {
+        std::shared_lock<std::shared_mutex> lock(cache_mutex_);
+        auto it = file_hashes_.find(normalized_path);
+        if (it != file_hashes_.end() && !it->second.racy &&
+            it->second.device == identity.device && it->second.inode == identity.inode &&
+            it->second.size == identity.size && it->second.mtime_ns == identity.mtime_ns) {
+            stats_.hash_memo_hits++;
+            hash = it->second.hash;
+            return true;
+        }
+    }
+    
+    if (!ContentHash::computeFile(normalized_path, identity.hash)) {
+        return false;
+    }
+    stats_.hashes_computed++;
+    hash = identity.hash;
+    
+    // Só memoriza se o arquivo não mudou durante a leitura. Uma modificação no
+    // mesmo segundo do cálculo pode não alterar o mtime; nesse caso o hash é
+    // recalculado na próxima consulta.
+    struct stat after;
+    if (stat(normalized_path.c_str(), &after) != 0 ||
+        after.st_size != before.st_size ||
+        after.st_mtim.tv_sec != before.st_mtim.tv_sec || after.st_mtim.tv_nsec != before.st_mtim.tv_nsec) {
+        std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+        file_hashes_.erase(normalized_path);
+        return true;
+    }
+    identity.racy = before.st_mtim.tv_sec >= static_cast<time_t>(time(nullptr));
+    std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+    file_hashes_[normalized_path] = identity;
+    return true;
+}
+
 bool FileManager::verifyFileIntegrity(const std::string& filepath, const std::string& expected_hash) const {
     try {
         std::string normalized_path = normalizeFilePath(filepath);
@@ -691,7 +991,7 @@ bool FileManager::verifyFileIntegrity(const std::string& filepath, const std::st
         bool integrity_ok = (current_hash == expected_hash);
         
         if (integrity_ok) {
-            logInfo("Integridade verificada com sucesso: " + normalized_path);
+            FM_LOG_INFO("Integridade verificada com sucesso: " + normalized_path);
         } else {
             logError("Falha na verificação de integridade: " + normalized_path + 
                     " (esperado: " + expected_hash + ", atual: " + current_hash + ")");
@@ -718,17 +1018,26 @@ bool FileManager::monitorFileChanges(const std::string& filepath) {
             return false;
         }
         
-        if (monitored_files_.find(normalized_path) != monitored_files_.end()) {
+        bool inserted = false;
+        {
+            std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+            inserted = monitored_files_.insert(normalized_path).second;
+        }
+        if (!inserted) {
             logWarning("Arquivo já está sendo monitorado: " + normalized_path);
             return true;
         }
         
-        monitored_files_.insert(normalized_path);
-        
         // Calcula hash inicial para detectar mudanças futuras
         calculateFileHash(normalized_path);
         
-        logInfo("Monitoramento iniciado para: " + normalized_path);
+        if (enableChangeWatching()) {
+            watchContainingDirectory(normalized_path);
+        } else {
+            logWarning("Notificações do sistema indisponíveis; mudanças detectadas pela data de modificação");
+        }
+        
+        FM_LOG_INFO("Monitoramento iniciado para: " + normalized_path);
         return true;
         
     } catch (const std::exception& e) {
@@ -741,32 +1050,60 @@ void FileManager::handleFileSystemEvents(const std::string& event_type, const st
     try {
         std::string normalized_path = normalizeFilePath(filepath);
         
-        logInfo("Evento do sistema de arquivos: " + event_type + " em " + normalized_path);
+        FM_LOG_INFO("Evento do sistema de arquivos: " + event_type + " em " + normalized_path);
         
         if (event_type == "MODIFIED" || event_type == "CHANGED") {
             // Remove do cache para forçar releitura
-            file_cache_.erase(normalized_path);
-            file_hashes_.erase(normalized_path);
+            bool monitored = false;
+            {
+                std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+                file_cache_.erase(normalized_path);
+                file_hashes_.erase(normalized_path);
+                monitored = monitored_files_.find(normalized_path) != monitored_files_.end();
+            }
             
             // Se está sendo monitorado, recalcula o hash
-            if (monitored_files_.find(normalized_path) != monitored_files_.end()) {
+            if (monitored) {
                 calculateFileHash(normalized_path);
             }
             
-            logInfo("Cache invalidado para arquivo modificado: " + normalized_path);
+            FM_LOG_INFO("Cache invalidado para arquivo modificado: " + normalized_path);
             
         } else if (event_type == "DELETED" || event_type == "REMOVED") {
-            // Remove todas as referências ao arquivo
-            file_cache_.erase(normalized_path);
-            file_hashes_.erase(normalized_path);
-            locked_files_.erase(normalized_path);
-            monitored_files_.erase(normalized_path);
-            dependencies_.erase(normalized_path);
+            {
+                // Remove todas as referências ao arquivo
+                std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+                file_cache_.erase(normalized_path);
+                file_hashes_.erase(normalized_path);
+                locked_files_.erase(normalized_path);
+                monitored_files_.erase(normalized_path);
+                dependencies_.erase(normalized_path);
+                
+                // Se era um diretório, os arquivos dentro dele também saem do cache
+                const std::string prefix = normalized_path + "/";
+                for (auto it = file_cache_.begin(); it != file_cache_.end(); ) {
+                    if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                        file_hashes_.erase(it->first);
+                        it = file_cache_.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
             
-            logInfo("Referências removidas para arquivo deletado: " + normalized_path);
+            clearLookupCaches();
+            
+            FM_LOG_INFO("Referências removidas para arquivo deletado: " + normalized_path);
             
         } else if (event_type == "CREATED" || event_type == "ADDED") {
-            logInfo("Novo arquivo detectado: " + normalized_path);
+            // Um rename sobre um arquivo existente aparece como criação
+            {
+                std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+                file_cache_.erase(normalized_path);
+                file_hashes_.erase(normalized_path);
+            }
+            clearLookupCaches();
+            FM_LOG_INFO("Novo arquivo detectado: " + normalized_path);
             
         } else {
             logWarning("Tipo de evento desconhecido: " + event_type);
@@ -777,6 +1114,82 @@ void FileManager::handleFileSystemEvents(const std::string& event_type, const st
     }
 }
 
+bool FileManager::enableChangeWatching(bool enabled) {
+    if (!enabled) {
+        watcher_.reset();
+        return true;
+    }
+    if (watcher_) {
+        return true;
+    }
+    
+    auto watcher = std::make_unique<FileWatcher>();
+    if (!watcher->isActive()) {
+        return false;
+    }
+    watcher_ = std::move(watcher);
+    
+    // Entradas anteriores à observação podem estar desatualizadas
+    {
+        std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+        file_cache_.clear();
+    }
+    clearLookupCaches();
+    for (const auto& path : getSearchPaths()) {
+        std::lock_guard<std::mutex> lock(watcher_mutex_);
+        watcher_->watchDirectory(path);
+    }
+    
+    if (logger_) {
+        FM_LOG_INFO("Observação de mudanças ativada (" + std::to_string(watcher_->watchCount()) + " diretórios)");
+    }
+    return true;
+}
+
+bool FileManager::isChangeWatchingActive() const {
+    return watcher_ != nullptr;
+}
+
+size_t FileManager::processFileSystemEvents() {
+    if (!watcher_) {
+        return 0;
+    }
+    
+    std::vector<FileWatchEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(watcher_mutex_);
+        if (watcher_->poll(events) == 0) {
+            return 0;
+        }
+    }
+    
+    for (const auto& event : events) {
+        switch (event.type) {
+            case FileWatchEventType::MODIFIED:
+                handleFileSystemEvents("MODIFIED", event.path);
+                break;
+            case FileWatchEventType::CREATED:
+                handleFileSystemEvents("CREATED", event.path);
+                break;
+            case FileWatchEventType::DELETED:
+                handleFileSystemEvents("DELETED", event.path);
+                break;
+            case FileWatchEventType::OVERFLOW:
+                // Eventos perdidos: nada do que está em cache é confiável
+                logWarning("Fila de notificações transbordou; caches descartados");
+                {
+                    std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+                    file_cache_.clear();
+                    file_hashes_.clear();
+                }
+                clearLookupCaches();
+                break;
+        }
+    }
+    stats_.change_events += events.size();
+    return events.size();
+}
+
 // ============================================================================
 // MÉTODOS AUXILIARES PRIVADOS
 // ============================================================================
@@ -784,19 +1197,30 @@ void FileManager::handleFileSystemEvents(const std::string& event_type, const st
 std::string FileManager::searchInPaths(const std::string& filename, 
                                       const std::vector<std::string>& paths) const {
     if (logger_) {
-        logInfo("Buscando arquivo: " + filename + " em " + std::to_string(paths.size()) + " caminhos");
+        FM_LOG_INFO("Buscando arquivo: " + filename + " em " + std::to_string(paths.size()) + " caminhos");
     }
     
     for (const auto& search_path : paths) {
         std::string full_path = resolveRelativePath(filename, search_path);
         
         if (logger_) {
-            logInfo("Testando caminho: " + full_path);
+            FM_LOG_INFO("Testando caminho: " + full_path);
+        }
+        
+        if (directory_listing_mode_) {
+            // Descarta o candidato sem stat quando o nome não está na listagem
+            size_t last_slash = full_path.find_last_of('/');
+            std::string directory = last_slash == std::string::npos ? "." :
+                                    last_slash == 0 ? "/" : full_path.substr(0, last_slash);
+            std::string name = last_slash == std::string::npos ? full_path : full_path.substr(last_slash + 1);
+            if (!directoryContains(directory, name)) {
+                continue;
+            }
         }
         
-        if (fileExists(full_path)) {
+        if (probeIncludeCandidate(full_path)) {
             if (logger_) {
-                logInfo("Arquivo encontrado em: " + full_path);
+                FM_LOG_INFO("Arquivo encontrado em: " + full_path);
             }
             return full_path;
         }
@@ -808,6 +1232,80 @@ std::string FileManager::searchInPaths(const std::string& filename,
     return ""; // Não encontrado
 }
 
+bool FileManager::probeIncludeCandidate(const std::string& path) const {
+    {
+        std::shared_lock<std::shared_mutex> lock(lookup_mutex_);
+        auto it = stat_cache_.find(path);
+        if (it != stat_cache_.end()) {
+            stats_.stat_cache_hits++;
+            return it->second;
+        }
+    }
+    
+    // Resultados negativos também são guardados: com muitos caminhos de busca
+    // a maioria das sondagens falha
+    struct stat st;
+    bool exists = stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+    {
+        std::unique_lock<std::shared_mutex> lock(lookup_mutex_);
+        stat_cache_.emplace(path, exists);
+    }
+    
+    // Um resultado memorizado só é seguro enquanto o diretório é observado
+    if (watcher_) {
+        watchContainingDirectory(path);
+    }
+    return exists;
+}
+
+bool FileManager::directoryContains(const std::string& directory, const std::string& name) const {
+    {
+        std::shared_lock<std::shared_mutex> lock(lookup_mutex_);
+        auto it = directory_listings_.find(directory);
+        if (it != directory_listings_.end()) {
+            return it->second.count(name) > 0;
+        }
+    }
+    
+    // Diretório inexistente ou ilegível fica com listagem vazia
+    std::unordered_set<std::string> entries;
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            entries.emplace(entry->d_name);
+        }
+        closedir(dir);
+    }
+    stats_.directories_listed++;
+    const bool contains = entries.count(name) > 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(lookup_mutex_);
+        directory_listings_.emplace(directory, std::move(entries));
+    }
+    
+    if (watcher_) {
+        watchContainingDirectory(directory + "/.");
+    }
+    return contains;
+}
+
+void FileManager::watchContainingDirectory(const std::string& path) const {
+    // Sobe até um diretório existente: a criação dos intermediários aparece nele
+    std::lock_guard<std::mutex> lock(watcher_mutex_);
+    std::string directory = path;
+    for (;;) {
+        size_t last_slash = directory.find_last_of('/');
+        if (last_slash == std::string::npos) {
+            directory = ".";
+        } else {
+            directory.erase(last_slash == 0 ? 1 : last_slash);
+        }
+        if (watcher_->isWatching(directory) || watcher_->watchDirectory(directory) ||
+            directory == "." || directory == "/") {
+            return;
+        }
+    }
+}
+
 std::string FileManager::resolveRelativePath(const std::string& filename, 
                                             const std::string& base_path) const {
     if (filename.empty()) {
@@ -834,60 +1332,113 @@ std::string FileManager::resolveRelativePath(const std::string& filename,
       return result;
 }
 
-void FileManager::cacheFile(const std::string& filepath, const std::string& content,
+void FileManager::cacheFile(const std::string& filepath, FileView content,
                            std::chrono::system_clock::time_point file_modified) {
     std::string normalized_path = normalizeFilePath(filepath);
     
-    // Verifica se precisa otimizar cache antes de adicionar
-    if (file_cache_.size() >= max_cache_entries_ || getCurrentCacheSize() >= max_cache_size_) {
-        optimizeCache();
-    }
-    
-    CachedFile cached_file(content, content.size());
+    const size_t content_size = content.size();
+    CachedFile cached_file(std::move(content));
     cached_file.normalized_path = normalized_path;
     cached_file.last_modified = file_modified;
     
+    // Identidade do arquivo mapeado; se já difere da visão, a entrada nunca é servida
+    if (cached_file.content.isMapped()) {
+        size_t disk_size = 0;
+        int64_t modified_ns = -1;
+        if (statIdentity(normalized_path, disk_size, modified_ns) && disk_size == content_size) {
+            cached_file.mapped_modified_ns = modified_ns;
+        }
+    }
+    
+    // Só o conteúdo em heap é comprimido, e só quando encolhe ao menos 1/8
+    if (enable_cache_compression_ && !cached_file.content.isMapped() &&
+        content_size >= MIN_CACHE_COMPRESSION_SIZE) {
+        const std::string_view text = cached_file.content.view();
+        std::string frame = BlockCodec::compress(text.data(), text.size());
+        if (frame.size() < content_size - content_size / 8) {
+            cached_file.content = FileView::fromString(std::move(frame));
+            cached_file.compressed = true;
+        }
+    }
+    
     // Calcula hash se necessário
     if (!cached_file.file_hash.empty() || enable_cache_compression_) {
         cached_file.file_hash = calculateFileHash(filepath);
     }
     
-    file_cache_[normalized_path] = std::move(cached_file);
+    {
+        std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+        
+        // Verifica se precisa otimizar cache antes de adicionar
+        if (file_cache_.size() >= max_cache_entries_ || getCurrentCacheSize() >= max_cache_size_) {
+            optimizeCacheLocked();
+        }
+        
+        file_cache_[normalized_path] = std::move(cached_file);
+    }
     stats_.files_cached++;
     
+    if (watcher_) {
+        watchContainingDirectory(normalized_path);
+    }
+    
     if (logger_) {
-        logInfo("Arquivo cacheado: " + normalized_path + " (" + 
-                std::to_string(content.size()) + " bytes)");
+        FM_LOG_INFO("Arquivo cacheado: " + normalized_path + " (" + 
+                std::to_string(content_size) + " bytes)");
     }
 }
 
-const CachedFile* FileManager::getCachedFile(const std::string& filepath) const {
-    std::string normalized_path = normalizeFilePath(filepath);
+bool FileManager::getCachedFile(const std::string& filepath, FileView& view) const {
+    std::shared_lock<std::shared_mutex> lock(cache_mutex_);
     
-    auto it = file_cache_.find(normalized_path);
+    auto it = file_cache_.find(filepath);
     if (it != file_cache_.end()) {
         // Verifica se o cache expirou
         if (it->second.isExpired(cache_ttl_)) {
+            lock.unlock();
+            if (logger_) {
+                FM_LOG_INFO("Cache expirado para: " + filepath);
+            }
+            return false;
+        }
+        
+        // Conteúdo mapeado é sempre conferido: eventos do observador podem chegar tarde
+        if (!mappedEntryValid(filepath, it->second)) {
+            lock.unlock();
             if (logger_) {
-                logInfo("Cache expirado para: " + normalized_path);
+                FM_LOG_INFO("Cache invalidado (arquivo mapeado alterado): " + filepath);
             }
-            return nullptr;
+            return false;
         }
         
-        // Verifica se o arquivo foi modificado
-        if (shouldInvalidateCache(normalized_path)) {
+        // Verifica se o arquivo foi modificado (com observação ativa, os eventos já invalidaram)
+        if (!watcher_ && shouldInvalidateCache(filepath, it->second)) {
+            lock.unlock();
             if (logger_) {
-                logInfo("Cache invalidado (arquivo modificado): " + normalized_path);
+                FM_LOG_INFO("Cache invalidado (arquivo modificado): " + filepath);
             }
-            return nullptr;
+            return false;
         }
         
         // Atualiza estatísticas de acesso
-        const_cast<CachedFile&>(it->second).updateAccess();
-        return &it->second;
+        it->second.updateAccess();
+        if (!it->second.compressed) {
+            view = it->second.content;
+            return true;
+        }
+        
+        // Descomprime fora da trava; o quadro é mantido vivo pela cópia da visão
+        const FileView frame = it->second.content;
+        lock.unlock();
+        std::string content;
+        if (!BlockCodec::decompress(frame.data(), frame.size(), content)) {
+            return false;
+        }
+        view = FileView::fromString(std::move(content));
+        return true;
     }
     
-    return nullptr;
+    return false;
 }
 
 bool FileManager::validateFilePath(const std::string& filepath) const {
@@ -935,6 +1486,7 @@ void FileManager::updateDependencies(const std::string& filepath) {
     std::string normalized_path = normalizeFilePath(filepath);
     
     // Cria ou atualiza entrada de dependência
+    std::unique_lock<std::shared_mutex> lock(cache_mutex_);
     if (dependencies_.find(normalized_path) == dependencies_.end()) {
         dependencies_[normalized_path] = FileDependency(normalized_path);
         stats_.dependency_updates++;
@@ -988,7 +1540,7 @@ void FileManager::configureCacheOptimization(size_t max_size, size_t max_entries
     enable_cache_compression_ = enable_compression;
     
     if (logger_) {
-        logInfo("Cache reconfigurado: " + std::to_string(max_size / (1024*1024)) + "MB, " + 
+        FM_LOG_INFO("Cache reconfigurado: " + std::to_string(max_size / (1024*1024)) + "MB, " + 
                 std::to_string(max_entries) + " entradas, TTL: " + std::to_string(ttl.count()) + "s");
     }
     
@@ -997,13 +1549,30 @@ void FileManager::configureCacheOptimization(size_t max_size, size_t max_entries
 }
 
 void FileManager::optimizeCache() {
+    std::unique_lock<std::shared_mutex> lock(cache_mutex_);
     size_t initial_size = file_cache_.size();
     size_t initial_memory = getCurrentCacheSize();
     
+    optimizeCacheLocked();
+    
+    size_t final_size = file_cache_.size();
+    size_t final_memory = getCurrentCacheSize();
+    lock.unlock();
+    
+    if (logger_ && (initial_size != final_size)) {
+        FM_LOG_INFO("Cache otimizado: " + std::to_string(initial_size) + " -> " + 
+                std::to_string(final_size) + " entradas, " + 
+                std::to_string(initial_memory / 1024) + " -> " + 
+                std::to_string(final_memory / 1024) + " KB");
+    }
+}
+
+void FileManager::optimizeCacheLocked() {
     // Remove entradas expiradas
     auto it = file_cache_.begin();
     while (it != file_cache_.end()) {
-        if (it->second.isExpired(cache_ttl_) || shouldInvalidateCache(it->first)) {
+        if (it->second.isExpired(cache_ttl_) || !mappedEntryValid(it->first, it->second) ||
+            (!watcher_ && shouldInvalidateCache(it->first, it->second))) {
             it = file_cache_.erase(it);
         } else {
             ++it;
@@ -1014,28 +1583,20 @@ void FileManager::optimizeCache() {
     if (file_cache_.size() > max_cache_entries_ || getCurrentCacheSize() > max_cache_size_) {
         evictLeastRecentlyUsed(max_cache_entries_ * 0.8); // Remove 20% das entradas
     }
-    
-    size_t final_size = file_cache_.size();
-    size_t final_memory = getCurrentCacheSize();
-    
-    if (logger_ && (initial_size != final_size)) {
-        logInfo("Cache otimizado: " + std::to_string(initial_size) + " -> " + 
-                std::to_string(final_size) + " entradas, " + 
-                std::to_string(initial_memory / 1024) + " -> " + 
-                std::to_string(final_memory / 1024) + " KB");
-    }
 }
 
 void FileManager::preloadFiles(const std::vector<std::string>& filepaths) {
     for (const auto& filepath : filepaths) {
         try {
-            if (fileExists(filepath) && !getCachedFile(filepath)) {
-                std::string content = readFile(filepath);
-                auto last_modified = getLastModified(filepath);
-                cacheFile(filepath, content, last_modified);
+            FileView cached;
+            if (fileExists(filepath) && !getCachedFile(normalizeFilePath(filepath), cached)) {
+                // openFileView já registra a visão no cache
+                if (!openFileView(filepath).valid()) {
+                    continue;
+                }
                 
                 if (logger_) {
-                    logInfo("Arquivo pré-carregado: " + filepath);
+                    FM_LOG_INFO("Arquivo pré-carregado: " + filepath);
                 }
             }
         } catch (const std::exception& e) {
@@ -1046,30 +1607,37 @@ void FileManager::preloadFiles(const std::vector<std::string>& filepaths) {
     }
 }
 
-bool FileManager::shouldInvalidateCache(const std::string& filepath) const {
-    auto it = file_cache_.find(normalizeFilePath(filepath));
-    if (it == file_cache_.end()) {
-        return false;
-    }
-    
+bool FileManager::shouldInvalidateCache(const std::string& filepath, const CachedFile& cached) const {
     try {
         auto current_modified = getLastModified(filepath);
-        return current_modified > it->second.last_modified;
+        return current_modified > cached.last_modified;
     } catch (const std::exception&) {
         // Se não conseguir verificar, assume que deve invalidar
         return true;
     }
 }
 
+bool FileManager::mappedEntryValid(const std::string& filepath, const CachedFile& cached) const {
+    if (!cached.content.isMapped()) {
+        return true;
+    }
+    size_t size = 0;
+    int64_t modified_ns = 0;
+    return cached.mapped_modified_ns >= 0 &&
+           statIdentity(filepath, size, modified_ns) &&
+           size == cached.file_size &&
+           modified_ns == cached.mapped_modified_ns;
+}
+
 void FileManager::evictLeastRecentlyUsed(size_t target_size) {
     if (file_cache_.size() <= target_size) {
         return;
     }
     
     // Cria vetor com entradas ordenadas por último acesso
-    std::vector<std::pair<std::chrono::system_clock::time_point, std::string>> entries;
+    std::vector<std::pair<std::chrono::system_clock::rep, std::string>> entries;
     for (const auto& pair : file_cache_) {
-        entries.emplace_back(pair.second.last_access, pair.first);
+        entries.emplace_back(pair.second.last_access.load(std::memory_order_relaxed), pair.first);
     }
     
     // Ordena por último acesso (mais antigos primeiro)
@@ -0,0 +1,96 @@
+#include "../include/file_view.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Preprocessor {
+
+struct FileView::Storage {
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    std::string heap;
+
+    ~Storage() {
+        if (mapping) {
+            ::munmap(mapping, mapping_size);
+        }
+    }
+};
+
+namespace {
+
+// Abaixo de uma página o custo de mmap/munmap supera o de uma leitura simples
+size_t mappingThreshold() {
+    static const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return page_size;
+}
+
+bool readDescriptor(int fd, size_t size_hint, std::string& content) {
+    content.clear();
+    content.reserve(size_hint);
+    char chunk[64 * 1024];
+    for (;;) {
+        ssize_t bytes = ::read(fd, chunk, sizeof(chunk));
+        if (bytes < 0) {
+            return false;
+        }
+        if (bytes == 0) {
+            return true;
+        }
+        content.append(chunk, static_cast<size_t>(bytes));
+    }
+}
+
+} // namespace
+
+FileView FileView::open(const std::string& path) {
+    FileView result;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return result;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return result;
+    }
+
+    auto storage = std::make_shared<Storage>();
+    const size_t size = static_cast<size_t>(info.st_size);
+    if (size >= mappingThreshold()) {
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            storage->mapping = mapped;
+            storage->mapping_size = size;
+        }
+    }
+
+    if (!storage->mapping && !readDescriptor(fd, size, storage->heap)) {
+        ::close(fd);
+        return result;
+    }
+    ::close(fd);
+
+    result.data_ = storage->mapping
+        ? std::string_view(static_cast<const char*>(storage->mapping), storage->mapping_size)
+        : std::string_view(storage->heap);
+    result.storage_ = std::move(storage);
+    return result;
+}
+
+FileView FileView::fromString(std::string content) {
+    auto storage = std::make_shared<Storage>();
+    storage->heap = std::move(content);
+    FileView result;
+    result.data_ = std::string_view(storage->heap);
+    result.storage_ = std::move(storage);
+    return result;
+}
+
+bool FileView::isMapped() const {
+    return storage_ && storage_->mapping != nullptr;
+}
+
+} // namespace Preprocessor
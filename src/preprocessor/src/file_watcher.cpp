@@ -0,0 +1,130 @@
+#include "../include/file_watcher.hpp"
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace Preprocessor {
+
+#ifdef __linux__
+
+namespace {
+
+constexpr uint32_t WATCH_MASK = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE |
+                                IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+} // namespace
+
+FileWatcher::FileWatcher() : fd_(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {}
+
+FileWatcher::~FileWatcher() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool FileWatcher::watchDirectory(const std::string& directory) {
+    if (fd_ < 0 || directory.empty()) {
+        return false;
+    }
+    if (directories_.count(directory)) {
+        return true;
+    }
+
+    int wd = ::inotify_add_watch(fd_, directory.c_str(), WATCH_MASK);
+    if (wd < 0) {
+        return false;
+    }
+    // O mesmo diretório por outro caminho (link simbólico) devolve o mesmo descritor
+    paths_.emplace(wd, directory);
+    directories_.emplace(directory, wd);
+    return true;
+}
+
+bool FileWatcher::isWatching(const std::string& directory) const {
+    return directories_.count(directory) > 0;
+}
+
+size_t FileWatcher::poll(std::vector<FileWatchEvent>& events) {
+    if (fd_ < 0) {
+        return 0;
+    }
+
+    const size_t initial = events.size();
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        ssize_t length = ::read(fd_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;  // EAGAIN: fila vazia
+        }
+
+        for (char* p = buffer; p < buffer + length; ) {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                events.push_back({FileWatchEventType::OVERFLOW, std::string()});
+                continue;
+            }
+
+            auto it = paths_.find(event->wd);
+            if (it == paths_.end()) {
+                continue;
+            }
+            const std::string& directory = it->second;
+
+            if (event->mask & IN_IGNORED) {
+                // Observação encerrada pelo kernel (diretório removido ou desmontado)
+                directories_.erase(directory);
+                paths_.erase(it);
+                continue;
+            }
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                events.push_back({FileWatchEventType::DELETED, directory});
+                continue;
+            }
+
+            std::string path = directory;
+            if (event->len > 0) {
+                path += '/';
+                path += event->name;
+            }
+
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                events.push_back({FileWatchEventType::CREATED, std::move(path)});
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                events.push_back({FileWatchEventType::DELETED, std::move(path)});
+            } else if (!events.empty() && events.back().type == FileWatchEventType::MODIFIED &&
+                       events.back().path == path) {
+                continue;  // Escritas consecutivas no mesmo arquivo geram um único evento
+            } else {
+                events.push_back({FileWatchEventType::MODIFIED, std::move(path)});
+            }
+        }
+    }
+    return events.size() - initial;
+}
+
+#else
+
+FileWatcher::FileWatcher() : fd_(-1) {}
+
+FileWatcher::~FileWatcher() {}
+
+bool FileWatcher::watchDirectory(const std::string&) {
+    return false;
+}
+
+bool FileWatcher::isWatching(const std::string& directory) const {
+    return directories_.count(directory) > 0;
+}
+
+size_t FileWatcher::poll(std::vector<FileWatchEvent>&) {
+    return 0;
+}
+
+#endif
+
+} // namespace Preprocessor
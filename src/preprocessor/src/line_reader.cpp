@@ -0,0 +1,82 @@
+#include "../include/line_reader.hpp"
+#include <cstring>
+
+namespace Preprocessor {
+
+namespace {
+
+// Tamanho da linha física sem a continuação "\\\n" (ou "\\\r\n"); npos se não houver
+inline size_t continuationLength(const char* begin, size_t length) {
+    if (length >= 1 && begin[length - 1] == '\\') {
+        return length - 1;
+    }
+    if (length >= 2 && begin[length - 1] == '\r' && begin[length - 2] == '\\') {
+        return length - 2;
+    }
+    return std::string_view::npos;
+}
+
+} // namespace
+
+LineReader::LineReader(std::string_view content, size_t offset)
+    : content_(content), offset_(offset) {}
+
+bool LineReader::next(std::string_view& line) {
+    splice_columns_.clear();
+    const size_t size = content_.size();
+    if (offset_ >= size) {
+        return false;
+    }
+
+    const char* data = content_.data();
+    bool splicing = false;
+
+    for (;;) {
+        const char* begin = data + offset_;
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', size - offset_));
+        size_t length = newline ? static_cast<size_t>(newline - begin) : size - offset_;
+        offset_ += length + (newline ? 1 : 0);
+
+        // A continuação só vale se houver uma próxima linha física
+        size_t kept = newline ? continuationLength(begin, length) : std::string_view::npos;
+        if (kept == std::string_view::npos) {
+            if (!splicing) {
+                line = std::string_view(begin, length);
+                return true;
+            }
+            spliced_.append(begin, length);
+            line = spliced_;
+            return true;
+        }
+
+        if (!splicing) {
+            spliced_.assign(begin, kept);
+            splicing = true;
+        } else {
+            spliced_.append(begin, kept);
+        }
+        splice_columns_.push_back(spliced_.size());
+
+        if (offset_ >= size) {
+            // Continuação antes do fim do buffer: não há outra linha física
+            splice_columns_.pop_back();
+            line = spliced_;
+            return true;
+        }
+    }
+}
+
+void LineReader::physicalPosition(size_t column, int& line_offset, size_t& physical_column) const {
+    line_offset = 0;
+    size_t line_start = 0;
+    for (size_t splice : splice_columns_) {
+        if (column <= splice) {
+            break;
+        }
+        line_offset++;
+        line_start = splice;
+    }
+    physical_column = column - line_start;
+}
+
+} // namespace Preprocessor
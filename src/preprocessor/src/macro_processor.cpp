@@ -1,7 +1,7 @@
 #include "../include/macro_processor.hpp"
 #include <algorithm>
+#include <chrono>
 #include <sstream>
-#include <regex>
 #include <cctype>
 #include <ctime>
 #include <iomanip>
@@ -106,6 +106,291 @@ void MacroExpansionContext::reset() {
     currentDepth = 0;
 }
 
+// ============================================================================
+// IMPLEMENTAÇÃO DA CLASSE MacroTable
+// ============================================================================
+
+MacroTable::MacroTable()
+    : count_(0), tombstones_(0), definitionCount_(0), generation_(0) {
+    slots_.resize(64, Slot{0, nullptr, 0, EMPTY_SLOT});
+}
+
+uint64_t MacroTable::hashName(std::string_view name) {
+    // FNV-1a 64 bits
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+size_t MacroTable::findSlot(std::string_view name, uint64_t hash) const {
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        const Slot& slot = slots_[i];
+        if (slot.definition == EMPTY_SLOT) {
+            return i;
+        }
+        if (slot.definition != TOMBSTONE && slot.hash == hash &&
+            std::string_view(slot.name, slot.nameLength) == name) {
+            return i;
+        }
+    }
+}
+
+uint32_t MacroTable::allocateDefinition() {
+    if (!freeDefinitions_.empty()) {
+        uint32_t index = freeDefinitions_.back();
+        freeDefinitions_.pop_back();
+        return index;
+    }
+    if (definitionCount_ == definitionChunks_.size() * DEFINITION_CHUNK) {
+        definitionChunks_.emplace_back(new MacroInfo[DEFINITION_CHUNK]);
+    }
+    definitionLive_.push_back(0);
+    return static_cast<uint32_t>(definitionCount_++);
+}
+
+void MacroTable::rehash(size_t newCapacity) {
+    std::vector<Slot> old(newCapacity, Slot{0, nullptr, 0, EMPTY_SLOT});
+    old.swap(slots_);
+    tombstones_ = 0;
+    
+    const size_t mask = slots_.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.definition == EMPTY_SLOT || slot.definition == TOMBSTONE) continue;
+        size_t i = slot.hash & mask;
+        while (slots_[i].definition != EMPTY_SLOT) {
+            i = (i + 1) & mask;
+        }
+        slots_[i] = slot;
+    }
+}
+
+MacroInfo* MacroTable::find(std::string_view name) {
+    size_t index = findSlot(name, hashName(name));
+    uint32_t def = slots_[index].definition;
+    return def == EMPTY_SLOT ? nullptr : &definitionAt(def);
+}
+
+const MacroInfo* MacroTable::find(std::string_view name) const {
+    size_t index = findSlot(name, hashName(name));
+    uint32_t def = slots_[index].definition;
+    return def == EMPTY_SLOT ? nullptr : &definitionAt(def);
+}
+
+MacroInfo& MacroTable::assign(std::string_view name, MacroInfo info) {
+    uint64_t hash = hashName(name);
+    size_t index = findSlot(name, hash);
+    info.name.assign(name.data(), name.size());
+    generation_++;
+    
+    if (slots_[index].definition != EMPTY_SLOT) {
+        MacroInfo& existing = definitionAt(slots_[index].definition);
+        existing = std::move(info);
+        // O buffer do nome mudou com a atribuição
+        slots_[index].name = existing.name.data();
+        return existing;
+    }
+    
+    // Mantém carga (entradas + lápides) abaixo de 75%
+    if ((count_ + tombstones_ + 1) * 4 > slots_.size() * 3) {
+        size_t capacity = slots_.size();
+        if ((count_ + 1) * 2 > capacity) capacity *= 2;
+        rehash(capacity);
+        index = findSlot(name, hash);
+    }
+    
+    uint32_t def = allocateDefinition();
+    MacroInfo& stored = definitionAt(def);
+    stored = std::move(info);
+    definitionLive_[def] = 1;
+    
+    // A chave aponta para o nome da própria definição, cujo endereço é estável nos blocos
+    slots_[index] = Slot{hash, stored.name.data(), static_cast<uint32_t>(name.size()), def};
+    count_++;
+    return stored;
+}
+
+bool MacroTable::erase(std::string_view name) {
+    size_t index = findSlot(name, hashName(name));
+    uint32_t def = slots_[index].definition;
+    if (def == EMPTY_SLOT) {
+        return false;
+    }
+    
+    generation_++;
+    
+    // Libera as strings da definição e devolve o espaço à lista livre
+    definitionAt(def) = MacroInfo();
+    definitionLive_[def] = 0;
+    freeDefinitions_.push_back(def);
+    
+    slots_[index].definition = TOMBSTONE;
+    count_--;
+    tombstones_++;
+    return true;
+}
+
+void MacroTable::reset() {
+    generation_++;
+    for (size_t i = 0; i < definitionCount_; ++i) {
+        if (definitionLive_[i]) definitionAt(i) = MacroInfo();
+    }
+    std::fill(slots_.begin(), slots_.end(), Slot{0, nullptr, 0, EMPTY_SLOT});
+    definitionLive_.clear();
+    freeDefinitions_.clear();
+    definitionCount_ = 0;
+    count_ = 0;
+    tombstones_ = 0;
+}
+
+size_t MacroTable::arenaBytes() const {
+    size_t total = definitionChunks_.size() * DEFINITION_CHUNK * sizeof(MacroInfo);
+    return total + slots_.size() * sizeof(Slot);
+}
+
+// ============================================================================
+// IMPLEMENTAÇÃO DA CLASSE MacroExpansionCache
+// ============================================================================
+
+MacroExpansionCache::MacroExpansionCache(size_t maxEntries, size_t maxBytes)
+    : head_(nullptr), tail_(nullptr), currentBytes_(0),
+      maxEntries_(maxEntries), maxBytes_(maxBytes) {
+}
+
+MacroExpansionCache::MacroExpansionCache(MacroExpansionCache&& other) noexcept
+    : entries_(std::move(other.entries_)), head_(other.head_), tail_(other.tail_),
+      currentBytes_(other.currentBytes_), maxEntries_(other.maxEntries_),
+      maxBytes_(other.maxBytes_), stats_(other.stats_) {
+    // Os nós da tabela não mudam de endereço ao mover o unordered_map
+    other.entries_.clear();
+    other.head_ = other.tail_ = nullptr;
+    other.currentBytes_ = 0;
+}
+
+MacroExpansionCache& MacroExpansionCache::operator=(MacroExpansionCache&& other) noexcept {
+    if (this != &other) {
+        entries_ = std::move(other.entries_);
+        head_ = other.head_;
+        tail_ = other.tail_;
+        currentBytes_ = other.currentBytes_;
+        maxEntries_ = other.maxEntries_;
+        maxBytes_ = other.maxBytes_;
+        stats_ = other.stats_;
+        other.entries_.clear();
+        other.head_ = other.tail_ = nullptr;
+        other.currentBytes_ = 0;
+    }
+    return *this;
+}
+
+size_t MacroExpansionCache::entryBytes(const std::string& key, const std::string& value) {
+    return key.size() + value.size();
+}
+
+void MacroExpansionCache::unlink(Node* node) {
+    if (node->prev) node->prev->next = node->next; else head_ = node->next;
+    if (node->next) node->next->prev = node->prev; else tail_ = node->prev;
+    node->prev = node->next = nullptr;
+}
+
+void MacroExpansionCache::pushFront(Node* node) {
+    node->prev = nullptr;
+    node->next = head_;
+    if (head_) head_->prev = node;
+    head_ = node;
+    if (!tail_) tail_ = node;
+}
+
+void MacroExpansionCache::erase(Node* node) {
+    unlink(node);
+    currentBytes_ -= entryBytes(*node->key, node->value);
+    // Copia a chave antes de apagar: node->key aponta para a própria entrada
+    std::string key = *node->key;
+    entries_.erase(key);
+}
+
+void MacroExpansionCache::enforceLimits() {
+    while (tail_ && (entries_.size() > maxEntries_ || currentBytes_ > maxBytes_)) {
+        erase(tail_);
+        stats_.evictions++;
+    }
+}
+
+const std::string* MacroExpansionCache::lookup(const std::string& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        stats_.misses++;
+        return nullptr;
+    }
+    
+    Node* node = &it->second;
+    if (node != head_) {
+        unlink(node);
+        pushFront(node);
+    }
+    node->lastAccess = time(nullptr);
+    stats_.hits++;
+    stats_.bytesSaved += node->value.size();
+    return &node->value;
+}
+
+bool MacroExpansionCache::contains(const std::string& key) const {
+    return entries_.find(key) != entries_.end();
+}
+
+void MacroExpansionCache::insert(const std::string& key, const std::string& value) {
+    if (maxEntries_ == 0 || entryBytes(key, value) > maxBytes_) {
+        return; // Entrada nunca caberia no orçamento
+    }
+    
+    auto result = entries_.emplace(key, Node());
+    Node* node = &result.first->second;
+    if (result.second) {
+        node->key = &result.first->first;
+        node->prev = node->next = nullptr;
+    } else {
+        currentBytes_ -= entryBytes(key, node->value);
+        unlink(node);
+    }
+    
+    node->value = value;
+    node->lastAccess = time(nullptr);
+    currentBytes_ += entryBytes(key, value);
+    pushFront(node);
+    enforceLimits();
+}
+
+size_t MacroExpansionCache::removeOlderThan(int maxAge) {
+    time_t currentTime = time(nullptr);
+    size_t removed = 0;
+    
+    // A lista está ordenada por último acesso: basta consumir a cauda
+    while (tail_ && currentTime - tail_->lastAccess > maxAge) {
+        erase(tail_);
+        removed++;
+    }
+    return removed;
+}
+
+void MacroExpansionCache::clear() {
+    entries_.clear();
+    head_ = tail_ = nullptr;
+    currentBytes_ = 0;
+}
+
+void MacroExpansionCache::setLimits(size_t maxEntries, size_t maxBytes) {
+    maxEntries_ = maxEntries;
+    maxBytes_ = maxBytes;
+    enforceLimits();
+}
+
+void MacroExpansionCache::resetStatistics() {
+    stats_ = MacroCacheStats();
+}
+
 // ============================================================================
 // IMPLEMENTAÇÃO DA CLASSE MacroProcessor
 // ============================================================================
@@ -113,16 +398,16 @@ void MacroExpansionContext::reset() {
 // Construtores e Destrutor
 MacroProcessor::MacroProcessor() 
     : logger_(nullptr), state_(nullptr), expansionContext_(200),
-      cacheEnabled_(true), maxCacheSize_(1000), enablePrecompilation_(true),
-      totalExpansions_(0), cacheHits_(0), cacheMisses_(0), external_error_handler_(nullptr) {
+      expansionCache_(1000), cacheEnabled_(true), enablePrecompilation_(true),
+      totalExpansions_(0), profilingEnabled_(false), external_error_handler_(nullptr) {
     initializeComponents();
 }
 
 MacroProcessor::MacroProcessor(std::shared_ptr<Preprocessor::PreprocessorLogger> logger,
                                std::shared_ptr<Preprocessor::PreprocessorState> state)
     : logger_(logger), state_(state), expansionContext_(200),
-      cacheEnabled_(true), maxCacheSize_(1000), enablePrecompilation_(true),
-      totalExpansions_(0), cacheHits_(0), cacheMisses_(0), external_error_handler_(nullptr) {
+      expansionCache_(1000), cacheEnabled_(true), enablePrecompilation_(true),
+      totalExpansions_(0), profilingEnabled_(false), external_error_handler_(nullptr) {
     initializeComponents();
 }
 
@@ -144,8 +429,7 @@ bool MacroProcessor::defineMacro(const std::string& name, const std::string& val
     }
     
     // Verifica redefinição
-    auto it = macros_.find(name);
-    if (it != macros_.end()) {
+    if (macros_.find(name)) {
         MacroInfo newInfo(name, value, MacroType::OBJECT_LIKE);
         newInfo.definedAt = position;
         
@@ -157,13 +441,13 @@ bool MacroProcessor::defineMacro(const std::string& name, const std::string& val
     // Define a macro
     MacroInfo info(name, value, MacroType::OBJECT_LIKE);
     info.definedAt = position;
-    macros_[name] = info;
+    macros_.assign(name, std::move(info));
     
     // Limpa cache relacionado
     clearCache();
     
     if (logger_) {
-        logger_->info("Macro definida: " + name + " = " + value, position);
+        PP_LOG_INFO(logger_, "Macro definida: " + name + " = " + value, position);
     }
     
     return true;
@@ -197,8 +481,7 @@ bool MacroProcessor::defineFunctionMacro(const std::string& name,
     }
     
     // Verifica redefinição
-    auto it = macros_.find(name);
-    if (it != macros_.end()) {
+    if (macros_.find(name)) {
         MacroInfo newInfo(name, body, parameters, isVariadic);
         newInfo.definedAt = position;
         
@@ -207,15 +490,16 @@ bool MacroProcessor::defineFunctionMacro(const std::string& name,
         }
     }
     
-    // Define a macro funcional
+    // Define a macro funcional, compilando o corpo uma única vez
     MacroInfo info(name, body, parameters, isVariadic);
     info.definedAt = position;
-    macros_[name] = info;
+    info.replacement = compileReplacementTemplate(body, parameters, isVariadic);
+    macros_.assign(name, std::move(info));
     
     // Limpa cache relacionado
     clearCache();
     
-    if (logger_) {
+    if (PP_LOG_ENABLED(logger_, LogLevel::INFO)) {
         std::ostringstream oss;
         oss << "Macro funcional definida: " << name << "(";
         for (size_t i = 0; i < parameters.size(); ++i) {
@@ -234,21 +518,21 @@ bool MacroProcessor::defineFunctionMacro(const std::string& name,
 }
 
 bool MacroProcessor::undefineMacro(const std::string& name) {
-    auto it = macros_.find(name);
-    if (it == macros_.end()) {
+    const MacroInfo* info = macros_.find(name);
+    if (!info) {
         return false; // Macro não existe
     }
     
-    if (it->second.isPredefined) {
+    if (info->isPredefined) {
         logMacroWarning("Tentativa de remover macro predefinida: " + name);
         return false;
     }
     
-    macros_.erase(it);
+    macros_.erase(name);
     clearCache();
     
     if (logger_) {
-        logger_->info("Macro removida: " + name);
+        PP_LOG_INFO(logger_, "Macro removida: " + name);
     }
     
     return true;
@@ -256,26 +540,25 @@ bool MacroProcessor::undefineMacro(const std::string& name) {
 
 // Consultas de Macro
 bool MacroProcessor::isDefined(const std::string& name) const {
-    return macros_.find(name) != macros_.end();
+    return macros_.find(name) != nullptr;
 }
 
 std::string MacroProcessor::getMacroValue(const std::string& name) const {
-    auto it = macros_.find(name);
-    return (it != macros_.end()) ? it->second.value : "";
+    const MacroInfo* info = macros_.find(name);
+    return info ? info->value : "";
 }
 
 const MacroInfo* MacroProcessor::getMacroInfo(const std::string& name) const {
-    auto it = macros_.find(name);
-    return (it != macros_.end()) ? &it->second : nullptr;
+    return macros_.find(name);
 }
 
 std::vector<std::string> MacroProcessor::getDefinedMacros() const {
     std::vector<std::string> result;
     result.reserve(macros_.size());
     
-    for (const auto& pair : macros_) {
-        result.push_back(pair.first);
-    }
+    macros_.forEach([&result](const MacroInfo& info) {
+        result.push_back(info.name);
+    });
     
     std::sort(result.begin(), result.end());
     return result;
@@ -292,24 +575,23 @@ std::string MacroProcessor::expandMacro(const std::string& name) {
         return name;
     }
     
-    // Verifica cache
-    if (cacheEnabled_) {
-        std::string cacheKey = generateCacheKey(name);
-        auto cacheIt = expansionCache_.find(cacheKey);
-        if (cacheIt != expansionCache_.end()) {
-            cacheHits_++;
-            return cacheIt->second;
-        }
-        cacheMisses_++;
-    }
-    
-    const MacroInfo& info = macros_[name];
+    MacroInfo& info = *macros_.find(name);
     
     if (info.isFunctionLike()) {
         // Macro funcional sem argumentos - retorna nome original
         return name;
     }
     
+    MacroProfileScope profile(*this, name);
+    
+    // Verifica cache
+    if (cacheEnabled_) {
+        if (const std::string* cached = expansionCache_.lookup(generateCacheKey(name))) {
+            profile.finish(cached->size(), true);
+            return *cached;
+        }
+    }
+    
     // Expande macro simples
     expansionContext_.pushMacro(name);
     std::string result = expandMacroRecursively(info.value);
@@ -317,13 +599,14 @@ std::string MacroProcessor::expandMacro(const std::string& name) {
     
     // Atualiza estatísticas
     totalExpansions_++;
-    macros_[name].expansionCount++;
+    info.expansionCount++;
     
     // Armazena no cache
     if (cacheEnabled_) {
         cacheMacroResult(generateCacheKey(name), result);
     }
     
+    profile.finish(result.size(), false);
     return result;
 }
 
@@ -333,7 +616,7 @@ std::string MacroProcessor::expandFunctionMacro(const std::string& name,
         return name;
     }
     
-    const MacroInfo& info = macros_[name];
+    MacroInfo& info = *macros_.find(name);
     
     if (!info.isFunctionLike()) {
         logMacroError("[MACRO_PROCESSOR::MacroProcessor::expandFunctionMacro] Tentativa de chamar macro não-funcional '" + name + "' como função - macro é do tipo OBJECT_LIKE");
@@ -341,7 +624,6 @@ std::string MacroProcessor::expandFunctionMacro(const std::string& name,
     }
     
     if (!validateParameterCount(name, arguments.size())) {
-        const MacroInfo& info = macros_[name];
         if (info.isVariadic) {
             logMacroError("[MACRO_PROCESSOR::MacroProcessor::expandFunctionMacro] Macro variádica '" + name + "' requer pelo menos " + std::to_string(info.parameters.size()) + " argumentos, mas recebeu " + std::to_string(arguments.size()));
         } else {
@@ -355,32 +637,34 @@ std::string MacroProcessor::expandFunctionMacro(const std::string& name,
         return name;
     }
     
+    MacroProfileScope profile(*this, name);
+    
     // Verifica cache
     if (cacheEnabled_) {
-        std::string cacheKey = generateCacheKey(name, arguments);
-        auto cacheIt = expansionCache_.find(cacheKey);
-        if (cacheIt != expansionCache_.end()) {
-            cacheHits_++;
-            return cacheIt->second;
+        if (const std::string* cached = expansionCache_.lookup(generateCacheKey(name, arguments))) {
+            profile.finish(cached->size(), true);
+            return *cached;
         }
-        cacheMisses_++;
     }
     
     // Substitui parâmetros
     expansionContext_.pushMacro(name);
-    std::string result = substituteParameters(info.value, info.parameters, arguments);
+    std::string result = info.replacement.compiled
+        ? instantiateTemplate(info.replacement, info.parameters.size(), arguments)
+        : substituteParameters(info.value, info.parameters, arguments);
     result = expandMacroRecursively(result);
     expansionContext_.popMacro(name);
     
     // Atualiza estatísticas
     totalExpansions_++;
-    macros_[name].expansionCount++;
+    info.expansionCount++;
     
     // Armazena no cache
     if (cacheEnabled_) {
         cacheMacroResult(generateCacheKey(name, arguments), result);
     }
     
+    profile.finish(result.size(), false);
     return result;
 }
 
@@ -394,12 +678,9 @@ std::string MacroProcessor::expandMacroRecursively(const std::string& text) {
     // Otimização: verifica cache primeiro para texto completo
     if (cacheEnabled_) {
         std::string textCacheKey = "__recursive_" + std::to_string(std::hash<std::string>{}(text));
-        auto cacheIt = expansionCache_.find(textCacheKey);
-        if (cacheIt != expansionCache_.end()) {
-            cacheHits_++;
-            return cacheIt->second;
+        if (const std::string* cached = expansionCache_.lookup(textCacheKey)) {
+            return *cached;
         }
-        cacheMisses_++;
     }
     
     std::string result = text;
@@ -528,6 +809,17 @@ std::string MacroProcessor::expandMacroRecursively(const std::string& text) {
 }
 
 std::string MacroProcessor::processLine(const std::string& line) {
+    // Sem posição: expansões desta linha não herdam a linha anterior como local de chamada
+    if (profilingEnabled_) {
+        profileSite_ = Preprocessor::PreprocessorPosition();
+    }
+    return expandMacroRecursively(line);
+}
+
+std::string MacroProcessor::processLine(const std::string& line, const Preprocessor::PreprocessorPosition& position) {
+    if (profilingEnabled_) {
+        profileSite_ = position;
+    }
     return expandMacroRecursively(line);
 }
 
@@ -582,12 +874,12 @@ bool MacroProcessor::validateParameters(const std::vector<std::string>& paramete
 }
 
 bool MacroProcessor::validateParameterCount(const std::string& macroName, size_t argumentCount) const {
-    auto it = macros_.find(macroName);
-    if (it == macros_.end()) {
+    const MacroInfo* found = macros_.find(macroName);
+    if (!found) {
         return false;
     }
     
-    const MacroInfo& info = it->second;
+    const MacroInfo& info = *found;
     
     if (info.isVariadic) {
         // Macro variádica: deve ter pelo menos o número de parâmetros fixos
@@ -600,12 +892,12 @@ bool MacroProcessor::validateParameterCount(const std::string& macroName, size_t
 
 // Tratamento Especial
 bool MacroProcessor::handleMacroRedefinition(const std::string& name, const MacroInfo& newInfo) {
-    auto it = macros_.find(name);
-    if (it == macros_.end()) {
+    const MacroInfo* found = macros_.find(name);
+    if (!found) {
         return true; // Não é redefinição
     }
     
-    const MacroInfo& oldInfo = it->second;
+    const MacroInfo& oldInfo = *found;
     
     if (oldInfo.isPredefined) {
         logMacroError("Tentativa de redefinir macro predefinida: " + name);
@@ -678,7 +970,7 @@ std::vector<std::string> MacroProcessor::parseParameterList(const std::string& p
     std::vector<std::string> parameters;
     
     if (logger_) {
-        logger_->debug("parseParameterList recebeu: '" + parameterList + "'");
+        PP_LOG_DEBUG(logger_, "parseParameterList recebeu: '" + parameterList + "'");
     }
     
     if (parameterList.empty()) {
@@ -690,7 +982,7 @@ std::vector<std::string> MacroProcessor::parseParameterList(const std::string& p
     if (cleanParams.front() == '(' && cleanParams.back() == ')') {
         cleanParams = cleanParams.substr(1, cleanParams.length() - 2);
         if (logger_) {
-            logger_->debug("Parâmetros após remoção de parênteses: '" + cleanParams + "'");
+            PP_LOG_DEBUG(logger_, "Parâmetros após remoção de parênteses: '" + cleanParams + "'");
         }
     }
     
@@ -706,13 +998,13 @@ std::vector<std::string> MacroProcessor::parseParameterList(const std::string& p
         if (!param.empty()) {
             parameters.push_back(param);
             if (logger_) {
-                logger_->debug("Parâmetro adicionado: '" + param + "'");
+                PP_LOG_DEBUG(logger_, "Parâmetro adicionado: '" + param + "'");
             }
         }
     }
     
     if (logger_) {
-        logger_->debug("Total de parâmetros encontrados: " + std::to_string(parameters.size()));
+        PP_LOG_DEBUG(logger_, "Total de parâmetros encontrados: " + std::to_string(parameters.size()));
     }
     
     return parameters;
@@ -805,27 +1097,28 @@ void MacroProcessor::defineCompilerMacros() {
     info.name = "__FILE__";
     info.value = "\"<unknown>\"";
     info.type = MacroType::OBJECT_LIKE;
-    macros_["__FILE__"] = info;
+    macros_.assign("__FILE__", info);
     
     // __LINE__
     info.name = "__LINE__";
     info.value = "1";
-    macros_["__LINE__"] = info;
+    macros_.assign("__LINE__", info);
     
     // __STDC__
     info.name = "__STDC__";
     info.value = "1";
-    macros_["__STDC__"] = info;
+    macros_.assign("__STDC__", info);
     
     // __STDC_VERSION__
     info.name = "__STDC_VERSION__";
     info.value = "199901L";
-    macros_["__STDC_VERSION__"] = info;
+    macros_.assign("__STDC_VERSION__", info);
 }
 
 void MacroProcessor::defineDateTimeMacros() {
     auto now = std::time(nullptr);
-    auto tm = *std::localtime(&now);
+    std::tm tm{};
+    localtime_r(&now, &tm);  // std::localtime usa um buffer global
     
     MacroInfo info;
     info.isPredefined = true;
@@ -836,14 +1129,14 @@ void MacroProcessor::defineDateTimeMacros() {
     dateStream << std::put_time(&tm, "\"%b %d %Y\"");
     info.name = "__DATE__";
     info.value = dateStream.str();
-    macros_["__DATE__"] = info;
+    macros_.assign("__DATE__", info);
     
     // __TIME__
     std::ostringstream timeStream;
     timeStream << std::put_time(&tm, "\"%H:%M:%S\"");
     info.name = "__TIME__";
     info.value = timeStream.str();
-    macros_["__TIME__"] = info;
+    macros_.assign("__TIME__", info);
 }
 
 // Otimização e Cache
@@ -856,7 +1149,6 @@ void MacroProcessor::setCacheEnabled(bool enabled) {
 
 void MacroProcessor::clearCache() {
     expansionCache_.clear();
-    cacheTimestamps_.clear();
 }
 
 bool MacroProcessor::optimizeMacroExpansion(const std::string& macroName) {
@@ -864,7 +1156,7 @@ bool MacroProcessor::optimizeMacroExpansion(const std::string& macroName) {
         return false;
     }
     
-    const MacroInfo& info = macros_[macroName];
+    const MacroInfo& info = *macros_.find(macroName);
     
     // Otimiza macros frequentemente usadas
     if (info.expansionCount > 10) {
@@ -882,50 +1174,22 @@ bool MacroProcessor::optimizeMacroExpansion(const std::string& macroName) {
 
 void MacroProcessor::cacheMacroResult(const std::string& key, const std::string& result) {
     if (cacheEnabled_) {
-        // Verifica se o cache excedeu o tamanho máximo
-        if (expansionCache_.size() >= maxCacheSize_) {
-            // Remove a entrada mais antiga
-            auto oldestIt = cacheTimestamps_.begin();
-            for (auto it = cacheTimestamps_.begin(); it != cacheTimestamps_.end(); ++it) {
-                if (it->second < oldestIt->second) {
-                    oldestIt = it;
-                }
-            }
-            expansionCache_.erase(oldestIt->first);
-            cacheTimestamps_.erase(oldestIt);
-        }
-        
-        expansionCache_[key] = result;
-        cacheTimestamps_[key] = time(nullptr);
+        // Remoção LRU e orçamento de bytes ficam a cargo do próprio cache
+        expansionCache_.insert(key, result);
     }
 }
 
 void MacroProcessor::configureCacheOptimization(size_t maxCacheSize, bool enablePrecompilation) {
-    maxCacheSize_ = maxCacheSize;
     enablePrecompilation_ = enablePrecompilation;
     
-    // Se o cache atual é maior que o novo limite, limpa
-    if (expansionCache_.size() > maxCacheSize_) {
-        clearCache();
-    }
+    // Reduzir o limite remove apenas as entradas menos recentemente usadas
+    expansionCache_.setLimits(maxCacheSize, expansionCache_.maxBytes());
 }
 
 void MacroProcessor::optimizeCache(int maxAge) {
     if (!cacheEnabled_) return;
     
-    time_t currentTime = time(nullptr);
-    std::vector<std::string> keysToRemove;
-    
-    for (const auto& entry : cacheTimestamps_) {
-        if (currentTime - entry.second > maxAge) {
-            keysToRemove.push_back(entry.first);
-        }
-    }
-    
-    for (const std::string& key : keysToRemove) {
-        expansionCache_.erase(key);
-        cacheTimestamps_.erase(key);
-    }
+    expansionCache_.removeOlderThan(maxAge);
 }
 
 void MacroProcessor::preloadFrequentMacros(const std::vector<std::string>& macroNames) {
@@ -933,10 +1197,10 @@ void MacroProcessor::preloadFrequentMacros(const std::vector<std::string>& macro
     
     for (const std::string& macroName : macroNames) {
         if (isDefined(macroName)) {
-            const MacroInfo& info = macros_[macroName];
+            const MacroInfo& info = *macros_.find(macroName);
             if (!info.isFunctionLike() && !info.value.empty()) {
                 std::string cacheKey = generateCacheKey(macroName);
-                if (expansionCache_.find(cacheKey) == expansionCache_.end()) {
+                if (!expansionCache_.contains(cacheKey)) {
                     std::string expandedValue = expandMacroRecursively(info.value);
                     cacheMacroResult(cacheKey, expandedValue);
                 }
@@ -949,17 +1213,37 @@ size_t MacroProcessor::getCurrentCacheSize() const {
     return expansionCache_.size();
 }
 
+void MacroProcessor::setCacheMemoryBudget(size_t maxBytes) {
+    expansionCache_.setLimits(expansionCache_.maxEntries(), maxBytes);
+}
+
+size_t MacroProcessor::getCurrentCacheBytes() const {
+    return expansionCache_.bytes();
+}
+
+const MacroCacheStats& MacroProcessor::getCacheStatistics() const {
+    return expansionCache_.statistics();
+}
+
 // Estatísticas e Relatórios
 std::string MacroProcessor::getStatistics() const {
     std::ostringstream oss;
     oss << "=== Estatísticas do Processador de Macros ===\n";
     oss << "Macros definidas: " << macros_.size() << "\n";
+    oss << "Tabela de macros: capacidade " << macros_.capacity()
+        << ", arena " << macros_.arenaBytes() << " bytes\n";
     oss << "Expansões totais: " << totalExpansions_ << "\n";
-    oss << "Cache hits: " << cacheHits_ << "\n";
-    oss << "Cache misses: " << cacheMisses_ << "\n";
     
-    if (cacheHits_ + cacheMisses_ > 0) {
-        double hitRate = static_cast<double>(cacheHits_) / (cacheHits_ + cacheMisses_) * 100.0;
+    const MacroCacheStats& cacheStats = expansionCache_.statistics();
+    oss << "Cache hits: " << cacheStats.hits << "\n";
+    oss << "Cache misses: " << cacheStats.misses << "\n";
+    oss << "Cache evictions: " << cacheStats.evictions << "\n";
+    oss << "Bytes poupados pelo cache: " << cacheStats.bytesSaved << "\n";
+    oss << "Entradas no cache: " << expansionCache_.size() << "/" << expansionCache_.maxEntries() << "\n";
+    oss << "Memória do cache: " << expansionCache_.bytes() << "/" << expansionCache_.maxBytes() << " bytes\n";
+    
+    if (cacheStats.hits + cacheStats.misses > 0) {
+        double hitRate = static_cast<double>(cacheStats.hits) / (cacheStats.hits + cacheStats.misses) * 100.0;
         oss << "Taxa de acerto do cache: " << std::fixed << std::setprecision(2) << hitRate << "%\n";
     }
     
@@ -979,17 +1263,161 @@ std::string MacroProcessor::generateMacroReport() const {
         }
     }
     
+    if (!profiles_.empty()) {
+        oss << "\n=== Macros por Custo de Expansão ===\n";
+        oss << std::left << std::setw(24) << "Macro" << std::right
+            << std::setw(10) << "Expansões" << std::setw(12) << "Total (us)"
+            << std::setw(12) << "Própr. (us)" << std::setw(12) << "Bytes"
+            << std::setw(6) << "Prof." << "  Locais\n";
+        for (const MacroProfile& profile : getMacroProfiles()) {
+            oss << std::left << std::setw(24) << profile.name << std::right
+                << std::setw(10) << profile.expansions
+                << std::setw(12) << std::fixed << std::setprecision(1) << profile.totalNanoseconds / 1000.0
+                << std::setw(12) << profile.selfNanoseconds / 1000.0
+                << std::setw(12) << profile.bytesProduced
+                << std::setw(6) << profile.maxDepth << "  ";
+            for (size_t i = 0; i < profile.callSites.size(); ++i) {
+                oss << (i > 0 ? ", " : "") << profile.callSites[i].filename << ":" << profile.callSites[i].line;
+            }
+            if (profile.callSitesTruncated) {
+                oss << ", ...";
+            }
+            oss << "\n";
+        }
+    }
+    
     return oss.str();
 }
 
 void MacroProcessor::resetStatistics() {
     totalExpansions_ = 0;
-    cacheHits_ = 0;
-    cacheMisses_ = 0;
+    expansionCache_.resetStatistics();
+    profiles_.clear();
     
     // Reseta contadores de expansão das macros
-    for (auto& pair : macros_) {
-        pair.second.expansionCount = 0;
+    macros_.forEach([](MacroInfo& info) {
+        info.expansionCount = 0;
+    });
+}
+
+// Instrumentação por macro
+void MacroProcessor::setProfilingEnabled(bool enabled) {
+    profilingEnabled_ = enabled;
+    profileChildNanos_.clear();
+}
+
+std::vector<MacroProfile> MacroProcessor::getMacroProfiles() const {
+    std::vector<MacroProfile> result;
+    result.reserve(profiles_.size());
+    for (const auto& entry : profiles_) {
+        result.push_back(entry.second);
+    }
+    std::sort(result.begin(), result.end(), [](const MacroProfile& a, const MacroProfile& b) {
+        if (a.totalNanoseconds != b.totalNanoseconds) {
+            return a.totalNanoseconds > b.totalNanoseconds;
+        }
+        return a.name < b.name;
+    });
+    return result;
+}
+
+namespace {
+
+void appendJsonString(std::ostringstream& oss, const std::string& text) {
+    oss << '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': oss << "\\\""; break;
+            case '\\': oss << "\\\\"; break;
+            case '\n': oss << "\\n"; break;
+            case '\t': oss << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    oss << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                        << static_cast<int>(c) << std::dec << std::setfill(' ');
+                } else {
+                    oss << c;
+                }
+                break;
+        }
+    }
+    oss << '"';
+}
+
+} // namespace
+
+std::string MacroProcessor::exportProfileJson() const {
+    std::ostringstream oss;
+    oss << "{\"total_expansions\":" << totalExpansions_ << ",\"macros\":[";
+    bool first = true;
+    for (const MacroProfile& profile : getMacroProfiles()) {
+        oss << (first ? "" : ",") << "{\"name\":";
+        appendJsonString(oss, profile.name);
+        oss << ",\"expansions\":" << profile.expansions
+            << ",\"cache_hits\":" << profile.cacheHits
+            << ",\"total_ns\":" << profile.totalNanoseconds
+            << ",\"self_ns\":" << profile.selfNanoseconds
+            << ",\"bytes\":" << profile.bytesProduced
+            << ",\"max_depth\":" << profile.maxDepth
+            << ",\"call_sites\":[";
+        for (size_t i = 0; i < profile.callSites.size(); ++i) {
+            oss << (i > 0 ? "," : "") << "{\"file\":";
+            appendJsonString(oss, profile.callSites[i].filename);
+            oss << ",\"line\":" << profile.callSites[i].line << "}";
+        }
+        oss << "],\"call_sites_truncated\":" << (profile.callSitesTruncated ? "true" : "false") << "}";
+        first = false;
+    }
+    oss << "]}";
+    return oss.str();
+}
+
+uint64_t MacroProcessor::beginMacroProfile() {
+    if (!profilingEnabled_) {
+        return 0;
+    }
+    profileChildNanos_.push_back(0);
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void MacroProcessor::endMacroProfile(const std::string& name, uint64_t start, size_t bytes, bool cacheHit) {
+    // A pilha fica vazia se a instrumentação foi ligada durante uma expansão
+    if (!profilingEnabled_ || profileChildNanos_.empty()) {
+        return;
+    }
+    const uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    const uint64_t elapsed = now - start;
+    const uint64_t children = profileChildNanos_.back();
+    profileChildNanos_.pop_back();
+    if (!profileChildNanos_.empty()) {
+        profileChildNanos_.back() += elapsed;
+    }
+    
+    MacroProfile& profile = profiles_[name];
+    if (profile.name.empty()) {
+        profile.name = name;
+    }
+    profile.expansions++;
+    profile.cacheHits += cacheHit ? 1 : 0;
+    profile.totalNanoseconds += elapsed;
+    profile.selfNanoseconds += elapsed > children ? elapsed - children : 0;
+    profile.bytesProduced += bytes;
+    profile.maxDepth = std::max(profile.maxDepth, expansionContext_.currentDepth + 1);
+    
+    if (profileSite_.filename.empty()) {
+        return;
+    }
+    for (const auto& site : profile.callSites) {
+        if (site.line == profileSite_.line && site.filename == profileSite_.filename) {
+            return;
+        }
+    }
+    if (profile.callSites.size() < MAX_PROFILE_CALL_SITES) {
+        profile.callSites.push_back(profileSite_);
+    } else {
+        profile.callSitesTruncated = true;
     }
 }
 
@@ -1003,20 +1431,54 @@ void MacroProcessor::resetExpansionContext() {
 }
 
 void MacroProcessor::clearUserMacros() {
-    auto it = macros_.begin();
-    while (it != macros_.end()) {
-        if (!it->second.isPredefined) {
-            it = macros_.erase(it);
-        } else {
-            ++it;
-        }
+    // Reset em bloco da tabela, reinserindo apenas as poucas macros predefinidas
+    std::vector<MacroInfo> predefined;
+    macros_.forEach([&predefined](const MacroInfo& info) {
+        if (info.isPredefined) predefined.push_back(info);
+    });
+    macros_.reset();
+    for (auto& info : predefined) {
+        std::string name = info.name;
+        macros_.assign(name, std::move(info));
     }
     clearCache();
 }
 
 void MacroProcessor::clearAllMacros() {
-    macros_.clear();
+    // Reset em bloco: a capacidade da tabela e da arena é reaproveitada
+    macros_.reset();
+    clearCache();
+}
+
+std::vector<MacroInfo> MacroProcessor::exportUserMacros() const {
+    std::vector<MacroInfo> result;
+    result.reserve(macros_.size());
+    macros_.forEach([&result](const MacroInfo& info) {
+        if (!info.isPredefined) result.push_back(info);
+    });
+    return result;
+}
+
+size_t MacroProcessor::importMacros(std::vector<MacroInfo> macros) {
+    clearUserMacros();
+    
+    size_t restored = 0;
+    for (auto& info : macros) {
+        if (info.name.empty() || info.isPredefined) continue;
+        if (info.isFunctionLike()) {
+            info.replacement = compileReplacementTemplate(info.value, info.parameters, info.isVariadic);
+        }
+        info.expansionCount = 0;
+        std::string name = info.name;
+        macros_.assign(name, std::move(info));
+        restored++;
+    }
+    
     clearCache();
+    if (logger_) {
+        PP_LOG_INFO(logger_, "Macros restauradas de snapshot: " + std::to_string(restored));
+    }
+    return restored;
 }
 
 // Métodos Auxiliares Privados
@@ -1040,155 +1502,205 @@ bool MacroProcessor::isReservedName(const std::string& name) const {
 std::string MacroProcessor::substituteParameters(const std::string& body,
                                                 const std::vector<std::string>& parameters,
                                                 const std::vector<std::string>& arguments) {
-    std::string result = body;
-    
-    // Primeiro passo: processar operadores # (stringificação) e ## (concatenação)
-    result = processStringificationAndConcatenation(result, parameters, arguments);
+    // Caminho sem template armazenado: compila sob demanda
+    bool hasVariadic = arguments.size() > parameters.size();
+    MacroReplacementTemplate tmpl = compileReplacementTemplate(body, parameters, hasVariadic);
+    return instantiateTemplate(tmpl, parameters.size(), arguments);
+}
+
+MacroReplacementTemplate MacroProcessor::compileReplacementTemplate(const std::string& body,
+                                                                    const std::vector<std::string>& parameters,
+                                                                    bool isVariadic) const {
+    MacroReplacementTemplate tmpl;
+    std::vector<MacroTemplatePart>& parts = tmpl.parts;
     
-    // Segundo passo: substituir parâmetros normais
-    for (size_t i = 0; i < parameters.size() && i < arguments.size(); ++i) {
-        const std::string& param = parameters[i];
-        const std::string& arg = arguments[i];
-        
-        // Usa regex simples para substituir palavras completas
-        std::regex paramRegex("\\b" + param + "\\b");
-        result = std::regex_replace(result, paramRegex, arg);
+    std::unordered_map<std::string, size_t> paramIndex;
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        paramIndex.emplace(parameters[i], i);
     }
-    
-    // Terceiro passo: tratar argumentos variádicos
-    if (arguments.size() > parameters.size()) {
-        std::vector<std::string> variadicArgs(arguments.begin() + parameters.size(), arguments.end());
-        std::string variadicExpansion = expandVariadicArguments(variadicArgs);
-        
-        // Substitui __VA_ARGS__
-        std::regex variadicRegex("\\b__VA_ARGS__\\b");
-        result = std::regex_replace(result, variadicRegex, variadicExpansion);
+    if (isVariadic) {
+        paramIndex.emplace("__VA_ARGS__", parameters.size());
     }
     
-    return result;
-}
-
-std::string MacroProcessor::processStringificationAndConcatenation(const std::string& body,
-                                                                  const std::vector<std::string>& parameters,
-                                                                  const std::vector<std::string>& arguments) {
-    std::string result = body;
+    auto appendLiteral = [&parts](const std::string& text) {
+        if (text.empty()) return;
+        if (!parts.empty() && parts.back().kind == MacroTemplateSlot::LITERAL) {
+            parts.back().text += text;
+        } else {
+            parts.emplace_back(MacroTemplateSlot::LITERAL, text);
+        }
+    };
     
-    // Processar operador de stringificação (#)
-    for (size_t i = 0; i < parameters.size() && i < arguments.size(); ++i) {
-        const std::string& param = parameters[i];
-        const std::string& arg = arguments[i];
-        
-        // Escapar caracteres especiais do parâmetro para regex
-        std::string escapedParam = std::regex_replace(param, std::regex("[.^$|()\\[\\]{}*+?]"), "\\$&");
-        
-        // Procurar por #param
-        try {
-            std::regex stringifyRegex("#\\s*" + escapedParam + "\\b");
-            std::string stringifiedArg = handleStringification(arg);
-            result = std::regex_replace(result, stringifyRegex, stringifiedArg);
-        } catch (const std::regex_error&) {
-            // Se a regex falhar, usar busca simples
-            std::string pattern = "# " + param;
-            size_t pos = result.find(pattern);
-            if (pos != std::string::npos) {
-                result.replace(pos, pattern.length(), handleStringification(arg));
-            }
+    auto readIdentifier = [&body](size_t pos) {
+        size_t end = pos;
+        while (end < body.length() && isValidMacroNameChar(body[end], end == pos)) {
+            end++;
         }
-    }
+        return end;
+    };
     
-    // Processar stringificação de __VA_ARGS__
-    if (arguments.size() > parameters.size()) {
-        std::vector<std::string> variadicArgs(arguments.begin() + parameters.size(), arguments.end());
-        std::string variadicExpansion = expandVariadicArguments(variadicArgs);
-        
-        try {
-            std::regex stringifyVariadicRegex("#\\s*__VA_ARGS__\\b");
-            std::string stringifiedVariadic = handleStringification(variadicExpansion);
-            result = std::regex_replace(result, stringifyVariadicRegex, stringifiedVariadic);
-        } catch (const std::regex_error&) {
-            // Fallback para busca simples
-            std::string pattern = "#__VA_ARGS__";
-            size_t pos = result.find(pattern);
-            if (pos != std::string::npos) {
-                result.replace(pos, pattern.length(), handleStringification(variadicExpansion));
-            }
+    auto skipSpaces = [&body](size_t pos) {
+        while (pos < body.length() && std::isspace(static_cast<unsigned char>(body[pos]))) {
+            pos++;
         }
-    }
+        return pos;
+    };
     
-    // Processar operador de concatenação (##)
-    for (size_t i = 0; i < parameters.size() && i < arguments.size(); ++i) {
-        const std::string& param = parameters[i];
-        const std::string& arg = arguments[i];
-        
-        // Escapar caracteres especiais do parâmetro para regex
-        std::string escapedParam = std::regex_replace(param, std::regex("[.^$|()\\[\\]{}*+?]"), "\\$&");
+    bool pasteNext = false; // Próximo token é operando direito de ##
+    size_t pos = 0;
+    
+    while (pos < body.length()) {
+        char c = body[pos];
         
-        try {
-            // Procurar por token##param ou param##token
-            std::regex concatLeftRegex("(\\w+)\\s*##\\s*" + escapedParam + "\\b");
-            std::regex concatRightRegex("\\b" + escapedParam + "\\s*##\\s*(\\w+)");
-            
-            // Substituir usando busca manual para evitar problemas com lambdas
-            std::smatch match;
-            if (std::regex_search(result, match, concatLeftRegex)) {
-                std::string replacement = handleConcatenation(match[1].str(), arg);
-                result = std::regex_replace(result, concatLeftRegex, replacement);
+        // Espaços: descartados ao redor de ##
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            size_t end = skipSpaces(pos);
+            if (!pasteNext && body.compare(end, 2, "##") != 0) {
+                appendLiteral(body.substr(pos, end - pos));
             }
-            
-            if (std::regex_search(result, match, concatRightRegex)) {
-                std::string replacement = handleConcatenation(arg, match[1].str());
-                result = std::regex_replace(result, concatRightRegex, replacement);
+            pos = end;
+            continue;
+        }
+        
+        // Literais de string/caractere nunca contêm parâmetros
+        if (c == '"' || c == '\'') {
+            size_t end = pos + 1;
+            while (end < body.length() && body[end] != c) {
+                if (body[end] == '\\') end++;
+                end++;
             }
-        } catch (const std::regex_error&) {
-            // Fallback para busca simples
-            std::string leftPattern = param + "##";
-            std::string rightPattern = "##" + param;
-            
-            size_t pos = result.find(leftPattern);
-            if (pos != std::string::npos) {
-                result.replace(pos, leftPattern.length(), arg);
+            end = std::min(end + 1, body.length());
+            appendLiteral(body.substr(pos, end - pos));
+            pasteNext = false;
+            pos = end;
+            continue;
+        }
+        
+        // Operador de concatenação: o operando esquerdo perde espaços finais
+        if (body.compare(pos, 2, "##") == 0) {
+            while (!parts.empty() && parts.back().kind == MacroTemplateSlot::LITERAL) {
+                std::string& text = parts.back().text;
+                size_t last = text.find_last_not_of(" \t\r\n");
+                if (last != std::string::npos) {
+                    text.erase(last + 1);
+                    break;
+                }
+                parts.pop_back();
             }
-            
-            pos = result.find(rightPattern);
-            if (pos != std::string::npos) {
-                result.replace(pos, rightPattern.length(), arg);
+            if (!parts.empty() && parts.back().kind == MacroTemplateSlot::PARAMETER) {
+                parts.back().kind = MacroTemplateSlot::PASTE;
             }
+            pasteNext = true;
+            pos += 2;
+            continue;
         }
-    }
-    
-    // Processar concatenação com __VA_ARGS__
-    if (arguments.size() > parameters.size()) {
-        std::vector<std::string> variadicArgs(arguments.begin() + parameters.size(), arguments.end());
-        std::string variadicExpansion = expandVariadicArguments(variadicArgs);
         
-        try {
-            std::regex concatVariadicLeftRegex("(\\w+)\\s*##\\s*__VA_ARGS__\\b");
-            std::regex concatVariadicRightRegex("\\b__VA_ARGS__\\s*##\\s*(\\w+)");
-            
-            std::smatch match;
-            if (std::regex_search(result, match, concatVariadicLeftRegex)) {
-                std::string replacement = handleConcatenation(match[1].str(), variadicExpansion);
-                result = std::regex_replace(result, concatVariadicLeftRegex, replacement);
+        // Operador de stringificação: só vale quando seguido de parâmetro
+        if (c == '#') {
+            size_t identStart = skipSpaces(pos + 1);
+            size_t identEnd = readIdentifier(identStart);
+            if (identEnd > identStart) {
+                auto it = paramIndex.find(body.substr(identStart, identEnd - identStart));
+                if (it != paramIndex.end()) {
+                    parts.emplace_back(MacroTemplateSlot::STRINGIFY, "", it->second);
+                    pasteNext = false;
+                    pos = identEnd;
+                    continue;
+                }
             }
-            
-            if (std::regex_search(result, match, concatVariadicRightRegex)) {
-                std::string replacement = handleConcatenation(variadicExpansion, match[1].str());
-                result = std::regex_replace(result, concatVariadicRightRegex, replacement);
+            appendLiteral("#");
+            pasteNext = false;
+            pos++;
+            continue;
+        }
+        
+        // Identificadores: parâmetro vira slot, demais são literais
+        if (isValidMacroNameChar(c, true)) {
+            size_t end = readIdentifier(pos);
+            std::string ident = body.substr(pos, end - pos);
+            auto it = paramIndex.find(ident);
+            if (it != paramIndex.end()) {
+                bool pasteRight = body.compare(skipSpaces(end), 2, "##") == 0;
+                parts.emplace_back(pasteNext || pasteRight ? MacroTemplateSlot::PASTE
+                                                           : MacroTemplateSlot::PARAMETER,
+                                   "", it->second);
+            } else {
+                appendLiteral(ident);
             }
-        } catch (const std::regex_error&) {
-            // Fallback para busca simples
-            std::string leftPattern = "__VA_ARGS__##";
-            std::string rightPattern = "##__VA_ARGS__";
-            
-            size_t pos = result.find(leftPattern);
-            if (pos != std::string::npos) {
-                result.replace(pos, leftPattern.length(), variadicExpansion);
+            pasteNext = false;
+            pos = end;
+            continue;
+        }
+        
+        // Números são consumidos inteiros para não confundir sufixos com parâmetros
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            size_t end = pos;
+            while (end < body.length() &&
+                   (std::isalnum(static_cast<unsigned char>(body[end])) || body[end] == '_' || body[end] == '.')) {
+                end++;
             }
-            
-            pos = result.find(rightPattern);
-            if (pos != std::string::npos) {
-                result.replace(pos, rightPattern.length(), variadicExpansion);
+            appendLiteral(body.substr(pos, end - pos));
+            pasteNext = false;
+            pos = end;
+            continue;
+        }
+        
+        appendLiteral(std::string(1, c));
+        pasteNext = false;
+        pos++;
+    }
+    
+    for (const auto& part : parts) {
+        tmpl.literalBytes += part.text.size();
+    }
+    tmpl.compiled = true;
+    return tmpl;
+}
+
+std::string MacroProcessor::instantiateTemplate(const MacroReplacementTemplate& tmpl,
+                                                size_t parameterCount,
+                                                const std::vector<std::string>& arguments) {
+    // Argumentos variádicos são unidos apenas uma vez por chamada
+    std::string variadicText;
+    bool variadicReady = false;
+    
+    auto argumentText = [&](size_t index) -> const std::string& {
+        if (index < parameterCount) {
+            static const std::string empty;
+            return index < arguments.size() ? arguments[index] : empty;
+        }
+        if (!variadicReady) {
+            if (arguments.size() > parameterCount) {
+                std::vector<std::string> variadicArgs(arguments.begin() + parameterCount, arguments.end());
+                variadicText = expandVariadicArguments(variadicArgs);
             }
+            variadicReady = true;
+        }
+        return variadicText;
+    };
+    
+    size_t estimatedSize = tmpl.literalBytes;
+    for (const auto& arg : arguments) {
+        estimatedSize += arg.size();
+    }
+    
+    std::string result;
+    result.reserve(estimatedSize);
+    
+    for (const auto& part : tmpl.parts) {
+        switch (part.kind) {
+            case MacroTemplateSlot::LITERAL:
+                result += part.text;
+                break;
+            case MacroTemplateSlot::PARAMETER:
+                result += argumentText(part.paramIndex);
+                break;
+            case MacroTemplateSlot::STRINGIFY:
+                result += handleStringification(argumentText(part.paramIndex));
+                break;
+            case MacroTemplateSlot::PASTE:
+                result += trimWhitespace(argumentText(part.paramIndex));
+                break;
         }
     }
     
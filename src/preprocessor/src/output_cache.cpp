@@ -0,0 +1,265 @@
+#include "../include/output_cache.hpp"
+#include "../include/binary_format.hpp"
+#include "../include/block_codec.hpp"
+#include "../include/file_view.hpp"
+#include <cerrno>
+#include <sys/stat.h>
+
+namespace Preprocessor {
+
+namespace {
+
+constexpr char OUTPUT_CACHE_MAGIC[4] = {'P', 'P', 'O', 'C'};
+constexpr uint32_t OUTPUT_CACHE_FORMAT_VERSION = 4;
+
+// Código expandido gravado como está ou como quadro do BlockCodec
+constexpr uint8_t CODE_STORED = 0;
+constexpr uint8_t CODE_COMPRESSED = 1;
+
+// Saídas pequenas não compensam o cabeçalho do quadro
+constexpr size_t MIN_COMPRESSED_CODE_SIZE = 512;
+
+// Cria o diretório e os diretórios intermediários (equivalente a mkdir -p)
+bool createDirectories(const std::string& path) {
+    if (path.empty()) {
+        return false;
+    }
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        std::string prefix = path.substr(0, pos);
+        if (::mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (pos == std::string::npos) {
+            break;
+        }
+    }
+    struct stat info;
+    return ::stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+} // namespace
+
+OutputCache::OutputCache(const std::string& directory, PreprocessorLogger* logger,
+                         const FileManager* file_manager)
+    : directory_(directory), logger_(logger), file_manager_(file_manager), usable_(false) {
+    while (directory_.size() > 1 && directory_.back() == '/') {
+        directory_.pop_back();
+    }
+    usable_ = createDirectories(directory_);
+    if (!usable_ && logger_) {
+        logger_->warning("Diretório do cache de saída indisponível: " + directory_);
+    }
+}
+
+std::string OutputCache::entryPath(uint64_t key) const {
+    return directory_ + "/" + ContentHash::toHex(key) + ".ppo";
+}
+
+bool OutputCache::hashFileContent(const std::string& path, uint64_t& hash) const {
+    if (file_manager_) {
+        return file_manager_->getContentHash(path, hash);
+    }
+    return ContentHash::computeFile(path, hash);
+}
+
+bool OutputCache::lookup(uint64_t key, CachedOutput& output) {
+    // A entrada é mapeada e decodificada direto da visão
+    FileView data = usable_ ? FileView::open(entryPath(key)) : FileView();
+    if (!data.valid()) {
+        stats_.misses++;
+        return false;
+    }
+
+    const char* payload = nullptr;
+    size_t payload_size = 0;
+    if (BinaryFormat::unseal(data.data(), data.size(), OUTPUT_CACHE_MAGIC, OUTPUT_CACHE_FORMAT_VERSION,
+                             payload, payload_size) != BinaryFormat::EnvelopeStatus::OK) {
+        if (logger_) {
+            logger_->warning("Entrada do cache de saída inválida: " + entryPath(key));
+        }
+        stats_.misses++;
+        return false;
+    }
+
+    BinaryFormat::Reader reader(payload, payload_size);
+    if (reader.u64() != key) {
+        stats_.misses++;
+        return false;
+    }
+
+    // Dependências primeiro: se alguma mudou, o resto da entrada nem é decodificado
+    uint32_t dependency_count = reader.u32();
+    if (dependency_count > payload_size) {
+        stats_.misses++;
+        return false;
+    }
+    output.dependencies.clear();
+    output.dependencies.reserve(dependency_count);
+    for (uint32_t i = 0; i < dependency_count && reader.good(); ++i) {
+        CachedDependency dependency;
+        dependency.path = reader.str();
+        dependency.contentHash = reader.u64();
+        uint64_t current_hash = 0;
+        if (reader.good() &&
+            (!hashFileContent(dependency.path, current_hash) || current_hash != dependency.contentHash)) {
+            stats_.invalidated++;
+            stats_.misses++;
+            return false;
+        }
+        output.dependencies.push_back(std::move(dependency));
+    }
+
+    uint32_t macro_count = reader.u32();
+    if (macro_count > payload_size) {
+        stats_.misses++;
+        return false;
+    }
+    output.macros.assign(macro_count, MacroInfo());
+    for (auto& info : output.macros) {
+        if (!BinaryFormat::readMacro(reader, info)) {
+            stats_.misses++;
+            return false;
+        }
+    }
+
+    output.outputLines = static_cast<size_t>(reader.u64());
+
+    uint32_t file_count = reader.u32();
+    if (file_count > payload_size) {
+        stats_.misses++;
+        return false;
+    }
+    std::vector<std::string> files;
+    files.reserve(file_count);
+    for (uint32_t i = 0; i < file_count && reader.good(); ++i) {
+        files.push_back(reader.str());
+    }
+    uint32_t run_count = reader.u32();
+    if (run_count > payload_size) {
+        stats_.misses++;
+        return false;
+    }
+    output.lineMap.clear();
+    output.lineMap.reserve(run_count);
+    for (uint32_t i = 0; i < run_count && reader.good(); ++i) {
+        uint32_t expanded_line = reader.u32();
+        uint32_t original_line = reader.u32();
+        uint32_t file_index = reader.u32();
+        if (!reader.good() || file_index >= files.size() ||
+            !output.lineMap.append(expanded_line, original_line, files[file_index])) {
+            stats_.misses++;
+            return false;
+        }
+    }
+    uint32_t splice_count = reader.u32();
+    if (splice_count > payload_size) {
+        stats_.misses++;
+        return false;
+    }
+    std::vector<size_t> columns;
+    for (uint32_t i = 0; i < splice_count && reader.good(); ++i) {
+        uint32_t expanded_line = reader.u32();
+        uint32_t column_count = reader.u32();
+        if (column_count > reader.remaining()) {
+            stats_.misses++;
+            return false;
+        }
+        columns.clear();
+        for (uint32_t j = 0; j < column_count && reader.good(); ++j) {
+            columns.push_back(reader.u32());
+        }
+        if (!reader.good() || !output.lineMap.appendSplices(expanded_line, columns)) {
+            stats_.misses++;
+            return false;
+        }
+    }
+
+    const uint8_t code_encoding = reader.u8();
+    std::string code = reader.str();
+    bool decoded = reader.good() && reader.atEnd();
+    if (decoded && code_encoding == CODE_COMPRESSED) {
+        decoded = BlockCodec::decompress(code.data(), code.size(), output.expandedCode);
+    } else {
+        decoded = decoded && code_encoding == CODE_STORED;
+        output.expandedCode = std::move(code);
+    }
+    if (!decoded) {
+        if (logger_) {
+            logger_->warning("Entrada do cache de saída corrompida: " + entryPath(key));
+        }
+        stats_.misses++;
+        return false;
+    }
+
+    stats_.hits++;
+    return true;
+}
+
+bool OutputCache::store(uint64_t key, const CachedOutput& output) {
+    if (!usable_) {
+        return false;
+    }
+
+    std::string payload;
+    payload.reserve(output.expandedCode.size() + 256);
+    BinaryFormat::putU64(payload, key);
+
+    BinaryFormat::putU32(payload, static_cast<uint32_t>(output.dependencies.size()));
+    for (const auto& dependency : output.dependencies) {
+        BinaryFormat::putString(payload, dependency.path);
+        BinaryFormat::putU64(payload, dependency.contentHash);
+    }
+
+    BinaryFormat::putU32(payload, static_cast<uint32_t>(output.macros.size()));
+    for (const auto& info : output.macros) {
+        BinaryFormat::putMacro(payload, info);
+    }
+
+    BinaryFormat::putU64(payload, static_cast<uint64_t>(output.outputLines));
+
+    BinaryFormat::putU32(payload, static_cast<uint32_t>(output.lineMap.fileCount()));
+    for (size_t i = 0; i < output.lineMap.fileCount(); ++i) {
+        BinaryFormat::putString(payload, output.lineMap.fileName(static_cast<uint32_t>(i)));
+    }
+    BinaryFormat::putU32(payload, static_cast<uint32_t>(output.lineMap.runCount()));
+    for (const auto& run : output.lineMap.runs()) {
+        BinaryFormat::putU32(payload, run.expandedLine);
+        BinaryFormat::putU32(payload, run.originalLine);
+        BinaryFormat::putU32(payload, run.fileIndex);
+    }
+    BinaryFormat::putU32(payload, static_cast<uint32_t>(output.lineMap.splices().size()));
+    for (const auto& splice : output.lineMap.splices()) {
+        BinaryFormat::putU32(payload, splice.expandedLine);
+        BinaryFormat::putU32(payload, splice.count);
+        for (uint32_t i = 0; i < splice.count; ++i) {
+            BinaryFormat::putU32(payload, output.lineMap.spliceColumns()[splice.begin + i]);
+        }
+    }
+
+    // Só o código expandido é comprimido: as dependências continuam legíveis sem descomprimir
+    std::string frame;
+    if (output.expandedCode.size() >= MIN_COMPRESSED_CODE_SIZE) {
+        frame = BlockCodec::compress(output.expandedCode);
+    }
+    if (!frame.empty() && frame.size() < output.expandedCode.size()) {
+        BinaryFormat::putU8(payload, CODE_COMPRESSED);
+        BinaryFormat::putString(payload, frame);
+    } else {
+        BinaryFormat::putU8(payload, CODE_STORED);
+        BinaryFormat::putString(payload, output.expandedCode);
+    }
+
+    const std::string path = entryPath(key);
+    if (!BinaryFormat::writeFileAtomically(path,
+            BinaryFormat::seal(OUTPUT_CACHE_MAGIC, OUTPUT_CACHE_FORMAT_VERSION, payload))) {
+        if (logger_) {
+            logger_->warning("Falha ao gravar entrada do cache de saída: " + path);
+        }
+        return false;
+    }
+
+    stats_.stores++;
+    return true;
+}
+
+} // namespace Preprocessor
@@ -1,15 +1,52 @@
 #include "../include/preprocessor.hpp"
 #include "../include/preprocessor_lexer_interface.hpp"
+#include "../include/binary_format.hpp"
+#include "../include/directive_scanner.hpp"
+#include "../include/line_reader.hpp"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
 
 namespace Preprocessor {
 
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[4] = {'P', 'P', 'S', 'N'};
+constexpr uint32_t SNAPSHOT_FORMAT_VERSION = 2;
+
+// Acumula a duração do escopo no custo de uma verificação de consistência
+class ConsistencyCheckTimer {
+public:
+    explicit ConsistencyCheckTimer(ConsistencyCheckCost& cost)
+        : cost_(cost), start_(std::chrono::steady_clock::now()) {}
+    
+    ~ConsistencyCheckTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        cost_.runs++;
+        cost_.nanoseconds += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    
+private:
+    ConsistencyCheckCost& cost_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace
+
 // Construtor
-PreprocessorMain::PreprocessorMain(const std::string& config_file)
-    : initialized_(false)
+PreprocessorMain::PreprocessorMain(const std::string& config_file, std::shared_ptr<FileManager> shared_files)
+    : file_manager_(std::move(shared_files))
+    , shared_file_manager_(file_manager_ != nullptr)
+    , output_bytes_(0)
+    , output_lines_(0)
+    , initialized_(false)
     , processing_active_(false)
     , current_line_(0)
     , external_error_handler_(nullptr)
@@ -24,7 +61,9 @@ PreprocessorMain::PreprocessorMain(const std::string& config_file)
     auto shared_state = std::shared_ptr<PreprocessorState>(state_.get(), [](PreprocessorState*){});
     
     macro_processor_ = std::make_unique<MacroProcessor>(shared_logger, shared_state);
-    file_manager_ = std::make_unique<FileManager>(std::vector<std::string>(), logger_.get());
+    if (!file_manager_) {
+        file_manager_ = std::make_shared<FileManager>(std::vector<std::string>(), logger_.get());
+    }
     conditional_processor_ = std::make_unique<ConditionalProcessor>(logger_.get(), macro_processor_.get());
     expression_evaluator_ = std::make_unique<ExpressionEvaluator>(macro_processor_.get(), logger_.get());
     
@@ -53,16 +92,18 @@ bool PreprocessorMain::initializeComponents() {
         // Carregar macros predefinidas
         macro_processor_->initializePredefinedMacros();
         
-        // Configurar caminhos de busca padrão
-        std::vector<std::string> default_paths = {
-            "/usr/include",
-            "/usr/local/include",
-            "."
-        };
-        file_manager_->setSearchPaths(default_paths);
+        // Configurar caminhos de busca padrão (um FileManager compartilhado já vem configurado)
+        if (!shared_file_manager_) {
+            std::vector<std::string> default_paths = {
+                "/usr/include",
+                "/usr/local/include",
+                "."
+            };
+            file_manager_->setSearchPaths(default_paths);
+        }
         
         initialized_ = true;
-        logger_->info("Preprocessor inicializado com sucesso");
+        PP_LOG_INFO(logger_, "Preprocessor inicializado com sucesso");
         return true;
         
     } catch (const std::exception& e) {
@@ -98,30 +139,75 @@ bool PreprocessorMain::process(const std::string& filename) {
             state_->setFileContext(FileContext(filename, 1, 1));
             state_->setProcessingMode(ProcessingMode::NORMAL);
             state_->addProcessedFile(filename);
+            for (const auto& prelude_file : snapshot_files_) {
+                state_->addProcessedFile(prelude_file);
+            }
         }
         
         // Limpar dados anteriores
         expanded_code_.clear();
+        output_bytes_ = 0;
+        output_lines_ = 0;
         dependencies_.clear();
-        position_mappings_.clear();
+        line_map_.clear();
+        
+        PP_LOG_INFO(logger_, "Iniciando processamento coordenado do arquivo: " + filename);
         
-        logger_->info("Iniciando processamento coordenado do arquivo: " + filename);
+        // Verificações de diagnóstico só no perfil CHECKED
+        const bool checked = config_->areConsistencyChecksEnabled();
         
         // 3. Validação de entrada
-        if (!validateInput(filename)) {
-            logger_->error("Falha na validação de entrada do arquivo: " + filename);
-            processing_active_ = false;
-            return false;
+        if (checked) {
+            ConsistencyCheckTimer timer(consistency_stats_.input_validation);
+            if (!validateInput(filename)) {
+                logger_->error("Falha na validação de entrada do arquivo: " + filename);
+                processing_active_ = false;
+                return false;
+            }
+        }
+        
+        // 3.1 Consulta ao cache de saída
+        uint64_t cache_key = 0;
+        const bool cacheable = output_cache_ && output_cache_->isUsable() &&
+                               computeOutputCacheKey(filename, cache_key);
+        if (cacheable) {
+            CachedOutput cached;
+            if (output_cache_->lookup(cache_key, cached)) {
+                restoreCachedOutput(cached);
+                processing_active_ = false;
+                if (state_) {
+                    state_->pushState(ProcessingState::FINISHED);
+                }
+                PP_LOG_INFO(logger_, "Resultado reaproveitado do cache de saída: " + filename);
+                return true;
+            }
         }
         
         // 4. Sincronização de componentes
-        if (!synchronizeProcessors()) {
-            logger_->error("Falha na sincronização de componentes");
-            processing_active_ = false;
-            return false;
+        if (checked) {
+            ConsistencyCheckTimer timer(consistency_stats_.synchronization);
+            if (!synchronizeProcessors()) {
+                logger_->error("Falha na sincronização de componentes");
+                processing_active_ = false;
+                return false;
+            }
+        } else if (conditional_processor_) {
+            // Condicionais abertas de uma execução anterior não podem vazar para esta
+            conditional_processor_->reset();
         }
         
         // 5. Processamento principal com monitoramento
+        // Em streaming a saída também é capturada para poder ser gravada no cache
+        std::string captured_output;
+        OutputSink original_sink;
+        if (cacheable && output_sink_) {
+            original_sink = output_sink_;
+            output_sink_ = [&captured_output, &original_sink](std::string_view chunk) {
+                captured_output.append(chunk.data(), chunk.size());
+                original_sink(chunk);
+            };
+        }
+        
         bool result = false;
         try {
             result = processFile(filename);
@@ -131,9 +217,18 @@ bool PreprocessorMain::process(const std::string& filename) {
             result = false;
         }
         
-        // 6. Validação de saída
-        if (result && !validateOutput(expanded_code_)) {
-            logger_->warning("Saída gerada pode conter problemas");
+        if (original_sink) {
+            output_sink_ = std::move(original_sink);
+        }
+        
+        // 6. Validação de saída. Em streaming a saída não fica em memória: só as
+        //    linhas de código passaram por validateOutput em processLine; as
+        //    linhas emitidas por diretivas não são validadas
+        if (checked && result && !output_sink_) {
+            ConsistencyCheckTimer timer(consistency_stats_.output_validation);
+            if (!validateOutput(expanded_code_)) {
+                logger_->warning("Saída gerada pode conter problemas");
+            }
         }
         
         // 7. Finalização coordenada
@@ -147,15 +242,44 @@ bool PreprocessorMain::process(const std::string& filename) {
             }
         }
         
-        // 8. Verificação de integridade final
+        // 8. Verificação de integridade final (decide o resultado em qualquer perfil)
         if (result) {
+            ConsistencyCheckTimer timer(consistency_stats_.integrity_check);
             result = performIntegrityCheck();
         }
         
+        // 8.1 Gravação no cache de saída
+        if (result && cacheable) {
+            CachedOutput entry;
+            bool complete = true;
+            for (const auto& dependency : dependencies_) {
+                uint64_t content_hash = 0;
+                if (!output_cache_->hashFileContent(dependency, content_hash)) {
+                    complete = false;
+                    break;
+                }
+                entry.dependencies.push_back(CachedDependency{dependency, content_hash});
+            }
+            if (complete) {
+                entry.macros = macro_processor_->exportUserMacros();
+                entry.outputLines = output_lines_;
+                entry.lineMap = line_map_;
+                // O buffer é emprestado à entrada e devolvido, sem cópia
+                entry.expandedCode = output_sink_ ? std::move(captured_output) : std::move(expanded_code_);
+                output_cache_->store(cache_key, entry);
+                if (!output_sink_) {
+                    expanded_code_ = std::move(entry.expandedCode);
+                }
+            }
+        }
+        
         // 9. Relatório final
         if (result) {
-            logger_->info("Processamento concluído com sucesso");
-            logger_->info("Estatísticas: " + generateProcessingReport());
+            PP_LOG_INFO(logger_, "Processamento concluído com sucesso");
+            if (checked && PP_LOG_ENABLED(logger_, LogLevel::INFO)) {
+                ConsistencyCheckTimer timer(consistency_stats_.report);
+                logger_->info("Estatísticas: " + generateProcessingReport());
+            }
         } else {
             logger_->error("Falha no processamento do arquivo");
         }
@@ -184,24 +308,22 @@ bool PreprocessorMain::processString(const std::string& content) {
      //   logger_->info("Iniciando processamento de string");
         
         // Validar entrada
-        if (!validateInput(content)) {
-            logger_->error("Entrada inválida");
-            processing_active_ = false;
-            return false;
+        if (config_->areConsistencyChecksEnabled()) {
+            ConsistencyCheckTimer timer(consistency_stats_.input_validation);
+            if (!validateInput(content)) {
+                logger_->error("Entrada inválida");
+                processing_active_ = false;
+                return false;
+            }
         }
         
         // Processar linha por linha
-        std::istringstream iss(content);
-        std::string line;
         int line_number = 1;
         
-        while (std::getline(iss, line)) {
-            if (!processLine(line, line_number)) {
-                logger_->error("Erro no processamento da linha " + std::to_string(line_number));
-                processing_active_ = false;
-                return false;
-            }
-            line_number++;
+        if (!processBuffer(content, line_number)) {
+            logger_->error("Erro no processamento da linha " + std::to_string(line_number));
+            processing_active_ = false;
+            return false;
         }
         
         processing_active_ = false;
@@ -218,9 +340,10 @@ bool PreprocessorMain::processString(const std::string& content) {
 // Processamento de arquivo específico
 bool PreprocessorMain::processFile(const std::string& filepath) {
     try {
-        // Verificar se arquivo existe
-        std::ifstream file(filepath);
-        if (!file.is_open()) {
+        // Visão do arquivo inteiro (mapeada e compartilhada com o cache do FileManager),
+        // o que permite saltar blocos inativos sem getline
+        FileView content = file_manager_->openFileView(filepath);
+        if (!content.valid()) {
             logger_->error("Não foi possível abrir o arquivo: " + filepath);
             return false;
         }
@@ -229,21 +352,13 @@ bool PreprocessorMain::processFile(const std::string& filepath) {
         dependencies_.push_back(filepath);
         
         // Processar linha por linha
-        std::string line;
         int line_number = 1;
         
-        while (std::getline(file, line)) {
-            current_line_ = line_number;
-            
-            if (!processLine(line, line_number)) {
-                logger_->error("Erro no processamento da linha " + std::to_string(line_number) + " do arquivo " + filepath);
-                return false;
-            }
-            
-            line_number++;
+        if (!processBuffer(content.view(), line_number)) {
+            logger_->error("Erro no processamento da linha " + std::to_string(line_number) + " do arquivo " + filepath);
+            return false;
         }
         
-        file.close();
         return true;
         
     } catch (const std::exception& e) {
@@ -252,6 +367,123 @@ bool PreprocessorMain::processFile(const std::string& filepath) {
     }
 }
 
+// Processamento de buffer completo
+bool PreprocessorMain::processBuffer(std::string_view content, int& line_number) {
+    const size_t size = content.size();
+    LineReader reader(content);
+    std::string_view logical_line;
+    std::string line;
+    
+    // O estado condicional só muda em diretivas; fora delas não é reconsultado
+    bool check_conditional = true;
+    
+    while (reader.offset() < size) {
+        if (check_conditional && conditional_processor_ && !conditional_processor_->shouldProcessBlock()) {
+            reader.seek(skipInactiveBlock(content, reader.offset(), line_number));
+            if (reader.offset() >= size) {
+                break;
+            }
+        }
+        
+        if (!reader.next(logical_line)) {
+            break;
+        }
+        line.assign(logical_line.data(), logical_line.size());
+        
+        size_t first_non_space = line.find_first_not_of(" \t");
+        check_conditional = (first_non_space != std::string::npos && line[first_non_space] == '#');
+        
+        current_line_ = line_number;
+        const uint32_t expanded_line = static_cast<uint32_t>(output_lines_ + 1);
+        if (!processLine(line, line_number)) {
+            if (reader.wasSpliced()) {
+                logger_->error("Linha lógica formada pelas linhas físicas " + std::to_string(line_number) +
+                               "-" + std::to_string(line_number + reader.physicalLineCount() - 1));
+            }
+            return false;
+        }
+        
+        // Linhas emendadas: preservar a numeração das linhas físicas na saída e
+        // guardar as emendas para que colunas após elas mapeiem para a linha física
+        int physical_lines = reader.physicalLineCount();
+        if (physical_lines > 1) {
+            line_map_.appendSplices(expanded_line, reader.spliceColumns());
+            writeOutput(std::string(static_cast<size_t>(physical_lines - 1), '\n'));
+        }
+        line_number += physical_lines;
+    }
+    
+    return true;
+}
+
+// Salto de bloco condicional inativo
+size_t PreprocessorMain::skipInactiveBlock(std::string_view content, size_t offset, int& line_number) {
+    const char* data = content.data();
+    const size_t size = content.size();
+    size_t cursor = offset;
+    size_t stop = size;
+    
+    while (cursor < size) {
+        const char* hash = static_cast<const char*>(std::memchr(data + cursor, '#', size - cursor));
+        if (!hash) {
+            break;
+        }
+        
+        // '#' só inicia diretiva se precedido apenas por espaços na linha
+        size_t line_start = static_cast<size_t>(hash - data);
+        while (line_start > 0 && (data[line_start - 1] == ' ' || data[line_start - 1] == '\t')) {
+            line_start--;
+        }
+        
+        // Linha física precedida de '\\' + quebra continua a linha lógica anterior
+        bool spliced = false;
+        if (line_start > 0 && data[line_start - 1] == '\n') {
+            size_t before = line_start - 1;
+            if (before > 0 && data[before - 1] == '\r') {
+                before--;
+            }
+            spliced = before > 0 && data[before - 1] == '\\';
+        }
+        
+        if (!spliced && (line_start == 0 || data[line_start - 1] == '\n')) {
+            const char* name = hash + 1;
+            const char* end = data + size;
+            while (name < end && (*name == ' ' || *name == '\t')) {
+                name++;
+            }
+            const char* name_end = name;
+            while (name_end < end && std::isalpha(static_cast<unsigned char>(*name_end))) {
+                name_end++;
+            }
+            std::string_view keyword(name, static_cast<size_t>(name_end - name));
+            if (isConditionalDirective(lookupDirectiveType(keyword))) {
+                stop = line_start;
+                break;
+            }
+        }
+        
+        const char* newline = static_cast<const char*>(std::memchr(hash, '\n', size - static_cast<size_t>(hash - data)));
+        cursor = newline ? static_cast<size_t>(newline - data) + 1 : size;
+    }
+    
+    // Preservar numeração: uma quebra de linha por linha saltada
+    size_t skipped = static_cast<size_t>(std::count(data + offset, data + stop, '\n'));
+    if (stop == size && stop > offset && data[size - 1] != '\n') {
+        skipped++;
+    }
+    
+    if (skipped > 0) {
+        writeOutput(std::string(skipped, '\n'));
+        line_number += static_cast<int>(skipped);
+        if (state_) {
+            state_->setCurrentLine(line_number);
+        }
+        PP_LOG_DEBUG(logger_, "Bloco condicional inativo saltado: " + std::to_string(skipped) + " linhas");
+    }
+    
+    return stop;
+}
+
 // Processamento de linha individual
 bool PreprocessorMain::processLine(const std::string& line, int line_number) {
     try {
@@ -266,23 +498,12 @@ bool PreprocessorMain::processLine(const std::string& line, int line_number) {
         
         // Verificar se é uma diretiva primeiro (diretivas sempre devem ser processadas)
         // Diretivas podem estar indentadas, então procurar por '#' após espaços em branco
-        std::string trimmed_line = line;
-        size_t first_non_space = trimmed_line.find_first_not_of(" \t");
-        
-        // Debug: log detalhado para verificar detecção de diretivas
-        // logger_->info("PROCESSANDO LINHA: '" + line + "'");
-        // logger_->info("first_non_space: " + std::to_string(first_non_space));
-        if (first_non_space != std::string::npos) {
-            char first_char = trimmed_line[first_non_space];
-            // logger_->info("Primeiro char não-espaço: '" + std::string(1, first_char) + "' (ASCII: " + std::to_string((int)first_char) + ")");
-            // logger_->info("Comparação com '#': " + std::string(first_char == '#' ? "true" : "false"));
-        }
-        
-        bool is_directive = (first_non_space != std::string::npos && trimmed_line[first_non_space] == '#');
+        size_t first_non_space = line.find_first_not_of(" \t");
+        bool is_directive = (first_non_space != std::string::npos && line[first_non_space] == '#');
  //       logger_->info("is_directive: " + std::string(is_directive ? "true" : "false"));
         
         if (is_directive) {
-            logger_->info("DIRETIVA DETECTADA: " + line);
+            PP_LOG_INFO(logger_, "DIRETIVA DETECTADA: " + line);
         }
         
         if (is_directive) {
@@ -346,7 +567,7 @@ bool PreprocessorMain::processLine(const std::string& line, int line_number) {
         } else {
             // Verificar se devemos processar esta linha normal (compilação condicional)
             if (conditional_processor_ && !conditional_processor_->shouldProcessBlock()) {
-                logger_->debug("Linha ignorada por compilação condicional: " + std::to_string(line_number));
+                PP_LOG_DEBUG(logger_, "Linha ignorada por compilação condicional: " + std::to_string(line_number));
                 // Para linhas dentro de blocos condicionais falsos, não escrever na saída
                 // mas adicionar quebra de linha para preservar numeração
                 writeOutput("\n");
@@ -356,19 +577,23 @@ bool PreprocessorMain::processLine(const std::string& line, int line_number) {
             // Linha normal - coordenar processamento entre componentes
             
             // 1. Expandir macros com mapeamento de posições
-            std::string expanded_line = macro_processor_->processLine(line);
+            std::string expanded_line = macro_processor_->processLine(line, original_pos);
             
-            // 2. Criar posição expandida
-            PreprocessorPosition expanded_pos(current_file_, line_number, 1);
-            expanded_pos.expanded_line = line_number;
+            // 2. Criar posição expandida (linha que esta saída ocupará)
+            int output_line = static_cast<int>(output_lines_ + 1);
+            PreprocessorPosition expanded_pos(current_file_, output_line, 1);
+            expanded_pos.expanded_line = output_line;
             expanded_pos.expanded_column = 1;
             
             // 3. Atualizar mapeamento de posições
             updatePositionMapping(original_pos, expanded_pos);
             
             // 4. Validar saída antes de escrever
-            if (!validateOutput(expanded_line)) {
-                logger_->warning("Linha com possíveis problemas: " + std::to_string(line_number));
+            if (config_->areConsistencyChecksEnabled()) {
+                ConsistencyCheckTimer timer(consistency_stats_.output_validation);
+                if (!validateOutput(expanded_line)) {
+                    logger_->warning("Linha com possíveis problemas: " + std::to_string(line_number));
+                }
             }
             
             // 5. Escrever na saída
@@ -415,17 +640,19 @@ bool PreprocessorMain::handleDirective(const Directive& directive) {
                 
             case DirectiveType::DEFINE:
                 {
-                    logger_->info("Processando #define: " + directive.getContent());
+                    PP_LOG_INFO(logger_, "Processando #define: " + directive.getContent());
                     
-                    // Debug: mostrar argumentos parseados
+                    // Debug: mostrar argumentos parseados (montado só se INFO estiver ativo)
                     const auto& args = directive.getArguments();
-                    std::string debug_args = "Argumentos parseados: [";
-                    for (size_t i = 0; i < args.size(); ++i) {
-                        if (i > 0) debug_args += ", ";
-                        debug_args += "'" + args[i] + "'";
+                    if (PP_LOG_ENABLED(logger_, LogLevel::INFO)) {
+                        std::string debug_args = "Argumentos parseados: [";
+                        for (size_t i = 0; i < args.size(); ++i) {
+                            if (i > 0) debug_args += ", ";
+                            debug_args += "'" + args[i] + "'";
+                        }
+                        debug_args += "]";
+                        logger_->info(debug_args);
                     }
-                    debug_args += "]";
-                    logger_->info(debug_args);
                     if (args.empty()) {
                         logger_->error("#define requer um nome de macro");
                         return false;
@@ -463,20 +690,22 @@ bool PreprocessorMain::handleDirective(const Directive& directive) {
                         // Definir macro funcional usando o método correto
                         macro_processor_->defineFunctionMacro(base_name, parameters, macro_value, isVariadic);
                         
-                        std::string log_msg = "Macro funcional definida: ";
-                        log_msg += base_name;
-                        log_msg += "(";
-                        for (size_t i = 0; i < parameters.size(); ++i) {
-                            if (i > 0) log_msg += ", ";
-                            log_msg += parameters[i];
-                        }
-                        if (isVariadic) {
-                            if (!parameters.empty()) log_msg += ", ";
-                            log_msg += "...";
+                        if (PP_LOG_ENABLED(logger_, LogLevel::INFO)) {
+                            std::string log_msg = "Macro funcional definida: ";
+                            log_msg += base_name;
+                            log_msg += "(";
+                            for (size_t i = 0; i < parameters.size(); ++i) {
+                                if (i > 0) log_msg += ", ";
+                                log_msg += parameters[i];
+                            }
+                            if (isVariadic) {
+                                if (!parameters.empty()) log_msg += ", ";
+                                log_msg += "...";
+                            }
+                            log_msg += ") = ";
+                            log_msg += macro_value;
+                            logger_->info(log_msg);
                         }
-                        log_msg += ") = ";
-                        log_msg += macro_value;
-                        logger_->info(log_msg);
                     } else {
                         // Macro simples (object-like)
                         if (args.size() > 1) {
@@ -491,20 +720,14 @@ bool PreprocessorMain::handleDirective(const Directive& directive) {
                         // Definir macro simples
                         macro_processor_->defineMacro(macro_name, macro_value);
                         
-                        std::string log_msg = "Macro definida: ";
-                        log_msg += macro_name;
-                        log_msg += " = ";
-                        log_msg += macro_value;
-                        logger_->info(log_msg);
+                        PP_LOG_INFO(logger_, "Macro definida: " + macro_name + " = " + macro_value);
                     }
                 }
                 break;
                 
             case DirectiveType::UNDEF:
                 {
-                    std::string log_msg = "Processando #undef: ";
-                    log_msg += directive.getContent();
-                    logger_->info(log_msg);
+                    PP_LOG_INFO(logger_, "Processando #undef: " + directive.getContent());
                     
                     const auto& args = directive.getArguments();
                     if (args.empty()) {
@@ -517,9 +740,7 @@ bool PreprocessorMain::handleDirective(const Directive& directive) {
                     // Verificar se a macro está definida
                     if (macro_processor_->isDefined(macro_name)) {
                         macro_processor_->undefineMacro(macro_name);
-                        std::string info_msg = "Macro removida: ";
-                        info_msg += macro_name;
-                        logger_->info(info_msg);
+                        PP_LOG_INFO(logger_, "Macro removida: " + macro_name);
                     } else {
                         std::string warn_msg = "Tentativa de remover macro não definida: ";
                         warn_msg += macro_name;
@@ -543,27 +764,27 @@ bool PreprocessorMain::handleDirective(const Directive& directive) {
                     bool result = true;
                     switch (directive.getType()) {
                         case DirectiveType::IF:
-                            logger_->info("Processando #if: " + expression);
+                            PP_LOG_INFO(logger_, "Processando #if: " + expression);
                             result = conditional_processor_->processIfDirective(expression, pos);
                             break;
                         case DirectiveType::IFDEF:
-                            logger_->info("Processando #ifdef: " + expression);
+                            PP_LOG_INFO(logger_, "Processando #ifdef: " + expression);
                             result = conditional_processor_->processIfdefDirective(expression, pos);
                             break;
                         case DirectiveType::IFNDEF:
-                            logger_->info("Processando #ifndef: " + expression);
+                            PP_LOG_INFO(logger_, "Processando #ifndef: " + expression);
                             result = conditional_processor_->processIfndefDirective(expression, pos);
                             break;
                         case DirectiveType::ELSE:
-                            logger_->info("Processando #else");
+                            PP_LOG_INFO(logger_, "Processando #else");
                             result = conditional_processor_->processElseDirective(pos);
                             break;
                         case DirectiveType::ELIF:
-                            logger_->info("Processando #elif: " + expression);
+                            PP_LOG_INFO(logger_, "Processando #elif: " + expression);
                             result = conditional_processor_->processElifDirective(expression, pos);
                             break;
                         case DirectiveType::ENDIF:
-                            logger_->info("Processando #endif");
+                            PP_LOG_INFO(logger_, "Processando #endif");
                             result = conditional_processor_->processEndifDirective(pos);
                             break;
                         default:
@@ -612,7 +833,7 @@ bool PreprocessorMain::handleDirective(const Directive& directive) {
                 break;
                 
             case DirectiveType::PRAGMA:
-                logger_->info("#pragma: " + directive.getContent());
+                PP_LOG_INFO(logger_, "#pragma: " + directive.getContent());
                 break;
                 
             case DirectiveType::LINE:
@@ -675,13 +896,14 @@ bool PreprocessorMain::handleDirective(const Directive& directive) {
 
 // Escrita na saída
 void PreprocessorMain::writeOutput(const std::string& content) {
-    expanded_code_ += content;
+    output_bytes_ += content.size();
+    output_lines_ += static_cast<size_t>(std::count(content.begin(), content.end(), '\n'));
     
-    // DEBUG: Imprimir o que está sendo enviado ao lexer
-    // Output content processed
-    if (!content.empty() && content.back() != '\n') {
-        // Add newline if needed (output disabled for cleaner preprocessor output)
+    if (output_sink_) {
+        output_sink_(content);
+        return;
     }
+    expanded_code_ += content;
 }
 
 // Obter código expandido
@@ -689,6 +911,273 @@ std::string PreprocessorMain::getExpandedCode() const {
     return expanded_code_;
 }
 
+std::string PreprocessorMain::takeExpandedCode() {
+    std::string result = std::move(expanded_code_);
+    expanded_code_.clear();
+    return result;
+}
+
+void PreprocessorMain::setOutputSink(OutputSink sink) {
+    output_sink_ = std::move(sink);
+}
+
+size_t PreprocessorMain::getOutputSize() const {
+    return output_bytes_;
+}
+
+const LineMap& PreprocessorMain::getLineMap() const {
+    return line_map_;
+}
+
+void PreprocessorMain::setLogLevel(LogLevel level) {
+    logger_->setLogLevel(level);
+}
+
+// Instrumentação por macro
+void PreprocessorMain::setMacroProfilingEnabled(bool enabled) {
+    if (macro_processor_) {
+        macro_processor_->setProfilingEnabled(enabled);
+    }
+}
+
+std::string PreprocessorMain::getMacroReport() const {
+    return macro_processor_ ? macro_processor_->generateMacroReport() : std::string();
+}
+
+bool PreprocessorMain::exportMacroProfile(const std::string& path) const {
+    if (!macro_processor_ || !macro_processor_->isProfilingEnabled()) {
+        logger_->warning("Instrumentação de macros desativada; nada a exportar");
+        return false;
+    }
+    if (!BinaryFormat::writeFileAtomically(path, macro_processor_->exportProfileJson())) {
+        logger_->error("Falha ao gravar o perfil de macros: " + path);
+        return false;
+    }
+    PP_LOG_INFO(logger_, "Perfil de macros gravado: " + path);
+    return true;
+}
+
+// Snapshots do estado de macros
+bool PreprocessorMain::saveSnapshot(const std::string& path) const {
+    if (!initialized_ || !macro_processor_) {
+        logger_->error("Preprocessor não foi inicializado");
+        return false;
+    }
+    
+    if (conditional_processor_ && conditional_processor_->hasOpenConditionals()) {
+        logger_->error("Snapshot recusado: diretivas condicionais abertas ao fim do prelúdio");
+        return false;
+    }
+    
+    std::string payload;
+    BinaryFormat::putU32(payload, config_ ? static_cast<uint32_t>(config_->getVersion()) : 0);
+    
+    std::vector<MacroInfo> macros = macro_processor_->exportUserMacros();
+    BinaryFormat::putU32(payload, static_cast<uint32_t>(macros.size()));
+    for (const auto& info : macros) {
+        BinaryFormat::putMacro(payload, info);
+    }
+    
+    // Arquivos do prelúdio (e de snapshots anteriores) contam como já processados
+    std::vector<std::string> files = state_ ? state_->getProcessedFiles() : std::vector<std::string>();
+    for (const auto& file : snapshot_files_) {
+        if (std::find(files.begin(), files.end(), file) == files.end()) {
+            files.push_back(file);
+        }
+    }
+    BinaryFormat::putU32(payload, static_cast<uint32_t>(files.size()));
+    for (const auto& file : files) {
+        BinaryFormat::putString(payload, file);
+    }
+    
+    const std::string data = BinaryFormat::seal(SNAPSHOT_MAGIC, SNAPSHOT_FORMAT_VERSION, payload);
+    if (!BinaryFormat::writeFileAtomically(path, data)) {
+        logger_->error("Falha ao gravar o snapshot: " + path);
+        return false;
+    }
+    
+    PP_LOG_INFO(logger_, "Snapshot salvo: " + path + " (" + std::to_string(macros.size()) + " macros, " +
+                  std::to_string(files.size()) + " arquivos, " + std::to_string(data.size()) + " bytes)");
+    return true;
+}
+
+bool PreprocessorMain::loadSnapshot(const std::string& path) {
+    if (!initialized_ || !macro_processor_) {
+        logger_->error("Preprocessor não foi inicializado");
+        return false;
+    }
+    
+    const FileView data = FileView::open(path);
+    if (!data.valid()) {
+        logger_->warning("Snapshot não encontrado: " + path);
+        return false;
+    }
+    
+    const char* payload = nullptr;
+    size_t payload_size = 0;
+    switch (BinaryFormat::unseal(data.data(), data.size(), SNAPSHOT_MAGIC, SNAPSHOT_FORMAT_VERSION,
+                                 payload, payload_size)) {
+        case BinaryFormat::EnvelopeStatus::OK:
+            break;
+        case BinaryFormat::EnvelopeStatus::BAD_MAGIC:
+            logger_->error("Arquivo não é um snapshot válido: " + path);
+            return false;
+        case BinaryFormat::EnvelopeStatus::BAD_VERSION:
+            logger_->warning("Versão de formato do snapshot incompatível: " + path);
+            return false;
+        case BinaryFormat::EnvelopeStatus::BAD_CHECKSUM:
+            logger_->error("Snapshot corrompido (checksum): " + path);
+            return false;
+    }
+    
+    BinaryFormat::Reader reader(payload, payload_size);
+    uint32_t version = reader.u32();
+    if (config_ && version != static_cast<uint32_t>(config_->getVersion())) {
+        logger_->warning("Snapshot gerado para outra versão do C: " + path);
+        return false;
+    }
+    
+    // A contagem é validada contra o tamanho do payload antes de reservar
+    uint32_t macro_count = reader.u32();
+    if (macro_count > payload_size) {
+        logger_->error("Snapshot corrompido (contagem de macros): " + path);
+        return false;
+    }
+    std::vector<MacroInfo> macros(macro_count);
+    for (auto& info : macros) {
+        if (!BinaryFormat::readMacro(reader, info)) {
+            logger_->error("Snapshot corrompido (macro): " + path);
+            return false;
+        }
+    }
+    
+    std::vector<std::string> files;
+    uint32_t file_count = reader.u32();
+    for (uint32_t i = 0; i < file_count && reader.good(); ++i) {
+        files.push_back(reader.str());
+    }
+    
+    if (!reader.good() || !reader.atEnd()) {
+        logger_->error("Snapshot corrompido (estrutura): " + path);
+        return false;
+    }
+    
+    size_t restored = macro_processor_->importMacros(std::move(macros));
+    snapshot_files_ = std::move(files);
+    if (state_) {
+        for (const auto& file : snapshot_files_) {
+            state_->addProcessedFile(file);
+        }
+    }
+    
+    PP_LOG_INFO(logger_, "Snapshot carregado: " + path + " (" + std::to_string(restored) + " macros, " +
+                  std::to_string(snapshot_files_.size()) + " arquivos)");
+    return true;
+}
+
+// Cache de saída
+void PreprocessorMain::setOutputCacheDirectory(const std::string& directory) {
+    if (directory.empty()) {
+        output_cache_.reset();
+        PP_LOG_INFO(logger_, "Cache de saída desabilitado");
+        return;
+    }
+    output_cache_ = std::make_unique<OutputCache>(directory, logger_.get(), file_manager_.get());
+    if (output_cache_->isUsable()) {
+        PP_LOG_INFO(logger_, "Cache de saída habilitado: " + output_cache_->getDirectory());
+    }
+}
+
+OutputCacheStats PreprocessorMain::getOutputCacheStatistics() const {
+    return output_cache_ ? output_cache_->getStatistics() : OutputCacheStats();
+}
+
+bool PreprocessorMain::computeOutputCacheKey(const std::string& filename, uint64_t& key) const {
+    // A mesma visão é reaproveitada por processFile em caso de falha no cache
+    FileView content = file_manager_->openFileView(filename);
+    if (!content.valid()) {
+        return false;
+    }
+    
+    // Macros dependentes do relógio tornam o resultado irreproduzível
+    for (const char* clock_macro : {"__DATE__", "__TIME__", "__TIMESTAMP__"}) {
+        if (content.view().find(clock_macro) != std::string_view::npos) {
+            return false;
+        }
+    }
+    
+    std::string material;
+    BinaryFormat::putString(material, filename);
+    BinaryFormat::putU64(material, BinaryFormat::checksum(content.data(), content.size()));
+    BinaryFormat::putU32(material, config_ ? static_cast<uint32_t>(config_->getVersion()) : 0);
+    
+    // Tabelas sem ordem definida são ordenadas para que a chave seja estável
+    if (config_) {
+        std::vector<std::pair<std::string, std::string>> predefined(
+            config_->getPredefinedMacros().begin(), config_->getPredefinedMacros().end());
+        std::sort(predefined.begin(), predefined.end());
+        BinaryFormat::putU32(material, static_cast<uint32_t>(predefined.size()));
+        for (const auto& entry : predefined) {
+            BinaryFormat::putString(material, entry.first);
+            BinaryFormat::putString(material, entry.second);
+        }
+    }
+    
+    std::vector<MacroInfo> user_macros = macro_processor_->exportUserMacros();
+    std::sort(user_macros.begin(), user_macros.end(),
+              [](const MacroInfo& a, const MacroInfo& b) { return a.name < b.name; });
+    BinaryFormat::putU32(material, static_cast<uint32_t>(user_macros.size()));
+    for (const auto& info : user_macros) {
+        BinaryFormat::putMacro(material, info);
+    }
+    
+    const std::vector<std::string> search_paths = file_manager_->getSearchPaths();
+    BinaryFormat::putU32(material, static_cast<uint32_t>(search_paths.size()));
+    for (const auto& path : search_paths) {
+        BinaryFormat::putString(material, path);
+    }
+    
+    BinaryFormat::putU32(material, static_cast<uint32_t>(snapshot_files_.size()));
+    for (const auto& prelude_file : snapshot_files_) {
+        BinaryFormat::putString(material, prelude_file);
+    }
+    
+    key = BinaryFormat::checksum(material.data(), material.size());
+    return true;
+}
+
+void PreprocessorMain::restoreCachedOutput(CachedOutput& cached) {
+    output_bytes_ = cached.expandedCode.size();
+    output_lines_ = cached.outputLines;
+    
+    if (output_sink_) {
+        // O sink recebe linhas completas, como no processamento normal
+        std::string_view code(cached.expandedCode);
+        size_t start = 0;
+        while (start < code.size()) {
+            size_t end = code.find('\n', start);
+            end = (end == std::string_view::npos) ? code.size() : end + 1;
+            output_sink_(code.substr(start, end - start));
+            start = end;
+        }
+    } else {
+        expanded_code_ = std::move(cached.expandedCode);
+    }
+    
+    line_map_ = std::move(cached.lineMap);
+    for (const auto& dependency : cached.dependencies) {
+        dependencies_.push_back(dependency.path);
+        if (state_) {
+            state_->addProcessedFile(dependency.path);
+        }
+    }
+    macro_processor_->importMacros(std::move(cached.macros));
+}
+
+FileView PreprocessorMain::openFileView(const std::string& filename) {
+    return file_manager_ ? file_manager_->openFileView(filename) : FileView::open(filename);
+}
+
 // Obter dependências
 std::vector<std::string> PreprocessorMain::getDependencies() const {
     return dependencies_;
@@ -696,9 +1185,13 @@ std::vector<std::string> PreprocessorMain::getDependencies() const {
 
 // Reset do preprocessor
 void PreprocessorMain::reset() {
+    snapshot_files_.clear();
     expanded_code_.clear();
+    output_bytes_ = 0;
+    output_lines_ = 0;
     dependencies_.clear();
-    position_mappings_.clear();
+    line_map_.clear();
+    consistency_stats_ = ConsistencyCheckStats();
     current_file_.clear();
     current_line_ = 0;
     processing_active_ = false;
@@ -712,14 +1205,14 @@ void PreprocessorMain::reset() {
         state_->reset();
     }
     
-    logger_->info("Preprocessor resetado");
+    PP_LOG_INFO(logger_, "Preprocessor resetado");
 }
 
 // Configuração de caminhos de busca
 void PreprocessorMain::setSearchPaths(const std::vector<std::string>& paths) {
     if (file_manager_) {
         file_manager_->setSearchPaths(paths);
-        logger_->info("Caminhos de busca atualizados");
+        PP_LOG_INFO(logger_, "Caminhos de busca atualizados");
     }
 }
 
@@ -727,7 +1220,7 @@ void PreprocessorMain::setSearchPaths(const std::vector<std::string>& paths) {
 void PreprocessorMain::addIncludePath(const std::string& path) {
     if (file_manager_) {
         file_manager_->addSearchPath(path);
-        logger_->info("Caminho de busca adicionado: " + path);
+        PP_LOG_INFO(logger_, "Caminho de busca adicionado: " + path);
     }
 }
 
@@ -736,7 +1229,7 @@ void PreprocessorMain::defineMacro(const std::string& name, const std::string& v
     if (macro_processor_) {
         PreprocessorPosition pos("<command-line>", 0, 0);
         macro_processor_->defineMacro(name, value, pos);
-        logger_->info("Macro definida: " + name + " = " + value);
+        PP_LOG_INFO(logger_, "Macro definida: " + name + " = " + value);
     }
 }
 
@@ -744,7 +1237,7 @@ void PreprocessorMain::defineMacro(const std::string& name, const std::string& v
 void PreprocessorMain::undefineMacro(const std::string& name) {
     if (macro_processor_) {
         macro_processor_->undefineMacro(name);
-        logger_->info("Macro removida: " + name);
+        PP_LOG_INFO(logger_, "Macro removida: " + name);
     }
 }
 
@@ -776,7 +1269,14 @@ void PreprocessorMain::setVersion(CVersion version) {
         if (macro_processor_) {
             macro_processor_->initializePredefinedMacros();
         }
-        logger_->info("Versão do C configurada");
+        PP_LOG_INFO(logger_, "Versão do C configurada");
+    }
+}
+
+void PreprocessorMain::setProcessingProfile(ProcessingProfile profile) {
+    if (config_) {
+        config_->setProcessingProfile(profile);
+        PP_LOG_INFO(logger_, "Perfil de desempenho configurado: " + processingProfileToString(profile));
     }
 }
 
@@ -829,14 +1329,14 @@ PreprocessorState PreprocessorMain::getStatistics() const {
              
              // Log de estatísticas de macros
              if (defined_macros > 0) {
-                 logger_->info("Macros definidas encontradas: " + std::to_string(defined_macros));
+                 PP_LOG_INFO(logger_, "Macros definidas encontradas: " + std::to_string(defined_macros));
              }
          }
          
          // Estatísticas de condicionais
          if (state_->isInConditionalBlock()) {
              // Atualizar estatísticas de blocos condicionais ativos
-             logger_->info("Bloco condicional ativo detectado");
+             PP_LOG_INFO(logger_, "Bloco condicional ativo detectado");
          }
         
         // Estatísticas de tamanho
@@ -862,61 +1362,16 @@ void PreprocessorMain::updatePositionMapping(const PreprocessorPosition& origina
         return;
     }
     
-    if (original.line == 0 || expanded.line == 0) {
+    if (original.line <= 0 || expanded.line <= 0) {
         logger_->warning("Tentativa de mapear posições com números de linha inválidos");
         return;
     }
     
-    // 2. Verificar se já existe mapeamento similar (evitar duplicatas)
-    for (const auto& mapping : position_mappings_) {
-        if (mapping.first.filename == original.filename &&
-            mapping.first.line == original.line &&
-            mapping.first.column == original.column &&
-            mapping.second.filename == expanded.filename &&
-            mapping.second.line == expanded.line &&
-            mapping.second.column == expanded.column) {
-            // Mapeamento já existe, não adicionar duplicata
-            return;
-        }
-    }
-    
-    // 3. Criar cópia das posições com informações adicionais
-    PreprocessorPosition enhanced_original = original;
-    PreprocessorPosition enhanced_expanded = expanded;
-    
-    // Adicionar informações de contexto se disponível
-    if (state_) {
-        FileContext current_context = state_->getFileContext();
-        enhanced_original.original_file = current_context.filename;
-        enhanced_expanded.original_file = current_context.filename;
-        
-        // Adicionar offset absoluto se disponível
-        enhanced_original.offset = current_context.absolute_position;
-        enhanced_expanded.offset = current_context.absolute_position;
-    }
-    
-    // 4. Adicionar informações de processamento
-    if (conditional_processor_ && conditional_processor_->hasOpenConditionals()) {
-        // Marcar que esta posição está dentro de um bloco condicional
-        enhanced_original.expanded_line = conditional_processor_->getCurrentNestingLevel();
-        enhanced_expanded.expanded_line = conditional_processor_->getCurrentNestingLevel();
-    }
-    
-    // 5. Adicionar o mapeamento
-    position_mappings_.emplace_back(enhanced_original, enhanced_expanded);
-    
-    // 6. Otimização: limitar o tamanho do vetor de mapeamentos
-    const size_t MAX_MAPPINGS = 10000;
-    if (position_mappings_.size() > MAX_MAPPINGS) {
-        // Remover os mapeamentos mais antigos
-        position_mappings_.erase(position_mappings_.begin(), 
-                               position_mappings_.begin() + (position_mappings_.size() - MAX_MAPPINGS));
-        logger_->debug("Cache de mapeamento de posições otimizado");
-    }
-    
-    logger_->debug("Mapeamento de posição adicionado: [" + original.filename + ":" + 
-                  std::to_string(original.line) + "] -> [" + expanded.filename + ":" + 
-                  std::to_string(expanded.line) + "]");
+    // 2. Registrar na tabela de linhas; linhas repetidas ou fora de ordem
+    //    são descartadas e linhas contíguas estendem a sequência atual
+    line_map_.append(static_cast<uint32_t>(expanded.line),
+                     static_cast<uint32_t>(original.line),
+                     original.filename);
 }
 
 // Tratamento de erros integrado e robusto
@@ -961,7 +1416,8 @@ void PreprocessorMain::reportError(const std::string& error_msg, const Preproces
     logger_->error(detailed_error, pos);
     
     // Atualizar mapeamento de posições para rastreamento de erros
-    updatePositionMapping(pos, pos);
+    PreprocessorPosition expanded_pos(current_file_, static_cast<int>(output_lines_ + 1), pos.column);
+    updatePositionMapping(pos, expanded_pos);
 }
 
 void PreprocessorMain::attemptErrorRecovery(const std::string& error_msg, const PreprocessorPosition& pos) {
@@ -969,7 +1425,7 @@ void PreprocessorMain::attemptErrorRecovery(const std::string& error_msg, const
     
     // 1. Recuperação de erros de diretiva
     if (error_msg.find("Diretiva") != std::string::npos) {
-        logger_->info("Tentando recuperação de erro de diretiva...");
+        PP_LOG_INFO(logger_, "Tentando recuperação de erro de diretiva...");
         
         // Verificar se há condicionais abertas e tentar fechar
         if (conditional_processor_ && conditional_processor_->hasOpenConditionals()) {
@@ -980,18 +1436,18 @@ void PreprocessorMain::attemptErrorRecovery(const std::string& error_msg, const
     
     // 2. Recuperação de erros de macro
     if (error_msg.find("macro") != std::string::npos || error_msg.find("Macro") != std::string::npos) {
-        logger_->info("Tentando recuperação de erro de macro...");
+        PP_LOG_INFO(logger_, "Tentando recuperação de erro de macro...");
         
         // Limpar estado de expansão de macro se necessário
         if (state_ && state_->getProcessingMode() == ProcessingMode::MACRO_EXPANSION) {
             state_->setProcessingMode(ProcessingMode::NORMAL);
-            logger_->info("Estado de expansão de macro resetado");
+            PP_LOG_INFO(logger_, "Estado de expansão de macro resetado");
         }
     }
     
     // 3. Recuperação de erros de arquivo
     if (error_msg.find("arquivo") != std::string::npos || error_msg.find("include") != std::string::npos) {
-        logger_->info("Tentando recuperação de erro de arquivo...");
+        PP_LOG_INFO(logger_, "Tentando recuperação de erro de arquivo...");
         
         // Verificar se há contextos de arquivo empilhados
         if (state_ && state_->getDepth() > 1) {
@@ -1004,18 +1460,20 @@ void PreprocessorMain::attemptErrorRecovery(const std::string& error_msg, const
         // Se não estamos em estado crítico, tentar continuar
         ProcessingState current_state = state_->getCurrentState();
         if (current_state != ProcessingState::ERROR_STATE) {
-            logger_->info("Tentando continuar processamento após erro não crítico");
+            PP_LOG_INFO(logger_, "Tentando continuar processamento após erro não crítico");
         }
     }
     
-    logger_->info("Recuperação de erro concluída");
+    PP_LOG_INFO(logger_, "Recuperação de erro concluída");
 }
 
 // Limpeza
 void PreprocessorMain::cleanup() {
     expanded_code_.clear();
+    output_bytes_ = 0;
+    output_lines_ = 0;
     dependencies_.clear();
-    position_mappings_.clear();
+    line_map_.clear();
     
     // Reset dos componentes
     if (macro_processor_) {
@@ -1104,50 +1562,33 @@ bool PreprocessorMain::validateOutput(const std::string& output) {
         return true; // Saída vazia é válida
     }
     
-    // Verificar se há diretivas não processadas
-    size_t pos = 0;
-    while ((pos = output.find('#', pos)) != std::string::npos) {
-        // Verificar se é início de linha ou precedido por espaços
-        bool is_directive = true;
-        if (pos > 0) {
-            // Verificar se há apenas espaços antes do #
-            for (size_t i = pos - 1; i >= 0; --i) {
-                if (output[i] == '\n') {
-                    break;
-                }
-                if (output[i] != ' ' && output[i] != '\t') {
-                    is_directive = false;
-                    break;
-                }
-                if (i == 0) break;
-            }
+    // Verificar se há diretivas não processadas: '#' precedido apenas de espaços na linha
+    size_t line_start = 0;
+    while (line_start < output.length()) {
+        size_t line_end = output.find('\n', line_start);
+        if (line_end == std::string::npos) {
+            line_end = output.length();
         }
         
-        if (is_directive) {
-            // Extrair a possível diretiva
-            size_t end_pos = output.find('\n', pos);
-            if (end_pos == std::string::npos) {
-                end_pos = output.length();
-            }
-            
-            std::string potential_directive = output.substr(pos, end_pos - pos);
+        size_t pos = line_start;
+        while (pos < line_end && (output[pos] == ' ' || output[pos] == '\t')) {
+            pos++;
+        }
+        
+        if (pos < line_end && output[pos] == '#') {
+            std::string_view potential_directive(output.data() + pos, line_end - pos);
             
             // Verificar se é uma diretiva conhecida não processada
-            if (potential_directive.find("#define") == 0 ||
-                potential_directive.find("#include") == 0 ||
-                potential_directive.find("#ifdef") == 0 ||
-                potential_directive.find("#ifndef") == 0 ||
-                potential_directive.find("#if") == 0 ||
-                potential_directive.find("#else") == 0 ||
-                potential_directive.find("#elif") == 0 ||
-                potential_directive.find("#endif") == 0 ||
-                potential_directive.find("#undef") == 0) {
-                
-                logger_->warning("Diretiva não processada encontrada na saída: " + potential_directive);
+            for (const char* prefix : {"#define", "#include", "#if", "#else", "#elif", "#endif", "#undef"}) {
+                if (potential_directive.compare(0, std::strlen(prefix), prefix) == 0) {
+                    logger_->warning("Diretiva não processada encontrada na saída: " +
+                                     std::string(potential_directive));
+                    break;
+                }
             }
         }
         
-        pos++;
+        line_start = line_end + 1;
     }
     
     // Verificar se há macros não expandidas (identificadores que começam com maiúscula)
@@ -1306,24 +1747,24 @@ void PreprocessorMain::optimizeProcessing() {
         return;
     }
     
-    logger_->info("Aplicando otimizações de processamento...");
+    PP_LOG_INFO(logger_, "Aplicando otimizações de processamento...");
     
     // Otimização 1: Pré-alocação de buffers
     if (expanded_code_.capacity() < 8192) {
         expanded_code_.reserve(8192); // Reservar 8KB iniciais
-        logger_->info("Buffer de saída otimizado (8KB reservados)");
+        PP_LOG_INFO(logger_, "Buffer de saída otimizado (8KB reservados)");
     }
     
     // Otimização 2: Otimização de containers de dependências
     if (dependencies_.capacity() < 32) {
         dependencies_.reserve(32); // Reservar espaço para 32 dependências
-        logger_->info("Buffer de dependências otimizado");
+        PP_LOG_INFO(logger_, "Buffer de dependências otimizado");
     }
     
     // Otimização 3: Pré-alocação de estruturas de mapeamento
-    if (position_mappings_.capacity() < 256) {
-        position_mappings_.reserve(256);
-        logger_->info("Mapeamento de posições otimizado");
+    if (line_map_.empty()) {
+        line_map_.reserve(256);
+        PP_LOG_INFO(logger_, "Mapeamento de posições otimizado");
     }
     
     // Otimização 4: Verificação de componentes para otimização futura
@@ -1354,11 +1795,11 @@ void PreprocessorMain::optimizeProcessing() {
     // Otimização 6: Limpeza preventiva de recursos
     if (expanded_code_.size() > 1024 * 1024) { // Se maior que 1MB
         expanded_code_.shrink_to_fit();
-        logger_->info("Memória do buffer de saída otimizada");
+        PP_LOG_INFO(logger_, "Memória do buffer de saída otimizada");
     }
     
-    logger_->info("Otimizações aplicadas em " + std::to_string(optimized_components) + " componentes");
-    logger_->info("Sistema de processamento otimizado com sucesso");
+    PP_LOG_INFO(logger_, "Otimizações aplicadas em " + std::to_string(optimized_components) + " componentes");
+    PP_LOG_INFO(logger_, "Sistema de processamento otimizado com sucesso");
 }
 
 void PreprocessorMain::enableOptimizations() {
@@ -1385,10 +1826,10 @@ bool PreprocessorMain::synchronizeProcessors() {
         if (file_manager_ && state_) {
             // Sincronizar gerenciador de arquivos
             auto search_paths = file_manager_->getSearchPaths();
-            logger_->debug("Sincronizados " + std::to_string(search_paths.size()) + " caminhos de busca");
+            PP_LOG_DEBUG(logger_, "Sincronizados " + std::to_string(search_paths.size()) + " caminhos de busca");
         }
         
-        logger_->debug("Sincronização de processadores concluída");
+        PP_LOG_DEBUG(logger_, "Sincronização de processadores concluída");
         return true;
         
     } catch (const std::exception& e) {
@@ -1400,7 +1841,7 @@ bool PreprocessorMain::synchronizeProcessors() {
 bool PreprocessorMain::performIntegrityCheck() {
     try {
         // Verificar integridade do código expandido
-        if (expanded_code_.empty()) {
+        if (output_bytes_ == 0) {
             logger_->warning("Código expandido está vazio");
             return true; // Não é necessariamente um erro
         }
@@ -1416,9 +1857,9 @@ bool PreprocessorMain::performIntegrityCheck() {
         }
         
         // Verificar consistência de mapeamentos de posição
-        size_t mapping_count = position_mappings_.size();
+        size_t mapping_count = line_map_.runCount();
         if (mapping_count > 0) {
-            logger_->debug("Verificados " + std::to_string(mapping_count) + " mapeamentos de posição");
+            PP_LOG_DEBUG(logger_, "Verificados " + std::to_string(mapping_count) + " mapeamentos de posição");
         }
         
         // Verificar estado final
@@ -1430,7 +1871,7 @@ bool PreprocessorMain::performIntegrityCheck() {
             }
         }
         
-        logger_->debug("Verificação de integridade concluída com sucesso");
+        PP_LOG_DEBUG(logger_, "Verificação de integridade concluída com sucesso");
         return true;
         
     } catch (const std::exception& e) {
@@ -1459,7 +1900,7 @@ std::string PreprocessorMain::generateProcessingReport() {
         }
         
         report += "Dependências: " + std::to_string(dependencies_.size()) + ", ";
-        report += "Mapeamentos: " + std::to_string(position_mappings_.size());
+        report += "Mapeamentos: " + std::to_string(line_map_.runCount());
         
         if (report.empty()) {
             report = "Nenhuma estatística disponível";
@@ -1474,162 +1915,99 @@ std::string PreprocessorMain::generateProcessingReport() {
 
 // Método auxiliar para parsear diretivas
 Directive PreprocessorMain::parseDirective(const std::string& line, const PreprocessorPosition& pos) {
-    // Encontrar a posição do '#' (pode estar indentado)
-    size_t hash_pos = line.find('#');
-    if (hash_pos == std::string::npos) {
+    // Reconhecer '#', nome e argumentos como visões sobre a linha
+    DirectiveScan scan;
+    if (!scanDirective(line, scan)) {
         return Directive(DirectiveType::UNKNOWN, line, pos);
     }
     
-    // Extrair nome da diretiva
-    size_t start = hash_pos + 1; // Pular o #
-    while (start < line.length() && std::isspace(line[start])) {
-        start++;
-    }
-    
-    if (start >= line.length()) {
-        return Directive(DirectiveType::UNKNOWN, line, pos);
-    }
-    
-    size_t end = start;
-    while (end < line.length() && 
-           (std::isalnum(line[end]) || line[end] == '_')) {
-        end++;
-    }
-    
-    if (end == start) {
-        return Directive(DirectiveType::UNKNOWN, line, pos);
-    }
-    
-    std::string directive_name = line.substr(start, end - start);
-    DirectiveType type = stringToDirectiveType(directive_name);
+    DirectiveType type = scan.type;
     
     // Criar diretiva
     Directive directive(type, line, pos);
     
-    // Extrair argumentos
+    // Extrair argumentos; só aqui o texto é copiado para a diretiva
     std::vector<std::string> arguments;
-    if (end < line.length()) {
-        // Pular espaços após o nome da diretiva
-        while (end < line.length() && std::isspace(line[end])) {
-            end++;
-        }
-        
-        if (end < line.length()) {
-            std::string args_str = line.substr(end);
-            
-            // Parsear argumentos baseado no tipo de diretiva
-            switch (type) {
-                case DirectiveType::INCLUDE:
-                    // Para #include, o argumento é o nome do arquivo
-                    arguments.push_back(args_str);
-                    break;
+    std::string_view args_str = scan.arguments;
+    
+    if (!args_str.empty()) {
+        // Parsear argumentos baseado no tipo de diretiva
+        switch (type) {
+            case DirectiveType::DEFINE:
+                // Para #define, tratar de forma especial para preservar macros funcionais
+                {
+                    // Verificar se é uma macro funcional (tem parênteses)
+                    size_t paren_pos = args_str.find('(');
+                    size_t space_pos = args_str.find_first_of(" \t");
+                    size_t name_end = std::string_view::npos;
                     
-                case DirectiveType::DEFINE:
-                    // Para #define, tratar de forma especial para preservar macros funcionais
-                    {
-                        // Verificar se é uma macro funcional (tem parênteses)
-                        size_t paren_pos = args_str.find('(');
-                        size_t space_pos = args_str.find_first_of(" \t");
-                        
-                        if (paren_pos != std::string::npos && 
-                            (space_pos == std::string::npos || paren_pos < space_pos)) {
-                            // É uma macro funcional - encontrar o ')' correspondente
-                            size_t close_paren = args_str.find(')', paren_pos);
-                            if (close_paren != std::string::npos) {
-                                // Macro funcional completa: nome + parâmetros
-                                std::string macro_name = args_str.substr(0, close_paren + 1);
-                                arguments.push_back(macro_name);
-                                
-                                // Pular espaços após os parênteses
-                                size_t value_start = close_paren + 1;
-                                while (value_start < args_str.length() && 
-                                       (args_str[value_start] == ' ' || args_str[value_start] == '\t')) {
-                                    value_start++;
-                                }
-                                
-                                if (value_start < args_str.length()) {
-                                    std::string macro_value = args_str.substr(value_start);
-                                    arguments.push_back(macro_value);
-                                }
-                            } else {
-                                // Parênteses não fechados - tratar como macro simples
-                                arguments.push_back(args_str);
-                            }
-                        } else if (space_pos != std::string::npos) {
-                            // Macro simples com valor
-                            std::string macro_name = args_str.substr(0, space_pos);
-                            arguments.push_back(macro_name);
-                            
-                            // Pular espaços/tabs
-                            size_t value_start = space_pos;
-                            while (value_start < args_str.length() && 
-                                   (args_str[value_start] == ' ' || args_str[value_start] == '\t')) {
-                                value_start++;
-                            }
-                            
-                            if (value_start < args_str.length()) {
-                                std::string macro_value = args_str.substr(value_start);
-                                arguments.push_back(macro_value);
-                            }
-                        } else {
-                            // Apenas o nome da macro (sem valor)
-                            arguments.push_back(args_str);
+                    if (paren_pos != std::string_view::npos && 
+                        (space_pos == std::string_view::npos || paren_pos < space_pos)) {
+                        // É uma macro funcional - encontrar o ')' correspondente
+                        size_t close_paren = args_str.find(')', paren_pos);
+                        if (close_paren != std::string_view::npos) {
+                            // Macro funcional completa: nome + parâmetros
+                            name_end = close_paren + 1;
                         }
+                    } else if (space_pos != std::string_view::npos) {
+                        // Macro simples com valor
+                        name_end = space_pos;
                     }
-                    break;
                     
-                case DirectiveType::UNDEF:
-                case DirectiveType::IFDEF:
-                case DirectiveType::IFNDEF:
-                    // Para estas diretivas, separar por espaços
-                    {
-                        std::istringstream iss(args_str);
-                        std::string arg;
-                        while (iss >> arg) {
-                            arguments.push_back(arg);
-                        }
+                    if (name_end == std::string_view::npos) {
+                        // Apenas o nome da macro (sem valor) ou parênteses não fechados
+                        arguments.emplace_back(args_str);
+                        break;
                     }
-                    break;
                     
-                case DirectiveType::IF:
-                case DirectiveType::ELIF:
-                    // Para expressões condicionais, manter como string única
-                    arguments.push_back(args_str);
-                    break;
+                    arguments.reserve(2);
+                    arguments.emplace_back(args_str.substr(0, name_end));
                     
-                case DirectiveType::ERROR:
-                case DirectiveType::WARNING:
-                case DirectiveType::PRAGMA:
-                case DirectiveType::LINE:
-                    // Para estas diretivas, manter argumentos como string única
-                    arguments.push_back(args_str);
-                    break;
+                    // Pular espaços/tabs
+                    size_t value_start = name_end;
+                    while (value_start < args_str.length() && 
+                           (args_str[value_start] == ' ' || args_str[value_start] == '\t')) {
+                        value_start++;
+                    }
                     
-                default:
-                    // Para diretivas desconhecidas ou sem argumentos
-                    if (!args_str.empty()) {
-                        arguments.push_back(args_str);
+                    if (value_start < args_str.length()) {
+                        arguments.emplace_back(args_str.substr(value_start));
                     }
-                    break;
-            }
+                }
+                break;
+                
+            case DirectiveType::UNDEF:
+            case DirectiveType::IFDEF:
+            case DirectiveType::IFNDEF:
+                // Para estas diretivas, separar por espaços
+                forEachDirectiveWord(args_str, [&arguments](std::string_view word) {
+                    arguments.emplace_back(word);
+                });
+                break;
+                
+            default:
+                // #include mantém o nome do arquivo; condicionais mantêm a expressão
+                // completa; demais diretivas mantêm os argumentos como string única
+                arguments.emplace_back(args_str);
+                break;
         }
     }
     
-    directive.setArguments(arguments);
+    directive.setArguments(std::move(arguments));
     return directive;
 }
 
 // Métodos de coordenação avançada entre módulos
 bool PreprocessorMain::coordinateModules() {
     try {
-        logger_->debug("Iniciando coordenação entre módulos");
+        PP_LOG_DEBUG(logger_, "Iniciando coordenação entre módulos");
         
         // 1. Coordenar MacroProcessor com ConditionalProcessor
         if (macro_processor_ && conditional_processor_) {
             // Verificar se macros afetam condicionais ativas
             if (conditional_processor_->hasOpenConditionals()) {
                 auto defined_macros = macro_processor_->getDefinedMacros();
-                logger_->debug("Coordenando " + std::to_string(defined_macros.size()) + 
+                PP_LOG_DEBUG(logger_, "Coordenando " + std::to_string(defined_macros.size()) + 
                              " macros com processador condicional");
             }
         }
@@ -1656,7 +2034,7 @@ bool PreprocessorMain::coordinateModules() {
             propagateState(state_info);
         }
         
-        logger_->debug("Coordenação entre módulos concluída");
+        PP_LOG_DEBUG(logger_, "Coordenação entre módulos concluída");
         return true;
         
     } catch (const std::exception& e) {
@@ -1667,7 +2045,7 @@ bool PreprocessorMain::coordinateModules() {
 
 void PreprocessorMain::propagateState(const std::string& state_info) {
     try {
-        logger_->debug("Propagando estado: " + state_info);
+        PP_LOG_DEBUG(logger_, "Propagando estado: " + state_info);
         
         // Propagar para todos os componentes que precisam de sincronização
         if (state_info.find("macro:") == 0) {
@@ -1702,7 +2080,7 @@ void PreprocessorMain::propagateState(const std::string& state_info) {
 
 bool PreprocessorMain::validateModuleConsistency() {
     try {
-        logger_->debug("Validando consistência entre módulos");
+        PP_LOG_DEBUG(logger_, "Validando consistência entre módulos");
         
         // 1. Verificar consistência entre MacroProcessor e State
         if (macro_processor_ && state_) {
@@ -1712,7 +2090,7 @@ bool PreprocessorMain::validateModuleConsistency() {
             // Verificar se há macros órfãs (sem arquivo de origem)
             for (const auto& macro : defined_macros) {
                 if (macro.find("__") == 0) continue; // Pular macros predefinidas
-                logger_->debug("Validando macro: " + macro);
+                PP_LOG_DEBUG(logger_, "Validando macro: " + macro);
             }
         }
         
@@ -1729,15 +2107,15 @@ bool PreprocessorMain::validateModuleConsistency() {
             auto current_context = state_->getFileContext();
             if (!current_context.filename.empty()) {
                 // Verificar se o arquivo atual existe no contexto do FileManager
-                logger_->debug("Validando contexto de arquivo: " + current_context.filename);
+                PP_LOG_DEBUG(logger_, "Validando contexto de arquivo: " + current_context.filename);
             }
         }
         
         // 4. Verificar integridade dos mapeamentos de posição
-        if (!position_mappings_.empty()) {
+        if (!line_map_.empty()) {
             size_t invalid_mappings = 0;
-            for (const auto& mapping : position_mappings_) {
-                if (mapping.first.filename.empty() || mapping.second.filename.empty()) {
+            for (const auto& run : line_map_.runs()) {
+                if (run.fileIndex >= line_map_.fileCount() || line_map_.fileName(run.fileIndex).empty()) {
                     invalid_mappings++;
                 }
             }
@@ -1747,7 +2125,7 @@ bool PreprocessorMain::validateModuleConsistency() {
             }
         }
         
-        logger_->debug("Validação de consistência concluída");
+        PP_LOG_DEBUG(logger_, "Validação de consistência concluída");
         return true;
         
     } catch (const std::exception& e) {
@@ -1759,7 +2137,7 @@ bool PreprocessorMain::validateModuleConsistency() {
 void PreprocessorMain::notifyStateChange(const std::string& component, const std::string& event) {
     try {
         std::string notification = component + ":" + event;
-        logger_->debug("Notificação de mudança de estado: " + notification);
+        PP_LOG_DEBUG(logger_, "Notificação de mudança de estado: " + notification);
         
         // Processar notificações específicas
         if (component == "MacroProcessor" && event == "macro_defined") {
@@ -1790,8 +2168,8 @@ void PreprocessorMain::notifyStateChange(const std::string& component, const std
         }
         
         if (component == "AllComponents" && event == "global_state_changed") {
-            // Evitar recursão infinita
-            static bool coordinating = false;
+            // Evitar recursão infinita (por thread: instâncias podem rodar em paralelo)
+            thread_local bool coordinating = false;
             if (!coordinating) {
                 coordinating = true;
                 coordinateModules();
@@ -1989,7 +2367,7 @@ bool PreprocessorMain::checkProcessorConsistency() {
 void PreprocessorMain::resolveProcessorConflicts() {
     try {
         if (logger_) {
-            logger_->info("Resolvendo conflitos entre processadores...");
+            PP_LOG_INFO(logger_, "Resolvendo conflitos entre processadores...");
         }
         
         // Resolver conflitos entre MacroProcessor e ConditionalProcessor
@@ -2034,7 +2412,7 @@ void PreprocessorMain::resolveProcessorConflicts() {
         }
         
         if (logger_) {
-            logger_->info("Conflitos resolvidos com sucesso");
+            PP_LOG_INFO(logger_, "Conflitos resolvidos com sucesso");
         }
         
     } catch (const std::exception& e) {
@@ -33,6 +33,7 @@ void PreprocessorConfig::initializeDefaultConfig() {
     enable_warnings_ = true;
     strict_mode_ = false;
     preserve_comments_ = false;
+    processing_profile_ = ProcessingProfile::CHECKED;
     
     // Configurar limites padrão
     max_macro_expansion_size_ = 1024 * 1024; // 1MB
@@ -60,6 +61,7 @@ void PreprocessorConfig::initializeDefaultConfig() {
     config_values_["debug"] = debug_mode_ ? "true" : "false";
     config_values_["warnings"] = enable_warnings_ ? "true" : "false";
     config_values_["strict"] = strict_mode_ ? "true" : "false";
+    config_values_["profile"] = processingProfileToString(processing_profile_);
 }
 
 bool PreprocessorConfig::loadConfiguration(const std::string& filepath) {
@@ -121,6 +123,8 @@ bool PreprocessorConfig::validateConfigValue(const std::string& key, const std::
         } catch (...) {
             return false;
         }
+    } else if (key == "profile") {
+        return value == "checked" || value == "fast";
     } else if (key == "debug" || key == "warnings" || key == "strict" || key == "preserve_comments") {
         return value == "true" || value == "false";
     } else if (key == "max_macro_expansion_size" || key == "max_include_depth" || key == "max_macro_recursion_depth") {
@@ -183,6 +187,8 @@ void PreprocessorConfig::applyConfigChanges() {
             strict_mode_ = (value == "true");
         } else if (key == "preserve_comments") {
             preserve_comments_ = (value == "true");
+        } else if (key == "profile") {
+            processing_profile_ = stringToProcessingProfile(value);
         } else if (key == "max_macro_expansion_size") {
             max_macro_expansion_size_ = std::stoull(value);
         } else if (key == "max_include_depth") {
@@ -207,6 +213,7 @@ bool PreprocessorConfig::saveConfigToFile(const std::string& filepath) {
     file << "warnings=" << (enable_warnings_ ? "true" : "false") << "\n";
     file << "strict=" << (strict_mode_ ? "true" : "false") << "\n";
     file << "preserve_comments=" << (preserve_comments_ ? "true" : "false") << "\n";
+    file << "profile=" << processingProfileToString(processing_profile_) << "\n";
     file << "max_macro_expansion_size=" << max_macro_expansion_size_ << "\n";
     file << "max_include_depth=" << max_include_depth_ << "\n";
     file << "max_macro_recursion_depth=" << max_macro_recursion_depth_ << "\n";
@@ -341,7 +348,8 @@ std::string PreprocessorConfig::generateConfigReport() const {
     report << "Modo Debug: " << (debug_mode_ ? "Ativo" : "Inativo") << "\n";
     report << "Warnings: " << (enable_warnings_ ? "Habilitados" : "Desabilitados") << "\n";
     report << "Modo Estrito: " << (strict_mode_ ? "Ativo" : "Inativo") << "\n";
-    report << "Preservar Comentários: " << (preserve_comments_ ? "Sim" : "Não") << "\n\n";
+    report << "Preservar Comentários: " << (preserve_comments_ ? "Sim" : "Não") << "\n";
+    report << "Perfil de Desempenho: " << processingProfileToString(processing_profile_) << "\n\n";
     
     report << "Limites:\n";
     report << "  Tamanho máximo de expansão de macro: " << max_macro_expansion_size_ << " bytes\n";
@@ -549,6 +557,21 @@ CVersion stringToCVersion(const std::string& version_str) {
     throw std::invalid_argument("Versão do C inválida: " + version_str);
 }
 
+std::string processingProfileToString(ProcessingProfile profile) {
+    switch (profile) {
+        case ProcessingProfile::CHECKED: return "checked";
+        case ProcessingProfile::FAST: return "fast";
+        default: return "checked";
+    }
+}
+
+ProcessingProfile stringToProcessingProfile(const std::string& profile_str) {
+    if (profile_str == "checked") return ProcessingProfile::CHECKED;
+    if (profile_str == "fast") return ProcessingProfile::FAST;
+    
+    throw std::invalid_argument("Perfil de desempenho inválido: " + profile_str);
+}
+
 bool versionSupportsFeature(CVersion version, const std::string& feature) {
     PreprocessorConfig config(version);
     const VersionFeatures& features = config.getVersionFeatures();
@@ -7,35 +7,89 @@
 namespace Preprocessor {
 
 // PositionMapper Implementation
+bool PositionMapper::continuesRun(const SourceMapping& run, const SourceMapping& mapping) {
+    return mapping.processedLine > run.processedLine &&
+           mapping.originalLine >= run.originalLine &&
+           mapping.processedLine - run.processedLine == mapping.originalLine - run.originalLine &&
+           mapping.processedColumn == run.processedColumn &&
+           mapping.originalColumn == run.originalColumn &&
+           mapping.fromMacroExpansion == run.fromMacroExpansion &&
+           mapping.originalFile == run.originalFile &&
+           mapping.macroName == run.macroName;
+}
+
 void PositionMapper::addMapping(const SourceMapping& mapping) {
-    mappings.push_back(mapping);
-    lineToMappingIndex[mapping.processedLine] = mappings.size() - 1;
+    // Caminho comum: inserção em ordem crescente de linha
+    if (mappings.empty() || mapping.processedLine > mappings.back().processedLine) {
+        if (!mappings.empty() && continuesRun(mappings.back(), mapping)) {
+            return;
+        }
+        mappings.push_back(mapping);
+        return;
+    }
+    
+    auto it = std::lower_bound(mappings.begin(), mappings.end(), mapping.processedLine,
+        [](const SourceMapping& run, size_t line) { return run.processedLine < line; });
+    if (it != mappings.end() && it->processedLine == mapping.processedLine) {
+        *it = mapping;
+    } else {
+        mappings.insert(it, mapping);
+    }
+}
+
+void PositionMapper::addSplices(size_t processedLine, std::vector<size_t> columns) {
+    if (columns.empty() || (!splices.empty() && processedLine <= splices.back().first)) {
+        return;
+    }
+    splices.emplace_back(processedLine, std::move(columns));
 }
 
 const SourceMapping* PositionMapper::findMapping(size_t processedLine, size_t processedColumn) const {
-    auto it = lineToMappingIndex.find(processedLine);
-    if (it != lineToMappingIndex.end()) {
-        return &mappings[it->second];
+    (void)processedColumn;
+    auto it = std::upper_bound(mappings.begin(), mappings.end(), processedLine,
+        [](size_t line, const SourceMapping& run) { return line < run.processedLine; });
+    if (it == mappings.begin()) {
+        return nullptr;
+    }
+    return &*(it - 1);
+}
+
+bool PositionMapper::resolve(size_t processedLine, size_t processedColumn, SourceMapping& mapping) const {
+    const SourceMapping* run = findMapping(processedLine, processedColumn);
+    if (!run) {
+        return false;
+    }
+    mapping = *run;
+    mapping.processedLine = processedLine;
+    mapping.originalLine = run->originalLine + (processedLine - run->processedLine);
+    if (processedColumn >= run->processedColumn) {
+        mapping.processedColumn = processedColumn;
+        mapping.originalColumn = run->originalColumn + (processedColumn - run->processedColumn);
     }
     
-    // Busca o mapeamento mais próximo
-    for (const auto& mapping : mappings) {
-        if (mapping.processedLine <= processedLine) {
-            return &mapping;
+    // Após uma emenda, a coluna pertence à linha física seguinte
+    auto splice = std::lower_bound(splices.begin(), splices.end(), processedLine,
+        [](const std::pair<size_t, std::vector<size_t>>& entry, size_t line) { return entry.first < line; });
+    if (splice != splices.end() && splice->first == processedLine) {
+        for (size_t start : splice->second) {
+            if (processedColumn <= start) {
+                break;
+            }
+            mapping.originalLine++;
+            mapping.originalColumn = processedColumn - start;
         }
     }
-    
-    return nullptr;
+    return true;
 }
 
 bool PositionMapper::mapToOriginal(size_t processedLine, size_t processedColumn,
                                   size_t& originalLine, size_t& originalColumn,
                                   std::string& originalFile) const {
-    const SourceMapping* mapping = findMapping(processedLine, processedColumn);
-    if (mapping) {
-        originalLine = mapping->originalLine;
-        originalColumn = mapping->originalColumn + (processedColumn - mapping->processedColumn);
-        originalFile = mapping->originalFile;
+    SourceMapping mapping;
+    if (resolve(processedLine, processedColumn, mapping)) {
+        originalLine = mapping.originalLine;
+        originalColumn = mapping.originalColumn;
+        originalFile = mapping.originalFile;
         return true;
     }
     return false;
@@ -58,7 +112,7 @@ std::string PositionMapper::getMacroName(size_t processedLine) const {
 
 void PositionMapper::clear() {
     mappings.clear();
-    lineToMappingIndex.clear();
+    splices.clear();
 }
 
 // IntegratedErrorHandler Implementation
@@ -120,13 +174,80 @@ bool PreprocessorLexerInterface::initialize(const PreprocessorConfig& config) {
 }
 
 ProcessingResult PreprocessorLexerInterface::processFile(const std::string& filename) {
+    runFileProcessing(filename);
+    return lastResult;
+}
+
+ProcessingResult PreprocessorLexerInterface::processFileAndRelease(const std::string& filename) {
+    runFileProcessing(filename);
+    
+    // Move o resultado (inclusive o código) e mantém apenas as listas de macros
+    ProcessingResult result = std::move(lastResult);
+    lastResult.clear();
+    lastResult.definedMacros = result.definedMacros;
+    lastResult.macroDefinitions = result.macroDefinitions;
+    return result;
+}
+
+FileView PreprocessorLexerInterface::openSourceView(const std::string& filename) {
+    return preprocessor ? preprocessor->openFileView(filename) : FileView::open(filename);
+}
+
+ProcessingResult PreprocessorLexerInterface::processFileStreaming(const std::string& filename, OutputSink sink) {
     lastResult.clear();
     
-    if (!isInitialized) {
+    if (!isInitialized || !preprocessor) {
         lastResult.addError("Interface not initialized");
         return lastResult;
     }
     
+    // Conta linhas no caminho para os mapeamentos, já que o código não fica retido
+    size_t lineCount = 0;
+    size_t byteCount = 0;
+    preprocessor->setOutputSink([&](std::string_view chunk) {
+        lineCount += static_cast<size_t>(std::count(chunk.begin(), chunk.end(), '\n'));
+        byteCount += chunk.size();
+        sink(chunk);
+    });
+    
+    try {
+        preprocessor->setErrorHandler(errorHandler.get());
+        
+        if (preprocessor->process(filename)) {
+            lastResult.includedFiles = preprocessor->getDependencies();
+        } else {
+            // Sem fallback aqui: o consumidor já recebeu parte da saída
+            lastResult.addError("Preprocessing failed: " + filename);
+        }
+        
+        buildLineMappings(filename, lineCount, byteCount > 0, &preprocessor->getLineMap());
+        collectMacroInformation();
+        
+        if (errorHandler) {
+            for (const auto& error : errorHandler->getErrors()) {
+                lastResult.addError(error.message);
+            }
+            for (const auto& warning : errorHandler->getWarnings()) {
+                lastResult.addWarning(warning.message);
+            }
+        }
+    } catch (const std::exception& e) {
+        lastResult.addError("Processing error: " + std::string(e.what()));
+    }
+    
+    preprocessor->setOutputSink(nullptr);
+    lastResult.hasErrors = !lastResult.errorMessages.empty();
+    return lastResult;
+}
+
+void PreprocessorLexerInterface::runFileProcessing(const std::string& filename) {
+    lastResult.clear();
+    
+    if (!isInitialized) {
+        lastResult.addError("Interface not initialized");
+        return;
+    }
+    
     try {
         // Processa o arquivo através do preprocessador real
         bool preprocessorSuccess = false;
@@ -136,9 +257,13 @@ ProcessingResult PreprocessorLexerInterface::processFile(const std::string& file
             
             preprocessorSuccess = preprocessor->process(filename);
             if (preprocessorSuccess) {
-                lastResult.processedCode = preprocessor->getExpandedCode();
+                lastResult.processedCode = preprocessor->takeExpandedCode();
                 lastResult.includedFiles = preprocessor->getDependencies();
             } else {
+                // Mesmo erro do caminho em streaming, para que o resultado não
+                // dependa do modo de entrega
+                lastResult.addError("Preprocessing failed: " + filename);
+                
                 // Pré-processador falhou, vamos coletar os erros
                 if (errorHandler) {
                     const auto& errors = errorHandler->getErrors();
@@ -164,12 +289,13 @@ ProcessingResult PreprocessorLexerInterface::processFile(const std::string& file
                 lastResult.processedCode = content;
             } else {
                 lastResult.addError("Could not open file: " + filename);
-                return lastResult;
+                return;
             }
         }
         
-        // Constrói mapeamentos básicos
-        buildPositionMappings(filename, lastResult.processedCode);
+        // Constrói mapeamentos a partir da tabela de linhas do preprocessador
+        buildPositionMappings(filename, lastResult.processedCode,
+                              preprocessorSuccess ? &preprocessor->getLineMap() : nullptr);
         
         // Coleta informações sobre macros
         collectMacroInformation();
@@ -196,8 +322,6 @@ ProcessingResult PreprocessorLexerInterface::processFile(const std::string& file
     
     // Define hasErrors baseado na presença de mensagens de erro
     lastResult.hasErrors = !lastResult.errorMessages.empty();
-    
-    return lastResult;
 }
 
 ProcessingResult PreprocessorLexerInterface::processString(const std::string& code, const std::string& filename) {
@@ -306,26 +430,40 @@ std::vector<std::string> PreprocessorLexerInterface::getDependencies() const {
     return lastResult.includedFiles;
 }
 
-void PreprocessorLexerInterface::buildPositionMappings(const std::string& filename, const std::string& processedCode) {
+void PreprocessorLexerInterface::buildPositionMappings(const std::string& filename, const std::string& processedCode,
+                                                       const LineMap* lineMap) {
+    size_t lineCount = static_cast<size_t>(std::count(processedCode.begin(), processedCode.end(), '\n'));
+    buildLineMappings(filename, lineCount, !processedCode.empty(), lineMap);
+}
+
+void PreprocessorLexerInterface::buildLineMappings(const std::string& filename, size_t lineCount, bool hasContent,
+                                                   const LineMap* lineMap) {
     if (!positionMapper) return;
     
-    // Cria mapeamentos básicos linha por linha
-    size_t line = 1;
-    for (size_t i = 0; i < processedCode.length(); ++i) {
-        if (processedCode[i] == '\n') {
-            SourceMapping mapping(line, 1, line, 1, filename);
-            positionMapper->addMapping(mapping);
-            lastResult.positionMappings.push_back(mapping);
-            ++line;
-        }
+    positionMapper->clear();
+    if (!hasContent) return;
+    
+    // Linhas anteriores à primeira sequência registrada (diretivas) mapeiam para si mesmas
+    if (!lineMap || lineMap->empty() || lineMap->runs().front().expandedLine > 1) {
+        positionMapper->addMapping(SourceMapping(1, 1, 1, 1, filename));
     }
     
-    // Adiciona pelo menos um mapeamento se não houver quebras de linha
-    if (lastResult.positionMappings.empty() && !processedCode.empty()) {
-        SourceMapping mapping(1, 1, 1, 1, filename);
-        positionMapper->addMapping(mapping);
-        lastResult.positionMappings.push_back(mapping);
+    // Uma entrada por sequência de linhas do pré-processador, limitada à saída produzida
+    if (lineMap) {
+        for (const auto& run : lineMap->runs()) {
+            if (run.expandedLine > lineCount + 1) break;
+            positionMapper->addMapping(SourceMapping(run.expandedLine, 1, run.originalLine, 1,
+                                                     lineMap->fileName(run.fileIndex)));
+        }
+        const std::vector<uint32_t>& columns = lineMap->spliceColumns();
+        for (const auto& splice : lineMap->splices()) {
+            if (splice.expandedLine > lineCount + 1) break;
+            positionMapper->addSplices(splice.expandedLine,
+                std::vector<size_t>(columns.begin() + splice.begin, columns.begin() + splice.begin + splice.count));
+        }
     }
+    
+    lastResult.positionMappings = positionMapper->getAllMappings();
 }
 
 void PreprocessorLexerInterface::collectMacroInformation() {
@@ -9,6 +9,8 @@
 #include <ctime>
 #include <algorithm>
 #include <fstream>
+#include <cstdio>
+#include <cstring>
 #include <sys/stat.h>
 #include <dirent.h>
 
@@ -66,12 +68,15 @@ static std::vector<std::string> listDirectory(const std::string& path) {
 PreprocessorLogger::PreprocessorLogger(LogLevel level)
     : currentLogLevel(level), consoleOutput(true), fileOutput(false),
       bufferingEnabled(false), maxBufferSize(1000), maxFileSize(10 * 1024 * 1024), // 10MB
-      logDirectory("./logs") {
+      logDirectory("./logs"), currentFileSize(0), asyncStopping(false),
+      cachedTimestampSecond(-1) {
     statistics.reset();
+    cachedTimestampPrefix[0] = '\0';
 }
 
 PreprocessorLogger::~PreprocessorLogger() {
     flushLogBuffer();
+    enableAsyncFileWriter(false);
     if (outputFile && outputFile->is_open()) {
         outputFile->close();
     }
@@ -86,8 +91,10 @@ void PreprocessorLogger::setLogLevel(LogLevel level) {
 }
 
 void PreprocessorLogger::setOutputFile(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(fileMutex);
     currentLogFile = filename;
     outputFile = std::make_unique<std::ofstream>(filename, std::ios::app);
+    currentFileSize = getFileSize(filename);
     if (!outputFile->is_open()) {
         handleLogErrors("Não foi possível abrir arquivo de log: " + filename);
         outputFile.reset();
@@ -110,6 +117,44 @@ void PreprocessorLogger::enableFileOutput(bool enable) {
     fileOutput = enable;
 }
 
+void PreprocessorLogger::enableAsyncFileWriter(bool enable) {
+    if (enable == asyncWriter.joinable()) {
+        return;
+    }
+    
+    if (enable) {
+        asyncStopping = false;
+        asyncWriter = std::thread(&PreprocessorLogger::runAsyncWriter, this);
+        return;
+    }
+    
+    // Encerrar: a thread grava o que estiver pendente antes de sair
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        asyncStopping = true;
+    }
+    asyncCondition.notify_one();
+    asyncWriter.join();
+}
+
+void PreprocessorLogger::runAsyncWriter() {
+    // Só grava: rotação, estatísticas e console ficam na thread que registra
+    std::vector<std::string> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(asyncMutex);
+            asyncCondition.wait(lock, [this] { return asyncStopping || !asyncQueue.empty(); });
+            if (asyncQueue.empty()) {
+                return;  // Encerrando e sem pendências
+            }
+            batch.swap(asyncQueue);
+        }
+        
+        writeLinesToFile(batch);
+        batch.clear();
+    }
+}
+
 // ============================================================================
 // Inicialização e Configuração Avançada
 // ============================================================================
@@ -371,21 +416,25 @@ void PreprocessorLogger::rotateLogFile() {
         return;
     }
     
-    // Fechar arquivo atual
-    outputFile->close();
-    
     // Gerar nome do arquivo rotacionado
     std::string rotatedFileName = generateRotatedFileName();
+    bool rotated = false;
     
     try {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        
+        // Fechar arquivo atual
+        outputFile->close();
+        
         // Renomear arquivo atual
         if (std::rename(currentLogFile.c_str(), rotatedFileName.c_str()) == 0) {
             // Reabrir arquivo com nome original
             outputFile = std::make_unique<std::ofstream>(currentLogFile, std::ios::app);
+            currentFileSize = 0;
             
             if (outputFile->is_open()) {
                 statistics.fileRotations++;
-                info("Arquivo de log rotacionado: " + rotatedFileName);
+                rotated = true;
             } else {
                 handleLogErrors("Erro ao reabrir arquivo de log após rotação");
             }
@@ -395,6 +444,11 @@ void PreprocessorLogger::rotateLogFile() {
     } catch (const std::exception& e) {
         handleLogErrors("Erro na rotação do arquivo de log: " + std::string(e.what()));
     }
+    
+    // Registrado fora da trava: info() volta a gravar no arquivo
+    if (rotated) {
+        info("Arquivo de log rotacionado: " + rotatedFileName);
+    }
 }
 
 void PreprocessorLogger::compressOldLogs() {
@@ -518,16 +572,26 @@ void PreprocessorLogger::optimizeLogPerformance() {
 
 std::string PreprocessorLogger::formatLogMessage(LogLevel level, const std::string& message, 
                                                 const PreprocessorPosition& pos) const {
-    std::ostringstream oss;
-    oss << "[" << getCurrentTimestamp() << "] ";
-    oss << "[" << logLevelToString(level) << "] ";
+    std::string formatted;
+    formatted.reserve(message.size() + pos.filename.size() + 64);
+    formatted += '[';
+    formatted += getCurrentTimestamp();
+    formatted += "] [";
+    formatted += logLevelToString(level);
+    formatted += "] ";
     
     if (!pos.filename.empty()) {
-        oss << "[" << pos.filename << ":" << pos.line << ":" << pos.column << "] ";
+        formatted += '[';
+        formatted += pos.filename;
+        formatted += ':';
+        formatted += std::to_string(pos.line);
+        formatted += ':';
+        formatted += std::to_string(pos.column);
+        formatted += "] ";
     }
     
-    oss << message;
-    return oss.str();
+    formatted += message;
+    return formatted;
 }
 
 std::string PreprocessorLogger::getCurrentTimestamp() const {
@@ -536,20 +600,46 @@ std::string PreprocessorLogger::getCurrentTimestamp() const {
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         now.time_since_epoch()) % 1000;
     
-    std::ostringstream oss;
-    oss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-    oss << "." << std::setfill('0') << std::setw(3) << ms.count();
-    return oss.str();
+    // localtime/strftime só quando o segundo muda
+    if (time_t != cachedTimestampSecond) {
+        std::tm local_time;
+        localtime_r(&time_t, &local_time);
+        std::strftime(cachedTimestampPrefix, sizeof(cachedTimestampPrefix), "%Y-%m-%d %H:%M:%S", &local_time);
+        cachedTimestampSecond = time_t;
+    }
+    
+    char timestamp[40];
+    std::snprintf(timestamp, sizeof(timestamp), "%s.%03d", cachedTimestampPrefix, static_cast<int>(ms.count()));
+    return timestamp;
 }
 
 void PreprocessorLogger::writeToFile(const std::string& message) {
-    if (outputFile && outputFile->is_open()) {
-        *outputFile << message << std::endl;
-        outputFile->flush();
-        
-        // Verificar se precisa rotacionar
-        checkFileRotation();
+    if (asyncWriter.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(asyncMutex);
+            asyncQueue.push_back(message);
+        }
+        asyncCondition.notify_one();
+        statistics.asyncWrites++;
+    } else {
+        writeLinesToFile(std::vector<std::string>(1, message));
     }
+    
+    // Verificar se precisa rotacionar (sempre nesta thread)
+    checkFileRotation();
+}
+
+void PreprocessorLogger::writeLinesToFile(const std::vector<std::string>& messages) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (!outputFile || !outputFile->is_open()) {
+        return;
+    }
+    for (const auto& message : messages) {
+        outputFile->write(message.data(), static_cast<std::streamsize>(message.size()));
+        outputFile->put('\n');
+        currentFileSize += message.size() + 1;
+    }
+    outputFile->flush();
 }
 
 void PreprocessorLogger::writeToConsole(const std::string& message) {
@@ -596,11 +686,14 @@ void PreprocessorLogger::checkFileRotation() {
     }
     
     try {
-        if (fileExists(currentLogFile)) {
-            auto size = getFileSize(currentLogFile);
-            if (size >= maxFileSize) {
-                rotateLogFile();
-            }
+        // Tamanho acompanhado pelas gravações, sem consultar o sistema de arquivos
+        size_t size;
+        {
+            std::lock_guard<std::mutex> lock(fileMutex);
+            size = currentFileSize;
+        }
+        if (size >= maxFileSize && fileExists(currentLogFile)) {
+            rotateLogFile();
         }
     } catch (const std::exception& e) {
         handleLogErrors("Erro ao verificar tamanho do arquivo: " + std::string(e.what()));
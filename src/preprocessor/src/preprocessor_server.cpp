@@ -0,0 +1,450 @@
+#include "../include/preprocessor_server.hpp"
+#include "../include/binary_format.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Preprocessor {
+
+namespace {
+
+constexpr char REQUEST_MAGIC[4] = {'P', 'P', 'R', 'Q'};
+constexpr char RESPONSE_MAGIC[4] = {'P', 'P', 'R', 'S'};
+constexpr uint32_t PROTOCOL_VERSION = 1;
+
+// Limite de um quadro; protege o servidor de tamanhos corrompidos
+constexpr uint32_t MAX_FRAME_SIZE = 256u * 1024 * 1024;
+
+// Intervalo em que o laço de aceitação verifica o pedido de encerramento
+constexpr int ACCEPT_POLL_MS = 100;
+
+bool fillSocketAddress(const std::string& socket_path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, socket_path.data(), socket_path.size());
+    return true;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = ::recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+// ============================================================================
+// Protocolo
+// ============================================================================
+
+namespace ServerProtocol {
+
+std::string encodeRequest(const ServerRequest& request) {
+    std::string payload;
+    BinaryFormat::putU8(payload, static_cast<uint8_t>(request.type));
+    BinaryFormat::putString(payload, request.filename);
+    BinaryFormat::putU32(payload, static_cast<uint32_t>(request.macros.size()));
+    for (const auto& macro : request.macros) {
+        BinaryFormat::putString(payload, macro.first);
+        BinaryFormat::putString(payload, macro.second);
+    }
+    return BinaryFormat::seal(REQUEST_MAGIC, PROTOCOL_VERSION, payload);
+}
+
+bool decodeRequest(const std::string& frame, ServerRequest& request) {
+    const char* payload = nullptr;
+    size_t payload_size = 0;
+    if (BinaryFormat::unseal(frame.data(), frame.size(), REQUEST_MAGIC, PROTOCOL_VERSION,
+                             payload, payload_size) != BinaryFormat::EnvelopeStatus::OK) {
+        return false;
+    }
+
+    BinaryFormat::Reader reader(payload, payload_size);
+    uint8_t type = reader.u8();
+    if (type < static_cast<uint8_t>(ServerRequestType::PREPROCESS) ||
+        type > static_cast<uint8_t>(ServerRequestType::SHUTDOWN)) {
+        return false;
+    }
+    request.type = static_cast<ServerRequestType>(type);
+    request.filename = reader.str();
+
+    uint32_t macro_count = reader.u32();
+    if (macro_count > reader.remaining()) {
+        return false;
+    }
+    request.macros.clear();
+    for (uint32_t i = 0; i < macro_count && reader.good(); ++i) {
+        std::string name = reader.str();
+        std::string value = reader.str();
+        request.macros.emplace_back(std::move(name), std::move(value));
+    }
+    return reader.good() && reader.atEnd();
+}
+
+std::string encodeResponse(const ServerResponse& response) {
+    std::string payload;
+    payload.reserve(response.expanded_code.size() + response.message.size() + 64);
+    BinaryFormat::putU8(payload, response.success ? 1 : 0);
+    BinaryFormat::putString(payload, response.expanded_code);
+    BinaryFormat::putU32(payload, static_cast<uint32_t>(response.dependencies.size()));
+    for (const auto& dependency : response.dependencies) {
+        BinaryFormat::putString(payload, dependency);
+    }
+    BinaryFormat::putString(payload, response.message);
+    return BinaryFormat::seal(RESPONSE_MAGIC, PROTOCOL_VERSION, payload);
+}
+
+bool decodeResponse(const std::string& frame, ServerResponse& response) {
+    const char* payload = nullptr;
+    size_t payload_size = 0;
+    if (BinaryFormat::unseal(frame.data(), frame.size(), RESPONSE_MAGIC, PROTOCOL_VERSION,
+                             payload, payload_size) != BinaryFormat::EnvelopeStatus::OK) {
+        return false;
+    }
+
+    BinaryFormat::Reader reader(payload, payload_size);
+    response.success = reader.u8() != 0;
+    response.expanded_code = reader.str();
+    uint32_t dependency_count = reader.u32();
+    if (dependency_count > reader.remaining()) {
+        return false;
+    }
+    response.dependencies.clear();
+    for (uint32_t i = 0; i < dependency_count && reader.good(); ++i) {
+        response.dependencies.push_back(reader.str());
+    }
+    response.message = reader.str();
+    return reader.good() && reader.atEnd();
+}
+
+bool writeFrame(int fd, const std::string& frame) {
+    if (frame.size() > MAX_FRAME_SIZE) {
+        return false;
+    }
+    std::string header;
+    BinaryFormat::putU32(header, static_cast<uint32_t>(frame.size()));
+    return writeAll(fd, header.data(), header.size()) && writeAll(fd, frame.data(), frame.size());
+}
+
+bool readFrame(int fd, std::string& frame) {
+    char header[4];
+    if (!readAll(fd, header, sizeof(header))) {
+        return false;
+    }
+    BinaryFormat::Reader reader(header, sizeof(header));
+    uint32_t size = reader.u32();
+    if (size > MAX_FRAME_SIZE) {
+        return false;
+    }
+    frame.resize(size);
+    return readAll(fd, &frame[0], size);
+}
+
+} // namespace ServerProtocol
+
+// ============================================================================
+// Servidor
+// ============================================================================
+
+PreprocessorServer::PreprocessorServer(ServerOptions options)
+    : options_(std::move(options)),
+      file_manager_(std::make_shared<FileManager>()),
+      worker_count_(options_.worker_count),
+      listen_fd_(-1),
+      running_(false),
+      request_count_(0) {
+    if (worker_count_ == 0) {
+        worker_count_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Mesmos caminhos que uma instância isolada usaria
+    if (options_.include_paths.empty()) {
+        file_manager_->setSearchPaths({"/usr/include", "/usr/local/include", "."});
+    } else {
+        file_manager_->setSearchPaths(options_.include_paths);
+    }
+
+    // Sem notificações, os acertos de cache continuam verificando a data de modificação
+    file_manager_->enableChangeWatching();
+}
+
+PreprocessorServer::~PreprocessorServer() {
+    stop();
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        ::unlink(options_.socket_path.c_str());
+    }
+}
+
+bool PreprocessorServer::start() {
+    sockaddr_un address;
+    if (listen_fd_ >= 0 || !fillSocketAddress(options_.socket_path, address)) {
+        return false;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Um socket que recusa conexões foi deixado por um servidor encerrado
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // Só um socket abandonado é removido; qualquer outro arquivo no caminho é preservado
+    struct stat existing;
+    if (::lstat(options_.socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            ::close(fd);
+            return false;
+        }
+        ::unlink(options_.socket_path.c_str());
+    }
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::chmod(options_.socket_path.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    listen_fd_ = fd;
+    running_ = true;
+    return true;
+}
+
+void PreprocessorServer::serve() {
+    if (listen_fd_ < 0) {
+        return;
+    }
+
+    workers_.reserve(worker_count_);
+    for (size_t i = 0; i < worker_count_; ++i) {
+        workers_.emplace_back(&PreprocessorServer::workerLoop, this);
+    }
+
+    pollfd listener{listen_fd_, POLLIN, 0};
+    while (running_) {
+        int ready = ::poll(&listener, 1, ACCEPT_POLL_MS);
+        if (ready <= 0) {
+            continue;
+        }
+        int connection = ::accept(listen_fd_, nullptr, nullptr);
+        if (connection < 0) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            pending_connections_.push(connection);
+        }
+        queue_ready_.notify_one();
+    }
+
+    queue_ready_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void PreprocessorServer::stop() {
+    running_ = false;
+    queue_ready_.notify_all();
+
+    // Acorda os trabalhadores bloqueados na leitura; a escrita continua possível
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (int fd : active_connections_) {
+        ::shutdown(fd, SHUT_RD);
+    }
+}
+
+void PreprocessorServer::workerLoop() {
+    // Instância reutilizada: configuração, macros predefinidas e expressões
+    // compiladas sobrevivem a reset()
+    PreprocessorMain preprocessor(options_.config_file, file_manager_);
+    preprocessor.setProcessingProfile(options_.profile);
+
+    while (true) {
+        int connection = -1;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_ready_.wait(lock, [this]() { return !running_ || !pending_connections_.empty(); });
+            if (pending_connections_.empty()) {
+                return;
+            }
+            connection = pending_connections_.front();
+            pending_connections_.pop();
+        }
+        handleConnection(connection, preprocessor);
+    }
+}
+
+void PreprocessorServer::handleConnection(int fd, PreprocessorMain& preprocessor) {
+    // Cliente ocioso não prende o trabalhador indefinidamente
+    if (options_.idle_timeout_ms > 0) {
+        timeval timeout{options_.idle_timeout_ms / 1000, (options_.idle_timeout_ms % 1000) * 1000};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+    {
+        // Registrada sob a mesma trava de stop(): nenhuma conexão escapa do encerramento
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        active_connections_.insert(fd);
+        if (!running_) {
+            ::shutdown(fd, SHUT_RD);
+        }
+    }
+
+    std::string frame;
+    while (ServerProtocol::readFrame(fd, frame)) {
+        ServerRequest request;
+        ServerResponse response;
+        if (ServerProtocol::decodeRequest(frame, request)) {
+            response = handleRequest(request, preprocessor);
+        } else {
+            response.message = "Requisição inválida";
+        }
+
+        if (!ServerProtocol::writeFrame(fd, ServerProtocol::encodeResponse(response)) ||
+            request.type == ServerRequestType::SHUTDOWN) {
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        active_connections_.erase(fd);
+    }
+    ::close(fd);
+}
+
+ServerResponse PreprocessorServer::handleRequest(const ServerRequest& request, PreprocessorMain& preprocessor) {
+    request_count_++;
+    ServerResponse response;
+
+    switch (request.type) {
+        case ServerRequestType::STATISTICS:
+            response.success = true;
+            response.message = statisticsJson();
+            return response;
+        case ServerRequestType::SHUTDOWN:
+            response.success = true;
+            stop();
+            return response;
+        case ServerRequestType::PREPROCESS:
+            break;
+    }
+
+    try {
+        preprocessor.reset();
+        if (!options_.snapshot_file.empty() && !preprocessor.loadSnapshot(options_.snapshot_file)) {
+            response.message = "Falha ao carregar o snapshot: " + options_.snapshot_file;
+            return response;
+        }
+        for (const auto& macro : request.macros) {
+            preprocessor.defineMacro(macro.first, macro.second);
+        }
+
+        response.success = preprocessor.process(request.filename);
+        response.expanded_code = preprocessor.takeExpandedCode();
+        response.dependencies = preprocessor.getDependencies();
+        if (!response.success) {
+            response.message = "Falha ao pré-processar: " + request.filename;
+        }
+    } catch (const std::exception& e) {
+        response.success = false;
+        response.message = e.what();
+    }
+    return response;
+}
+
+std::string PreprocessorServer::statisticsJson() const {
+    const FileStats stats = file_manager_->getStatistics();
+    std::string json = "{";
+    json += "\"socket\":\"" + jsonEscape(options_.socket_path) + "\"";
+    json += ",\"workers\":" + std::to_string(worker_count_);
+    json += ",\"requests\":" + std::to_string(request_count_.load());
+    json += ",\"files_read\":" + std::to_string(stats.files_read);
+    json += ",\"cache_hits\":" + std::to_string(stats.cache_hits);
+    json += ",\"cache_misses\":" + std::to_string(stats.cache_misses);
+    json += ",\"resolution_cache_hits\":" + std::to_string(stats.resolution_cache_hits);
+    json += ",\"change_events\":" + std::to_string(stats.change_events);
+    json += ",\"change_watching\":";
+    json += file_manager_->isChangeWatchingActive() ? "true" : "false";
+    json += "}";
+    return json;
+}
+
+// ============================================================================
+// Cliente
+// ============================================================================
+
+bool sendServerRequest(const std::string& socket_path, const ServerRequest& request, ServerResponse& response) {
+    sockaddr_un address;
+    if (!fillSocketAddress(socket_path, address)) {
+        return false;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    std::string frame;
+    bool ok = ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+              ServerProtocol::writeFrame(fd, ServerProtocol::encodeRequest(request)) &&
+              ServerProtocol::readFrame(fd, frame) &&
+              ServerProtocol::decodeResponse(frame, response);
+    ::close(fd);
+    return ok;
+}
+
+} // namespace Preprocessor
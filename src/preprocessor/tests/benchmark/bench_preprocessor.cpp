@@ -0,0 +1,400 @@
+// Benchmark do pré-processador sobre entradas sintéticas reproduzíveis
+//
+// Cada cenário gera um arquivo determinístico que estressa um caminho
+// específico (tabela de macros, aninhamento de macros funcionais, tabelas
+// X-macro, #if aninhados, linhas com continuação e blocos inativos). O
+// resultado é impresso em tabela e emitido em JSON, com o hash da entrada,
+// para comparação entre commits. O pico de memória é o do processo até o fim
+// de cada cenário (ru_maxrss), acumulado; use --scenario para isolar um.
+//
+// Uso: bench_preprocessor [--iterations N] [--scale F] [--profile checked|fast]
+//                         [--scenario NOME] [--output arquivo.json]
+
+#include "../../include/preprocessor.hpp"
+#include "../../include/content_hash.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace Preprocessor;
+
+namespace {
+
+constexpr int BENCH_FORMAT_VERSION = 1;
+
+// ============================================================================
+// GERADORES DE ENTRADA
+// ============================================================================
+
+size_t scaled(size_t base, double scale) {
+    return std::max<size_t>(1, static_cast<size_t>(base * scale));
+}
+
+// Tabela grande de macros objeto, cada uma usada uma vez
+std::string generateObjectMacros(double scale) {
+    const size_t count = scaled(10000, scale);
+    std::ostringstream out;
+    for (size_t i = 0; i < count; ++i) {
+        out << "#define OBJ_" << i << " (" << i << " + 1)\n";
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out << "int obj_" << i << " = OBJ_" << i << ";\n";
+    }
+    return out.str();
+}
+
+// Cadeia de macros funcionais: N39(x) expande por 40 níveis
+std::string generateFunctionNesting(double scale) {
+    const size_t depth = 40;
+    const size_t uses = scaled(2000, scale);
+    std::ostringstream out;
+    out << "#define NEST_0(x) (x)\n";
+    for (size_t i = 1; i < depth; ++i) {
+        out << "#define NEST_" << i << "(x) NEST_" << (i - 1) << "((x) + " << i << ")\n";
+    }
+    for (size_t i = 0; i < uses; ++i) {
+        out << "int nest_" << i << " = NEST_" << (depth - 1) << "(" << i << ");\n";
+    }
+    return out.str();
+}
+
+// Tabela X-macro com continuações, expandida sob várias definições de X
+std::string generateXMacroTable(double scale) {
+    const size_t entries = scaled(1000, scale);
+    std::ostringstream out;
+    out << "#define COLOR_TABLE \\\n";
+    for (size_t i = 0; i < entries; ++i) {
+        out << "    X(color_" << i << ", " << i << ")" << (i + 1 < entries ? " \\\n" : "\n");
+    }
+    const char* expansions[] = {
+        "#define X(name, value) name = value,\nenum colors { COLOR_TABLE };\n",
+        "#define X(name, value) #name,\nconst char* color_names[] = { COLOR_TABLE };\n",
+        "#define X(name, value) value,\nint color_values[] = { COLOR_TABLE };\n",
+        "#define X(name, value) case value: return #name;\nconst char* color_name(int c) { switch (c) { COLOR_TABLE } return 0; }\n"
+    };
+    for (const char* expansion : expansions) {
+        out << expansion << "#undef X\n";
+    }
+    return out.str();
+}
+
+// Blocos com 50 níveis de #if, alternando ramos ativos e inativos
+std::string generateNestedConditionals(double scale) {
+    const size_t depth = 50;
+    const size_t blocks = scaled(200, scale);
+    std::ostringstream out;
+    out << "#define LEVEL_LIMIT 1000\n#define FEATURE_ON 1\n";
+    for (size_t block = 0; block < blocks; ++block) {
+        for (size_t level = 0; level < depth; ++level) {
+            if (level % 2 == 0) {
+                out << "#if defined(FEATURE_ON) && " << level << " < LEVEL_LIMIT\n";
+            } else {
+                out << "#ifdef FEATURE_ON\n";
+            }
+        }
+        out << "int active_" << block << ";\n";
+        for (size_t level = 0; level < depth; ++level) {
+            out << "#else\nint inactive_" << block << "_" << level << ";\n#endif\n";
+        }
+    }
+    return out.str();
+}
+
+// Linhas lógicas longas formadas por continuações
+std::string generateContinuationLines(double scale) {
+    const size_t lines = scaled(2000, scale);
+    const size_t pieces = 20;
+    std::ostringstream out;
+    out << "#define TERM(i) ((i) * 2)\n";
+    for (size_t i = 0; i < lines; ++i) {
+        out << "int long_" << i << " = 0";
+        for (size_t piece = 0; piece < pieces; ++piece) {
+            out << " + TERM(" << piece << ") \\\n";
+        }
+        out << "    + " << i << ";\n";
+    }
+    return out.str();
+}
+
+// Muitos blocos inativos com diretivas internas, intercalados com código
+std::string generateSkippedBlocks(double scale) {
+    const size_t blocks = scaled(5000, scale);
+    std::ostringstream out;
+    for (size_t i = 0; i < blocks; ++i) {
+        out << "#if 0\n"
+            << "#define DEAD_" << i << " 1\n"
+            << "#ifdef DEAD_" << i << "\n"
+            << "int dead_a_" << i << " = DEAD_" << i << ";\n"
+            << "#else\n"
+            << "#error nunca avaliado\n"
+            << "#endif\n"
+            << "/* # não é diretiva */ int dead_b_" << i << ";\n"
+            << "#endif\n"
+            << "int live_" << i << ";\n";
+    }
+    return out.str();
+}
+
+struct Scenario {
+    const char* name;
+    std::function<std::string(double)> generate;
+};
+
+const std::vector<Scenario>& scenarios() {
+    static const std::vector<Scenario> all = {
+        {"object_macros", generateObjectMacros},
+        {"function_nesting", generateFunctionNesting},
+        {"x_macro_table", generateXMacroTable},
+        {"nested_conditionals", generateNestedConditionals},
+        {"continuation_lines", generateContinuationLines},
+        {"skipped_blocks", generateSkippedBlocks}
+    };
+    return all;
+}
+
+// ============================================================================
+// MEDIÇÃO
+// ============================================================================
+
+struct IterationResult {
+    bool success = false;
+    size_t output_bytes = 0;
+    uint64_t setup_ns = 0;
+    uint64_t process_ns = 0;
+    ConsistencyCheckStats checks;
+};
+
+struct ScenarioResult {
+    std::string name;
+    size_t input_bytes = 0;
+    size_t input_lines = 0;
+    uint64_t input_hash = 0;
+    std::vector<IterationResult> iterations;
+    long cumulative_peak_rss_kb = 0;   // ru_maxrss do processo ao fim do cenário (só cresce)
+};
+
+uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+// Pico do processo inteiro desde o início, não do cenário isolado
+long cumulativePeakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+IterationResult runIteration(const std::string& path, ProcessingProfile profile) {
+    IterationResult result;
+
+    auto start = std::chrono::steady_clock::now();
+    PreprocessorMain preprocessor("");
+    preprocessor.setLogLevel(LogLevel::ERROR);
+    preprocessor.setProcessingProfile(profile);
+    preprocessor.setSearchPaths({"."});
+    result.setup_ns = elapsedNs(start);
+
+    start = std::chrono::steady_clock::now();
+    result.success = preprocessor.process(path);
+    result.process_ns = elapsedNs(start);
+
+    result.output_bytes = preprocessor.getOutputSize();
+    result.checks = preprocessor.getConsistencyCheckStatistics();
+    return result;
+}
+
+// Iteração com o tempo de processamento mediano
+const IterationResult& medianIteration(const ScenarioResult& scenario) {
+    std::vector<const IterationResult*> sorted;
+    for (const auto& iteration : scenario.iterations) {
+        sorted.push_back(&iteration);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const IterationResult* a, const IterationResult* b) {
+        return a->process_ns < b->process_ns;
+    });
+    return *sorted[sorted.size() / 2];
+}
+
+double perSecond(size_t amount, uint64_t ns) {
+    return ns > 0 ? static_cast<double>(amount) * 1e9 / static_cast<double>(ns) : 0.0;
+}
+
+// ============================================================================
+// RELATÓRIOS
+// ============================================================================
+
+std::string hex64(uint64_t value) {
+    std::ostringstream out;
+    out << std::hex << std::setw(16) << std::setfill('0') << value;
+    return out.str();
+}
+
+void printTable(const std::vector<ScenarioResult>& results) {
+    std::cout << std::left << std::setw(22) << "Cenário" << std::right
+              << std::setw(10) << "Linhas" << std::setw(12) << "Mediana ms"
+              << std::setw(14) << "Linhas/s" << std::setw(12) << "MB/s"
+              << std::setw(12) << "Verif. ms" << std::setw(14) << "Pico acum. KB" << "\n";
+    for (const auto& scenario : results) {
+        const IterationResult& median = medianIteration(scenario);
+        std::cout << std::left << std::setw(22) << scenario.name << std::right
+                  << std::setw(10) << scenario.input_lines
+                  << std::setw(12) << std::fixed << std::setprecision(2) << median.process_ns / 1e6
+                  << std::setw(14) << std::setprecision(0) << perSecond(scenario.input_lines, median.process_ns)
+                  << std::setw(12) << std::setprecision(2) << perSecond(scenario.input_bytes, median.process_ns) / 1e6
+                  << std::setw(12) << median.checks.totalNanoseconds() / 1e6
+                  << std::setw(14) << scenario.cumulative_peak_rss_kb
+                  << (median.success ? "" : "  (falhou)") << "\n";
+    }
+}
+
+std::string toJson(const std::vector<ScenarioResult>& results, ProcessingProfile profile,
+                   size_t iterations, double scale) {
+    std::ostringstream out;
+    out << "{\n  \"benchmark\": \"bench_preprocessor\",\n"
+        << "  \"format_version\": " << BENCH_FORMAT_VERSION << ",\n"
+        << "  \"profile\": \"" << processingProfileToString(profile) << "\",\n"
+        << "  \"iterations\": " << iterations << ",\n"
+        << "  \"scale\": " << scale << ",\n"
+        << "  \"scenarios\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ScenarioResult& scenario = results[i];
+        const IterationResult& median = medianIteration(scenario);
+        uint64_t min_ns = median.process_ns;
+        for (const auto& iteration : scenario.iterations) {
+            min_ns = std::min(min_ns, iteration.process_ns);
+        }
+        const ConsistencyCheckStats& checks = median.checks;
+        const uint64_t check_ns = checks.totalNanoseconds();
+
+        out << (i > 0 ? "," : "") << "\n    {\n"
+            << "      \"name\": \"" << scenario.name << "\",\n"
+            << "      \"input_hash\": \"" << hex64(scenario.input_hash) << "\",\n"
+            << "      \"input_bytes\": " << scenario.input_bytes << ",\n"
+            << "      \"input_lines\": " << scenario.input_lines << ",\n"
+            << "      \"output_bytes\": " << median.output_bytes << ",\n"
+            << "      \"success\": " << (median.success ? "true" : "false") << ",\n"
+            << "      \"median_ns\": " << median.process_ns << ",\n"
+            << "      \"min_ns\": " << min_ns << ",\n"
+            << std::fixed << std::setprecision(1)
+            << "      \"lines_per_second\": " << perSecond(scenario.input_lines, median.process_ns) << ",\n"
+            << "      \"bytes_per_second\": " << perSecond(scenario.input_bytes, median.process_ns) << ",\n"
+            << std::defaultfloat
+            << "      \"cumulative_peak_rss_kb\": " << scenario.cumulative_peak_rss_kb << ",\n"
+            << "      \"phases_ns\": {\n"
+            << "        \"setup\": " << median.setup_ns << ",\n"
+            << "        \"input_validation\": " << checks.input_validation.nanoseconds << ",\n"
+            << "        \"synchronization\": " << checks.synchronization.nanoseconds << ",\n"
+            << "        \"output_validation\": " << checks.output_validation.nanoseconds << ",\n"
+            << "        \"integrity_check\": " << checks.integrity_check.nanoseconds << ",\n"
+            << "        \"report\": " << checks.report.nanoseconds << ",\n"
+            << "        \"processing\": " << (median.process_ns > check_ns ? median.process_ns - check_ns : 0) << "\n"
+            << "      }\n    }";
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t iterations = 5;
+    double scale = 1.0;
+    ProcessingProfile profile = ProcessingProfile::CHECKED;
+    std::string only_scenario;
+    std::string output_path;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (arg == "--iterations" && has_value) {
+                iterations = std::max<size_t>(1, std::stoul(argv[++i]));
+            } else if (arg == "--scale" && has_value) {
+                scale = std::stod(argv[++i]);
+            } else if (arg == "--profile" && has_value) {
+                profile = stringToProcessingProfile(argv[++i]);
+            } else if (arg == "--scenario" && has_value) {
+                only_scenario = argv[++i];
+            } else if (arg == "--output" && has_value) {
+                output_path = argv[++i];
+            } else {
+                std::cerr << "Uso: " << argv[0] << " [--iterations N] [--scale F] [--profile checked|fast]"
+                          << " [--scenario NOME] [--output arquivo.json]\n";
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Argumento inválido: " << e.what() << "\n";
+        return 1;
+    }
+
+    const std::filesystem::path work_dir = std::filesystem::temp_directory_path() /
+        ("bench_preprocessor_" + std::to_string(getpid()));
+    std::filesystem::create_directories(work_dir);
+
+    std::vector<ScenarioResult> results;
+    for (const auto& scenario : scenarios()) {
+        if (!only_scenario.empty() && only_scenario != scenario.name) {
+            continue;
+        }
+
+        const std::string source = scenario.generate(scale);
+        const std::string path = (work_dir / (std::string(scenario.name) + ".c")).string();
+        {
+            std::ofstream out(path, std::ios::binary);
+            out << source;
+        }
+
+        ScenarioResult result;
+        result.name = scenario.name;
+        result.input_bytes = source.size();
+        result.input_lines = static_cast<size_t>(std::count(source.begin(), source.end(), '\n'));
+        result.input_hash = ContentHash::compute(source.data(), source.size());
+
+        // Uma execução de aquecimento fora da medição (cache de páginas, alocador)
+        runIteration(path, profile);
+        for (size_t i = 0; i < iterations; ++i) {
+            result.iterations.push_back(runIteration(path, profile));
+        }
+        result.cumulative_peak_rss_kb = cumulativePeakRssKb();
+        results.push_back(std::move(result));
+    }
+    std::filesystem::remove_all(work_dir);
+
+    if (results.empty()) {
+        std::cerr << "Cenário desconhecido: " << only_scenario << "\n";
+        return 1;
+    }
+
+    printTable(results);
+
+    const std::string json = toJson(results, profile, iterations, scale);
+    if (output_path.empty()) {
+        std::cout << "\n" << json;
+    } else {
+        std::ofstream out(output_path);
+        out << json;
+        if (!out.good()) {
+            std::cerr << "Falha ao gravar " << output_path << "\n";
+            return 1;
+        }
+        std::cout << "\nJSON gravado em " << output_path << "\n";
+    }
+
+    bool all_succeeded = true;
+    for (const auto& scenario : results) {
+        all_succeeded = all_succeeded && medianIteration(scenario).success;
+    }
+    return all_succeeded ? 0 : 2;
+}
@@ -204,6 +204,59 @@ void testPositionMapping() {
     }
     EXPECT_TRUE(foundMapping);
     
+    // Linhas contíguas do mesmo arquivo formam uma única sequência
+    PositionMapper mapper;
+    for (size_t line = 1; line <= 100; ++line) {
+        mapper.addMapping(SourceMapping(line, 1, line, 1, "a.c"));
+    }
+    mapper.addMapping(SourceMapping(101, 1, 1, 1, "b.h"));
+    mapper.addMapping(SourceMapping(102, 1, 2, 1, "b.h"));
+    EXPECT_EQ(mapper.getAllMappings().size(), 2u);
+    
+    // Busca binária com deslocamento dentro da sequência
+    size_t originalLine = 0;
+    size_t originalColumn = 0;
+    std::string originalFile;
+    ASSERT_TRUE(mapper.mapToOriginal(57, 4, originalLine, originalColumn, originalFile));
+    EXPECT_EQ(originalLine, 57u);
+    EXPECT_EQ(originalColumn, 4u);
+    EXPECT_EQ(originalFile, "a.c");
+    ASSERT_TRUE(mapper.mapToOriginal(102, 1, originalLine, originalColumn, originalFile));
+    EXPECT_EQ(originalLine, 2u);
+    EXPECT_EQ(originalFile, "b.h");
+    EXPECT_TRUE(mapper.findMapping(0, 1) == nullptr);
+    
+    // Tabela de linhas do preprocessor: somente inserção em ordem crescente
+    LineMap lineMap;
+    EXPECT_TRUE(lineMap.append(1, 1, "a.c"));
+    EXPECT_TRUE(lineMap.append(2, 2, "a.c"));
+    EXPECT_FALSE(lineMap.append(2, 2, "a.c"));
+    EXPECT_TRUE(lineMap.append(3, 10, "a.c"));
+    EXPECT_EQ(lineMap.runCount(), 2u);
+    uint32_t mappedLine = 0;
+    const std::string* mappedFile = nullptr;
+    ASSERT_TRUE(lineMap.lookup(5, mappedLine, mappedFile));
+    EXPECT_EQ(mappedLine, 12u);
+    EXPECT_EQ(*mappedFile, "a.c");
+    
+    // Arquivo real: mapeamentos vêm da tabela de linhas do preprocessor
+    std::string testFile = "test_position_mapping.c";
+    std::ofstream file(testFile);
+    file << "#define TEST 42\n";
+    for (int i = 0; i < 50; ++i) {
+        file << "int x" << i << " = TEST;\n";
+    }
+    file.close();
+    
+    ProcessingResult fileResult = test.interface->processFile(testFile);
+    EXPECT_FALSE(fileResult.hasErrors);
+    EXPECT_FALSE(fileResult.positionMappings.empty());
+    EXPECT_LT(fileResult.positionMappings.size(), 50u);
+    ASSERT_TRUE(test.interface->getPositionMapper().mapToOriginal(30, 1, originalLine, originalColumn, originalFile));
+    EXPECT_EQ(originalLine, 30u);
+    
+    std::remove(testFile.c_str());
+    
     test.TearDown();
 }
 
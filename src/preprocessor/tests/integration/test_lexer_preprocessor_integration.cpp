@@ -13,6 +13,8 @@
 #include <vector>
 #include <chrono>
 #include <fstream>
+#include <future>
+#include <cstdlib>
 
 using namespace Integration;
 using namespace std;
@@ -36,6 +38,8 @@ public:
         allPassed &= testErrorHandling();
         allPassed &= testPerformance();
         allPassed &= testCompatibility();
+        allPassed &= testPipeliningEquivalence();
+        allPassed &= testPipeliningErrorLimit();
         
         if (allPassed) {
             cout << "\n✅ TODOS OS TESTES DE INTEGRAÇÃO PASSARAM!" << endl;
@@ -481,7 +485,157 @@ public:
         }
     }
     
+    /**
+     * @brief Compara o processamento com e sem pipelining sobre o mesmo arquivo
+     *
+     * A entrada ocupa vários blocos da fila; as variantes com erro o inserem no
+     * meio, depois de blocos já entregues ao lexer.
+     */
+    static bool testPipeliningEquivalence() {
+        cout << "\n--- Teste: Pipelining Equivalente ---" << endl;
+        
+        try {
+            string largeCode = generateLargeTestCode(2000);
+            size_t middle = largeCode.find('\n', largeCode.size() / 2) + 1;
+            string errorCode = largeCode.substr(0, middle)
+                             + "#error falha no meio do fluxo\n"
+                             + largeCode.substr(middle);
+            string unterminatedCode = largeCode.substr(0, middle)
+                                    + "#if 1\n"
+                                    + largeCode.substr(middle);
+            
+            const string largeFile = "pipelining_equivalence_test.c";
+            const string errorFile = "pipelining_error_test.c";
+            const string unterminatedFile = "pipelining_unterminated_test.c";
+            ofstream(largeFile) << largeCode;
+            ofstream(errorFile) << errorCode;
+            ofstream(unterminatedFile) << unterminatedCode;
+            
+            bool passed = comparePipelining(largeFile, false)
+                       && comparePipelining(errorFile, true)
+                       && comparePipelining(unterminatedFile, true);
+            
+            remove(largeFile.c_str());
+            remove(errorFile.c_str());
+            remove(unterminatedFile.c_str());
+            
+            if (passed) {
+                cout << "✅ Teste de pipelining equivalente passou" << endl;
+            }
+            return passed;
+            
+        } catch (const exception& e) {
+            cout << "❌ Exceção no teste de pipelining: " << e.what() << endl;
+            return false;
+        }
+    }
+    
+    /**
+     * @brief Testa que o lexer parando no limite de erros não bloqueia o produtor
+     */
+    static bool testPipeliningErrorLimit() {
+        cout << "\n--- Teste: Pipelining com Limite de Erros do Lexer ---" << endl;
+        
+        const string errorFile = "pipelining_error_limit_test.c";
+        {
+            // Muito mais saída do que cabe na fila, com um erro léxico por linha
+            string code;
+            for (int i = 0; i < 2000; ++i) {
+                code += "int value" + to_string(i) + " = @ " + to_string(i) + ";\n";
+            }
+            code += "int last_value = 0;\n";
+            ofstream(errorFile) << code;
+        }
+        
+        IntegrationConfig config;
+        config.enablePipelining = true;
+        config.pipelineChunkSize = 64;
+        config.pipelineQueueDepth = 1;
+        config.maxLexerErrors = 3;
+        
+        LexerPreprocessorBridge bridge(config);
+        auto processing = async(launch::async, [&]() {
+            return bridge.initialize() && bridge.processFile(errorFile);
+        });
+        if (processing.wait_for(chrono::seconds(30)) != future_status::ready) {
+            // O produtor está bloqueado na fila: não há como fazer join
+            cout << "❌ Pipeline bloqueado após o lexer atingir o limite de erros" << endl;
+            remove(errorFile.c_str());
+            _Exit(1);
+        }
+        
+        bool processed = processing.get();
+        remove(errorFile.c_str());
+        if (!processed) {
+            cout << "❌ Falha no processamento com limite de erros" << endl;
+            return false;
+        }
+        if (bridge.getLastProcessingResult().processedCode.find("last_value") == string::npos) {
+            cout << "❌ Saída do pré-processador não foi retida por completo" << endl;
+            return false;
+        }
+        
+        cout << "✅ Lexer interrompido pelo limite de erros sem bloquear o produtor" << endl;
+        return true;
+    }
+    
 private:
+    /**
+     * @brief Processa um arquivo com e sem pipelining e compara tokens e mapeamentos
+     */
+    static bool comparePipelining(const string& filename, bool expectErrors) {
+        vector<IntegratedToken> results[2];
+        bool errors[2] = {false, false};
+        
+        for (int pipelined = 0; pipelined < 2; ++pipelined) {
+            IntegrationConfig config;
+            config.enablePipelining = pipelined != 0;
+            // Blocos pequenos e fila curta forçam muitos blocos em trânsito
+            config.pipelineChunkSize = 256;
+            config.pipelineQueueDepth = 2;
+            
+            LexerPreprocessorBridge bridge(config);
+            if (!bridge.initialize() || !bridge.processFile(filename)) {
+                cout << "❌ Falha no processamento de " << filename
+                     << (pipelined ? " com" : " sem") << " pipelining" << endl;
+                return false;
+            }
+            results[pipelined] = bridge.tokenizeAll();
+            errors[pipelined] = bridge.getLastProcessingResult().hasErrors;
+        }
+        
+        if (errors[0] != expectErrors || errors[1] != expectErrors) {
+            cout << "❌ Estado de erro inesperado para " << filename << endl;
+            return false;
+        }
+        
+        if (results[0].empty() || results[0].size() != results[1].size()) {
+            cout << "❌ Quantidade de tokens difere: " << results[0].size()
+                 << " sem pipelining, " << results[1].size() << " com pipelining" << endl;
+            return false;
+        }
+        
+        for (size_t i = 0; i < results[0].size(); ++i) {
+            const IntegratedToken& a = results[0][i];
+            const IntegratedToken& b = results[1][i];
+            bool sameToken = a.lexerToken.getType() == b.lexerToken.getType()
+                          && a.lexerToken.getLexeme() == b.lexerToken.getLexeme()
+                          && a.lexerToken.getPosition().line == b.lexerToken.getPosition().line
+                          && a.lexerToken.getPosition().column == b.lexerToken.getPosition().column;
+            bool sameMapping = a.sourceMapping.originalLine == b.sourceMapping.originalLine
+                            && a.sourceMapping.originalColumn == b.sourceMapping.originalColumn
+                            && a.sourceMapping.originalFile == b.sourceMapping.originalFile;
+            if (!sameToken || !sameMapping) {
+                cout << "❌ Token " << i << " difere: '" << a.lexerToken.getLexeme()
+                     << "' vs '" << b.lexerToken.getLexeme() << "'" << endl;
+                return false;
+            }
+        }
+        
+        cout << "✅ " << results[0].size() << " tokens idênticos em " << filename << endl;
+        return true;
+    }
+    
     /**
      * @brief Cria uma configuração de integração
      */
@@ -2,6 +2,7 @@
 // Valida todos os métodos implementados do DirectiveProcessor
 
 #include "../../include/directive.hpp"
+#include "../../include/directive_scanner.hpp"
 #include "../../include/preprocessor_state.hpp"
 #include "../../include/preprocessor_logger.hpp"
 #include "../../include/macro_processor.hpp"
@@ -244,6 +245,41 @@ void testUtilityMethods() {
     assertTrue(normalized1.find("//") == std::string::npos, "normalizeDirectiveLine() remove comentários");
 }
 
+void testDirectiveScanner() {
+    std::cout << "\n=== Testando Reconhecimento de Diretivas ===" << std::endl;
+    
+    // Todos os nomes conhecidos, sem diferenciar maiúsculas
+    const char* names[] = {"include", "define", "undef", "if", "ifdef", "ifndef", "else",
+                           "elif", "endif", "error", "warning", "pragma", "line"};
+    bool allKnown = true;
+    for (const char* name : names) {
+        allKnown = allKnown && lookupDirectiveType(name) != DirectiveType::UNKNOWN &&
+                   directiveTypeToString(lookupDirectiveType(name)) == name;
+    }
+    assertTrue(allKnown, "lookupDirectiveType() reconhece todas as diretivas");
+    assertTrue(lookupDirectiveType("IfDef") == DirectiveType::IFDEF, "lookupDirectiveType() ignora maiúsculas");
+    assertTrue(lookupDirectiveType("ifdeff") == DirectiveType::UNKNOWN, "Nome com sufixo é desconhecido");
+    assertTrue(lookupDirectiveType("elsf") == DirectiveType::UNKNOWN, "Nome com mesmo hash é desconhecido");
+    assertTrue(lookupDirectiveType("") == DirectiveType::UNKNOWN, "Nome vazio é desconhecido");
+    
+    DirectiveScan scan;
+    assertTrue(scanDirective("  #  ifndef GUARD_H  ", scan), "scanDirective() aceita diretiva indentada");
+    assertTrue(scan.type == DirectiveType::IFNDEF, "scanDirective() identifica o tipo");
+    assertEqual("GUARD_H  ", std::string(scan.arguments), "scanDirective() expõe os argumentos");
+    assertFalse(scanDirective("int x; # define", scan), "scanDirective() rejeita código comum");
+    assertEqual("N", std::string(stripDirectiveComment("N /* nota */ // fim")), "stripDirectiveComment() remove comentários");
+    
+    // Linha já normalizada e linha que precisa de normalização produzem a mesma diretiva
+    auto processor = createDirectiveProcessor();
+    PreprocessorPosition pos(1, 1, "test.c");
+    Directive plain = processor->parseDirective("#define SIZE (4 * 2)", pos);
+    Directive messy = processor->parseDirective("#define\tSIZE   (4 * 2)  // tamanho", pos);
+    assertEqual(plain.getContent(), messy.getContent(), "Conteúdo normalizado igual");
+    assertTrue(plain.getArguments() == messy.getArguments(), "Argumentos iguais");
+    assertEqual("SIZE", plain.getArguments()[0], "Nome da macro separado");
+    assertEqual("(4 * 2)", plain.getArguments()[1], "Corpo da macro separado");
+}
+
 void testErrorHandling() {
     std::cout << "\n=== Testando Tratamento de Erros ===" << std::endl;
     
@@ -319,6 +355,8 @@ int main() {
         testUtilityMethods();
         std::cout << "[DEBUG] testUtilityMethods concluído com sucesso" << std::endl;
         
+        testDirectiveScanner();
+        
         std::cout << "[DEBUG] Iniciando testErrorHandling..." << std::endl;
         testErrorHandling();
         std::cout << "[DEBUG] testErrorHandling concluído com sucesso" << std::endl;
@@ -292,6 +292,53 @@ void testPerformanceStress() {
     }
 }
 
+void testCompiledExpressionCache() {
+    std::cout << "\n=== Testando Cache de Expressões Compiladas ===" << std::endl;
+    
+    auto macroProcessor = createMacroProcessor();
+    auto logger = std::make_shared<PreprocessorLogger>();
+    ExpressionEvaluator evaluator(macroProcessor.get(), logger.get());
+    PreprocessorPosition pos(1, 1, "test.c");
+    
+    try {
+        const std::string featureTest = "defined(FEATURE_X) && defined FEATURE_Y == 0";
+        
+        // Mesma geração de macros: resultado memorizado
+        assertEqual(0, evaluator.evaluateExpression(featureTest, pos), "defined() sem macros");
+        assertEqual(0, evaluator.evaluateExpression(featureTest, pos), "defined() repetido");
+        assertTrue(evaluator.getCacheStatistics().memoHits == 1, "Resultado reaproveitado na mesma geração");
+        
+        // Nova definição invalida o resultado, mas reaproveita o programa compilado
+        macroProcessor->defineMacro("FEATURE_X", "1");
+        assertEqual(1, evaluator.evaluateExpression(featureTest, pos), "defined() após #define");
+        macroProcessor->defineMacro("FEATURE_Y", "1");
+        assertEqual(0, evaluator.evaluateExpression(featureTest, pos), "defined() após segundo #define");
+        assertTrue(evaluator.getCacheStatistics().compilations == 1, "Expressão compilada uma única vez");
+        assertTrue(evaluator.getCacheStatistics().compiledHits == 2, "Programa compilado reutilizado");
+        
+        // Valores de macros entram pela expansão; #undef também invalida
+        macroProcessor->defineMacro("LEVEL", "3");
+        assertEqual(1, evaluator.evaluateExpression("LEVEL >= 2 && LEVEL < 5", pos), "Comparação com macro");
+        macroProcessor->undefineMacro("LEVEL");
+        assertEqual(0, evaluator.evaluateExpression("LEVEL >= 2 && LEVEL < 5", pos), "Comparação após #undef");
+        
+        // Operadores unários e precedência preservados no programa compilado
+        assertEqual(-7, evaluator.evaluateExpression("-(3 + 4)", pos), "Menos unário compilado");
+        assertEqual(1, evaluator.evaluateExpression("!0 && 2 * 3 == 6", pos), "NOT e precedência compilados");
+        
+        // Erros não são memorizados
+        assertThrows([&]() { evaluator.evaluateExpression("1 / 0", pos); }, "Divisão por zero compilada");
+        assertThrows([&]() { evaluator.evaluateExpression("1 / 0", pos); }, "Divisão por zero repetida");
+        
+        evaluator.clearExpressionCache();
+        assertTrue(evaluator.getCacheStatistics().compilations == 0, "Cache de expressões limpo");
+        
+    } catch (const std::exception& e) {
+        std::cout << "❌ Erro em testes de cache de expressões: " << e.what() << std::endl;
+        assert(false);
+    }
+}
+
 // ============================================================================
 // FUNÇÃO PRINCIPAL
 // ============================================================================
@@ -310,6 +357,7 @@ int main() {
         testComplexExpressions();
         testErrorHandling();
         testPerformanceStress();
+        testCompiledExpressionCache();
         
         std::cout << "\n=== RESUMO FINAL ===" << std::endl;
         std::cout << "✅ Testes Aritméticos Básicos: Concluído" << std::endl;
@@ -320,6 +368,7 @@ int main() {
         std::cout << "✅ Testes de Expressões Complexas: Concluído" << std::endl;
         std::cout << "✅ Testes de Tratamento de Erros: Concluído" << std::endl;
         std::cout << "✅ Testes de Performance: Concluído" << std::endl;
+        std::cout << "✅ Testes de Cache de Expressões Compiladas: Concluído" << std::endl;
         
         std::cout << "\n🎉 TODOS OS TESTES DE EXPRESSÕES PASSARAM COM SUCESSO! 🎉" << std::endl;
         
@@ -433,6 +433,171 @@ void testMacroStatistics() {
     }
 }
 
+void testMacroTable() {
+    std::cout << "\n=== Testando Tabela de Macros com Arena ===" << std::endl;
+    
+    MacroTable table;
+    for (int i = 0; i < 5000; ++i) {
+        table.assign("M" + std::to_string(i), MacroInfo("", std::to_string(i)));
+    }
+    assertTrue(table.size() == 5000, "Inserção de muitas macros");
+    assertTrue(table.capacity() >= 5000, "Tabela cresce com a carga");
+    
+    const MacroInfo* stable = table.find("M42");
+    assertTrue(stable != nullptr && stable->name == "M42", "Nome ajustado na definição");
+    for (int i = 0; i < 1000; ++i) {
+        table.erase("M" + std::to_string(i * 2 + 1000));
+        table.assign("N" + std::to_string(i), MacroInfo("", "x"));
+    }
+    assertTrue(table.find("M42") == stable, "Endereço da definição estável após remoções");
+    assertTrue(table.find("M1000") == nullptr && table.find("M1001") != nullptr, "Remoção com lápides");
+    assertEqual("4999", table.find("M4999")->value, "Busca após rehash");
+    
+    table.reset();
+    assertTrue(table.size() == 0 && table.find("M42") == nullptr, "Reset em bloco");
+    table.assign("AFTER", MacroInfo("", "1"));
+    assertTrue(table.find("AFTER") != nullptr, "Tabela reutilizável após reset");
+    
+    // #undef/#define repetidos do mesmo nome não acumulam memória
+    const std::string long_name = "CONFIGURATION_FLAG_WITH_A_NAME_LONGER_THAN_SSO";
+    table.assign(long_name, MacroInfo("", "0"));
+    size_t arena_before = table.arenaBytes();
+    for (int i = 0; i < 10000; ++i) {
+        table.erase(long_name);
+        table.assign(long_name, MacroInfo("", std::to_string(i)));
+        table.assign(long_name, MacroInfo("", std::to_string(i + 1)));
+    }
+    assertTrue(table.arenaBytes() == arena_before, "Arena estável com redefinições repetidas");
+    assertTrue(table.find(long_name) != nullptr && table.find(long_name)->value == "10000",
+               "Busca após redefinições repetidas");
+    
+    auto processor = createMacroProcessor();
+    processor->defineMacro("USER", "1");
+    processor->clearUserMacros();
+    assertFalse(processor->isDefined("USER"), "clearUserMacros remove macros do usuário");
+    assertTrue(processor->isDefined("__STDC__"), "clearUserMacros preserva predefinidas");
+}
+
+void testCompiledMacroTemplates() {
+    std::cout << "\n=== Testando Templates Pré-compilados de Macros ===" << std::endl;
+    
+    auto processor = createMacroProcessor();
+    processor->setCacheEnabled(false);
+    
+    processor->defineFunctionMacro("FIELD", {"obj", "name"}, "obj.m_ ## name");
+    const MacroInfo* info = processor->getMacroInfo("FIELD");
+    assertTrue(info != nullptr && info->replacement.compiled, "Corpo compilado na definição");
+    assertEqual("p.m_size", processor->expandFunctionMacro("FIELD", {"p", "size"}), "Slot de concatenação");
+    
+    processor->defineFunctionMacro("SHOW", {"x"}, "#x \"x\" x");
+    assertEqual("\"a+b\" \"x\" a+b", processor->expandFunctionMacro("SHOW", {"a+b"}),
+                "Stringificação e literal preservado");
+    
+    processor->defineFunctionMacro("LOG", {"fmt"}, "log(fmt, __VA_ARGS__)", true);
+    assertEqual("log(\"%d %d\", 1, 2)", processor->expandFunctionMacro("LOG", {"\"%d %d\"", "1", "2"}),
+                "Slot variádico");
+    
+    processor->defineFunctionMacro("ID", {"x"}, "x1 + x");
+    assertEqual("x1 + 7", processor->expandFunctionMacro("ID", {"7"}), "Identificador parcial não é parâmetro");
+}
+
+void testMacroCacheLRU() {
+    std::cout << "\n=== Testando Cache LRU de Expansões ===" << std::endl;
+    
+    MacroExpansionCache cache(2, 1024);
+    cache.insert("A", "1");
+    cache.insert("B", "22");
+    
+    // Acessar A torna B a entrada menos recentemente usada
+    assertTrue(cache.lookup("A") != nullptr, "Hit em entrada existente");
+    cache.insert("C", "333");
+    assertTrue(cache.contains("A"), "Entrada recente preservada");
+    assertFalse(cache.contains("B"), "Entrada LRU removida por limite de entradas");
+    assertTrue(cache.lookup("B") == nullptr, "Miss após remoção");
+    
+    const MacroCacheStats& stats = cache.statistics();
+    assertTrue(stats.hits == 1 && stats.misses == 1, "Contadores de hits e misses");
+    assertTrue(stats.evictions == 1, "Contador de remoções");
+    assertTrue(stats.bytesSaved == 1, "Bytes poupados contabilizados");
+    
+    // Orçamento de bytes: cada entrada ocupa chave + valor
+    cache.setLimits(10, 5);
+    assertTrue(cache.bytes() <= 5, "Orçamento de bytes respeitado");
+    assertTrue(cache.contains("C") && !cache.contains("A"), "Remoção segue ordem LRU");
+    
+    cache.insert("HUGE", std::string(64, 'x'));
+    assertFalse(cache.contains("HUGE"), "Entrada maior que o orçamento não é armazenada");
+    
+    // Integração com MacroProcessor
+    auto processor = createMacroProcessor();
+    processor->configureCacheOptimization(4, true);
+    processor->defineMacro("X", "10");
+    processor->expandMacro("X");
+    processor->expandMacro("X");
+    assertTrue(processor->getCacheStatistics().hits >= 1, "MacroProcessor reaproveita expansão em cache");
+    assertTrue(processor->getCurrentCacheSize() <= 4, "MacroProcessor respeita limite de entradas");
+    assertTrue(processor->getStatistics().find("Cache evictions:") != std::string::npos,
+               "Estatísticas incluem remoções do cache");
+}
+
+void testMacroProfiling() {
+    std::cout << "\n=== Testando Instrumentação por Macro ===" << std::endl;
+    
+    auto processor = createMacroProcessor();
+    processor->defineMacro("BASE", "100");
+    processor->defineFunctionMacro("TWICE", {"x"}, "((x) + (x))");
+    processor->defineFunctionMacro("QUAD", {"x"}, "TWICE(x) * TWICE(BASE)");
+    
+    // Desativada por padrão: nenhuma medição
+    processor->processLine("int a = BASE;");
+    assertTrue(processor->getMacroProfiles().empty(), "Instrumentação desativada por padrão");
+    
+    processor->setProfilingEnabled(true);
+    processor->processLine("int b = QUAD(BASE);", PreprocessorPosition("hot.c", 7, 1));
+    processor->processLine("int c = QUAD(2);", PreprocessorPosition("hot.c", 9, 1));
+    
+    std::vector<MacroProfile> profiles = processor->getMacroProfiles();
+    assertFalse(profiles.empty(), "Perfis registrados");
+    bool sorted = true;
+    for (size_t i = 1; i < profiles.size(); ++i) {
+        sorted = sorted && profiles[i - 1].totalNanoseconds >= profiles[i].totalNanoseconds;
+    }
+    assertTrue(sorted, "Perfis ordenados por tempo total");
+    
+    const MacroProfile* quad = nullptr;
+    const MacroProfile* twice = nullptr;
+    for (const auto& profile : profiles) {
+        if (profile.name == "QUAD") quad = &profile;
+        if (profile.name == "TWICE") twice = &profile;
+    }
+    assertTrue(quad && quad->expansions == 2, "Expansões de QUAD contadas");
+    assertTrue(quad && quad->callSites.size() == 2 && quad->callSites[1].line == 9, "Locais de chamada distintos");
+    assertTrue(quad && quad->selfNanoseconds <= quad->totalNanoseconds, "Tempo próprio não excede o total");
+    assertTrue(twice && twice->maxDepth > quad->maxDepth, "Profundidade de aninhamento registrada");
+    assertTrue(quad && quad->bytesProduced > 0, "Bytes gerados contabilizados");
+    
+    std::string report = processor->generateMacroReport();
+    assertTrue(report.find("Custo de Expansão") != std::string::npos &&
+               report.find("hot.c:7") != std::string::npos, "Relatório inclui macros custosas");
+    
+    std::string json = processor->exportProfileJson();
+    assertTrue(json.find("\"name\":\"QUAD\"") != std::string::npos &&
+               json.find("\"call_sites\":[{\"file\":\"hot.c\",\"line\":7}") != std::string::npos,
+               "Exportação JSON");
+    
+    // Linha sem posição não herda o local de chamada da linha anterior
+    processor->defineMacro("LONE", "1");
+    processor->processLine("int d = LONE;");
+    bool loneWithoutSite = false;
+    for (const auto& profile : processor->getMacroProfiles()) {
+        if (profile.name == "LONE") loneWithoutSite = profile.callSites.empty();
+    }
+    assertTrue(loneWithoutSite, "processLine sem posição não reaproveita o local anterior");
+    
+    processor->resetStatistics();
+    assertTrue(processor->getMacroProfiles().empty(), "resetStatistics limpa as medições");
+}
+
 // ============================================================================
 // TESTES DE INTEGRAÇÃO
 // ============================================================================
@@ -595,6 +760,10 @@ int main() {
         testMacroRecursionAndLimits();
         testMacroPerformance();
         testMacroStatistics();
+        testMacroTable();
+        testCompiledMacroTemplates();
+        testMacroCacheLRU();
+        testMacroProfiling();
         testMacroIntegration();
         
         std::cout << "\n=== RESUMO FINAL ===" << std::endl;
@@ -612,6 +781,9 @@ int main() {
         std::cout << "✅ Testes de Recursão/Limites: Concluído" << std::endl;
         std::cout << "✅ Testes de Performance: Concluído" << std::endl;
         std::cout << "✅ Testes de Estatísticas: Concluído" << std::endl;
+        std::cout << "✅ Testes de Tabela de Macros: Concluído" << std::endl;
+        std::cout << "✅ Testes de Templates Pré-compilados: Concluído" << std::endl;
+        std::cout << "✅ Testes de Cache LRU: Concluído" << std::endl;
         std::cout << "✅ Testes de Integração: Concluído" << std::endl;
         
         std::cout << "\n🎉 TODOS OS TESTES DE MACROS PASSARAM COM SUCESSO! 🎉" << std::endl;
@@ -1,6 +1,21 @@
 #include "../../include/preprocessor.hpp"
+#include "../../include/line_reader.hpp"
+#include "../../include/preprocessor_lexer_interface.hpp"
+#include "../../include/batch_preprocessor.hpp"
+#include "../../include/preprocessor_server.hpp"
+#include "../../include/binary_format.hpp"
 #include <iostream>
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 int main() {
     try {
@@ -50,10 +65,520 @@ int result = MIN(10, 20);
             std::cout << "\n--- Teste de macro ---\n";
             std::cout << "TEST_MACRO definida: " << (preprocessor.isMacroDefined("TEST_MACRO") ? "Sim" : "Não") << "\n";
             
+            // Transferência do buffer sem cópia
+            std::string taken = preprocessor.takeExpandedCode();
+            if (taken != expanded || !preprocessor.getExpandedCode().empty()) {
+                std::cout << "✗ takeExpandedCode não transferiu o buffer\n";
+                return 1;
+            }
+            std::cout << "✓ Buffer de saída transferido sem cópia\n";
+            
             // Reset do preprocessor
             preprocessor.reset();
             std::cout << "\n✓ Reset do preprocessor realizado\n";
             
+            // Saída em streaming: linhas entregues ao sink, buffer interno vazio
+            std::string streamed;
+            size_t lines = 0;
+            preprocessor.setOutputSink([&](std::string_view chunk) {
+                streamed.append(chunk.data(), chunk.size());
+                lines++;
+            });
+            if (!preprocessor.processString(test_code)) {
+                std::cout << "✗ Falha no processamento com sink\n";
+                return 1;
+            }
+            preprocessor.setOutputSink(nullptr);
+            if (streamed != expanded || !preprocessor.getExpandedCode().empty() ||
+                preprocessor.getOutputSize() != streamed.size() || lines == 0) {
+                std::cout << "✗ Saída em streaming divergente do modo buffer\n";
+                return 1;
+            }
+            std::cout << "✓ Saída em streaming entregue em " << lines << " linhas\n";
+            
+            // Blocos inativos: saltados sem processar diretivas não condicionais
+            preprocessor.reset();
+            std::string skip_code =
+                "int before;\n"
+                "#if 0\n"
+                "int dead1;\n"
+                "  #ifdef ANYTHING\n"
+                "#define DEAD_MACRO 1\n"
+                "  #endif\n"
+                "#error nao deveria disparar\n"
+                "int dead2; /* # no meio da linha */\n"
+                // Continuações de linha: "#endif" e "#else" pertencem à linha anterior
+                "int dead3; \\\n"
+                "#endif\n"
+                "int dead4; \\\r\n"
+                "  #else\n"
+                "#else\n"
+                "int alive;\n"
+                "#endif\n"
+                "int after;";
+            if (!preprocessor.processString(skip_code)) {
+                std::cout << "✗ Falha no processamento de bloco inativo\n";
+                return 1;
+            }
+            std::string skipped = preprocessor.getExpandedCode();
+            size_t newline_count = static_cast<size_t>(std::count(skipped.begin(), skipped.end(), '\n'));
+            if (skipped.find("dead") != std::string::npos || skipped.find("alive") == std::string::npos ||
+                skipped.find("after") == std::string::npos || newline_count != 16 ||
+                preprocessor.isMacroDefined("DEAD_MACRO")) {
+                std::cout << "✗ Bloco inativo processado incorretamente\n";
+                return 1;
+            }
+            std::cout << "✓ Bloco condicional inativo saltado preservando numeração\n";
+            
+            // Snapshot do prelúdio: macros salvas em disco e restauradas em outra instância
+            preprocessor.reset();
+            const std::string snapshot_path = "test_preprocessor_snapshot.pps";
+            if (!preprocessor.processString("#define PRELUDE_SIZE 64\n#define SQUARE(x) ((x) * (x))\n") ||
+                !preprocessor.saveSnapshot(snapshot_path)) {
+                std::cout << "✗ Falha ao salvar snapshot\n";
+                return 1;
+            }
+            Preprocessor::PreprocessorMain restored("");
+            if (!restored.loadSnapshot(snapshot_path) || !restored.isMacroDefined("PRELUDE_SIZE") ||
+                !restored.processString("int v = SQUARE(PRELUDE_SIZE);")) {
+                std::cout << "✗ Falha ao restaurar snapshot\n";
+                std::remove(snapshot_path.c_str());
+                return 1;
+            }
+            if (restored.getExpandedCode().find("((64) * (64))") == std::string::npos) {
+                std::cout << "✗ Macro restaurada expandida incorretamente\n";
+                std::remove(snapshot_path.c_str());
+                return 1;
+            }
+            {
+                std::fstream corrupt(snapshot_path, std::ios::in | std::ios::out | std::ios::binary);
+                corrupt.seekp(12);
+                corrupt.put('\x7f');
+            }
+            Preprocessor::PreprocessorMain rejected("");
+            bool corrupt_loaded = rejected.loadSnapshot(snapshot_path);
+            std::remove(snapshot_path.c_str());
+            if (corrupt_loaded || rejected.isMacroDefined("PRELUDE_SIZE")) {
+                std::cout << "✗ Snapshot corrompido aceito\n";
+                return 1;
+            }
+            std::cout << "✓ Snapshot de macros salvo, restaurado e validado\n";
+            
+            // Cache de saída: nova execução sobre o mesmo arquivo vem do disco
+            const std::string cache_source = "test_preprocessor_cache_input.c";
+            const std::string cache_dir = "test_preprocessor_output_cache";
+            {
+                std::ofstream source(cache_source);
+                source << "#define CACHED_VALUE 7\nint cached = CACHED_VALUE;\n";
+            }
+            Preprocessor::PreprocessorMain first_pp("");
+            first_pp.setOutputCacheDirectory(cache_dir);
+            bool first_ok = first_pp.process(cache_source);
+            std::string first_output = first_pp.getExpandedCode();
+            Preprocessor::PreprocessorMain cached_pp("");
+            cached_pp.setOutputCacheDirectory(cache_dir);
+            bool second_ok = cached_pp.process(cache_source);
+            std::string second_output = cached_pp.getExpandedCode();
+            Preprocessor::OutputCacheStats cache_stats = cached_pp.getOutputCacheStatistics();
+            bool cache_hit_ok = first_ok && second_ok && first_output == second_output &&
+                                cache_stats.hits == 1 && cache_stats.stores == 0 &&
+                                cached_pp.isMacroDefined("CACHED_VALUE") &&
+                                !cached_pp.getLineMap().empty();
+            {
+                std::ofstream source(cache_source);
+                source << "#define CACHED_VALUE 8\nint cached = CACHED_VALUE;\n";
+            }
+            Preprocessor::PreprocessorMain changed_pp("");
+            changed_pp.setOutputCacheDirectory(cache_dir);
+            bool changed_ok = changed_pp.process(cache_source) &&
+                              changed_pp.getExpandedCode().find("8") != std::string::npos &&
+                              changed_pp.getOutputCacheStatistics().hits == 0;
+            std::remove(cache_source.c_str());
+            std::error_code cleanup_error;
+            std::filesystem::remove_all(cache_dir, cleanup_error);
+            if (cleanup_error) {
+                std::cout << "Aviso: diretório de cache não removido\n";
+            }
+            if (!cache_hit_ok || !changed_ok) {
+                std::cout << "✗ Cache de saída inconsistente\n";
+                return 1;
+            }
+            std::cout << "✓ Cache de saída reaproveitado e invalidado por conteúdo\n";
+            
+            // Escritores concorrentes do mesmo destino: cada um com seu temporário
+            const std::string shared_dir = "test_preprocessor_shared_writes";
+            const std::string shared_target = shared_dir + "/entry.bin";
+            std::filesystem::create_directories(shared_dir);
+            {
+                std::ofstream user_file(shared_target + ".tmp");
+                user_file << "arquivo do usuário";
+            }
+            std::vector<std::string> payloads;
+            for (int i = 0; i < 4; ++i) {
+                payloads.push_back(std::string(64 * 1024, static_cast<char>('a' + i)));
+            }
+            std::atomic<int> write_failures{0};
+            {
+                std::vector<std::thread> writers;
+                for (int i = 0; i < 4; ++i) {
+                    writers.emplace_back([&, i]() {
+                        for (int round = 0; round < 25; ++round) {
+                            if (!Preprocessor::BinaryFormat::writeFileAtomically(shared_target, payloads[i])) {
+                                write_failures++;
+                            }
+                        }
+                    });
+                }
+                for (auto& writer : writers) {
+                    writer.join();
+                }
+            }
+            std::string final_content;
+            {
+                std::ifstream final_file(shared_target, std::ios::binary);
+                final_content.assign(std::istreambuf_iterator<char>(final_file), std::istreambuf_iterator<char>());
+            }
+            std::string user_content;
+            {
+                std::ifstream user_file(shared_target + ".tmp");
+                std::getline(user_file, user_content);
+            }
+            size_t shared_entries = static_cast<size_t>(std::distance(std::filesystem::directory_iterator(shared_dir),
+                                                                      std::filesystem::directory_iterator()));
+            std::filesystem::remove_all(shared_dir, cleanup_error);
+            if (write_failures != 0 || user_content != "arquivo do usuário" || shared_entries != 2 ||
+                std::find(payloads.begin(), payloads.end(), final_content) == payloads.end()) {
+                std::cout << "✗ Escritas concorrentes corromperam o destino\n";
+                return 1;
+            }
+            std::cout << "✓ Escritas concorrentes usam temporários exclusivos\n";
+
+            // Perfil FAST: mesma saída, sem as verificações de diagnóstico
+            const std::string profile_source = "test_preprocessor_profile_input.c";
+            {
+                std::ofstream source(profile_source);
+                source << "#define LIMIT 10\n#ifdef LIMIT\nint limit = LIMIT;\n#endif\n";
+            }
+            Preprocessor::PreprocessorMain checked_pp("");
+            bool checked_ok = checked_pp.process(profile_source);
+            Preprocessor::PreprocessorMain fast_pp("");
+            fast_pp.setProcessingProfile(Preprocessor::ProcessingProfile::FAST);
+            bool fast_ok = fast_pp.process(profile_source);
+            Preprocessor::PreprocessorMain unbalanced_pp("");
+            unbalanced_pp.setProcessingProfile(Preprocessor::ProcessingProfile::FAST);
+            bool unbalanced_ok = unbalanced_pp.processString("#ifdef LIMIT\nint x;\n") &&
+                                 unbalanced_pp.process(profile_source);
+            std::remove(profile_source.c_str());
+            const Preprocessor::ConsistencyCheckStats& checked_costs = checked_pp.getConsistencyCheckStatistics();
+            const Preprocessor::ConsistencyCheckStats& fast_costs = fast_pp.getConsistencyCheckStatistics();
+            if (!checked_ok || !fast_ok || !unbalanced_ok ||
+                checked_pp.getExpandedCode() != fast_pp.getExpandedCode() ||
+                checked_costs.input_validation.runs != 1 || checked_costs.synchronization.runs != 1 ||
+                checked_costs.output_validation.runs == 0 || checked_costs.integrity_check.runs != 1 ||
+                fast_costs.input_validation.runs != 0 || fast_costs.synchronization.runs != 0 ||
+                fast_costs.output_validation.runs != 0 || fast_costs.report.runs != 0 ||
+                fast_costs.integrity_check.runs != 1) {
+                std::cout << "✗ Perfil de desempenho inconsistente\n";
+                return 1;
+            }
+            std::cout << "✓ Perfil FAST omite verificações de diagnóstico com saída idêntica\n";
+
+            // Emenda de linhas terminadas por barra invertida
+            const std::string splice_source = "test_preprocessor_splice_input.c";
+            {
+                std::ofstream source(splice_source);
+                source << "#define SUM(a, b) \\\n    ((a) + \\\n     (b))\nint s = SUM(1, 2);\nint after;\n";
+            }
+            Preprocessor::PreprocessorMain splice_pp("");
+            bool splice_ok = splice_pp.process(splice_source);
+            std::remove(splice_source.c_str());
+            std::string spliced = splice_pp.getExpandedCode();
+            size_t after_pos = spliced.find("int after;");
+            size_t lines_before_after = after_pos == std::string::npos ? 0 :
+                static_cast<size_t>(std::count(spliced.begin(), spliced.begin() + after_pos, '\n'));
+            Preprocessor::LineReader reader("ab\\\ncd\\\r\nef\ngh");
+            std::string_view logical;
+            int line_offset = 0;
+            size_t physical_column = 0;
+            bool reader_ok = reader.next(logical) && logical == "abcdef" && reader.physicalLineCount() == 3;
+            reader.physicalPosition(5, line_offset, physical_column);
+            reader_ok = reader_ok && line_offset == 2 && physical_column == 1 &&
+                        reader.next(logical) && logical == "gh" && !reader.wasSpliced() &&
+                        !reader.next(logical);
+            if (!splice_ok || spliced.find("(1)") == std::string::npos ||
+                spliced.find("(2)") == std::string::npos || lines_before_after != 4 || !reader_ok) {
+                std::cout << "✗ Emenda de linhas incorreta\n";
+                return 1;
+            }
+            std::cout << "✓ Linhas com continuação emendadas preservando numeração\n";
+
+            // Colunas após a emenda mapeiam para a linha e coluna físicas
+            Preprocessor::PreprocessorLexerInterface splice_interface;
+            splice_interface.initialize(Preprocessor::PreprocessorConfig());
+            const std::string splice_map_source = "test_preprocessor_splice_map.c";
+            {
+                std::ofstream source(splice_map_source);
+                source << "int t = 1 + \\\n    2;\nint u;\n";
+            }
+            auto splice_result = splice_interface.processFile(splice_map_source);
+            std::remove(splice_map_source.c_str());
+            uint32_t splice_line = 0, splice_column = 0;
+            const std::string* splice_file = nullptr;
+            Preprocessor::PreprocessorMain splice_map_pp("");
+            bool splice_map_ok = splice_map_pp.processString("int t = 1 + \\\n    2;\nint u;\n") &&
+                splice_map_pp.getLineMap().lookup(1, 17, splice_line, splice_column, splice_file) &&
+                splice_line == 2 && splice_column == 5 &&
+                splice_map_pp.getLineMap().lookup(1, 5, splice_line, splice_column, splice_file) &&
+                splice_line == 1 && splice_column == 5;
+            size_t mapped_line = 0, mapped_column = 0;
+            std::string mapped_file;
+            splice_map_ok = splice_map_ok && !splice_result.hasErrors &&
+                splice_interface.getPositionMapper().mapToOriginal(1, 17, mapped_line, mapped_column, mapped_file) &&
+                mapped_line == 2 && mapped_column == 5 &&
+                splice_interface.getPositionMapper().mapToOriginal(3, 1, mapped_line, mapped_column, mapped_file) &&
+                mapped_line == 3 && mapped_column == 1;
+            if (!splice_map_ok) {
+                std::cout << "✗ Posições após emenda mapeadas incorretamente\n";
+                return 1;
+            }
+            std::cout << "✓ Colunas após emenda mapeadas para a linha física\n";
+
+            // Lote de unidades em paralelo sobre um FileManager compartilhado
+            std::vector<std::string> batch_files;
+            for (int i = 0; i < 6; ++i) {
+                std::string unit = "test_preprocessor_batch_" + std::to_string(i) + ".c";
+                std::ofstream source(unit);
+                source << "#define UNIT_ID " << i << "\nint unit = UNIT_ID * SCALE;\n";
+                batch_files.push_back(unit);
+            }
+            Preprocessor::BatchOptions batch_options;
+            batch_options.worker_count = 3;
+            batch_options.macros["SCALE"] = "10";
+            Preprocessor::BatchPreprocessor batch(batch_options);
+            std::vector<Preprocessor::BatchUnitResult> first_run = batch.process(batch_files);
+            std::vector<Preprocessor::BatchUnitResult> second_run = batch.process(batch_files);
+            bool batch_ok = first_run.size() == batch_files.size() && second_run.size() == batch_files.size();
+            for (size_t i = 0; batch_ok && i < batch_files.size(); ++i) {
+                std::string expected = "int unit = " + std::to_string(i) + " * 10;";
+                batch_ok = first_run[i].success && second_run[i].success &&
+                           first_run[i].filename == batch_files[i] &&
+                           first_run[i].expanded_code.find(expected) != std::string::npos &&
+                           second_run[i].expanded_code == first_run[i].expanded_code;
+            }
+            Preprocessor::FileStats batch_stats = batch.getFileManager()->getStatistics();
+            for (const auto& unit : batch_files) {
+                std::remove(unit.c_str());
+            }
+            if (!batch_ok || batch_stats.cache_hits < batch_files.size()) {
+                std::cout << "✗ Pré-processamento em lote inconsistente\n";
+                return 1;
+            }
+            std::cout << "✓ Lote processado em " << batch.getWorkerCount() << " threads com cache compartilhado\n";
+
+            // Servidor com caches aquecidos: estado de uma requisição não vaza para a próxima
+            {
+                std::ofstream header("test_preprocessor_server.h");
+                header << "#ifndef SERVER_H\n#define SERVER_H\n#define SERVER_VALUE 1\n#endif\n";
+                std::ofstream first("test_preprocessor_server_a.c");
+                first << "#include \"test_preprocessor_server.h\"\n#define LEAK 1\nint a = SCALE;\n";
+                std::ofstream second("test_preprocessor_server_b.c");
+                second << "#include \"test_preprocessor_server.h\"\n#ifdef LEAK\nint leaked;\n#endif\nint b;\n";
+            }
+            const std::string socket_path = "/tmp/test_preprocessor_server_" + std::to_string(getpid()) + ".sock";
+            Preprocessor::ServerOptions server_options;
+            server_options.socket_path = socket_path;
+            server_options.worker_count = 2;
+            server_options.include_paths = {"."};
+            Preprocessor::PreprocessorServer server(server_options);
+            bool server_ok = server.start();
+            std::thread server_thread([&server]() { server.serve(); });
+
+            Preprocessor::ServerRequest server_request;
+            Preprocessor::ServerResponse first_response, second_response, repeat_response, stats_response, stop_response;
+            server_request.filename = std::filesystem::absolute("test_preprocessor_server_a.c").string();
+            server_request.macros.emplace_back("SCALE", "2");
+            server_ok = server_ok && Preprocessor::sendServerRequest(socket_path, server_request, first_response);
+            server_request.filename = std::filesystem::absolute("test_preprocessor_server_b.c").string();
+            server_request.macros.clear();
+            server_ok = server_ok && Preprocessor::sendServerRequest(socket_path, server_request, second_response);
+            server_request.filename = std::filesystem::absolute("test_preprocessor_server_a.c").string();
+            server_request.macros.emplace_back("SCALE", "3");
+            server_ok = server_ok && Preprocessor::sendServerRequest(socket_path, server_request, repeat_response);
+            server_request.type = Preprocessor::ServerRequestType::STATISTICS;
+            server_ok = server_ok && Preprocessor::sendServerRequest(socket_path, server_request, stats_response);
+            // Cliente conectado e ocioso: o encerramento não pode esperar por ele
+            int idle_client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un idle_address{};
+            idle_address.sun_family = AF_UNIX;
+            std::snprintf(idle_address.sun_path, sizeof(idle_address.sun_path), "%s", socket_path.c_str());
+            server_ok = server_ok &&
+                ::connect(idle_client, reinterpret_cast<sockaddr*>(&idle_address), sizeof(idle_address)) == 0;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            server_request.type = Preprocessor::ServerRequestType::SHUTDOWN;
+            server_ok = Preprocessor::sendServerRequest(socket_path, server_request, stop_response) && server_ok;
+            if (!server_ok) {
+                server.stop();
+            }
+            server_thread.join();
+            ::close(idle_client);
+            
+            // Caminho ocupado por um arquivo comum: o servidor recusa e o arquivo é preservado
+            const std::string occupied_path = "test_preprocessor_server_occupied.c";
+            {
+                std::ofstream occupied(occupied_path);
+                occupied << "int keep;\n";
+            }
+            Preprocessor::ServerOptions occupied_options;
+            occupied_options.socket_path = occupied_path;
+            bool occupied_started = Preprocessor::PreprocessorServer(occupied_options).start();
+            std::ifstream occupied_file(occupied_path);
+            std::string occupied_text((std::istreambuf_iterator<char>(occupied_file)), std::istreambuf_iterator<char>());
+            std::remove(occupied_path.c_str());
+            server_ok = server_ok && !occupied_started && occupied_text == "int keep;\n";
+            for (const char* file : {"test_preprocessor_server.h", "test_preprocessor_server_a.c",
+                                     "test_preprocessor_server_b.c"}) {
+                std::remove(file);
+            }
+
+            server_ok = server_ok && first_response.success && second_response.success && repeat_response.success &&
+                        first_response.expanded_code.find("int a = 2;") != std::string::npos &&
+                        repeat_response.expanded_code.find("int a = 3;") != std::string::npos &&
+                        second_response.expanded_code.find("leaked") == std::string::npos &&
+                        !second_response.dependencies.empty() &&
+                        stats_response.message.find("\"requests\":4") != std::string::npos &&
+                        server.getFileManager()->getStatistics().cache_hits >= 1 &&
+                        stop_response.success && server.getRequestCount() == 5;
+            if (!server_ok) {
+                std::cout << "✗ Servidor de pré-processamento inconsistente\n";
+                return 1;
+            }
+            std::cout << "✓ Servidor atendeu requisições pelo socket com caches compartilhados\n";
+
+            // Reprocessamento incremental guiado pelo grafo de dependências
+            const std::filesystem::path incremental_dir = "test_preprocessor_incremental";
+            std::filesystem::create_directories(incremental_dir / "src");
+            {
+                std::ofstream header(incremental_dir / "src" / "shared.h");
+                header << "#define SHARED 1\n";
+                std::ofstream with_header(incremental_dir / "src" / "uses_header.c");
+                with_header << "#include \"shared.h\"\nint x = MODE;\n";
+                std::ofstream standalone(incremental_dir / "src" / "standalone.c");
+                standalone << "int y = 2;\n";
+            }
+            const std::vector<std::string> incremental_units = {
+                (incremental_dir / "src" / "uses_header.c").string(),
+                (incremental_dir / "src" / "standalone.c").string()
+            };
+            Preprocessor::BatchOptions incremental_options;
+            incremental_options.worker_count = 2;
+            incremental_options.output_directory = (incremental_dir / "out").string();
+            incremental_options.dependency_graph_file = (incremental_dir / "out" / "deps.ppdg").string();
+            incremental_options.macros["MODE"] = "1";
+            auto run_incremental = [&]() {
+                Preprocessor::BatchPreprocessor incremental_batch(incremental_options);
+                std::vector<bool> reprocessed;
+                for (const auto& result : incremental_batch.process(incremental_units)) {
+                    reprocessed.push_back(result.success && !result.up_to_date);
+                }
+                return reprocessed;
+            };
+            std::vector<bool> cold_run = run_incremental();
+            std::vector<bool> warm_run = run_incremental();
+            {
+                std::ofstream header(incremental_dir / "src" / "shared.h", std::ios::app);
+                header << "#define SHARED_CHANGED 1\n";
+            }
+            std::vector<bool> header_run = run_incremental();
+            incremental_options.macros["MODE"] = "2";
+            std::vector<bool> macro_run = run_incremental();
+            std::ifstream depfile(incremental_dir / "out" / incremental_dir / "src" / "uses_header.d");
+            std::string depfile_text((std::istreambuf_iterator<char>(depfile)), std::istreambuf_iterator<char>());
+            std::ifstream output(incremental_dir / "out" / incremental_dir / "src" / "uses_header.i");
+            std::string output_text((std::istreambuf_iterator<char>(output)), std::istreambuf_iterator<char>());
+            std::filesystem::remove_all(incremental_dir);
+
+            if (cold_run != std::vector<bool>{true, true} || warm_run != std::vector<bool>{false, false} ||
+                header_run != std::vector<bool>{true, false} || macro_run != std::vector<bool>{true, false} ||
+                depfile_text.find("shared.h") == std::string::npos ||
+                output_text.find("int x = 2;") == std::string::npos) {
+                std::cout << "✗ Reprocessamento incremental inconsistente\n";
+                return 1;
+            }
+            std::cout << "✓ Apenas unidades com entradas alteradas foram reprocessadas\n";
+
+            // Homônimos em diretórios diferentes (caminhos absolutos) têm saídas distintas;
+            // duas unidades com a mesma saída cancelam o lote
+            const std::filesystem::path homonym_dir =
+                std::filesystem::absolute("test_preprocessor_homonyms");
+            std::filesystem::create_directories(homonym_dir / "a");
+            std::filesystem::create_directories(homonym_dir / "b");
+            {
+                std::ofstream(homonym_dir / "a" / "util.c") << "int from_a;\n";
+                std::ofstream(homonym_dir / "b" / "util.c") << "int from_b;\n";
+                std::ofstream(homonym_dir / "a" / "util.h") << "int header;\n";
+            }
+            Preprocessor::BatchOptions homonym_options;
+            homonym_options.output_directory = (homonym_dir / "out").string();
+            homonym_options.source_root = homonym_dir.string();
+            homonym_options.dependency_graph_file = (homonym_dir / "out" / "deps.ppdg").string();
+            auto homonym_results = Preprocessor::BatchPreprocessor(homonym_options).process(
+                {(homonym_dir / "a" / "util.c").string(), (homonym_dir / "b" / "util.c").string()});
+            std::ifstream from_a(homonym_dir / "out" / "a" / "util.i");
+            std::string from_a_text((std::istreambuf_iterator<char>(from_a)), std::istreambuf_iterator<char>());
+            auto conflict_results = Preprocessor::BatchPreprocessor(homonym_options).process(
+                {(homonym_dir / "a" / "util.c").string(), (homonym_dir / "a" / "util.h").string()});
+            std::filesystem::remove_all(homonym_dir);
+
+            if (homonym_results.size() != 2 || !homonym_results[0].success || !homonym_results[1].success ||
+                homonym_results[0].output_file == homonym_results[1].output_file ||
+                from_a_text.find("int from_a;") == std::string::npos ||
+                conflict_results[0].success || conflict_results[1].success ||
+                conflict_results[1].error.find("util.c") == std::string::npos) {
+                std::cout << "✗ Saídas de unidades homônimas em conflito\n";
+                return 1;
+            }
+            std::cout << "✓ Unidades homônimas gravam saídas distintas e conflitos cancelam o lote\n";
+
+            // Dependências negativas: cabeçalho criado depois ou que passa a ter precedência
+            const std::filesystem::path negative_dir = "test_preprocessor_negative";
+            std::filesystem::create_directories(negative_dir / "src");
+            std::filesystem::create_directories(negative_dir / "first");
+            std::filesystem::create_directories(negative_dir / "second");
+            {
+                std::ofstream(negative_dir / "src" / "missing.c") << "#include \"late.h\"\nint m;\n";
+                std::ofstream(negative_dir / "src" / "shadowed.c") << "#include \"shadow.h\"\nint s;\n";
+                std::ofstream(negative_dir / "second" / "shadow.h") << "#define SHADOW 2\n";
+            }
+            Preprocessor::BatchOptions negative_options;
+            negative_options.output_directory = (negative_dir / "out").string();
+            negative_options.dependency_graph_file = (negative_dir / "out" / "deps.ppdg").string();
+            negative_options.include_paths = {(negative_dir / "first").string(), (negative_dir / "second").string()};
+            const std::vector<std::string> negative_units = {
+                (negative_dir / "src" / "missing.c").string(),
+                (negative_dir / "src" / "shadowed.c").string()
+            };
+            auto run_negative = [&]() {
+                std::vector<bool> reprocessed;
+                for (const auto& result : Preprocessor::BatchPreprocessor(negative_options).process(negative_units)) {
+                    reprocessed.push_back(result.success && !result.up_to_date);
+                }
+                return reprocessed;
+            };
+            run_negative();
+            std::vector<bool> negative_warm = run_negative();
+            std::ofstream(negative_dir / "second" / "late.h") << "int late;\n";
+            std::vector<bool> late_run = run_negative();
+            std::ofstream(negative_dir / "first" / "shadow.h") << "#define SHADOW 1\n";
+            std::vector<bool> shadow_run = run_negative();
+            std::filesystem::remove_all(negative_dir);
+
+            if (negative_warm != std::vector<bool>{false, false} || late_run != std::vector<bool>{true, false} ||
+                shadow_run != std::vector<bool>{false, true}) {
+                std::cout << "✗ Dependências negativas ignoradas\n";
+                return 1;
+            }
+            std::cout << "✓ Cabeçalhos criados ou com precedência nova forçam reprocessamento\n";
+
         } else {
             std::cout << "✗ Falha no processamento de string\n";
             return 1;
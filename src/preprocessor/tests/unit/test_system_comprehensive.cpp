@@ -6,6 +6,7 @@
 #include "../../include/file_manager.hpp"
 #include "../../include/preprocessor_logger.hpp"
 #include "../../include/preprocessor_state.hpp"
+#include "../../include/block_codec.hpp"
 #include <iostream>
 #include <cassert>
 #include <vector>
@@ -13,6 +14,12 @@
 #include <fstream>
 #include <cstdio>
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace Preprocessor;
 
@@ -183,6 +190,425 @@ void testFileOperations() {
     }
 }
 
+void testFileContentHash() {
+    std::cout << "\n=== Testando Hash de Conteúdo de Arquivos ===" << std::endl;
+    
+    auto logger = std::make_shared<PreprocessorLogger>();
+    FileManager manager({"/tmp"}, logger.get());
+    
+    std::string testFile = "/tmp/test_file_manager_hash.h";
+    {
+        std::ofstream file(testFile, std::ios::binary);
+        file << "abc";
+    }
+    // Data de modificação no passado: o hash pode ser memorizado
+    struct timeval old_times[2] = {{1000000000, 0}, {1000000000, 0}};
+    utimes(testFile.c_str(), old_times);
+    
+    std::string hash = manager.calculateFileHash(testFile);
+    assertEqual(std::string("44bc2cf5ad770999"), hash, "Hash XXH64 de \"abc\"");
+    assertEqual(hash, manager.calculateFileHash(testFile), "Hash estável para arquivo inalterado");
+    FileStats stats = manager.getStatistics();
+    assertEqual(static_cast<size_t>(1), stats.hashes_computed, "Conteúdo lido uma única vez");
+    assertTrue(stats.hash_memo_hits >= 1, "Hash reaproveitado pela identidade do arquivo");
+    
+    // Mesmo tamanho, conteúdo e data diferentes: o hash deve ser recalculado
+    {
+        std::ofstream file(testFile, std::ios::binary);
+        file << "abd";
+    }
+    struct timeval new_times[2] = {{1000000100, 0}, {1000000100, 0}};
+    utimes(testFile.c_str(), new_times);
+    assertFalse(manager.verifyFileIntegrity(testFile, hash), "Integridade detecta alteração do conteúdo");
+    
+    std::remove(testFile.c_str());
+}
+
+void testFileViews() {
+    std::cout << "\n=== Testando Visões de Arquivo ===" << std::endl;
+    
+    auto logger = std::make_shared<PreprocessorLogger>();
+    FileManager manager({"/tmp"}, logger.get());
+    
+    std::string largeFile = "/tmp/test_file_manager_view.h";
+    std::string largeContent;
+    for (int i = 0; i < 8000; ++i) {
+        largeContent += "int value_" + std::to_string(i) + ";\n";
+    }
+    {
+        std::ofstream file(largeFile, std::ios::binary);
+        file << largeContent;
+    }
+    
+    FileView first = manager.openFileView(largeFile);
+    FileView second = manager.openFileView(largeFile);
+    assertTrue(first.valid() && first.isMapped(), "Arquivo grande mapeado em memória");
+    assertTrue(first.view() == largeContent, "Conteúdo da visão igual ao arquivo");
+    assertTrue(first.data() == second.data(), "Visões compartilham o mesmo conteúdo");
+    assertEqual(static_cast<size_t>(1), manager.getStatistics().files_read, "Arquivo lido uma única vez");
+    assertTrue(manager.readFile(largeFile) == largeContent, "readFile servido pela visão em cache");
+    
+    // Truncado no mesmo segundo: a visão mapeada em cache não pode ser servida
+    std::string truncated = largeContent.substr(0, largeContent.size() / 2);
+    {
+        std::ofstream file(largeFile, std::ios::binary | std::ios::trunc);
+        file << truncated;
+    }
+    FileView reopened = manager.openFileView(largeFile);
+    assertTrue(reopened.view() == truncated, "Arquivo mapeado truncado é relido");
+    assertTrue(!reopened.isMapped(), "Arquivo médio copiado para o heap no cache");
+    
+    std::string smallFile = "/tmp/test_file_manager_view_small.h";
+    {
+        std::ofstream file(smallFile, std::ios::binary);
+        file << "#define SMALL 1\n";
+    }
+    FileView small = manager.openFileView(smallFile);
+    assertTrue(small.valid() && !small.isMapped(), "Arquivo pequeno lido para o heap");
+    
+    assertFalse(manager.openFileView("/tmp/arquivo_inexistente_view.h").valid(), "Arquivo inexistente gera visão inválida");
+    
+    // A visão continua válida depois que o arquivo é removido
+    std::remove(largeFile.c_str());
+    std::remove(smallFile.c_str());
+    assertEqual(largeContent.size(), first.size(), "Visão sobrevive à remoção do arquivo");
+}
+
+void testFileCompression() {
+    std::cout << "\n=== Testando Compressão de Arquivos ===" << std::endl;
+    
+    auto logger = std::make_shared<PreprocessorLogger>();
+    FileManager manager({"/tmp"}, logger.get());
+    
+    // Mais de um bloco, com repetições (comprime) e um trecho pseudoaleatório (não comprime)
+    std::string content;
+    for (int i = 0; i < 6000; ++i) {
+        content += "#define VALUE_" + std::to_string(i % 97) + " (" + std::to_string(i) + ")\n";
+    }
+    uint32_t seed = 12345;
+    for (int i = 0; i < 70000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        content.push_back(static_cast<char>(seed >> 24));
+    }
+    
+    std::string frame = BlockCodec::compress(content);
+    std::string decoded;
+    assertTrue(BlockCodec::decompress(frame.data(), frame.size(), decoded) && decoded == content,
+               "Quadro em memória preserva o conteúdo");
+    std::string empty_frame = BlockCodec::compress("", 0);
+    assertTrue(BlockCodec::decompress(empty_frame.data(), empty_frame.size(), decoded) && decoded.empty(),
+               "Quadro vazio");
+    assertFalse(BlockCodec::decompress(frame.data(), frame.size() - 1, decoded), "Quadro truncado rejeitado");
+    
+    std::string original = "/tmp/test_file_manager_compress.h";
+    std::string compressed = original + ".ppz";
+    std::string restored = "/tmp/test_file_manager_compress_restored.h";
+    {
+        std::ofstream file(original, std::ios::binary);
+        file << content;
+    }
+    
+    assertTrue(manager.compressFile(original), "Arquivo comprimido");
+    struct stat compressed_info;
+    stat(compressed.c_str(), &compressed_info);
+    assertTrue(static_cast<size_t>(compressed_info.st_size) < content.size(), "Arquivo comprimido é menor");
+    assertTrue(manager.decompressFile(compressed, restored), "Arquivo descomprimido");
+    assertTrue(manager.readFile(restored) == content, "Conteúdo restaurado igual ao original");
+    
+    // Saída igual à entrada (mesmo caminho ou link) é recusada sem tocar no original
+    std::string alias = "/tmp/test_file_manager_compress_alias.h";
+    std::remove(alias.c_str());
+    link(original.c_str(), alias.c_str());
+    assertFalse(manager.compressFile(original, original), "Compressão sobre o próprio arquivo recusada");
+    assertFalse(manager.compressFile(original, alias), "Compressão sobre link do arquivo recusada");
+    {
+        std::ifstream file(original, std::ios::binary);
+        std::string on_disk((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        assertTrue(on_disk == content, "Original intacto após recusa");
+    }
+    std::remove(alias.c_str());
+    
+    // Descompressão sobre o próprio arquivo comprimido (mesmo caminho ou link) é recusada
+    link(compressed.c_str(), alias.c_str());
+    assertFalse(manager.decompressFile(compressed, compressed), "Descompressão sobre o próprio arquivo recusada");
+    assertFalse(manager.decompressFile(compressed, alias), "Descompressão sobre link do arquivo recusada");
+    std::remove(alias.c_str());
+    
+    // Destino padrão remove só ".ppz"; um arquivo "<destino>.tmp" do usuário não é tocado
+    std::string user_temp = original + ".tmp";
+    {
+        std::ofstream file(user_temp);
+        file << "temporário do usuário";
+    }
+    assertTrue(manager.decompressFile(compressed), "Descompressão para o destino padrão");
+    assertTrue(manager.readFile(original) == content, "Destino padrão é o arquivo sem .ppz");
+    assertTrue(manager.readFile(user_temp) == "temporário do usuário", "Arquivo .tmp do usuário intacto");
+    std::remove(user_temp.c_str());
+    
+    // Sem extensão .ppz, o destino é obrigatório: nada é cortado no último '.' do caminho
+    std::string versioned_dir = "/tmp/test_file_manager_decompress";
+    std::filesystem::create_directories(versioned_dir + "/v1.2");
+    std::string unrelated = versioned_dir + "/v1";
+    std::string archive = versioned_dir + "/v1.2/archive";
+    {
+        std::ofstream file(unrelated);
+        file << "não relacionado";
+    }
+    std::filesystem::copy_file(compressed, archive, std::filesystem::copy_options::overwrite_existing);
+    assertFalse(manager.decompressFile(archive), "Destino obrigatório sem extensão .ppz");
+    assertTrue(manager.readFile(unrelated) == "não relacionado", "Arquivo não relacionado intacto");
+    assertTrue(manager.decompressFile(archive, archive + ".h"), "Destino explícito aceito");
+    std::filesystem::remove_all(versioned_dir);
+    
+    // Um byte alterado no meio do quadro é detectado e não deixa saída
+    {
+        std::fstream file(compressed, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(compressed_info.st_size / 2);
+        file.put('\x5A');
+    }
+    std::remove(restored.c_str());
+    assertFalse(manager.decompressFile(compressed, restored), "Quadro corrompido rejeitado");
+    assertFalse(manager.fileExists(restored), "Nenhuma saída parcial após falha");
+    
+    // Cache em memória comprimido: conteúdo em heap servido igual ao arquivo
+    FileManager compressing({"/tmp"}, logger.get());
+    compressing.configureCacheOptimization(50 * 1024 * 1024, 1000, std::chrono::seconds(300), true);
+    std::string small = "/tmp/test_file_manager_compress_small.h";
+    std::string small_content = content.substr(0, 3000);
+    {
+        std::ofstream file(small, std::ios::binary);
+        file << small_content;
+    }
+    assertTrue(compressing.readFile(small) == small_content, "Primeira leitura com cache comprimido");
+    assertTrue(compressing.readFile(small) == small_content, "Leitura servida pelo cache comprimido");
+    assertEqual(static_cast<size_t>(1), compressing.getStatistics().files_read, "Arquivo lido uma única vez");
+    
+    std::remove(original.c_str());
+    std::remove(compressed.c_str());
+    std::remove(small.c_str());
+}
+
+void testIncludeLookupCaches() {
+    std::cout << "\n=== Testando Caches de Resolução de Inclusões ===" << std::endl;
+    
+    auto logger = std::make_shared<PreprocessorLogger>();
+    std::string dirA = "/tmp/test_fm_lookup_a";
+    std::string dirB = "/tmp/test_fm_lookup_b";
+    ::mkdir(dirA.c_str(), 0755);
+    ::mkdir(dirB.c_str(), 0755);
+    std::string header = dirB + "/lookup.h";
+    {
+        std::ofstream file(header);
+        file << "#define LOOKUP 1\n";
+    }
+    
+    FileManager manager({dirA, dirB}, logger.get());
+    std::string first = manager.resolveInclude("lookup.h", true);
+    std::string second = manager.resolveInclude("lookup.h", true);
+    assertEqual(first, second, "Resolução repetida retorna o mesmo caminho");
+    assertEqual(static_cast<size_t>(1), manager.getStatistics().resolution_cache_hits, "Segunda resolução servida pelo memo");
+    
+    int failures = 0;
+    for (int i = 0; i < 2; ++i) {
+        try {
+            manager.resolveInclude("late.h", true);
+        } catch (const std::runtime_error&) {
+            failures++;
+        }
+    }
+    assertEqual(2, failures, "Inclusão ausente falha também pelo resultado negativo");
+    
+    // Arquivo criado depois da falha só é visto após invalidar os caches
+    std::string late = dirA + "/late.h";
+    {
+        std::ofstream file(late);
+        file << "#define LATE 1\n";
+    }
+    manager.clearLookupCaches();
+    bool found = false;
+    try {
+        found = manager.resolveInclude("late.h", true).find("late.h") != std::string::npos;
+    } catch (const std::runtime_error&) {
+    }
+    assertTrue(found, "Arquivo novo encontrado após clearLookupCaches");
+    
+    // Inclusão local sem arquivo atual percorre os mesmos caminhos já sondados
+    manager.clearLookupCaches();
+    manager.resolveInclude("lookup.h", true);
+    manager.resolveInclude("lookup.h", false);
+    assertTrue(manager.getStatistics().stat_cache_hits > 0, "Resultados de stat reaproveitados");
+    
+    std::remove(header.c_str());
+    std::remove(late.c_str());
+    ::rmdir(dirA.c_str());
+    ::rmdir(dirB.c_str());
+}
+
+void testDirectoryListingMode() {
+    std::cout << "\n=== Testando Resolução por Listagem de Diretórios ===" << std::endl;
+    
+    auto logger = std::make_shared<PreprocessorLogger>();
+    std::string dirA = "/tmp/test_fm_listing_a";
+    std::string dirB = "/tmp/test_fm_listing_b";
+    std::string subdir = dirB + "/sys";
+    ::mkdir(dirA.c_str(), 0755);
+    ::mkdir(dirB.c_str(), 0755);
+    ::mkdir(subdir.c_str(), 0755);
+    std::string header = dirB + "/listed.h";
+    std::string nested = subdir + "/types.h";
+    {
+        std::ofstream file(header);
+        file << "#define LISTED 1\n";
+    }
+    {
+        std::ofstream file(nested);
+        file << "#define TYPES 1\n";
+    }
+    
+    FileManager manager({dirA, dirB}, logger.get());
+    manager.setDirectoryListingMode(true);
+    assertTrue(manager.isDirectoryListingMode(), "Modo de listagem ativado");
+    
+    assertEqual(header, manager.resolveInclude("listed.h", true), "Arquivo encontrado pela listagem");
+    assertEqual(nested, manager.resolveInclude("sys/types.h", true), "Arquivo em subdiretório encontrado");
+    
+    bool missing = false;
+    try {
+        manager.resolveInclude("absent.h", true);
+    } catch (const std::runtime_error&) {
+        missing = true;
+    }
+    assertTrue(missing, "Arquivo ausente continua gerando erro");
+    
+    // dirA, dirB, dirA/sys (inexistente) e dirB/sys: cada um listado uma vez
+    assertEqual(static_cast<size_t>(4), manager.getStatistics().directories_listed, "Cada diretório listado uma única vez");
+    
+    // Um subdiretório com o nome procurado não é aceito como arquivo
+    bool directoryRejected = false;
+    try {
+        manager.resolveInclude("sys", true);
+    } catch (const std::runtime_error&) {
+        directoryRejected = true;
+    }
+    assertTrue(directoryRejected, "Diretório não é resolvido como inclusão");
+    
+    std::remove(header.c_str());
+    std::remove(nested.c_str());
+    ::rmdir(subdir.c_str());
+    ::rmdir(dirA.c_str());
+    ::rmdir(dirB.c_str());
+}
+
+void testChangeWatching() {
+    std::cout << "\n=== Testando Observação de Mudanças ===" << std::endl;
+    
+    auto logger = std::make_shared<PreprocessorLogger>();
+    std::string dir = "/tmp/test_fm_watch";
+    ::mkdir(dir.c_str(), 0755);
+    std::string header = dir + "/watched.h";
+    {
+        std::ofstream file(header);
+        file << "#define VERSION 1\n";
+    }
+    
+    FileManager manager({dir}, logger.get());
+    if (!manager.enableChangeWatching()) {
+        std::cout << "⚠️  Notificações do sistema indisponíveis, teste ignorado" << std::endl;
+        std::remove(header.c_str());
+        ::rmdir(dir.c_str());
+        return;
+    }
+    assertTrue(manager.isChangeWatchingActive(), "Observação de mudanças ativa");
+    
+    assertTrue(manager.openFileView(header).view() == "#define VERSION 1\n", "Conteúdo inicial lido");
+    
+    // Mesmo tamanho e possivelmente a mesma data: só o evento denuncia a mudança
+    {
+        std::ofstream file(header);
+        file << "#define VERSION 2\n";
+    }
+    assertTrue(manager.processFileSystemEvents() > 0, "Modificação notificada");
+    assertTrue(manager.openFileView(header).view() == "#define VERSION 2\n", "Cache invalidado pela notificação");
+    
+    bool missing = false;
+    try {
+        manager.resolveInclude("later.h", true);
+    } catch (const std::runtime_error&) {
+        missing = true;
+    }
+    assertTrue(missing, "Inclusão ausente antes da criação");
+    
+    std::string later = dir + "/later.h";
+    {
+        std::ofstream file(later);
+        file << "#define LATER 1\n";
+    }
+    bool found = false;
+    try {
+        found = manager.resolveInclude("later.h", true) == later;
+    } catch (const std::runtime_error&) {
+    }
+    assertTrue(found, "Resultado negativo invalidado pela criação do arquivo");
+    assertTrue(manager.getStatistics().change_events > 0, "Eventos contabilizados");
+    
+    std::remove(header.c_str());
+    std::remove(later.c_str());
+    ::rmdir(dir.c_str());
+}
+
+void testConcurrentFileManager() {
+    std::cout << "\n=== Testando FileManager Compartilhado entre Threads ===" << std::endl;
+    
+    std::string dir = "/tmp/test_fm_concurrent";
+    ::mkdir(dir.c_str(), 0755);
+    std::vector<std::string> headers;
+    for (int i = 0; i < 8; ++i) {
+        std::string header = dir + "/shared_" + std::to_string(i) + ".h";
+        std::ofstream file(header);
+        file << "#define SHARED_" << i << " " << i << "\n";
+        headers.push_back(header);
+    }
+    
+    FileManager manager({dir});
+    const int threads_count = 4;
+    const int rounds = 50;
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int round = 0; round < rounds; ++round) {
+                size_t i = static_cast<size_t>(round + t) % headers.size();
+                std::string expected = "#define SHARED_" + std::to_string(i) + " " + std::to_string(i) + "\n";
+                uint64_t hash = 0;
+                try {
+                    if (manager.openFileView(headers[i]).view() != expected ||
+                        manager.resolveInclude("shared_" + std::to_string(i) + ".h", true) != headers[i] ||
+                        !manager.getContentHash(headers[i], hash)) {
+                        failures++;
+                    }
+                } catch (const std::exception&) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    FileStats stats = manager.getStatistics();
+    const size_t total = static_cast<size_t>(threads_count * rounds);
+    assertEqual(0, failures.load(), "Leituras concorrentes consistentes");
+    assertEqual(total, stats.cache_hits + stats.cache_misses, "Nenhuma leitura perdida nas estatísticas");
+    assertTrue(stats.cache_hits >= total - headers.size() * threads_count, "Acertos compartilhados entre threads");
+    assertEqual(total, stats.path_resolutions, "Resoluções contabilizadas");
+    
+    for (const auto& header : headers) {
+        std::remove(header.c_str());
+    }
+    ::rmdir(dir.c_str());
+}
+
 // ============================================================================
 // TESTES DE LOGGER (test_logger.cpp)
 // ============================================================================
@@ -261,6 +687,49 @@ void testLogLevels() {
     }
 }
 
+void testLazyLogging() {
+    std::cout << "\n=== Testando Log Preguiçoso ===" << std::endl;
+    
+    PreprocessorLogger logger(LogLevel::WARNING);
+    logger.enableConsoleOutput(false);
+    
+    int evaluated = 0;
+    auto message = [&evaluated]() {
+        evaluated++;
+        return std::string("mensagem");
+    };
+    PP_LOG_DEBUG(&logger, message());
+    PP_LOG_INFO(&logger, message());
+    assertEqual(0, evaluated, "Mensagens abaixo do nível não são montadas");
+    PP_LOG_WARNING(&logger, message());
+    assertEqual(isLogLevelCompiled(LogLevel::WARNING) ? 1 : 0, evaluated, "Mensagem habilitada é montada");
+    
+    PreprocessorLogger* missing = nullptr;
+    PP_LOG_ERROR(missing, message());
+    assertTrue(!PP_LOG_ENABLED(missing, LogLevel::ERROR), "Logger nulo é ignorado");
+    
+    // Escrita assíncrona: tudo o que foi registrado chega ao arquivo ao desativar
+    std::string logFile = "/tmp/test_logger_async.log";
+    std::remove(logFile.c_str());
+    logger.setOutputFile(logFile);
+    logger.enableAsyncFileWriter();
+    assertTrue(logger.isAsyncFileWriterEnabled(), "Escrita assíncrona ativa");
+    for (int i = 0; i < 200; ++i) {
+        logger.warning("linha " + std::to_string(i));
+    }
+    logger.enableAsyncFileWriter(false);
+    
+    std::ifstream file(logFile);
+    std::string line;
+    int lines = 0;
+    while (std::getline(file, line)) {
+        lines++;
+    }
+    assertEqual(200, lines, "Todas as mensagens gravadas pela thread de escrita");
+    assertEqual(static_cast<size_t>(200), logger.calculateLogStatistics().asyncWrites, "Mensagens contabilizadas");
+    std::remove(logFile.c_str());
+}
+
 // ============================================================================
 // TESTES DE ESTADO (test_state.cpp)
 // ============================================================================
@@ -338,11 +807,19 @@ int main() {
         // Testes de Gerenciador de Arquivos
         testFileManagerConstructor();
         testFileOperations();
+        testFileContentHash();
+        testFileViews();
+        testFileCompression();
+        testIncludeLookupCaches();
+        testDirectoryListingMode();
+        testChangeWatching();
+    testConcurrentFileManager();
         
         // Testes de Logger
         testPreprocessorPosition();
         testLoggerBasicFunctionality();
         testLogLevels();
+        testLazyLogging();
         
         // Testes de Estado
         testPreprocessorStateConstructor();